@@ -19,6 +19,7 @@
 #include "commoncommandlinefunctions.h"
 
 #include "graph/assemblygraph.h"
+#include "layout/graphlayoutworker.h"
 #include "program/globals.h"
 #include "program/memory.h"
 
@@ -27,6 +28,9 @@
 #include <QApplication>
 #include <QRegularExpression>
 
+#include <atomic>
+#include <csignal>
+
 
 void outputText(const QString& text, QTextStream * out) {
     QStringList list;
@@ -196,3 +200,27 @@ void getOnlineHelpMessage(QStringList * text)
     *text << "Online Bandage help: https://github.com/asl/BandageNG/wiki";
     *text << "";
 }
+
+static std::atomic<GraphLayoutWorker *> s_interruptibleLayoutWorker{nullptr};
+
+static void cancelLayoutOnInterrupt(int) {
+    // Only sets a flag, so it is safe in a signal handler
+    if (GraphLayoutWorker *worker = s_interruptibleLayoutWorker.load())
+        worker->cancelLayout();
+    std::signal(SIGINT, SIG_DFL);
+}
+
+void layoutGraphInterruptibly(GraphLayoutWorker &worker,
+                              QSharedPointer<AssemblyGraphList> graphList,
+                              QTextStream * err) {
+    s_interruptibleLayoutWorker = &worker;
+    auto previousHandler = std::signal(SIGINT, cancelLayoutOnInterrupt);
+
+    worker.layoutGraph(std::move(graphList));
+
+    std::signal(SIGINT, previousHandler == SIG_ERR ? SIG_DFL : previousHandler);
+    s_interruptibleLayoutWorker = nullptr;
+
+    if (worker.isCancelled())
+        outputText("Bandage-NG warning: the layout was interrupted, the incomplete layout is used", err);
+}
@@ -27,6 +27,10 @@
 #include <QTextStream>
 #include <QDateTime>
 #include <QStringList>
+#include <QSharedPointer>
+
+class AssemblyGraphList;
+class GraphLayoutWorker;
 
 QString getElapsedTime(const QDateTime& start, const QDateTime& end);
 
@@ -47,4 +51,11 @@ void outputText(const QString& text, QTextStream * out);
 void outputText(const QStringList& text, QTextStream * out);
 void getOnlineHelpMessage(QStringList * text);
 
+// Lays the graphs out. SIGINT cancels the layout, so the graphs are left
+// with the layout reached so far (a warning is printed to err), the next
+// SIGINT terminates as usual.
+void layoutGraphInterruptibly(GraphLayoutWorker &worker,
+                              QSharedPointer<AssemblyGraphList> graphList,
+                              QTextStream * err);
+
 #endif // COMMANDCOMMANDLINEFUNCTIONS_H
@@ -0,0 +1,65 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "compact.h"
+#include "commoncommandlinefunctions.h"
+
+#include "graph/assemblygraph.h"
+#include "graph/gfawriter.h"
+
+#include "program/globals.h"
+
+#include <CLI/CLI.hpp>
+
+CLI::App *addCompactSubcommand(CLI::App &app, CompactCmd &cmd) {
+    auto *compact = app.add_subcommand("compact", "Merge all non-branching paths of a graph and save it in GFA format");
+    compact->add_option("<inputgraph>", cmd.m_graph, "A graph file of any type supported by Bandage")
+            ->required()->check(CLI::ExistingFile);
+    compact->add_option("<outputgraph>", cmd.m_out, "The filename for the compacted graph (if it does not end in '.gfa', the extension will be added)")
+            ->required();
+
+    compact->footer("Bandage compact does the same as 'Merge all possible nodes' in the GUI: every maximal "
+                    "path without branches (a unitig) is replaced by a single node. The sequence of the "
+                    "merged node is the path sequence, its depth is the length-weighted mean depth of the "
+                    "path nodes.");
+
+    return compact;
+}
+
+int handleCompactCmd(QApplication *app,
+                     const CLI::App &cli, const CompactCmd &cmd) {
+    QTextStream err(stderr);
+
+    QString outputFilename = cmd.m_out.c_str();
+    if (!outputFilename.endsWith(".gfa"))
+        outputFilename += ".gfa";
+
+    AssemblyGraph &graph = *g_assemblyGraph->first();
+    if (!graph.loadGraphFromFile(cmd.m_graph.c_str())) {
+        outputText(("Bandage-NG error: could not load " + cmd.m_graph.native()).c_str(), &err);
+        return 1;
+    }
+
+    graph.mergeAllPossible();
+
+    if (!gfa::saveEntireGraph(outputFilename, graph)) {
+        err << "Bandage was unable to save the graph file." << Qt::endl;
+        return 1;
+    }
+
+    return 0;
+}
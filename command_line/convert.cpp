@@ -0,0 +1,98 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "convert.h"
+#include "commoncommandlinefunctions.h"
+
+#include "graph/assemblygraph.h"
+#include "graph/gfawriter.h"
+#include "graph/snapshot.h"
+
+#include "layout/graphlayout.h"
+#include "layout/io.h"
+
+#include "program/globals.h"
+
+#include <CLI/CLI.hpp>
+#include <memory>
+
+CLI::App *addConvertSubcommand(CLI::App &app, ConvertCmd &cmd) {
+    auto *convert = app.add_subcommand("convert", "Convert a graph to Bandage snapshot or GFA format");
+    convert->add_option("<inputgraph>", cmd.m_graph, "A graph file of any type supported by Bandage")
+            ->required()->check(CLI::ExistingFile);
+    convert->add_option("<outputgraph>", cmd.m_out, "The filename for the graph to be made (if it does not end in '.gfa' or '.bandage', the '.bandage' extension will be added)")
+            ->required();
+    convert->add_option("--layout", cmd.m_layout, "A layout file (.layout or snapshot) to be stored in the snapshot")
+            ->check(CLI::ExistingFile);
+
+    convert->footer("Bandage convert saves an entire graph either as a GFA file or as a Bandage snapshot. "
+                    "Snapshots are binary files that are loaded much faster than the text formats. "
+                    "Layout of an input snapshot is preserved unless --layout is specified.");
+
+    return convert;
+}
+
+int handleConvertCmd(QApplication *app,
+                     const CLI::App &cli, const ConvertCmd &cmd) {
+    QTextStream err(stderr);
+
+    QString outputFilename = cmd.m_out.c_str();
+    bool isGfa = outputFilename.endsWith(".gfa");
+    if (!isGfa && !outputFilename.endsWith(".bandage"))
+        outputFilename += ".bandage";
+
+    AssemblyGraph &graph = *g_assemblyGraph->first();
+    if (!graph.loadGraphFromFile(cmd.m_graph.c_str())) {
+        outputText(("Bandage-NG error: could not load " + cmd.m_graph.native()).c_str(), &err);
+        return 1;
+    }
+
+    if (isGfa) {
+        if (!cmd.m_layout.empty())
+            outputText("Bandage-NG warning: layout could only be stored in snapshots, ignoring --layout", &err);
+        if (!gfa::saveEntireGraph(outputFilename, graph)) {
+            err << "Bandage was unable to save the graph file." << Qt::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    std::unique_ptr<GraphLayout> layout;
+    QString layoutFilename = cmd.m_layout.c_str();
+    if (layoutFilename.isEmpty() && snapshot::isSnapshot(cmd.m_graph.c_str()))
+        layoutFilename = cmd.m_graph.c_str();
+    if (!layoutFilename.isEmpty()) {
+        layout = std::make_unique<GraphLayout>(graph);
+        try {
+            layout::io::load(layoutFilename, *layout);
+        } catch (std::runtime_error &e) {
+            // Snapshots without layout are fine unless the layout was requested explicitly
+            if (!cmd.m_layout.empty()) {
+                outputText(("Bandage-NG error: could not load layout " + cmd.m_layout.native() + ": " + e.what()).c_str(), &err);
+                return 1;
+            }
+            layout.reset();
+        }
+    }
+
+    if (!snapshot::save(outputFilename, graph, layout.get())) {
+        err << "Bandage was unable to save the graph file." << Qt::endl;
+        return 1;
+    }
+
+    return 0;
+}
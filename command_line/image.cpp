@@ -29,9 +29,12 @@
 #include "layout/graphlayout.h"
 #include "layout/graphlayoutworker.h"
 
+#include "painting/tiledrenderer.h"
+
 #include "ui/bandagegraphicsscene.h"
 #include "ui/bandagegraphicsview.h"
 
+#include <algorithm>
 #include <vector>
 #include <QPainter>
 #include <QSvgGenerator>
@@ -44,12 +47,15 @@ CLI::App *addImageSubcommand(CLI::App &app, ImageCmd &cmd) {
             ->required()->check(CLI::ExistingPath);
     image->add_option("<output_file>", cmd.m_image, "The image file to be created (must end in '.jpg', '.png' or '.svg')")
             ->required();
-    image->add_option("--height", cmd.m_height, "Image height")
-            ->default_val(cmd.m_height)->check(CLI::Range(1, 32767));
-    image->add_option("--width", cmd.m_width, "Image width")
-            ->check(CLI::Range(1, 32767));
+    image->add_option("--height", cmd.m_height, "Image height (at most 32767 for JPG)")
+            ->default_val(cmd.m_height)->check(CLI::Range(1, 1 << 20));
+    image->add_option("--width", cmd.m_width, "Image width (at most 32767 for JPG)")
+            ->check(CLI::Range(1, 1 << 20));
     image->add_option("--color", cmd.m_color, "csv file with 2 columns: first the node name second the node color")
             ->check(CLI::ExistingFile);
+    image->add_flag("--tiles", cmd.m_tiles,
+                    "Write a pyramid of 256x256 PNG tiles into the <output_file> directory as z/x/y.png, "
+                    "from the whole graph in one tile down to the image size");
 
     image->footer("If only height or width is set, the other will be determined automatically. If both are set, the image will be exactly that size");
 
@@ -63,7 +69,7 @@ int handleImageCmd(QApplication *app,
 
     QTextStream out(stdout);
     QTextStream err(stderr);
-    if (imageFileExtension == ".png" || imageFileExtension == ".jpg")
+    if (cmd.m_tiles || imageFileExtension == ".png" || imageFileExtension == ".jpg")
         pixelImage = true;
     else if (imageFileExtension == ".svg")
         pixelImage = false;
@@ -164,7 +170,8 @@ int handleImageCmd(QApplication *app,
 
     BandageGraphicsScene scene;
     {
-        GraphLayoutWorker(g_settings->graphLayoutQuality, g_settings->linearLayout, g_settings->componentSeparation).layoutGraph(g_assemblyGraph);
+        GraphLayoutWorker worker(g_settings->graphLayoutQuality, g_settings->linearLayout, g_settings->componentSeparation);
+        layoutGraphInterruptibly(worker, g_assemblyGraph, &err);
 
         scene.clear();
         int drawnNodeCount = 0;
@@ -195,9 +202,20 @@ int handleImageCmd(QApplication *app,
     else if (height == 0 && width > 0)
         height = width / sceneRectAspectRatio;
 
+    if (imageFileExtension == ".jpg" && !cmd.m_tiles && std::max(width, height) > 32767) {
+        outputText("Bandage-NG error: only PNG images can be larger than 32767 pixels", &err);
+        return 1;
+    }
+
     bool success = true;
     QPainter painter;
-    if (pixelImage) {
+    if (cmd.m_tiles) {
+        success = TiledRenderer(scene, QSize(width, height)).saveTilePyramid(cmd.m_image.c_str());
+    } else if (imageFileExtension == ".png") {
+        // Rendered in tiles on all cores and streamed to the file, so
+        // neither the size nor the memory is limited by a single QImage
+        success = TiledRenderer(scene, QSize(width, height)).savePng(cmd.m_image.c_str());
+    } else if (pixelImage) {
         QImage image(width, height, QImage::Format_ARGB32);
         image.fill(Qt::white);
         painter.begin(&image);
@@ -30,6 +30,7 @@ struct ImageCmd {
     unsigned m_height = 1000;
     unsigned m_width = 0;
     std::filesystem::path m_color;
+    bool m_tiles = false;
 };
 
 CLI::App *addImageSubcommand(CLI::App &app, ImageCmd &cmd);
@@ -19,18 +19,28 @@
 
 #include "commoncommandlinefunctions.h"
 #include "graph/assemblygraph.h"
+#include "graph/graphstats.h"
 #include "program/settings.h"
 
 #include <CLI/CLI.hpp>
 
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <algorithm>
+#include <vector>
+
 CLI::App *addInfoSubcommand(CLI::App &app, InfoCmd &cmd) {
     auto *info = app.add_subcommand("info", "Display information about a graph");
-    info->add_option("<graph>", cmd.m_graph, "A graph file of any type supported by Bandage")
-            ->required()->check(CLI::ExistingFile);
-    info->add_flag("--tsv", cmd.m_tsv, "Output the information in a single tab-delimited line starting with the graph file");
+    info->add_option("<graph>", cmd.m_graph, "A graph file of any type supported by Bandage, or a directory of graphs")
+            ->required()->check(CLI::ExistingPath);
+    auto *tsv = info->add_flag("--tsv", cmd.m_tsv, "Output the information in a single tab-delimited line starting with the graph file");
+    info->add_flag("--json", cmd.m_json, "Output the information as JSON")->excludes(tsv);
 
     info->footer(
-        "Bandage info takes a graph file as input and outputs (to stdout) the following statistics about the graph:\n"
+        "Bandage info takes a graph file as input and outputs (to stdout) the following statistics about the graph. "
+        "If a directory is given, all graphs found in it (recursively) are reported one after another:\n"
         "  * Node count: The number of nodes in the graph. Only positive nodes are counted (i.e. each complementary pair counts as one).\n"
         "  * Edge count: The number of edges in the graph. Only one edge in each complementary pair is counted.\n"
         "  * Smallest edge overlap: The smallest overlap size (in bp) for the edges in the graph.\n"
@@ -54,83 +64,129 @@ CLI::App *addInfoSubcommand(CLI::App &app, InfoCmd &cmd) {
     return info;
 }
 
+// Same files as AssemblyGraphList::loadGraphsFromDir() picks up, in a stable order
+static std::vector<std::filesystem::path> findGraphFiles(const std::filesystem::path &dir) {
+    std::vector<std::filesystem::path> files;
+    for (const auto &entry : std::filesystem::recursive_directory_iterator(dir)) {
+        if (entry.is_regular_file() && entry.path().extension() != ".fasta")
+            files.push_back(entry.path());
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+static QJsonObject toJson(const QString &graphFile, const graph::Statistics &stats) {
+    QJsonObject json;
+    json["graph"] = graphFile;
+    json["nodeCount"] = stats.nodeCount;
+    json["edgeCount"] = stats.edgeCount;
+    json["smallestOverlap"] = stats.smallestOverlap;
+    json["largestOverlap"] = stats.largestOverlap;
+    json["totalLength"] = qint64(stats.totalLength);
+    json["totalLengthNoOverlaps"] = qint64(stats.totalLengthNoOverlaps);
+    json["deadEnds"] = qint64(stats.deadEnds);
+    json["percentageDeadEnds"] = stats.percentageDeadEnds;
+    json["componentCount"] = stats.componentCount;
+    json["largestComponentLength"] = qint64(stats.largestComponentLength);
+    json["totalLengthOrphanedNodes"] = qint64(stats.totalLengthOrphanedNodes);
+    json["n50"] = stats.n50;
+    json["shortestNode"] = stats.shortestNode;
+    json["firstQuartileNode"] = stats.firstQuartile;
+    json["medianNode"] = stats.median;
+    json["thirdQuartileNode"] = stats.thirdQuartile;
+    json["longestNode"] = stats.longestNode;
+    json["medianDepthByBase"] = stats.medianDepthByBase;
+    json["estimatedSequenceLength"] = qint64(stats.estimatedSequenceLength);
+    return json;
+}
+
+static void printStatistics(QTextStream &out, const QString &graphFile, const graph::Statistics &stats, bool tsv) {
+    if (tsv) {
+        out << graphFile << "\t"
+            << stats.nodeCount << "\t"
+            << stats.edgeCount << "\t"
+            << stats.smallestOverlap << "\t"
+            << stats.largestOverlap << "\t"
+            << stats.totalLength << "\t"
+            << stats.totalLengthNoOverlaps << "\t"
+            << stats.deadEnds << "\t"
+            << stats.percentageDeadEnds << "%\t"
+            << stats.componentCount << "\t"
+            << stats.largestComponentLength << "\t"
+            << stats.totalLengthOrphanedNodes << "\t"
+            << stats.n50 << "\t"
+            << stats.shortestNode << "\t"
+            << stats.firstQuartile << "\t"
+            << stats.median << "\t"
+            << stats.thirdQuartile << "\t"
+            << stats.longestNode << "\t"
+            << stats.medianDepthByBase << "\t"
+            << stats.estimatedSequenceLength << "\n";
+    } else {
+        out << "Node count:                       " << stats.nodeCount << "\n"
+            << "Edge count:                       " << stats.edgeCount << "\n"
+            << "Smallest edge overlap (bp):       " << stats.smallestOverlap << "\n"
+            << "Largest edge overlap (bp):        " << stats.largestOverlap << "\n"
+            << "Total length (bp):                " << stats.totalLength << "\n"
+            << "Total length no overlaps (bp):    " << stats.totalLengthNoOverlaps << "\n"
+            << "Dead ends:                        " << stats.deadEnds << "\n"
+            << "Percentage dead ends:             " << stats.percentageDeadEnds << "%\n"
+            << "Connected components:             " << stats.componentCount << "\n"
+            << "Largest component (bp):           " << stats.largestComponentLength << "\n"
+            << "Total length orphaned nodes (bp): " << stats.totalLengthOrphanedNodes << "\n"
+            << "N50 (bp):                         " << stats.n50 << "\n"
+            << "Shortest node (bp):               " << stats.shortestNode << "\n"
+            << "Lower quartile node (bp):         " << stats.firstQuartile << "\n"
+            << "Median node (bp):                 " << stats.median << "\n"
+            << "Upper quartile node (bp):         " << stats.thirdQuartile << "\n"
+            << "Longest node (bp):                " << stats.longestNode << "\n"
+            << "Median depth:                     " << stats.medianDepthByBase << "\n"
+            << "Estimated sequence length (bp):   " << stats.estimatedSequenceLength << "\n";
+    }
+}
+
 int handleInfoCmd(QApplication *app,
                   const CLI::App &cli, const InfoCmd &cmd) {
     QTextStream out(stdout);
     QTextStream err(stderr);
 
-    if (!g_assemblyGraph->first()->loadGraphFromFile(cmd.m_graph.c_str())) {
-        err << "Bandage-NG error: could not load " << cmd.m_graph.c_str() << Qt::endl;
+    bool directory = std::filesystem::is_directory(cmd.m_graph);
+    std::vector<std::filesystem::path> graphFiles =
+            directory ? findGraphFiles(cmd.m_graph) : std::vector<std::filesystem::path>{ cmd.m_graph };
+
+    QJsonArray jsonGraphs;
+    size_t reported = 0;
+    for (const auto &graphFile : graphFiles) {
+        // Graphs are loaded one at a time, only the statistics are kept
+        AssemblyGraph graph;
+        QString fileName = QString::fromStdString(graphFile.string());
+        if (!graph.loadGraphFromFile(fileName)) {
+            err << "Bandage-NG error: could not load " << fileName << Qt::endl;
+            // Directories could contain other files as well
+            if (directory)
+                continue;
+            return 1;
+        }
+
+        graph::Statistics stats = graph::computeStatistics(graph);
+        if (cmd.m_json) {
+            jsonGraphs.append(toJson(fileName, stats));
+        } else {
+            if (directory && !cmd.m_tsv)
+                out << (reported ? "\n" : "") << "Graph:                            " << fileName << "\n";
+            printStatistics(out, fileName, stats, cmd.m_tsv);
+        }
+        reported += 1;
+    }
+
+    if (directory && !reported) {
+        err << "Bandage-NG error: no graphs found in " << cmd.m_graph.c_str() << Qt::endl;
         return 1;
     }
 
-    int nodeCount = g_assemblyGraph->first()->m_nodeCount;
-    int edgeCount = g_assemblyGraph->first()->m_edgeCount;
-    QPair<int, int> overlapRange = g_assemblyGraph->first()->getOverlapRange();
-    int smallestOverlap = overlapRange.first;
-    int largestOverlap = overlapRange.second;
-    int totalLength = g_assemblyGraph->first()->m_totalLength;
-    int totalLengthNoOverlaps = g_assemblyGraph->first()->getTotalLengthMinusEdgeOverlaps();
-    int deadEnds = g_assemblyGraph->first()->getDeadEndCount();
-    double percentageDeadEnds = 100.0 * double(deadEnds) / (2 * nodeCount);
-
-    int n50 = 0;
-    int shortestNode = 0;
-    int firstQuartile = 0;
-    int median = 0;
-    int thirdQuartile = 0;
-    int longestNode = 0;
-    g_assemblyGraph->first()->getNodeStats(&n50, &shortestNode, &firstQuartile, &median, &thirdQuartile, &longestNode);
-
-    int componentCount = 0;
-    int largestComponentLength = 0;
-    g_assemblyGraph->first()->getGraphComponentCountAndLargestComponentSize(&componentCount, &largestComponentLength);
-    long long totalLengthOrphanedNodes = g_assemblyGraph->first()->getTotalLengthOrphanedNodes();
-
-    double medianDepthByBase = g_assemblyGraph->first()->getMedianDepthByBase();
-    long long estimatedSequenceLength = g_assemblyGraph->first()->getEstimatedSequenceLength(medianDepthByBase);
-
-    if (cmd.m_tsv) {
-        out << cmd.m_graph.c_str() << "\t"
-            << nodeCount << "\t"
-            << edgeCount << "\t"
-            << smallestOverlap << "\t"
-            << largestOverlap << "\t"
-            << totalLength << "\t"
-            << totalLengthNoOverlaps << "\t"
-            << deadEnds << "\t"
-            << percentageDeadEnds << "%\t"
-            << componentCount << "\t"
-            << largestComponentLength << "\t"
-            << totalLengthOrphanedNodes << "\t"
-            << n50 << "\t"
-            << shortestNode << "\t"
-            << firstQuartile << "\t"
-            << median << "\t"
-            << thirdQuartile << "\t"
-            << longestNode << "\t"
-            << medianDepthByBase << "\t"
-            << estimatedSequenceLength << "\n";
-    } else {
-        out << "Node count:                       " << nodeCount << "\n"
-            << "Edge count:                       " << edgeCount << "\n"
-            << "Smallest edge overlap (bp):       " << smallestOverlap << "\n"
-            << "Largest edge overlap (bp):        " << largestOverlap << "\n"
-            << "Total length (bp):                " << totalLength << "\n"
-            << "Total length no overlaps (bp):    " << totalLengthNoOverlaps << "\n"
-            << "Dead ends:                        " << deadEnds << "\n"
-            << "Percentage dead ends:             " << percentageDeadEnds << "%\n"
-            << "Connected components:             " << componentCount << "\n"
-            << "Largest component (bp):           " << largestComponentLength << "\n"
-            << "Total length orphaned nodes (bp): " << totalLengthOrphanedNodes << "\n"
-            << "N50 (bp):                         " << n50 << "\n"
-            << "Shortest node (bp):               " << shortestNode << "\n"
-            << "Lower quartile node (bp):         " << firstQuartile << "\n"
-            << "Median node (bp):                 " << median << "\n"
-            << "Upper quartile node (bp):         " << thirdQuartile << "\n"
-            << "Longest node (bp):                " << longestNode << "\n"
-            << "Median depth:                     " << medianDepthByBase << "\n"
-            << "Estimated sequence length (bp):   " << estimatedSequenceLength << "\n";
+    if (cmd.m_json) {
+        QJsonDocument json = directory ? QJsonDocument(jsonGraphs) : QJsonDocument(jsonGraphs.first().toObject());
+        out << json.toJson(QJsonDocument::Indented);
     }
 
     return 0;
@@ -112,9 +112,10 @@ int handleLayoutCmd(QApplication *app,
         assemblyGraph->markNodesToDraw(scope, startingNodes);
     }
 
-    GraphLayoutWorker(g_settings->graphLayoutQuality,
-                       g_settings->linearLayout,
-                       g_settings->componentSeparation).layoutGraph(g_assemblyGraph);
+    GraphLayoutWorker worker(g_settings->graphLayoutQuality,
+                             g_settings->linearLayout,
+                             g_settings->componentSeparation);
+    layoutGraphInterruptibly(worker, g_assemblyGraph, &err);
 
     bool success;
 
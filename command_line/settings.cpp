@@ -277,8 +277,24 @@ static CLI::App *addGraphLayoutSettings(CLI::App &app) {
     auto *layout = app.add_option_group("Graph layout");
     add_setting(*layout, "--nodseglen", g_settings->nodeSegmentLength, "Node segment length");
     add_setting(*layout, "--iter", g_settings->graphLayoutQuality, "Graph layout iterations");
+    add_setting(*layout, "--seed", g_settings->layoutSeed, "Graph layout random seed");
     layout->add_flag("--linear", g_settings->linearLayout, "Linear graph layout")
             ->capture_default_str();
+    layout->add_option("--engine", g_settings->graphLayoutEngine,
+                       "Graph layout engine, one of: fmmm, fme (fast multipole embedder, uses several threads per component)")
+            ->transform(CLI::CheckedTransformer(
+                std::vector<std::pair<std::string, GraphLayoutEngine>>{
+                    {"fmmm", GraphLayoutEngine::FMMM_LAYOUT},
+                    {"fme", GraphLayoutEngine::FAST_MULTIPOLE_LAYOUT}}))
+            ->default_val("fmmm");
+    layout->add_flag("--multilevel", g_settings->multilevelLayout,
+                     "Multilevel graph layout: collapse non-branching paths, lay out and expand them back")
+            ->capture_default_str();
+    layout->add_option("--layoutcache", g_settings->layoutCacheDir,
+                       "Directory to cache graph layouts in (default: none, the user cache directory in the GUI)");
+    add_setting(*layout, "--layoutcachesize", g_settings->layoutCacheSize, "Maximum size (in MB) of the layout cache");
+    add_setting(*layout, "--hierarchical", g_settings->hierarchicalLayoutNodes,
+                "Lay out components of at least this many node segments hierarchically (0 disables)");
 
     return layout;
 }
@@ -292,6 +308,12 @@ static CLI::App *addGraphAppearanceSettings(CLI::App &app) {
             ->check(CLI::QColorValidator())
             ->default_str(getDefaultColour(g_settings->outlineColour).toStdString());
     add_setting(*ga, "--outline", g_settings->outlineThickness, "Node outline thickness");
+    add_setting(*ga, "--noddetail", g_settings->nodeDetailPixels,
+                "Draw nodes narrower than this many pixels as plain lines (0 always draws full detail)");
+    add_setting(*ga, "--edgdetail", g_settings->edgeDetailPixels,
+                "Draw edges spanning less than this many pixels as polylines (0 always draws full detail)");
+    add_setting(*ga, "--batched", g_settings->batchedSceneNodes,
+                "Draw graphs with at least this many drawn nodes as a single batched scene item (0 disables)");
     ga->add_option("--selcol", g_settings->selectionColour, "Color for selections")
             ->check(CLI::QColorValidator())
             ->default_str(getDefaultColour(g_settings->selectionColour).toStdString());
@@ -518,6 +540,15 @@ static CLI::App *addQueryPathsSettings(CLI::App &app) {
     return bqp;
 }
 
+static CLI::App *addPerformanceSettings(CLI::App &app) {
+    auto *perf = app.add_option_group("Performance");
+    add_setting(*perf, "--threads", g_settings->threads, "Number of threads to use, 0 means all available cores");
+    perf->add_flag("--lazyseq", g_settings->lazySequences, "Read GFA sequences from the input on demand instead of keeping them in memory");
+    add_setting(*perf, "--seqcache", g_settings->sequenceCacheSize, "Memory budget (in MB) for sequences read on demand");
+
+    return perf;
+}
+
 CLI::App *addSettings(CLI::App &app) {
     auto *scope = addGraphScopeSettings(app);
     auto *size = addGraphSizeSettings(app);
@@ -532,6 +563,7 @@ CLI::App *addSettings(CLI::App &app) {
     auto *dc = addDepthColorsSettings(app);
     auto *bs = addBlastSearchSettings(app);
     auto *bqp = addQueryPathsSettings(app);
+    auto *perf = addPerformanceSettings(app);
 
     return &app;
 }
@@ -0,0 +1,95 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "adjacency.h"
+
+#include "assemblygraph.h"
+#include "debruijnedge.h"
+#include "debruijnnode.h"
+
+namespace graph {
+    Adjacency::Adjacency(const AssemblyGraph &graph, std::shared_ptr<const NodeStore> store)
+            : m_nodes(std::move(store)) {
+        const NodeStore &nodes = *m_nodes;
+        size_t nodeCount = nodes.size(), edgeCount = graph.m_deBruijnGraphEdges.size();
+        m_outOffsets.reserve(nodeCount + 1); m_inOffsets.reserve(nodeCount + 1);
+        m_outNodes.reserve(edgeCount); m_outEdges.reserve(edgeCount);
+        m_inNodes.reserve(edgeCount); m_inEdges.reserve(edgeCount);
+        m_sources.reserve(edgeCount); m_edges.reserve(edgeCount);
+        m_ids.reserve(edgeCount);
+
+        // Outgoing edges first, they define the edge ids
+        m_outOffsets.push_back(0);
+        for (NodeId id = 0; id < nodeCount; ++id) {
+            if (nodes.exists(id)) {
+                const DeBruijnNode *node = nodes.node(id);
+                for (DeBruijnEdge *edge : node->edges()) {
+                    if (edge->getStartingNode() != node)
+                        continue;
+                    NodeId target = nodes.id(edge->getEndingNode());
+                    if (target == NodeStore::InvalidId)
+                        continue;
+
+                    auto edgeId = EdgeId(m_edges.size());
+                    m_outNodes.push_back(target);
+                    m_outEdges.push_back(edgeId);
+                    m_sources.push_back(id);
+                    m_edges.push_back(edge);
+                    m_ids.emplace(edge, edgeId);
+                }
+            }
+            m_outOffsets.push_back(uint32_t(m_outNodes.size()));
+        }
+
+        m_inOffsets.push_back(0);
+        for (NodeId id = 0; id < nodeCount; ++id) {
+            if (nodes.exists(id)) {
+                const DeBruijnNode *node = nodes.node(id);
+                for (DeBruijnEdge *edge : node->edges()) {
+                    if (edge->getEndingNode() != node)
+                        continue;
+                    EdgeId edgeId = this->id(edge);
+                    if (edgeId == InvalidEdgeId)
+                        continue;
+
+                    m_inNodes.push_back(m_sources[edgeId]);
+                    m_inEdges.push_back(edgeId);
+                }
+            }
+            m_inOffsets.push_back(uint32_t(m_inNodes.size()));
+        }
+    }
+
+    Adjacency::EdgeId Adjacency::id(const DeBruijnEdge *edge) const {
+        auto it = m_ids.find(edge);
+        return it != m_ids.end() ? it->second : InvalidEdgeId;
+    }
+
+    template<class T>
+    static size_t vectorMemory(const std::vector<T> &v) {
+        return v.capacity() * sizeof(T);
+    }
+
+    size_t Adjacency::memoryUsage() const {
+        return sizeof(*this) +
+               vectorMemory(m_outOffsets) + vectorMemory(m_outNodes) + vectorMemory(m_outEdges) +
+               vectorMemory(m_inOffsets) + vectorMemory(m_inNodes) + vectorMemory(m_inEdges) +
+               vectorMemory(m_sources) + vectorMemory(m_edges) +
+               // Slots plus one control byte per slot
+               m_ids.capacity() * (sizeof(decltype(m_ids)::value_type) + 1);
+    }
+}
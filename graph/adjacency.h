@@ -0,0 +1,98 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "nodestore.h"
+
+#include "llvm/ADT/iterator_range.h"
+#include "parallel_hashmap/phmap.h"
+
+#include <memory>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+class AssemblyGraph;
+class DeBruijnEdge;
+
+namespace graph {
+    // Immutable compressed sparse row snapshot of the graph edges over the
+    // NodeStore ids. For every node both the outgoing (node is the starting
+    // one) and incoming (node is the ending one) neighbours are stored as
+    // contiguous slices of node ids with the parallel slices of edge ids, so
+    // traversals do not need to allocate or chase DeBruijnEdge pointers.
+    // Within a slice edges follow the order of DeBruijnNode::edges(). Edge
+    // ids are dense, edges leaving the same node get consecutive ids. Like
+    // NodeStore, the snapshot does not follow graph edits, it is rebuilt by
+    // AssemblyGraph::adjacency().
+    class Adjacency {
+    public:
+        using NodeId = NodeStore::Id;
+        using EdgeId = uint32_t;
+        static constexpr EdgeId InvalidEdgeId = ~EdgeId(0);
+
+        template<class T>
+        using Range = llvm::iterator_range<const T *>;
+
+        Adjacency(const AssemblyGraph &graph, std::shared_ptr<const NodeStore> nodes);
+
+        [[nodiscard]] const NodeStore &nodes() const { return *m_nodes; }
+        [[nodiscard]] size_t nodeCount() const { return m_outOffsets.size() - 1; }
+        [[nodiscard]] size_t edgeCount() const { return m_edges.size(); }
+
+        [[nodiscard]] uint32_t outDegree(NodeId id) const { return m_outOffsets[id + 1] - m_outOffsets[id]; }
+        [[nodiscard]] uint32_t inDegree(NodeId id) const { return m_inOffsets[id + 1] - m_inOffsets[id]; }
+
+        [[nodiscard]] Range<NodeId> outNodes(NodeId id) const { return slice(m_outNodes, m_outOffsets, id); }
+        [[nodiscard]] Range<EdgeId> outEdges(NodeId id) const { return slice(m_outEdges, m_outOffsets, id); }
+        [[nodiscard]] Range<NodeId> inNodes(NodeId id) const { return slice(m_inNodes, m_inOffsets, id); }
+        [[nodiscard]] Range<EdgeId> inEdges(NodeId id) const { return slice(m_inEdges, m_inOffsets, id); }
+
+        [[nodiscard]] NodeId source(EdgeId edge) const { return m_sources[edge]; }
+        [[nodiscard]] NodeId target(EdgeId edge) const { return m_outNodes[edge]; }
+
+        // DeBruijnEdge facade
+        [[nodiscard]] DeBruijnEdge *edge(EdgeId edge) const { return m_edges[edge]; }
+        [[nodiscard]] EdgeId id(const DeBruijnEdge *edge) const;
+
+        // Memory used by the snapshot, in bytes
+        [[nodiscard]] size_t memoryUsage() const;
+
+    private:
+        template<class T>
+        static Range<T> slice(const std::vector<T> &values,
+                              const std::vector<uint32_t> &offsets, NodeId id) {
+            return llvm::make_range(values.data() + offsets[id], values.data() + offsets[id + 1]);
+        }
+
+        // Kept alive as long as the snapshot
+        std::shared_ptr<const NodeStore> m_nodes;
+
+        std::vector<uint32_t> m_outOffsets;
+        std::vector<NodeId> m_outNodes;
+        std::vector<EdgeId> m_outEdges;
+        std::vector<uint32_t> m_inOffsets;
+        std::vector<NodeId> m_inNodes;
+        std::vector<EdgeId> m_inEdges;
+
+        std::vector<NodeId> m_sources;
+        std::vector<DeBruijnEdge *> m_edges;
+        phmap::flat_hash_map<const DeBruijnEdge *, EdgeId> m_ids;
+    };
+}
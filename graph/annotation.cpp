@@ -23,6 +23,8 @@
 #include <QPen>
 #include <QPainter>
 
+#include <algorithm>
+
 void SolidView::drawFigure(QPainter &painter, GraphicsItemNode &graphicsItemNode, bool reverseComplement, int64_t start,
                            int64_t end) const {
     QPen pen;
@@ -60,12 +62,19 @@ void RainbowBlastHitView::drawFigure(QPainter &painter, GraphicsItemNode &graphi
     if (partCount > scaledHitLength * 2.0)
         partCount = int(scaledHitLength * 2.0);
 
-    double nodeSpacing = (fractionEnd - fractionStart) / partCount;
-    double rainbowSpacing = (m_rainbowFractionEnd - m_rainbowFractionStart) / partCount;
-
     double nodeFraction = fractionStart;
     double rainbowFraction = m_rainbowFractionStart;
 
+    //If the node is zoomed out to a few pixels, the hit is drawn as a single
+    //band of its middle colour.
+    if (!graphicsItemNode.drawnInDetail(painter) && partCount > 1) {
+        partCount = 1;
+        rainbowFraction = (m_rainbowFractionStart + m_rainbowFractionEnd) / 2.0;
+    }
+
+    double nodeSpacing = (fractionEnd - fractionStart) / partCount;
+    double rainbowSpacing = (m_rainbowFractionEnd - m_rainbowFractionStart) / partCount;
+
     QPen pen;
     pen.setCapStyle(Qt::FlatCap);
     pen.setJoinStyle(Qt::BevelJoin);
@@ -117,11 +126,25 @@ BedBlockView::BedBlockView(double widthMultiplier, const QColor &color, const st
     m_blocks.reserve(blocks.size());
     for (const auto &block: blocks) {
         m_blocks.emplace_back(widthMultiplier, color, block.start, block.end);
+        if (m_blocks.size() == 1) {
+            m_blocksStart = block.start;
+            m_blocksEnd = block.end;
+        } else {
+            m_blocksStart = std::min(m_blocksStart, block.start);
+            m_blocksEnd = std::max(m_blocksEnd, block.end);
+        }
     }
 }
 
 void BedBlockView::drawFigure(QPainter &painter, GraphicsItemNode &graphicsItemNode, bool reverseComplement, int64_t start,
                               int64_t end) const {
+    // Zoomed out, the blocks are merged into a single band
+    if (m_blocks.size() > 1 && !graphicsItemNode.drawnInDetail(painter)) {
+        BedThickView(m_widthMultiplier, m_color, m_blocksStart, m_blocksEnd)
+                .drawFigure(painter, graphicsItemNode, reverseComplement, start, end);
+        return;
+    }
+
     for (const auto &block: m_blocks) {
         block.drawFigure(painter, graphicsItemNode, reverseComplement, start, end);
     }
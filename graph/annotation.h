@@ -143,6 +143,9 @@ private:
     const double m_widthMultiplier;
     const QColor m_color;
     std::vector<BedThickView> m_blocks;
+    // All the blocks merged, drawn when the node is zoomed out
+    int64_t m_blocksStart = 0;
+    int64_t m_blocksEnd = 0;
 };
 
 class FeatureClassView : public SolidView {
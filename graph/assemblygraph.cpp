@@ -23,6 +23,10 @@
 #include "graphicsitemedgecommon.h"
 #include "graphicsitemnode.h"
 #include "sequenceutils.h"
+#include "sequencestore.h"
+#include "nodestore.h"
+#include "adjacency.h"
+#include "compaction.h"
 
 #include "layout/graphlayoutworker.h"
 
@@ -34,11 +38,14 @@
 #include "ui/bandagegraphicsscene.h"
 
 #include <QApplication>
+#include <QEventLoop>
 #include <QFile>
+#include <QFutureWatcher>
 #include <QList>
-#include <QQueue>
 #include <QRegularExpression>
 #include <QSet>
+#include <QTimer>
+#include <QtConcurrent>
 
 #include <algorithm>
 #include <iterator>
@@ -92,6 +99,7 @@ void AssemblyGraph::cleanUp() {
         }
         m_deBruijnGraphNodes.clear();
     }
+    m_sequenceStore.reset();
 
     {
         for (auto &entry : m_deBruijnGraphEdges) {
@@ -114,6 +122,32 @@ void AssemblyGraph::cleanUp() {
     m_nodeCSVData.clear();
     
     clearGraphInfo();
+    invalidateIndices();
+}
+
+std::shared_ptr<const graph::NodeStore> AssemblyGraph::nodeStore() const {
+    std::lock_guard<std::mutex> lock(m_indexMutex);
+    if (!m_nodeStore)
+        m_nodeStore = std::make_shared<graph::NodeStore>(*this);
+
+    return m_nodeStore;
+}
+
+std::shared_ptr<const graph::Adjacency> AssemblyGraph::adjacency() const {
+    std::lock_guard<std::mutex> lock(m_indexMutex);
+    if (!m_nodeStore)
+        m_nodeStore = std::make_shared<graph::NodeStore>(*this);
+    if (!m_adjacency)
+        m_adjacency = std::make_shared<graph::Adjacency>(*this, m_nodeStore);
+
+    return m_adjacency;
+}
+
+void AssemblyGraph::invalidateIndices() {
+    // Snapshots handed out earlier are freed by their last holder
+    std::lock_guard<std::mutex> lock(m_indexMutex);
+    m_adjacency.reset();
+    m_nodeStore.reset();
 }
 
 //The function returns a node name, replacing "+" at the end with "-" or
@@ -148,24 +182,34 @@ void AssemblyGraph::createDeBruijnEdge(const QString& node1Name, const QString&
         negNode2 == m_deBruijnGraphNodes.end())
         return;
 
+    if (addEdgePair(*node1, *node2, *negNode1, *negNode2, overlap, overlapType))
+        invalidateIndices();
+}
+
+//Creates the edge pair without invalidating the indices.  Returns nullptr if
+//the edge already exists.
+DeBruijnEdge *AssemblyGraph::addEdgePair(DeBruijnNode *node1, DeBruijnNode *node2,
+                                         DeBruijnNode *negNode1, DeBruijnNode *negNode2,
+                                         int overlap, EdgeOverlapType overlapType)
+{
     //Quit if the edge already exists
-    for (const auto *edge : (*node1)->edges()) {
-        if (edge->getStartingNode() == *node1 &&
-            edge->getEndingNode() == *node2)
-            return;
+    for (const auto *edge : node1->edges()) {
+        if (edge->getStartingNode() == node1 &&
+            edge->getEndingNode() == node2)
+            return nullptr;
     }
 
     //Usually, an edge has a different pair, but it is possible
     //for an edge to be its own pair.
-    bool isOwnPair = (*node1 == *negNode2 && *node2 == *negNode1);
+    bool isOwnPair = (node1 == negNode2 && node2 == negNode1);
 
-    auto * forwardEdge = new DeBruijnEdge(*node1, *node2);
+    auto * forwardEdge = new DeBruijnEdge(node1, node2);
     DeBruijnEdge * backwardEdge;
 
     if (isOwnPair)
         backwardEdge = forwardEdge;
     else
-        backwardEdge = new DeBruijnEdge(*negNode2, *negNode1);
+        backwardEdge = new DeBruijnEdge(negNode2, negNode1);
 
     forwardEdge->setReverseComplement(backwardEdge);
     backwardEdge->setReverseComplement(forwardEdge);
@@ -179,10 +223,12 @@ void AssemblyGraph::createDeBruijnEdge(const QString& node1Name, const QString&
     if (!isOwnPair)
         m_deBruijnGraphEdges.emplace(std::make_pair(backwardEdge->getStartingNode(), backwardEdge->getEndingNode()), backwardEdge);
 
-    (*node1)->addEdge(forwardEdge);
-    (*node2)->addEdge(forwardEdge);
-    (*negNode1)->addEdge(backwardEdge);
-    (*negNode2)->addEdge(backwardEdge);
+    node1->addEdge(forwardEdge);
+    node2->addEdge(forwardEdge);
+    negNode1->addEdge(backwardEdge);
+    negNode2->addEdge(backwardEdge);
+
+    return forwardEdge;
 }
 
 void AssemblyGraph::resetNodes()
@@ -883,15 +929,11 @@ void AssemblyGraph::deleteNodes(const std::vector<DeBruijnNode *> &nodes)
         nodesToDelete.insert(node->getReverseComplement());
     }
 
-    //Build a list of edges to delete.
+    //Build a list of edges to delete.  deleteEdges() takes care of the
+    //duplicates.
     std::vector<DeBruijnEdge *> edgesToDelete;
-    for (auto *node : nodesToDelete) {
-        for (auto *edge : node->edges()) {
-            bool alreadyAdded = std::find(edgesToDelete.begin(), edgesToDelete.end(), edge) != edgesToDelete.end();
-            if (!alreadyAdded)
-                edgesToDelete.push_back(edge);
-        }
-    }
+    for (auto *node : nodesToDelete)
+        edgesToDelete.insert(edgesToDelete.end(), node->edgeBegin(), node->edgeEnd());
 
     // Remove the edges from the graph,
     deleteEdges(edgesToDelete);
@@ -902,6 +944,8 @@ void AssemblyGraph::deleteNodes(const std::vector<DeBruijnNode *> &nodes)
 
     for (auto *node : nodesToDelete)
         delete node;
+
+    invalidateIndices();
 }
 
 void AssemblyGraph::deleteEdges(const std::vector<DeBruijnEdge *> &edges)
@@ -924,6 +968,8 @@ void AssemblyGraph::deleteEdges(const std::vector<DeBruijnEdge *> &edges)
 
         delete edge;
     }
+
+    invalidateIndices();
 }
 
 //This function assumes it is receiving a positive node.  It will duplicate both
@@ -973,6 +1019,7 @@ void AssemblyGraph::duplicateNodePair(DeBruijnNode * node, BandageGraphicsScene
 
     originalPosNode->setDepth(newDepth);
     originalNegNode->setDepth(newDepth);
+    invalidateIndices();
 
     scene->duplicateGraphicsNode(originalPosNode, newPosNode);
     scene->duplicateGraphicsNode(originalNegNode, newNegNode);
@@ -1132,10 +1179,11 @@ bool AssemblyGraph::mergeNodes(QList<DeBruijnNode *> nodes, BandageGraphicsScene
 }
 
 
-static bool mergeGraphicsNodes2(const std::vector<DeBruijnNode *> &originalNodes,
-                                DeBruijnNode * newNode,
-                                BandageGraphicsScene * scene) {
-    bool success = true;
+//Makes the GraphicsItemNode of the merged node from the line points of the
+//original nodes.  Edges are left to the caller.
+static bool makeMergedGraphicsNode(const std::vector<DeBruijnNode *> &originalNodes,
+                                   DeBruijnNode * newNode,
+                                   BandageGraphicsScene * scene) {
     std::vector<QPointF> linePoints;
 
     for (auto *node : originalNodes) {
@@ -1148,10 +1196,8 @@ static bool mergeGraphicsNodes2(const std::vector<DeBruijnNode *> &originalNodes
         }
 
         GraphicsItemNode * originalGraphicsItemNode = node->getGraphicsItemNode();
-        if (originalGraphicsItemNode == nullptr) {
-            success = false;
-            break;
-        }
+        if (originalGraphicsItemNode == nullptr)
+            return false;
 
         const auto& originalLinePoints = originalGraphicsItemNode->m_linePoints;
 
@@ -1166,26 +1212,36 @@ static bool mergeGraphicsNodes2(const std::vector<DeBruijnNode *> &originalNodes
         }
     }
 
-    if (success) {
-        // We pass dummy width here, as node widths will be recalculated later
-        auto * newGraphicsItemNode = new GraphicsItemNode(newNode, 0, linePoints);
+    // We pass dummy width here, as node widths will be recalculated later
+    auto * newGraphicsItemNode = new GraphicsItemNode(newNode, 0, linePoints);
 
-        newNode->setGraphicsItemNode(newGraphicsItemNode);
-        newGraphicsItemNode->setFlag(QGraphicsItem::ItemIsSelectable);
-        newGraphicsItemNode->setFlag(QGraphicsItem::ItemIsMovable);
-        newGraphicsItemNode->setNodeColour(g_settings->nodeColorer->get(newGraphicsItemNode));
+    newNode->setGraphicsItemNode(newGraphicsItemNode);
+    newGraphicsItemNode->setFlag(QGraphicsItem::ItemIsSelectable);
+    newGraphicsItemNode->setFlag(QGraphicsItem::ItemIsMovable);
+    newGraphicsItemNode->setNodeColour(g_settings->nodeColorer->get(newGraphicsItemNode));
 
-        scene->addItem(newGraphicsItemNode);
+    scene->addItem(newGraphicsItemNode);
+    return true;
+}
 
-        for (auto *newEdge : newNode->edges()) {
-            auto * graphicsItemEdge = new GraphicsItemEdge(newEdge);
-            graphicsItemEdge->setZValue(-1.0);
-            newEdge->setGraphicsItemEdge(graphicsItemEdge);
-            graphicsItemEdge->setFlag(QGraphicsItem::ItemIsSelectable);
-            scene->addItem(graphicsItemEdge);
-        }
-    }
-    return success;
+static void addGraphicsItemEdge(DeBruijnEdge * edge, BandageGraphicsScene * scene) {
+    auto * graphicsItemEdge = new GraphicsItemEdge(edge);
+    graphicsItemEdge->setZValue(-1.0);
+    edge->setGraphicsItemEdge(graphicsItemEdge);
+    graphicsItemEdge->setFlag(QGraphicsItem::ItemIsSelectable);
+    scene->addItem(graphicsItemEdge);
+}
+
+static bool mergeGraphicsNodes2(const std::vector<DeBruijnNode *> &originalNodes,
+                                DeBruijnNode * newNode,
+                                BandageGraphicsScene * scene) {
+    if (!makeMergedGraphicsNode(originalNodes, newNode, scene))
+        return false;
+
+    for (auto *newEdge : newNode->edges())
+        addGraphicsItemEdge(newEdge, scene);
+
+    return true;
 }
 
 static void mergeGraphicsNodes(const std::vector<DeBruijnNode *> &originalNodes,
@@ -1208,103 +1264,154 @@ static void mergeGraphicsNodes(const std::vector<DeBruijnNode *> &originalNodes,
 
 //This function simplifies the graph by merging all possible nodes in a simple
 //line.  It returns the number of merges that it did.
-//It gets a pointer to the progress dialog as well so it can check to see if the
-//user has cancelled the merge.
+//All chains are found and their merged nodes are built before the graph is
+//touched, then the graph (and the scene, if given) is modified in one go.
+//With a progress dialog the merged nodes are built on a worker thread, while
+//the event loop keeps the dialog responsive.  Cancelling stops that stage and
+//leaves the graph unchanged, the modification itself cannot be cancelled.
 int AssemblyGraph::mergeAllPossible(BandageGraphicsScene * scene,
                                     MyProgressDialog * progressDialog)
 {
-    //Create a set of all nodes.
-    QSet<DeBruijnNode *> uncheckedNodes;
-    for (auto &entry : m_deBruijnGraphNodes) {
-        uncheckedNodes.insert(entry);
+    std::vector<graph::Chain> chains = graph::findChains(*this);
+    if (chains.empty())
+        return 0;
+
+    emit setMergeTotalCount(int(chains.size()));
+    std::vector<graph::Unitig> unitigs;
+    if (progressDialog == nullptr)
+        unitigs = graph::buildUnitigs(*this, chains);
+    else {
+        std::atomic<bool> cancelled = false;
+        std::atomic<size_t> built = 0;
+
+        QEventLoop loop;
+        QFutureWatcher<std::vector<graph::Unitig>> watcher;
+        connect(&watcher, &QFutureWatcher<std::vector<graph::Unitig>>::finished, &loop, &QEventLoop::quit);
+        connect(progressDialog, &MyProgressDialog::halt, &loop, [&cancelled]() { cancelled = true; });
+
+        QTimer progressTimer;
+        connect(&progressTimer, &QTimer::timeout, this, [&]() { emit setMergeCompletedCount(int(built)); });
+        progressTimer.start(100);
+
+        watcher.setFuture(QtConcurrent::run([&]() {
+            return graph::buildUnitigs(*this, chains, &cancelled, &built);
+        }));
+        loop.exec();
+        progressTimer.stop();
+
+        if (cancelled)
+            return 0;
+        unitigs = watcher.result();
+    }
+    chains.clear();
+
+    //Create the merged nodes.  Edges entering the first node of a chain and
+    //leaving the last one are moved over to the merged node (and to its
+    //reverse complement for the complementary chain), so remember where the
+    //chain ends went.
+    phmap::flat_hash_map<const DeBruijnNode *, DeBruijnNode *> newStarts, newEnds;
+    std::vector<DeBruijnNode *> newNodes;
+    newNodes.reserve(unitigs.size());
+    for (auto &unitig : unitigs) {
+        QString newNodeBaseName = getUniqueNodeName(unitig.name);
+        QString newPosNodeName = newNodeBaseName + "+";
+        QString newNegNodeName = newNodeBaseName + "-";
+
+        auto newPosNode = new DeBruijnNode(getGraphId(), newPosNodeName, unitig.depth, unitig.sequence);
+        auto newNegNode = new DeBruijnNode(getGraphId(), newNegNodeName, unitig.depth,
+                                           unitig.sequence.GetReverseComplement());
+        newPosNode->setReverseComplement(newNegNode);
+        newNegNode->setReverseComplement(newPosNode);
+
+        m_deBruijnGraphNodes.emplace(newPosNodeName.toStdString(), newPosNode);
+        m_deBruijnGraphNodes.emplace(newNegNodeName.toStdString(), newNegNode);
+
+        newStarts.emplace(unitig.nodes.front(), newPosNode);
+        newStarts.emplace(unitig.nodes.back()->getReverseComplement(), newNegNode);
+        newEnds.emplace(unitig.nodes.back(), newPosNode);
+        newEnds.emplace(unitig.nodes.front()->getReverseComplement(), newNegNode);
+        newNodes.push_back(newPosNode);
     }
 
-    //Create a list of all merges to be done.
-    QList< QList<DeBruijnNode *> > allMerges;
-    for (auto &entry : m_deBruijnGraphNodes) {
-        DeBruijnNode * node = entry;
+    std::vector<DeBruijnNode *> oldNodes;
+    for (const auto &unitig : unitigs)
+        oldNodes.insert(oldNodes.end(), unitig.nodes.begin(), unitig.nodes.end());
+
+    //Now the edges.  They are collected first, as creating them modifies the
+    //edge lists of the neighbours.  Edges of chain nodes other than the ones
+    //inside the chains only touch chain ends (see graph::findChains()), so
+    //all of them are kept.
+    struct NewEdge {
+        DeBruijnNode *from, *to;
+        int overlap;
+        EdgeOverlapType overlapType;
+    };
+    auto mapped = [](const phmap::flat_hash_map<const DeBruijnNode *, DeBruijnNode *> &map,
+                     DeBruijnNode *node) {
+        auto it = map.find(node);
+        return it == map.end() ? node : it->second;
+    };
+    std::vector<NewEdge> newEdges;
+    for (size_t i = 0; i < unitigs.size(); ++i) {
+        const DeBruijnNode *first = unitigs[i].nodes.front(), *last = unitigs[i].nodes.back();
+        for (const auto *edge : last->edges()) {
+            if (edge->getStartingNode() == last)
+                newEdges.push_back({newNodes[i], mapped(newStarts, edge->getEndingNode()),
+                                    edge->getOverlap(), edge->getOverlapType()});
+        }
+        for (const auto *edge : first->edges()) {
+            if (edge->getEndingNode() == first)
+                newEdges.push_back({mapped(newEnds, edge->getStartingNode()), newNodes[i],
+                                    edge->getOverlap(), edge->getOverlapType()});
+        }
+    }
 
-        //If the current node isn't checked, then we will find the longest
-        //possible mergable sequence containing this node.
-        if (uncheckedNodes.contains(node))
-        {
-            QList<DeBruijnNode *> nodesToMerge;
-            nodesToMerge.push_back(node);
+    std::vector<DeBruijnEdge *> createdEdges;
+    for (const auto &edge : newEdges) {
+        if (auto *created = addEdgePair(edge.from, edge.to,
+                                        edge.from->getReverseComplement(), edge.to->getReverseComplement(),
+                                        edge.overlap, edge.overlapType)) {
+            createdEdges.push_back(created);
+            if (created->getReverseComplement() != created)
+                createdEdges.push_back(created->getReverseComplement());
+        }
+    }
 
-            uncheckedNodes.remove(node);
-            uncheckedNodes.remove(node->getReverseComplement());
+    //The scene is updated once: merged nodes take over the line points of the
+    //original ones, then edges are added for all new edges that are drawn.
+    if (scene != nullptr) {
+        for (size_t i = 0; i < unitigs.size(); ++i) {
+            DeBruijnNode * newPosNode = newNodes[i];
+            if (makeMergedGraphicsNode(unitigs[i].nodes, newPosNode, scene))
+                newPosNode->setAsDrawn();
+
+            if (g_settings->doubleMode) {
+                std::vector<DeBruijnNode *> revCompNodes;
+                for (auto it = unitigs[i].nodes.rbegin(); it != unitigs[i].nodes.rend(); ++it)
+                    revCompNodes.push_back((*it)->getReverseComplement());
+
+                DeBruijnNode * newNegNode = newPosNode->getReverseComplement();
+                if (makeMergedGraphicsNode(revCompNodes, newNegNode, scene))
+                    newNegNode->setAsDrawn();
+            }
+        }
 
-            //Extend forward as much as possible.
-            bool extended;
-            do
-            {
-                extended = false;
-                DeBruijnNode * last = nodesToMerge.back();
-                std::vector<DeBruijnEdge *> outgoingEdges = last->getLeavingEdges();
-                if (outgoingEdges.size() == 1)
-                {
-                    DeBruijnEdge * potentialEdge = outgoingEdges[0];
-                    DeBruijnNode * potentialNode = potentialEdge->getEndingNode();
-                    std::vector<DeBruijnEdge *> edgesEnteringPotentialNode = potentialNode->getEnteringEdges();
-                    if (edgesEnteringPotentialNode.size() == 1 &&
-                            edgesEnteringPotentialNode[0] == potentialEdge &&
-                            !nodesToMerge.contains(potentialNode) &&
-                            uncheckedNodes.contains(potentialNode))
-                    {
-                        nodesToMerge.push_back(potentialNode);
-                        uncheckedNodes.remove(potentialNode);
-                        uncheckedNodes.remove(potentialNode->getReverseComplement());
-                        extended = true;
-                    }
-                }
-            } while (extended);
+        BandageGraphicsScene::removeGraphicsItemNodes(oldNodes, true);
 
-            //Extend backward as much as possible.
-            do
-            {
-                extended = false;
-                DeBruijnNode * first = nodesToMerge.front();
-                std::vector<DeBruijnEdge *> incomingEdges = first->getEnteringEdges();
-                if (incomingEdges.size() == 1)
-                {
-                    DeBruijnEdge * potentialEdge = incomingEdges[0];
-                    DeBruijnNode * potentialNode = potentialEdge->getStartingNode();
-                    std::vector<DeBruijnEdge *> edgesLeavingPotentialNode = potentialNode->getLeavingEdges();
-                    if (edgesLeavingPotentialNode.size() == 1 &&
-                            edgesLeavingPotentialNode[0] == potentialEdge &&
-                            !nodesToMerge.contains(potentialNode) &&
-                            uncheckedNodes.contains(potentialNode))
-                    {
-                        nodesToMerge.push_front(potentialNode);
-                        uncheckedNodes.remove(potentialNode);
-                        uncheckedNodes.remove(potentialNode->getReverseComplement());
-                        extended = true;
-                    }
-                }
-            } while (extended);
-
-            if (nodesToMerge.size() > 1)
-                allMerges.push_back(nodesToMerge);
+        for (auto *edge : createdEdges) {
+            if (edge->determineIfDrawn())
+                addGraphicsItemEdge(edge, scene);
         }
     }
 
-    //Now do the actual merges.
-    QApplication::processEvents();
-    emit setMergeTotalCount(allMerges.size());
-    for (int i = 0; i < allMerges.size(); ++i)
-    {
-        if (progressDialog != nullptr && progressDialog->wasCancelled())
-            break;
-
-        mergeNodes(allMerges[i], scene);
-        emit setMergeCompletedCount(i+1);
-        QApplication::processEvents();
-    }
+    deleteNodes(oldNodes);
 
     recalculateAllNodeWidths(g_settings->averageNodeWidth,
                              g_settings->depthPower, g_settings->depthEffectOnWidth);
 
-    return allMerges.size();
+    emit setMergeCompletedCount(int(unitigs.size()));
+
+    return int(unitigs.size());
 }
 
 bool AssemblyGraph::hasCustomColour(const DeBruijnNode* node) const {
@@ -1443,6 +1550,8 @@ void AssemblyGraph::changeNodeName(const QString& oldName, const QString& newNam
 
     m_deBruijnGraphNodes.emplace(posNewNodeName.toStdString(), posNode);
     m_deBruijnGraphNodes.emplace(negNewNodeName.toStdString(), negNode);
+
+    invalidateIndices();
 }
 
 
@@ -1481,6 +1590,7 @@ void AssemblyGraph::changeNodeDepth(const std::vector<DeBruijnNode *> &nodes,
         node->setDepth(newDepth);
         node->getReverseComplement()->setDepth(newDepth);
     }
+    invalidateIndices();
 
     //If this graph does not already have a depthTag, give it a depthTag of KC
     //so the depth info will be saved.
@@ -1557,55 +1667,41 @@ void AssemblyGraph::getGraphComponentCountAndLargestComponentSize(int * componen
     *componentCount = 0;
     *largestComponentLength = 0;
 
-    QSet<DeBruijnNode *> visitedNodes;
-    QList< QList<DeBruijnNode *> > connectedComponents;
-
-    //Loop through all positive nodes.
-    for (auto &entry : m_deBruijnGraphNodes) {
-        DeBruijnNode * v = entry;
-        if (v->isNegativeNode())
+    //Components are searched over the node pairs (id / 2), the edges of the
+    //positive node reach the pairs of all connected nodes.
+    auto snapshot = this->adjacency();
+    const graph::Adjacency &adjacency = *snapshot;
+    const graph::NodeStore &nodes = adjacency.nodes();
+    std::vector<bool> visited(nodes.size() / 2, false);
+    std::vector<graph::NodeStore::Id> queue;
+    queue.reserve(nodes.size() / 2);
+
+    for (graph::NodeStore::Id v = 0; v < nodes.size(); v += 2) {
+        if (!nodes.exists(v) || nodes.isNegative(v) || visited[v / 2])
             continue;
 
-        //If the node has not yet been visited, then it must be the start of a new connected component.
-        if (!visitedNodes.contains(v))
-        {
-            QList<DeBruijnNode *> connectedComponent;
-
-            QQueue<DeBruijnNode *> q;
-            q.enqueue(v);
-            visitedNodes.insert(v);
-
-            while (!q.isEmpty())
-            {
-                DeBruijnNode * w = q.dequeue();
-                connectedComponent.push_back(w);
-
-                std::vector<DeBruijnNode *> connectedNodes = w->getAllConnectedPositiveNodes();
-                for (auto k : connectedNodes)
-                {
-                    if (!visitedNodes.contains(k))
-                    {
-                        visitedNodes.insert(k);
-                        q.enqueue(k);
+        //If the node has not yet been visited, then it must be the start of
+        //a new connected component.
+        long long componentLength = 0;
+        queue.assign(1, v);
+        visited[v / 2] = true;
+        for (size_t head = 0; head < queue.size(); ++head) {
+            graph::NodeStore::Id w = queue[head];
+            componentLength += nodes.length(w);
+
+            for (auto neighbours : { adjacency.outNodes(w), adjacency.inNodes(w) }) {
+                for (graph::NodeStore::Id k : neighbours) {
+                    if (!visited[k / 2]) {
+                        visited[k / 2] = true;
+                        queue.push_back(k & ~1u);
                     }
                 }
             }
-
-            connectedComponents.push_back(connectedComponent);
         }
-    }
-
-    //Now that the list of connected components is built, we look for the
-    //largest one (as measured by total node length).
-    *componentCount = connectedComponents.size();
-    for (int i = 0; i < *componentCount; ++i)
-    {
-        int componentLength = 0;
-        for (auto & j : connectedComponents[i])
-            componentLength += j->getLength();
 
+        ++*componentCount;
         if (componentLength > *largestComponentLength)
-            *largestComponentLength = componentLength;
+            *largestComponentLength = int(componentLength);
     }
 }
 
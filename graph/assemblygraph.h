@@ -36,6 +36,8 @@
 #include <QString>
 #include <QPair>
 #include <QObject>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 class DeBruijnNode;
@@ -44,6 +46,11 @@ class HiCEdge;
 class MyProgressDialog;
 class BandageGraphicsScene;
 class TextGraphicsItemNode;
+class SequenceStore;
+namespace graph {
+    class NodeStore;
+    class Adjacency;
+}
 
 class AssemblyGraphError : public std::runtime_error {
   public:
@@ -118,10 +125,23 @@ public:
     QString m_filename;
     QString m_depthTag;
     SequencesLoadedFromFasta m_sequencesLoadedFromFasta;
+    // Backing storage for lazily loaded node sequences (if any)
+    std::unique_ptr<SequenceStore> m_sequenceStore;
     QString m_graphName;
 
 
     void cleanUp();
+
+    // Read-only scan index of the nodes, built on the first request.
+    // Structural edits invalidate it (see invalidateIndices()), but the
+    // returned snapshot stays valid for as long as it is held, so it can be
+    // used from worker threads.
+    std::shared_ptr<const graph::NodeStore> nodeStore() const;
+    // CSR snapshot of the edges over the nodeStore() ids, same lifetime rules
+    std::shared_ptr<const graph::Adjacency> adjacency() const;
+    // Must be called after the graph is edited. Edits done via AssemblyGraph
+    // methods take care of this.
+    void invalidateIndices();
     void createDeBruijnEdge(const QString& node1Name, const QString& node2Name,
                             int overlap = 0,
                             EdgeOverlapType overlapType = UNKNOWN_OVERLAP);
@@ -213,8 +233,15 @@ private:
     std::vector<int> makeOverlapCountVector();
     void clearAllCsvData();
     QString getNewNodeName(QString oldNodeName) const;
+    DeBruijnEdge *addEdgePair(DeBruijnNode *node1, DeBruijnNode *node2,
+                              DeBruijnNode *negNode1, DeBruijnNode *negNode2,
+                              int overlap, EdgeOverlapType overlapType);
     TextGraphicsItemNode* m_textGraphicsItemNode = nullptr;
     int m_graphId = 1;
+
+    mutable std::mutex m_indexMutex;
+    mutable std::shared_ptr<const graph::NodeStore> m_nodeStore;
+    mutable std::shared_ptr<const graph::Adjacency> m_adjacency;
 signals:
     void setMergeTotalCount(int totalCount);
     void setMergeCompletedCount(int completedCount);
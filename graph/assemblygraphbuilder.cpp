@@ -17,6 +17,8 @@
 
 #include "io.h"
 #include "path.h"
+#include "snapshot.h"
+#include "sequencestore.h"
 
 #include "graph/assemblygraph.h"
 #include "graph/debruijnedge.h"
@@ -24,6 +26,7 @@
 
 #include "io/gfa.h"
 #include "io/fileutils.h"
+#include "io/linereader.h"
 
 #include "seq/sequence.hpp"
 
@@ -32,24 +35,25 @@
 #include <QDir>
 #include <QString>
 #include <QRegularExpression>
+#include <QScopeGuard>
+#include <QThreadPool>
+#include <QtConcurrent>
+
 #include <memory>
+#include <numeric>
 #include <program/settings.h>
 
-#include <zlib.h>
-
 static bool checkFirstLineOfFile(const QString& fullFileName, const QString& regExp) {
-    QFile inputFile(fullFileName);
-    if (inputFile.open(QIODevice::ReadOnly)) {
-        QTextStream in(&inputFile);
-        if (in.atEnd())
-            return false;
+    io::LineReader reader(fullFileName.toStdString(), 64 << 10);
+    if (!reader.isOpen())
+        return false;
 
-        QRegularExpression rx(regExp);
-        QString line = in.readLine();
-        if (rx.match(line).hasMatch())
-            return true;
-    }
-    return false;
+    std::string_view line;
+    if (!reader.readLine(line))
+        return false;
+
+    QRegularExpression rx(regExp);
+    return rx.match(QString::fromLatin1(line.data(), qsizetype(line.size()))).hasMatch();
 }
 
 //Cursory look to see if file appears to be a FASTG file.
@@ -83,56 +87,54 @@ static bool checkFileIsAsqg(const QString& fullFileName) {
     return checkFirstLineOfFile(fullFileName, "^HT\t");
 }
 
-static ssize_t gzgetdelim(char **buf, size_t *bufsiz, int delimiter, gzFile fp) {
-    char *ptr, *eptr;
+static std::string getOppositeNodeName(std::string nodeName) {
+    return (nodeName.back() == '-' ?
+            nodeName.substr(0, nodeName.size() - 1) + '+' :
+            nodeName.substr(0, nodeName.size() - 1) + '-');
+}
 
-    if (*buf == NULL || *bufsiz == 0) {
-        *bufsiz = BUFSIZ;
-        if ((*buf = (char*)malloc(*bufsiz)) == NULL)
-            return -1;
-    }
+static SequenceStore &getSequenceStore(AssemblyGraph &graph) {
+    if (!graph.m_sequenceStore)
+        graph.m_sequenceStore = std::make_unique<SequenceStore>(size_t(g_settings->sequenceCacheSize.val) << 20);
 
-    for (ptr = *buf, eptr = *buf + *bufsiz;;) {
-        char c = gzgetc(fp);
-        if (c == -1) {
-            if (gzeof(fp)) {
-                ssize_t diff = (ssize_t) (ptr - *buf);
-                if (diff != 0) {
-                    *ptr = '\0';
-                    return diff;
-                }
-            }
-            return -1;
-        }
-        *ptr++ = c;
-        if (c == delimiter) {
-            *ptr = '\0';
-            return ptr - *buf;
-        }
-        if (ptr + 2 >= eptr) {
-            char *nbuf;
-            size_t nbufsiz = *bufsiz * 2;
-            ssize_t d = ptr - *buf;
-            if ((nbuf = (char*)realloc(*buf, nbufsiz)) == NULL)
-                return -1;
-
-            *buf = nbuf;
-            *bufsiz = nbufsiz;
-            eptr = nbuf + nbufsiz;
-            ptr = nbuf + d;
-        }
-    }
+    return *graph.m_sequenceStore;
 }
 
-static ssize_t gzgetline(char **buf, size_t *bufsiz, gzFile fp) {
-    return gzgetdelim(buf, bufsiz, '\n', fp);
-}
+struct FastaIndexEntry {
+    QString name;
+    uint64_t length, offset;
+    uint32_t lineBases, lineWidth;
+};
+
+// Reads samtools .fai index. Returns false if there is no index or it could
+// not be parsed.
+static bool readFastaIndex(const QString &fileName,
+                           std::vector<FastaIndexEntry> &entries) {
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return false;
 
+    while (!file.atEnd()) {
+        QByteArray line = file.readLine().trimmed();
+        if (line.isEmpty())
+            continue;
 
-static std::string getOppositeNodeName(std::string nodeName) {
-    return (nodeName.back() == '-' ?
-            nodeName.substr(0, nodeName.size() - 1) + '+' :
-            nodeName.substr(0, nodeName.size() - 1) + '-');
+        QList<QByteArray> fields = line.split('\t');
+        if (fields.size() < 5)
+            return false;
+
+        bool ok[4];
+        FastaIndexEntry entry{QString::fromUtf8(fields[0]),
+                              fields[1].toULongLong(&ok[0]), fields[2].toULongLong(&ok[1]),
+                              fields[3].toUInt(&ok[2]), fields[4].toUInt(&ok[3])};
+        if (!ok[0] || !ok[1] || !ok[2] || !ok[3] ||
+            entry.lineBases == 0 || entry.lineWidth <= entry.lineBases)
+            return false;
+
+        entries.push_back(std::move(entry));
+    }
+
+    return true;
 }
 
 //This function will look to see if there is a FASTA file (.fa or .fasta) with
@@ -164,6 +166,33 @@ static bool attemptToLoadSequencesFromFasta(AssemblyGraph &graph) {
         return false;
 
     bool atLeastOneNodeSequenceLoaded = false;
+
+    // If the FASTA file is indexed, then there is no need to read it:
+    // the sequences could be loaded on demand
+    std::vector<FastaIndexEntry> index;
+    if (g_settings->lazySequences &&
+        readFastaIndex(fastaName + ".fai", index)) {
+        SequenceStore &store = getSequenceStore(graph);
+        uint32_t file = store.addFile(fastaName.toStdString());
+        for (const auto &entry : index) {
+            QString name = entry.name;
+            if (g_settings->multyGraphMode)
+                name = QString::number(graph.getGraphId()) + "_" + name;
+            auto nodeIt = graph.m_deBruijnGraphNodes.find((name + "+").toStdString());
+            if (nodeIt == graph.m_deBruijnGraphNodes.end() || !(*nodeIt)->sequenceIsMissing())
+                continue;
+
+            auto id = store.add(file, entry.offset, entry.length, entry.lineBases, entry.lineWidth);
+            DeBruijnNode *posNode = *nodeIt;
+            posNode->setLazySequence(&store, id, false, unsigned(entry.length));
+            DeBruijnNode *negNode = graph.m_deBruijnGraphNodes.at((name + "-").toStdString());
+            negNode->setLazySequence(&store, id, true, unsigned(entry.length));
+            atLeastOneNodeSequenceLoaded = true;
+        }
+
+        return atLeastOneNodeSequenceLoaded;
+    }
+
     std::vector<QString> names;
     std::vector<QByteArray> sequences;
     utils::readFastaFile(fastaName, names, sequences);
@@ -224,7 +253,7 @@ namespace io {
             // If node already exists it should be a placeholder of zero length
             if (nodeStorage != graph.m_deBruijnGraphNodes.end()) {
                 DeBruijnNode *placeholder = nodeStorage.value();
-                if (!placeholder->getSequence().empty())
+                if (placeholder->hasLazySequence() || !placeholder->getSequence().empty())
                     return nullptr;
 
                 // Takeover the placeholder
@@ -294,75 +323,120 @@ namespace io {
             return false;
         }
 
-        bool handleSegment(const gfa::segment &record,
-                           AssemblyGraph &graph) {
-            bool sequencesAreMissing = false;
-
+        // Segment record converted into everything needed to create the node
+        // pair. Preparation does not touch the graph, so it could be done
+        // concurrently for different records. For lazily loaded sequences
+        // only the location of the sequence in the input is recorded.
+        struct PreparedSegment {
             std::string nodeName;
-            const auto &seq = record.seq;
-            if (g_settings->multyGraphMode)
-                nodeName = std::to_string(graph.getGraphId()) + "_" + std::string(record.name);
-            else
-                nodeName = record.name;
-
+            Sequence sequence;
+            size_t length = 0;
+            uint64_t sequenceOffset = 0;
+            bool lazySequence = false;
+            double depth = 0;
+            const char *depthTag = nullptr;
+            bool sequenceIsMissing = false;
+            std::vector<gfa::tag> tags;
+        };
+
+        // Location of the text being parsed in the input. Used to compute the
+        // offsets of lazily loaded sequences, text is nullptr if sequences are
+        // to be loaded right away.
+        struct TextLocation {
+            const char *text = nullptr;
+            uint64_t offset = 0;
+        };
+
+        static PreparedSegment prepareSegment(gfa::segment &record,
+                                              const std::string &prefix,
+                                              TextLocation location) {
+            PreparedSegment res;
+
+            res.nodeName = prefix + std::string(record.name);
             // We check to see if the node ended in a "+" or "-".
             // If so, we assume that is giving the orientation and leave it.
             // And if it doesn't end in a "+" or "-", we assume "+" and add
             // that to the node name.
-            if (nodeName.back() != '+' && nodeName.back() != '-')
-                nodeName.push_back('+');
+            if (res.nodeName.back() != '+' && res.nodeName.back() != '-')
+                res.nodeName.push_back('+');
 
             // GFA can use * to indicate that the sequence is not in the
             // file.  In this case, try to use the LN tag for length.
             // If there is a sequence, then the LN tag will be ignored.
+            const auto &seq = record.seq;
             size_t length = seq.size();
-            Sequence sequence;
             if (!length ||
                 length == 1 && seq[0] == '*') {
                 auto lnTag = gfa::getTag<int64_t>("LN", record.tags);
                 if (lnTag)
                     length = size_t(*lnTag);
 
-                sequencesAreMissing = true;
-                sequence = Sequence(length, /* allNs */ true);
+                res.sequenceIsMissing = true;
+                res.sequence = Sequence(length, /* allNs */ true);
+            } else if (location.text) {
+                res.lazySequence = true;
+                res.sequenceOffset = location.offset + uint64_t(seq.data() - location.text);
             } else
-                sequence = Sequence{seq};
+                res.sequence = Sequence{seq};
+            res.length = length;
 
-            double nodeDepth = 0;
             if (auto dpTag = gfa::getTag<float>("DP", record.tags)) {
-                graph.m_depthTag = "DP";
-                nodeDepth = *dpTag;
+                res.depthTag = "DP";
+                res.depth = *dpTag;
             } else if (auto dpTag = gfa::getTag<float>("dp", record.tags)) {
-                graph.m_depthTag = "DP";
-                nodeDepth = *dpTag;
+                res.depthTag = "DP";
+                res.depth = *dpTag;
             } else if (auto kcTag = gfa::getTag<int64_t>("KC", record.tags)) {
-                graph.m_depthTag = "KC";
-                nodeDepth = double(*kcTag) / double(length);
+                res.depthTag = "KC";
+                res.depth = double(*kcTag) / double(length);
             } else if (auto rcTag = gfa::getTag<int64_t>("RC", record.tags)) {
-                graph.m_depthTag = "RC";
-                nodeDepth = double(*rcTag) / double(length);
+                res.depthTag = "RC";
+                res.depth = double(*rcTag) / double(length);
             } else if (auto fcTag = gfa::getTag<int64_t>("FC", record.tags)) {
-                graph.m_depthTag = "FC";
-                nodeDepth = double(*fcTag) / double(length);
+                res.depthTag = "FC";
+                res.depth = double(*fcTag) / double(length);
             }
 
+            res.tags = std::move(record.tags);
+
+            return res;
+        }
+
+        bool addSegment(const PreparedSegment &segment,
+                        AssemblyGraph &graph) {
+            if (segment.depthTag)
+                graph.m_depthTag = segment.depthTag;
+
             // FIXME: get rid of copies and QString's
-            auto [nodePtr, oppositeNodePtr] = addSegmentPair(nodeName, nodeDepth, sequence, graph);
+            auto [nodePtr, oppositeNodePtr] = addSegmentPair(segment.nodeName, segment.depth, segment.sequence, graph);
+            if (segment.lazySequence) {
+                auto id = sequenceStore_->add(sequenceFile_, segment.sequenceOffset, segment.length);
+                nodePtr->setLazySequence(sequenceStore_, id, false, unsigned(segment.length));
+                oppositeNodePtr->setLazySequence(sequenceStore_, id, true, unsigned(segment.length));
+            }
 
-            auto lb = gfa::getTag<std::string>("LB", record.tags);
-            auto l2 = gfa::getTag<std::string>("L2", record.tags);
+            const auto &tags = segment.tags;
+            auto lb = gfa::getTag<std::string>("LB", tags);
+            auto l2 = gfa::getTag<std::string>("L2", tags);
             hasCustomLabels_ = hasCustomLabels_ || lb || l2;
             if (lb) graph.setCustomLabel(nodePtr, lb->c_str());
             if (l2) graph.setCustomLabel(oppositeNodePtr, l2->c_str());
 
-            hasCustomColours_ |= maybeAddCustomColor(nodePtr, record.tags, "CB", graph);
-            hasCustomColours_ |= maybeAddCustomColor(oppositeNodePtr, record.tags, "C2", graph);
-            hasCustomColours_ |= maybeAddCustomColor(nodePtr, record.tags, "CL", graph);
+            hasCustomColours_ |= maybeAddCustomColor(nodePtr, tags, "CB", graph);
+            hasCustomColours_ |= maybeAddCustomColor(oppositeNodePtr, tags, "C2", graph);
+            hasCustomColours_ |= maybeAddCustomColor(nodePtr, tags, "CL", graph);
 
-            maybeAddTags(nodePtr, graph.m_nodeTags, record.tags);
-            maybeAddTags(oppositeNodePtr, graph.m_nodeTags, record.tags);
+            maybeAddTags(nodePtr, graph.m_nodeTags, tags);
+            maybeAddTags(oppositeNodePtr, graph.m_nodeTags, tags);
 
-            return sequencesAreMissing;
+            return segment.sequenceIsMissing;
+        }
+
+        bool handleSegment(gfa::segment &record,
+                           const std::string &prefix,
+                           TextLocation location,
+                           AssemblyGraph &graph) {
+            return addSegment(prepareSegment(record, prefix, location), graph);
         }
 
         static DeBruijnNode *getNode(const std::string &name,
@@ -378,41 +452,87 @@ namespace io {
             return nodePtr;
         }
 
-        auto addLink(const std::string &fromNode,
-                     const std::string &toNode,
-                     const std::vector<gfa::tag> &tags,
-                     AssemblyGraph &graph) {
-            // Get source / dest nodes (or create placeholders to fill in)
-            DeBruijnNode *fromNodePtr = getNode(fromNode, graph);
-            DeBruijnNode *toNodePtr = getNode(toNode, graph);
-
-            DeBruijnEdge *edgePtr = nullptr, *rcEdgePtr = nullptr;
+        template<class Link>
+        static std::pair<std::string, std::string>
+        linkNodeNames(const Link &record, const std::string &prefix) {
+            std::string fromNode{prefix + std::string(record.lhs)};
+            fromNode.push_back(record.lhs_revcomp ? '-' : '+');
+            std::string toNode{prefix + std::string(record.rhs)};
+            toNode.push_back(record.rhs_revcomp ? '-' : '+');
 
-            // Ignore dups, hifiasm seems to create them
-            if (graph.m_deBruijnGraphEdges.count({fromNodePtr, toNodePtr}))
-                return std::make_pair(edgePtr, rcEdgePtr);
+            return { std::move(fromNode), std::move(toNode) };
+        }
 
-            edgePtr = new DeBruijnEdge(fromNodePtr, toNodePtr);
+        // Creates the edge and its reverse complement (nullptr if the edge is
+        // its own reverse complement). Neither the graph nor the nodes are
+        // modified.
+        static std::pair<DeBruijnEdge *, DeBruijnEdge *>
+        createEdgePair(DeBruijnNode *fromNodePtr, DeBruijnNode *toNodePtr) {
+            auto *edgePtr = new DeBruijnEdge(fromNodePtr, toNodePtr);
+            DeBruijnEdge *rcEdgePtr = nullptr;
 
             bool isOwnPair = fromNodePtr == toNodePtr->getReverseComplement() &&
                              toNodePtr == fromNodePtr->getReverseComplement();
-            graph.m_deBruijnGraphEdges[{fromNodePtr, toNodePtr}] = edgePtr;
-            fromNodePtr->addEdge(edgePtr);
-            toNodePtr->addEdge(edgePtr);
-
             if (isOwnPair) {
                 edgePtr->setReverseComplement(edgePtr);
             } else {
-                auto *rcFromNodePtr = fromNodePtr->getReverseComplement();
-                auto *rcToNodePtr = toNodePtr->getReverseComplement();
-                rcEdgePtr = new DeBruijnEdge(rcToNodePtr, rcFromNodePtr);
-                rcFromNodePtr->addEdge(rcEdgePtr);
-                rcToNodePtr->addEdge(rcEdgePtr);
+                rcEdgePtr = new DeBruijnEdge(toNodePtr->getReverseComplement(),
+                                             fromNodePtr->getReverseComplement());
                 edgePtr->setReverseComplement(rcEdgePtr);
                 rcEdgePtr->setReverseComplement(edgePtr);
-                graph.m_deBruijnGraphEdges[{rcToNodePtr, rcFromNodePtr}] = rcEdgePtr;
             }
 
+            return { edgePtr, rcEdgePtr };
+        }
+
+        static void addEdgePairToNodes(DeBruijnEdge *edgePtr, DeBruijnEdge *rcEdgePtr) {
+            edgePtr->getStartingNode()->addEdge(edgePtr);
+            edgePtr->getEndingNode()->addEdge(edgePtr);
+            if (rcEdgePtr) {
+                rcEdgePtr->getStartingNode()->addEdge(rcEdgePtr);
+                rcEdgePtr->getEndingNode()->addEdge(rcEdgePtr);
+            }
+        }
+
+        static bool setLinkOverlap(const gfa::link &record,
+                                   DeBruijnEdge *edgePtr, DeBruijnEdge *rcEdgePtr) {
+            bool complexOverlap = false;
+            const auto &overlap = record.overlap;
+            size_t overlapLength = 0;
+            if (overlap.size() > 1 ||
+                (overlap.size() == 1 && overlap.front().op != 'M')) {
+                complexOverlap = true;
+            } else if (overlap.size() == 1) {
+                overlapLength = overlap.front().count;
+            }
+
+            edgePtr->setOverlap(static_cast<int>(overlapLength));
+            edgePtr->setOverlapType(EXACT_OVERLAP);
+            if (rcEdgePtr) {
+                rcEdgePtr->setOverlap(edgePtr->getOverlap());
+                rcEdgePtr->setOverlapType(edgePtr->getOverlapType());
+            }
+
+            return complexOverlap;
+        }
+
+        static bool setLinkOverlap(const gfa::gaplink &record,
+                                   DeBruijnEdge *edgePtr, DeBruijnEdge *rcEdgePtr) {
+            edgePtr->setOverlap(record.distance == std::numeric_limits<int64_t>::min() ? 0 : record.distance);
+            edgePtr->setOverlapType(JUMP);
+            if (rcEdgePtr) {
+                rcEdgePtr->setOverlap(edgePtr->getOverlap());
+                rcEdgePtr->setOverlapType(edgePtr->getOverlapType());
+            }
+
+            return false;
+        }
+
+        template<class Link>
+        void addLinkAttributes(const Link &record,
+                               DeBruijnEdge *edgePtr, DeBruijnEdge *rcEdgePtr,
+                               AssemblyGraph &graph) {
+            const auto &tags = record.tags;
             hasCustomColours_ |= maybeAddCustomColor(edgePtr, tags, "CB", graph);
             hasCustomColours_ |= maybeAddCustomColor(rcEdgePtr, tags, "C2", graph);
 
@@ -435,85 +555,45 @@ namespace io {
                 maybeAddTags(rcEdgePtr, graph.m_edgeTags, tags,
                              false);
 
-            return std::make_pair(edgePtr, rcEdgePtr);
+            if constexpr (std::is_same_v<Link, gfa::gaplink>) {
+                if (!graph.hasCustomColour(edgePtr))
+                    graph.setCustomColour(edgePtr, "red");
+                if (!graph.hasCustomColour(rcEdgePtr))
+                    graph.setCustomColour(rcEdgePtr, "red");
+                if (!graph.hasCustomStyle(edgePtr))
+                    graph.setCustomStyle(edgePtr, Qt::DashLine);
+                if (!graph.hasCustomStyle(rcEdgePtr))
+                    graph.setCustomStyle(rcEdgePtr, Qt::DashLine);
+            }
         }
 
-        void handleLink(const gfa::link &record,
+        template<class Link>
+        void handleLink(const Link &record,
+                        const std::string &prefix,
                         AssemblyGraph &graph) {
-            std::string prefix;
-            if (g_settings->multyGraphMode)
-                prefix = std::to_string(graph.getGraphId()) + "_";
-            else
-                prefix = "";
-            std::string fromNode{prefix + std::string(record.lhs)};
-            fromNode.push_back(record.lhs_revcomp ? '-' : '+');
-            std::string toNode{prefix + std::string(record.rhs)};
-            toNode.push_back(record.rhs_revcomp ? '-' : '+');
-
-            auto [edgePtr, rcEdgePtr] =
-                    addLink(fromNode, toNode, record.tags, graph);
-            if (!edgePtr)
-                return;
-
-            const auto &overlap = record.overlap;
-            size_t overlapLength = 0;
-            if (overlap.size() > 1 ||
-                (overlap.size() == 1 && overlap.front().op != 'M')) {
-                hasComplexOverlaps_ = true;
-            } else if (overlap.size() == 1) {
-                overlapLength = overlap.front().count;
-            }
-
-            edgePtr->setOverlap(static_cast<int>(overlapLength));
-            edgePtr->setOverlapType(EXACT_OVERLAP);
-            if (rcEdgePtr) {
-                rcEdgePtr->setOverlap(edgePtr->getOverlap());
-                rcEdgePtr->setOverlapType(edgePtr->getOverlapType());
-            }
-        }
+            auto [fromNode, toNode] = linkNodeNames(record, prefix);
 
-        void handleGapLink(const gfa::gaplink &record,
-                           AssemblyGraph &graph) {
-            // FIXME: get rid of severe duplication!
-            std::string prefix;
-            if (g_settings->multyGraphMode)
-                prefix = std::to_string(graph.getGraphId()) + "_";
-            else
-                prefix = "";
-            std::string fromNode = prefix + std::string(record.lhs);
-            fromNode.push_back(record.lhs_revcomp ? '-' : '+');
-            std::string toNode{prefix + std::string(record.rhs)};
-            toNode.push_back(record.rhs_revcomp ? '-' : '+');
+            // Get source / dest nodes (or create placeholders to fill in)
+            DeBruijnNode *fromNodePtr = getNode(fromNode, graph);
+            DeBruijnNode *toNodePtr = getNode(toNode, graph);
 
-            auto [edgePtr, rcEdgePtr] =
-                    addLink(fromNode, toNode, record.tags, graph);
-            if (!edgePtr)
+            // Ignore dups, hifiasm seems to create them
+            if (graph.m_deBruijnGraphEdges.count({fromNodePtr, toNodePtr}))
                 return;
 
-            edgePtr->setOverlap(record.distance == std::numeric_limits<int64_t>::min() ? 0 : record.distance);
-            edgePtr->setOverlapType(JUMP);
-            if (rcEdgePtr) {
-                rcEdgePtr->setOverlap(edgePtr->getOverlap());
-                rcEdgePtr->setOverlapType(edgePtr->getOverlapType());
-            }
+            auto [edgePtr, rcEdgePtr] = createEdgePair(fromNodePtr, toNodePtr);
+            graph.m_deBruijnGraphEdges[{fromNodePtr, toNodePtr}] = edgePtr;
+            if (rcEdgePtr)
+                graph.m_deBruijnGraphEdges[{rcEdgePtr->getStartingNode(), rcEdgePtr->getEndingNode()}] = rcEdgePtr;
+            addEdgePairToNodes(edgePtr, rcEdgePtr);
 
-            if (!graph.hasCustomColour(edgePtr))
-                graph.setCustomColour(edgePtr, "red");
-            if (!graph.hasCustomColour(rcEdgePtr))
-                graph.setCustomColour(rcEdgePtr, "red");
-            if (!graph.hasCustomStyle(edgePtr))
-                graph.setCustomStyle(edgePtr, Qt::DashLine);
-            if (!graph.hasCustomStyle(rcEdgePtr))
-                graph.setCustomStyle(rcEdgePtr, Qt::DashLine);
+            addLinkAttributes(record, edgePtr, rcEdgePtr, graph);
+            hasComplexOverlaps_ |= setLinkOverlap(record, edgePtr, rcEdgePtr);
         }
 
         void handlePath(const gfa::path &record,
+                        const std::string &prefix,
                         AssemblyGraph &graph) {
-            std::string prefix;
-            if (g_settings->multyGraphMode)
-                prefix = std::to_string(graph.getGraphId()) + "_";
-            else
-                prefix = "";
             std::vector<DeBruijnNode *> pathNodes;
             pathNodes.reserve(record.segments.size());            
             for (const auto &node: record.segments)
@@ -521,47 +601,309 @@ namespace io {
             graph.m_deBruijnGraphPaths[record.name] = new Path(Path::makeFromOrderedNodes(pathNodes, false));
         }
 
+        bool buildSequential(io::LineReader &reader,
+                             const std::string &prefix,
+                             AssemblyGraph &graph) {
+            bool sequencesAreMissing = false;
 
-    public:
-        using AssemblyGraphBuilder::AssemblyGraphBuilder;
+            std::string_view line;
+            while (reader.readLine(line)) {
+                if (line.empty())
+                    continue; // skip empty lines
 
-        bool build(AssemblyGraph &graph) override {
-            graph.m_filename = fileName_;
+                auto result = gfa::parseRecord(line.data(), line.size());
+                if (!result)
+                    continue;
 
-            bool sequencesAreMissing = false;
+                std::visit([&](auto &record) {
+                               using T = std::decay_t<decltype(record)>;
+                               if constexpr (std::is_same_v<T, gfa::segment>) {
+                                   TextLocation location;
+                                   if (sequenceStore_)
+                                       location = { line.data(), reader.lineOffset() };
+                                   sequencesAreMissing |= handleSegment(record, prefix, location, graph);
+                               } else if constexpr (std::is_same_v<T, gfa::link> ||
+                                                    std::is_same_v<T, gfa::gaplink>) {
+                                   handleLink(record, prefix, graph);
+                               } else if constexpr (std::is_same_v<T, gfa::path>) {
+                                   handlePath(record, prefix, graph);
+                               }
+                           },
+                           *result);
+            }
 
-            std::unique_ptr<std::remove_pointer<gzFile>::type, decltype(&gzclose)>
-                    fp(gzopen(fileName_.toStdString().c_str(), "r"), gzclose);
-            if (!fp)
-                throw AssemblyGraphError("failed to open file: " + fileName_.toStdString());
+            return sequencesAreMissing;
+        }
 
-            size_t i = 0;
-            char *line = nullptr;
-            size_t len = 0;
-            ssize_t read;
-            while ((read = gzgetline(&line, &len, fp.get())) != -1) {
-                if (read <= 1)
+        // Parallel loader. The input is read in large chunks of whole lines
+        // (the next chunk is read while the current one is processed). Each
+        // chunk is processed in two phases:
+        //  1. The chunk is split into batches which are parsed concurrently.
+        //     Segments are prepared (names, sequences, depths) right away,
+        //     everything else is kept in file order.
+        //  2. Segments are inserted into the node storage in file order.
+        //     Links are resolved concurrently and inserted into the edge
+        //     table with every thread owning its own subset of the edge table
+        //     shards. Things that could not be partitioned (placeholders,
+        //     node adjacency, custom attributes, paths) are handled
+        //     sequentially in file order.
+        // Within a chunk segments are added before links and links before
+        // paths. This does not change the resulting graph: link to a segment
+        // defined later in the file just does not need a placeholder.
+        struct PreparedLink {
+            const gfa::record *record = nullptr;
+            std::string fromNode, toNode;
+            DeBruijnNode *fromNodePtr = nullptr, *toNodePtr = nullptr;
+            DeBruijnEdge *edgePtr = nullptr, *rcEdgePtr = nullptr;
+        };
+
+        struct RecordBatch {
+            std::string_view text;
+            uint64_t offset = 0; // Offset of the text in the input
+            std::vector<PreparedSegment> segments;
+            std::vector<gfa::record> records;
+            std::vector<PreparedLink> links;
+        };
+
+        struct InputChunk {
+            uint64_t offset = 0;
+            std::vector<char> text;
+        };
+
+        static constexpr size_t ChunkSize = 16 << 20;
+
+        static void parseBatch(RecordBatch &batch, const std::string &prefix,
+                               bool lazySequences) {
+            TextLocation location;
+            if (lazySequences)
+                location = { batch.text.data(), batch.offset };
+
+            std::string_view text = batch.text;
+            while (!text.empty()) {
+                size_t eol = text.find('\n');
+                std::string_view line = text.substr(0, eol);
+                text.remove_prefix(eol == std::string_view::npos ? text.size() : eol + 1);
+                if (!line.empty() && line.back() == '\r')
+                    line.remove_suffix(1);
+                if (line.empty())
                     continue; // skip empty lines
 
-                auto result = gfa::parseRecord(line, read - 1);
+                auto result = gfa::parseRecord(line.data(), line.size());
                 if (!result)
                     continue;
 
+                if (auto *segment = std::get_if<gfa::segment>(&*result))
+                    batch.segments.push_back(prepareSegment(*segment, prefix, location));
+                else if (!std::holds_alternative<gfa::header>(*result))
+                    batch.records.push_back(std::move(*result));
+            }
+
+            // Records are not going to move anymore, so we could refer to them
+            for (const auto &record : batch.records) {
+                PreparedLink link;
+                if (auto *l = std::get_if<gfa::link>(&record))
+                    std::tie(link.fromNode, link.toNode) = linkNodeNames(*l, prefix);
+                else if (auto *j = std::get_if<gfa::gaplink>(&record))
+                    std::tie(link.fromNode, link.toNode) = linkNodeNames(*j, prefix);
+                else
+                    continue;
+
+                link.record = &record;
+                batch.links.push_back(std::move(link));
+            }
+        }
+
+        // Splits the chunk into approximately equal parts at line boundaries
+        static std::vector<RecordBatch> splitChunk(const InputChunk &chunk,
+                                                   size_t parts) {
+            std::vector<RecordBatch> batches;
+            std::string_view text(chunk.text.data(), chunk.text.size());
+            size_t partSize = text.size() / parts + 1;
+            while (!text.empty()) {
+                size_t end = text.find('\n', std::min(partSize, text.size()) - 1);
+                end = (end == std::string_view::npos ? text.size() : end + 1);
+                auto &batch = batches.emplace_back();
+                batch.text = text.substr(0, end);
+                batch.offset = chunk.offset + uint64_t(batch.text.data() - chunk.text.data());
+                text.remove_prefix(end);
+            }
+
+            return batches;
+        }
+
+        bool processChunk(const InputChunk &chunk,
+                          const std::string &prefix,
+                          QThreadPool &pool,
+                          AssemblyGraph &graph) {
+            bool sequencesAreMissing = false;
+            size_t threads = size_t(pool.maxThreadCount());
+
+            // Phase 1: parse
+            auto batches = splitChunk(chunk, 4 * threads);
+            bool lazySequences = sequenceStore_ != nullptr;
+            QtConcurrent::blockingMap(&pool, batches, [&prefix, lazySequences](RecordBatch &batch) {
+                parseBatch(batch, prefix, lazySequences);
+            });
+
+            // Phase 2: segments
+            for (const auto &batch : batches)
+                for (const auto &segment : batch.segments)
+                    sequencesAreMissing |= addSegment(segment, graph);
+
+            // Resolve links. The node storage is not modified here, so
+            // concurrent lookups are safe.
+            const auto &nodes = graph.m_deBruijnGraphNodes;
+            QtConcurrent::blockingMap(&pool, batches, [&nodes](RecordBatch &batch) {
+                for (auto &link : batch.links) {
+                    auto fromIt = nodes.find(link.fromNode), toIt = nodes.find(link.toNode);
+                    link.fromNodePtr = fromIt != nodes.end() ? *fromIt : nullptr;
+                    link.toNodePtr = toIt != nodes.end() ? *toIt : nullptr;
+                }
+            });
+
+            std::vector<PreparedLink *> links;
+            for (auto &batch : batches)
+                for (auto &link : batch.links) {
+                    // Create placeholders for the nodes not seen so far
+                    if (!link.fromNodePtr)
+                        link.fromNodePtr = getNode(link.fromNode, graph);
+                    if (!link.toNodePtr)
+                        link.toNodePtr = getNode(link.toNode, graph);
+                    links.push_back(&link);
+                }
+
+            // Links. The edge table is sharded, different shards could be
+            // safely modified concurrently. First, the owner of the shard
+            // of the canonical (out of the edge and its reverse complement)
+            // key of each link decides whether the link is a duplicate and
+            // creates the edges. Then each edge is inserted by the owner
+            // of its own shard.
+            auto &edges = graph.m_deBruijnGraphEdges;
+            size_t owners = std::min(threads, edges.subcnt());
+            auto owner = [&edges, owners](const AssemblyGraph::DeBruijnLink &key) {
+                return edges.subidx(edges.hash(key)) % owners;
+            };
+            edges.reserve(edges.size() + 2 * links.size());
+
+            std::vector<size_t> ownerIds(owners);
+            std::iota(ownerIds.begin(), ownerIds.end(), 0);
+            QtConcurrent::blockingMap(&pool, ownerIds, [&](size_t id) {
+                phmap::flat_hash_set<AssemblyGraph::DeBruijnLink> seen;
+                for (auto *link : links) {
+                    AssemblyGraph::DeBruijnLink key{link->fromNodePtr, link->toNodePtr},
+                            rcKey{link->toNodePtr->getReverseComplement(), link->fromNodePtr->getReverseComplement()};
+                    const auto &canonicalKey = std::min(key, rcKey);
+                    if (owner(canonicalKey) != id)
+                        continue;
+
+                    // Ignore dups, hifiasm seems to create them. The table
+                    // is not modified at this point.
+                    if (edges.count(key) || !seen.insert(canonicalKey).second)
+                        continue;
+
+                    std::tie(link->edgePtr, link->rcEdgePtr) = createEdgePair(link->fromNodePtr, link->toNodePtr);
+                }
+            });
+            QtConcurrent::blockingMap(&pool, ownerIds, [&](size_t id) {
+                for (const auto *link : links) {
+                    for (auto *edgePtr : { link->edgePtr, link->rcEdgePtr }) {
+                        if (!edgePtr)
+                            continue;
+                        AssemblyGraph::DeBruijnLink key{edgePtr->getStartingNode(), edgePtr->getEndingNode()};
+                        if (owner(key) == id)
+                            edges[key] = edgePtr;
+                    }
+                }
+            });
+
+            for (const auto *link : links) {
+                if (!link->edgePtr)
+                    continue;
+
+                addEdgePairToNodes(link->edgePtr, link->rcEdgePtr);
                 std::visit([&](const auto &record) {
                                using T = std::decay_t<decltype(record)>;
-                               if constexpr (std::is_same_v<T, gfa::segment>) {
-                                   sequencesAreMissing |= handleSegment(record, graph);
-                               } else if constexpr (std::is_same_v<T, gfa::link>) {
-                                   handleLink(record, graph);
-                               } else if constexpr (std::is_same_v<T, gfa::gaplink>) {
-                                   handleGapLink(record, graph);
-                               } else if constexpr (std::is_same_v<T, gfa::path>) {
-                                   handlePath(record, graph);
+                               if constexpr (std::is_same_v<T, gfa::link> ||
+                                             std::is_same_v<T, gfa::gaplink>) {
+                                   addLinkAttributes(record, link->edgePtr, link->rcEdgePtr, graph);
+                                   hasComplexOverlaps_ |= setLinkOverlap(record, link->edgePtr, link->rcEdgePtr);
                                }
                            },
-                           *result);
+                           *link->record);
+            }
+
+            // Paths
+            for (const auto &batch : batches)
+                for (const auto &record : batch.records)
+                    if (auto *path = std::get_if<gfa::path>(&record))
+                        handlePath(*path, prefix, graph);
+
+            return sequencesAreMissing;
+        }
+
+        bool buildParallel(io::LineReader &reader,
+                           const std::string &prefix,
+                           unsigned threads,
+                           AssemblyGraph &graph) {
+            bool sequencesAreMissing = false;
+
+            QThreadPool pool;
+            pool.setMaxThreadCount(int(threads));
+
+            auto readChunk = [&reader]() {
+                InputChunk chunk;
+                chunk.offset = reader.offset();
+                reader.readChunk(chunk.text, ChunkSize);
+                return chunk;
+            };
+
+            InputChunk chunk = readChunk();
+            while (!chunk.text.empty()) {
+                QFuture<InputChunk> next = QtConcurrent::run(&pool, readChunk);
+                // Do not let the reader go away while it is still being used
+                auto readGuard = qScopeGuard([&next] {
+                    try {
+                        next.waitForFinished();
+                    } catch (...) {}
+                });
+
+                sequencesAreMissing |= processChunk(chunk, prefix, pool, graph);
+                chunk = next.result();
+            }
+
+            return sequencesAreMissing;
+        }
+
+        // Storage for lazily loaded sequences, nullptr if sequences are
+        // loaded right away
+        SequenceStore *sequenceStore_ = nullptr;
+        uint32_t sequenceFile_ = 0;
+
+    public:
+        using AssemblyGraphBuilder::AssemblyGraphBuilder;
+
+        bool build(AssemblyGraph &graph) override {
+            graph.m_filename = fileName_;
+
+            io::LineReader reader(fileName_.toStdString());
+            if (!reader.isOpen())
+                throw AssemblyGraphError("failed to open file: " + fileName_.toStdString());
+
+            std::string prefix;
+            if (g_settings->multyGraphMode)
+                prefix = std::to_string(graph.getGraphId()) + "_";
+
+            if (g_settings->lazySequences) {
+                sequenceStore_ = &getSequenceStore(graph);
+                sequenceFile_ = sequenceStore_->addFile(fileName_.toStdString());
             }
 
+            unsigned threads = g_settings->threadCount();
+            bool sequencesAreMissing =
+                    threads > 1 ?
+                    buildParallel(reader, prefix, threads, graph) :
+                    buildSequential(reader, prefix, graph);
+
             graph.m_sequencesLoadedFromFasta = NOT_TRIED;
             if (sequencesAreMissing)
                 attemptToLoadSequencesFromFasta(graph);
@@ -705,19 +1047,26 @@ namespace io {
             graph.m_filename = fileName_;
             graph.m_depthTag = "KC";
 
-            QFile inputFile(fileName_);
-            if (inputFile.open(QIODevice::ReadOnly)) {
+            io::LineReader reader(fileName_.toStdString());
+            if (reader.isOpen()) {
                 std::vector<QString> edgeStartingNodeNames;
                 std::vector<QString> edgeEndingNodeNames;
                 DeBruijnNode *node = nullptr;
                 QByteArray sequenceBytes;
 
-                QTextStream in(&inputFile);
-                while (!in.atEnd()) {
+                std::string_view lineView;
+                while (reader.readLine(lineView)) {
                     QString nodeName;
                     double nodeDepth;
 
-                    QString line = in.readLine();
+                    //If the line does not start with a '>', then this line is part of the
+                    //sequence for the last node.
+                    if (!lineView.empty() && lineView.front() != '>') {
+                        sequenceBytes.append(QByteArray(lineView.data(), qsizetype(lineView.size())).simplified());
+                        continue;
+                    }
+
+                    QString line = QString::fromLatin1(lineView.data(), qsizetype(lineView.size()));
 
                     //If the line starts with a '>', then we are beginning a new node.
                     if (line.startsWith(">")) {
@@ -791,20 +1140,12 @@ namespace io {
                             edgeEndingNodeNames.push_back(edgeNodeName);
                         }
                     }
-
-                        //If the line does not start with a '>', then this line is part of the
-                        //sequence for the last node.
-                    else {
-                        sequenceBytes.push_back(line.simplified().toLocal8Bit());
-                    }
                 }
                 if (node != nullptr) {
                     node->setSequence(sequenceBytes);
                     sequenceBytes.clear();
                 }
 
-                inputFile.close();
-
                 // Add fake reverse-complementary nodes for all self-reverse-complement ones
                 {
                     std::vector<DeBruijnNode *> nodes;
@@ -851,17 +1192,17 @@ namespace io {
 
             int badEdgeCount = 0;
 
-            QFile inputFile(fileName_);
-            if (inputFile.open(QIODevice::ReadOnly)) {
+            io::LineReader reader(fileName_.toStdString());
+            if (reader.isOpen()) {
                 std::vector<QString> edgeStartingNodeNames;
                 std::vector<QString> edgeEndingNodeNames;
                 std::vector<int> edgeOverlaps;
 
-                QTextStream in(&inputFile);
-                while (!in.atEnd()) {
-                    QString line = in.readLine();
+                std::string_view lineView;
+                while (reader.readLine(lineView)) {
+                    QString line = QString::fromLatin1(lineView.data(), qsizetype(lineView.size()));
 
-                    QStringList lineParts = line.split(QRegularExpression("\t"));
+                    QStringList lineParts = line.split('\t');
                     if (lineParts.empty())
                         continue;
 
@@ -1117,11 +1458,28 @@ namespace io {
         }
     };
 
+    class SnapshotAssemblyGraphBuilder : public AssemblyGraphBuilder {
+        using AssemblyGraphBuilder::AssemblyGraphBuilder;
+
+        bool build(AssemblyGraph &graph) override {
+            graph.m_filename = fileName_;
+
+            auto flags = snapshot::load(fileName_, graph);
+            hasCustomLabels_ = flags.hasCustomLabels;
+            hasCustomColours_ = flags.hasCustomColours;
+
+            return true;
+        }
+    };
+
     std::unique_ptr<AssemblyGraphBuilder>
     AssemblyGraphBuilder::get(const QString &fullFileName) {
         std::unique_ptr<AssemblyGraphBuilder> res;
 
-        if (checkFileIsGfa(fullFileName))
+        // Snapshots are recognized by the magic, so check them first
+        if (snapshot::isSnapshot(fullFileName))
+            res.reset(new SnapshotAssemblyGraphBuilder(fullFileName));
+        else if (checkFileIsGfa(fullFileName))
             res.reset(new GFAAssemblyGraphBuilder(fullFileName));
         else if (checkFileIsFastG(fullFileName))
             res.reset(new FastgAssemblyGraphBuilder(fullFileName));
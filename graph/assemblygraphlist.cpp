@@ -93,6 +93,7 @@ void AssemblyGraphList::changeNodeDepth(const std::vector<DeBruijnNode *> &nodes
     }
 
     for (auto node : nodes) {
+        m_graphMap[node->getGraphId()]->invalidateIndices();
 
         //If this graph does not already have a depthTag, give it a depthTag of KC
         //so the depth info will be saved.
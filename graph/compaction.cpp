@@ -0,0 +1,147 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "compaction.h"
+
+#include "adjacency.h"
+#include "assemblygraph.h"
+#include "debruijnedge.h"
+#include "debruijnnode.h"
+
+#include "program/settings.h"
+
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <deque>
+
+namespace graph {
+    std::vector<Chain> findChains(const AssemblyGraph &graph) {
+        auto snapshot = graph.adjacency();
+        const Adjacency &adjacency = *snapshot;
+        const NodeStore &nodes = adjacency.nodes();
+
+        std::vector<bool> checked(nodes.size(), false);
+        auto check = [&](NodeStore::Id id) {
+            checked[id] = true;
+            checked[NodeStore::reverseComplement(id)] = true;
+        };
+
+        std::vector<Chain> chains;
+        std::deque<NodeStore::Id> chain;
+        for (const DeBruijnNode *node : graph.m_deBruijnGraphNodes) {
+            NodeStore::Id id = nodes.id(node);
+            if (id == NodeStore::InvalidId || checked[id])
+                continue;
+
+            chain.assign(1, id);
+            check(id);
+
+            // Extend forward as much as possible. A node only gets into the
+            // chain while unchecked, so the chain cannot contain it already.
+            while (adjacency.outDegree(chain.back()) == 1) {
+                NodeStore::Id next = *adjacency.outNodes(chain.back()).begin();
+                if (adjacency.inDegree(next) != 1 || checked[next])
+                    break;
+
+                chain.push_back(next);
+                check(next);
+            }
+
+            // Extend backward as much as possible
+            while (adjacency.inDegree(chain.front()) == 1) {
+                NodeStore::Id prev = *adjacency.inNodes(chain.front()).begin();
+                if (adjacency.outDegree(prev) != 1 || checked[prev])
+                    break;
+
+                chain.push_front(prev);
+                check(prev);
+            }
+
+            if (chain.size() > 1)
+                chains.emplace_back(chain.begin(), chain.end());
+        }
+
+        return chains;
+    }
+
+    // Same as Path::getPathSequence() for the whole chain: the overlap is
+    // trimmed from the start of every subsequent node, negative overlaps are
+    // filled with Ns
+    static Sequence chainSequence(const Adjacency &adjacency, const Chain &chain) {
+        const NodeStore &nodes = adjacency.nodes();
+
+        std::vector<Sequence> parts;
+        parts.reserve(2 * chain.size());
+        parts.push_back(nodes.sequence(chain.front()));
+        for (size_t i = 1; i < chain.size(); ++i) {
+            Sequence next = nodes.sequence(chain[i]);
+            int overlap = adjacency.edge(*adjacency.outEdges(chain[i - 1]).begin())->getOverlap();
+            if (overlap > 0 && size_t(overlap) <= next.size())
+                next = next.Subseq(size_t(overlap));
+            else if (overlap < 0)
+                parts.emplace_back(size_t(-overlap), true);
+            parts.push_back(next);
+        }
+
+        return Sequence::Concat(parts);
+    }
+
+    std::vector<Unitig> buildUnitigs(const AssemblyGraph &graph,
+                                     const std::vector<Chain> &chains,
+                                     const std::atomic<bool> *cancelled,
+                                     std::atomic<size_t> *built) {
+        auto snapshot = graph.adjacency();
+        const Adjacency &adjacency = *snapshot;
+        const NodeStore &nodes = adjacency.nodes();
+
+        std::vector<Unitig> unitigs(chains.size());
+        for (size_t i = 0; i < chains.size(); ++i) {
+            unitigs[i].nodes.reserve(chains[i].size());
+            for (NodeStore::Id id : chains[i])
+                unitigs[i].nodes.push_back(nodes.node(id));
+        }
+
+        QThreadPool pool;
+        pool.setMaxThreadCount(int(g_settings->threadCount()));
+        std::vector<size_t> indices(chains.size());
+        for (size_t i = 0; i < indices.size(); ++i)
+            indices[i] = i;
+
+        QtConcurrent::blockingMap(&pool, indices, [&](size_t i) {
+            if (cancelled != nullptr && *cancelled)
+                return;
+
+            const Chain &chain = chains[i];
+            Unitig &unitig = unitigs[i];
+
+            for (size_t j = 0; j < unitig.nodes.size(); ++j) {
+                if (j > 0)
+                    unitig.name += '_';
+                unitig.name += unitig.nodes[j]->getNameWithoutSign();
+            }
+            unitig.depth = AssemblyGraph::getMeanDepth(unitig.nodes);
+            unitig.sequence = chainSequence(adjacency, chain);
+            if (built != nullptr)
+                ++*built;
+        });
+
+        if (cancelled != nullptr && *cancelled)
+            return {};
+        return unitigs;
+    }
+}
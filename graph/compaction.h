@@ -0,0 +1,66 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "nodestore.h"
+
+#include "seq/sequence.hpp"
+
+#include <QString>
+
+#include <atomic>
+#include <vector>
+
+class AssemblyGraph;
+class DeBruijnNode;
+
+namespace graph {
+    // Maximal non-branching path of nodes (a unitig), in path order
+    using Chain = std::vector<NodeStore::Id>;
+
+    // Finds all chains of two or more nodes in a single pass over the CSR
+    // adjacency. Every complementary pair belongs to at most one chain. Nodes
+    // are visited in the order of the node trie, so the result (including the
+    // strand a chain is reported on) is deterministic.
+    //
+    // Inner nodes of a chain have no edges other than the ones joining them
+    // to their chain neighbours (the reverse complements only have the
+    // complementary ones), so every other edge of the chain nodes touches
+    // the first or the last node and can be moved over to the merged node.
+    std::vector<Chain> findChains(const AssemblyGraph &graph);
+
+    // The node replacing a chain
+    struct Unitig {
+        // Chain nodes, the merged node is the positive strand of this path
+        std::vector<DeBruijnNode *> nodes;
+        // Node names joined by '_', not necessarily unique in the graph
+        QString name;
+        double depth = 0;
+        // Path sequence, edge overlaps are removed
+        Sequence sequence;
+    };
+
+    // Builds merged sequences, names and depths of all chains in parallel
+    // (g_settings->threadCount() threads are used). The graph is not modified.
+    // Chains are skipped once cancelled is set, and nothing is returned then;
+    // built counts the finished chains, for progress reporting.
+    std::vector<Unitig> buildUnitigs(const AssemblyGraph &graph,
+                                     const std::vector<Chain> &chains,
+                                     const std::atomic<bool> *cancelled = nullptr,
+                                     std::atomic<size_t> *built = nullptr);
+}
@@ -18,9 +18,11 @@
 
 #include "debruijnedge.h"
 #include "assemblygraph.h"
+#include "adjacency.h"
 
 #include "program/settings.h"
 
+#include <algorithm>
 #include <cmath>
 #include <QApplication>
 
@@ -90,75 +92,83 @@ bool DeBruijnEdge::isPositiveEdge() const
 }
 
 
+namespace {
+    using NodeId = graph::NodeStore::Id;
+
+    // Paths are traced over the CSR snapshot. A single path buffer is shared
+    // by the whole search, so the only allocations are the reported paths.
+    struct PathTracer {
+        const graph::Adjacency &adjacency;
+        bool forward;
+        NodeId startingNode;
+        std::vector<std::vector<DeBruijnNode *>> &allPaths;
+        std::vector<NodeId> path;
+
+        void report() {
+            std::vector<DeBruijnNode *> &nodes = allPaths.emplace_back();
+            nodes.reserve(path.size());
+            for (NodeId id : path)
+                nodes.push_back(adjacency.nodes().node(id));
+        }
+
+        void trace(NodeId nextNode, int stepsRemaining) {
+            //This can go for a while, so keep the UI responsive.
+            QApplication::processEvents();
+
+            //Add the node to the path so far.
+            path.push_back(nextNode);
+
+            //If there are no steps left, then the path so far is done.
+            //If there are no next edges, then we are finished with the
+            //path search, even though steps remain.
+            auto nextNodes = forward ? adjacency.outNodes(nextNode) : adjacency.inNodes(nextNode);
+            if (--stepsRemaining == 0 || nextNodes.empty()) {
+                report();
+                path.pop_back();
+                return;
+            }
+
+            //Continue with all of the next nodes.
+            //However, we also need to check to see if we are tracing a loop
+            //and stop if that is the case.
+            for (NodeId nextNextNode : nextNodes) {
+                //If that node is the starting node, then we've made
+                //a full loop and the path should be considered complete.
+                if (nextNextNode == startingNode) {
+                    report();
+                    continue;
+                }
+
+                //If that node is already in the path TWICE so far, that means
+                //we're caught in a loop, and we should throw this path out.
+                //If it appears 0 or 1 times, then continue the path search.
+                if (std::count(path.begin(), path.end(), nextNextNode) < 2)
+                    trace(nextNextNode, stepsRemaining);
+            }
+
+            path.pop_back();
+        }
+    };
+}
+
 //This function traces all possible paths from this edge.
 //It proceeds a number of steps, as determined by a setting.
 //If forward is true, it looks in a forward direction (starting nodes to
 //ending nodes).  If forward is false, it looks in a backward direction
 //(ending nodes to starting nodes).
-void DeBruijnEdge::tracePaths(bool forward,
+void DeBruijnEdge::tracePaths(const graph::Adjacency &adjacency,
+                              bool forward,
                               int stepsRemaining,
                               std::vector< std::vector <DeBruijnNode *> > &allPaths,
-                              const DeBruijnNode * startingNode,
-                              std::vector<DeBruijnNode *> pathSoFar) const {
-    //This can go for a while, so keep the UI responsive.
-    QApplication::processEvents();
-
-    //Find the node in the direction we are tracing.
-    DeBruijnNode * nextNode;
-    if (forward)
-        nextNode = m_endingNode;
-    else
-        nextNode = m_startingNode;
-
-    //Add that node to the path so far.
-    pathSoFar.push_back(nextNode);
-
-    //If there are no steps left, then the path so far is done.
-    --stepsRemaining;
-    if (stepsRemaining == 0)
-    {
-        allPaths.push_back(pathSoFar);
-        return;
-    }
-
-    //If the code got here, then more steps remain.
-    //Find the edges that are in the correct direction.
-    std::vector<DeBruijnEdge *> nextEdges = findNextEdgesInPath(nextNode, forward);
-
-    //If there are no next edges, then we are finished with the
-    //path search, even though steps remain.
-    if (nextEdges.empty())
-    {
-        allPaths.push_back(pathSoFar);
+                              const DeBruijnNode * startingNode) const {
+    const graph::NodeStore &nodes = adjacency.nodes();
+    NodeId nextNode = nodes.id(forward ? m_endingNode : m_startingNode);
+    if (nextNode == graph::NodeStore::InvalidId)
         return;
-    }
 
-    //Call this function on all of the next edges.
-    //However, we also need to check to see if we are tracing a loop
-    //and stop if that is the case.
-    for (auto nextEdge : nextEdges)
-    {
-        //Determine the node that this next edge leads to.
-        DeBruijnNode * nextNextNode;
-        if (forward)
-            nextNextNode = nextEdge->m_endingNode;
-        else
-            nextNextNode = nextEdge->m_startingNode;
-
-        //If that node is the starting node, then we've made
-        //a full loop and the path should be considered complete.
-        if (nextNextNode == startingNode)
-        {
-            allPaths.push_back(pathSoFar);
-            continue;
-        }
-
-        //If that node is already in the path TWICE so far, that means
-        //we're caught in a loop, and we should throw this path out.
-        //If it appears 0 or 1 times, then continue the path search.
-        if (timesNodeInPath(nextNextNode, pathSoFar) < 2)
-            nextEdge->tracePaths(forward, stepsRemaining, allPaths, startingNode, pathSoFar);
-    }
+    PathTracer tracer{adjacency, forward, nodes.id(startingNode), allPaths, {}};
+    tracer.path.reserve(size_t(std::max(stepsRemaining, 0)));
+    tracer.trace(nextNode, stepsRemaining);
 }
 
 
@@ -267,6 +277,30 @@ std::vector<DeBruijnEdge *> DeBruijnEdge::findNextEdgesInPath(DeBruijnNode * nex
 }
 
 
+//Whether the last overlap bases of the starting node (of the given length)
+//are the first overlap bases of the ending node. The sequences are fetched
+//by the caller once: a lazily loaded node reads its whole sequence for every
+//getSequence() call.
+static bool sequencesOverlap(const Sequence &start, int startLength,
+                             const Sequence &end, int overlap)
+{
+    int offset = startLength - overlap;
+    if (offset >= 0 && startLength == int(start.size()) && overlap <= int(end.size()))
+        return start.Subseq(offset, startLength) == end.First(overlap);
+
+    //Bases out of range compare as getBaseAt() returns them
+    auto baseAt = [](const Sequence &sequence, int i) {
+        return i >= 0 && i < int(sequence.size()) ? sequence[i] : '\0';
+    };
+    for (int j = 0; j < overlap; ++j)
+    {
+        if (baseAt(start, offset + j) != baseAt(end, j))
+            return false;
+    }
+    return true;
+}
+
+
 //This function tries to automatically determine the overlap size
 //between the two nodes.  It tries each overlap size between the min
 //to the max (in settings), assigning the first one it finds.
@@ -282,13 +316,16 @@ void DeBruijnEdge::autoDetermineExactOverlap()
     int min = std::min(minPossibleOverlap, g_settings->minAutoFindEdgeOverlap);
     int max = std::min(minPossibleOverlap, g_settings->maxAutoFindEdgeOverlap);
 
+    Sequence start = m_startingNode->getSequence(), end = m_endingNode->getSequence();
+    int startLength = m_startingNode->getLength();
+
     //Try each overlap in the range and set the first one found.
     //However, we don't want the search to be biased towards larger
     //or smaller overlaps, so start with a pseudorandom value and loop.
     int testOverlap = min + (rand() % (max - min + 1));
     for (int i = min; i <= max; ++i)
     {
-        if (testExactOverlap(testOverlap))
+        if (sequencesOverlap(start, startLength, end, testOverlap))
         {
             m_overlap = testOverlap;
             return;
@@ -307,20 +344,8 @@ void DeBruijnEdge::autoDetermineExactOverlap()
 //If the overlap works perfectly, it returns true.
 bool DeBruijnEdge::testExactOverlap(int overlap) const
 {
-    bool mismatchFound = false;
-
-    int seq1Offset = m_startingNode->getLength() - overlap;
-
-    //Look at each position in the overlap
-    for (int j = 0; j < overlap && !mismatchFound; ++j)
-    {
-        char a = m_startingNode->getBaseAt(seq1Offset + j);
-        char b = m_endingNode->getBaseAt(j);
-        if (a != b)
-            mismatchFound = true;
-    }
-
-    return !mismatchFound;
+    return sequencesOverlap(m_startingNode->getSequence(), m_startingNode->getLength(),
+                            m_endingNode->getSequence(), overlap);
 }
 
 
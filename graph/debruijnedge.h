@@ -21,6 +21,9 @@
 #include "debruijnnode.h"
 
 class GraphicsItemEdge;
+namespace graph {
+    class Adjacency;
+}
 
 enum EdgeOverlapType {
     UNKNOWN_OVERLAP, EXACT_OVERLAP,
@@ -45,11 +48,11 @@ public:
     EdgeOverlapType getOverlapType() const {return m_overlapType;}
     DeBruijnNode * getOtherNode(const DeBruijnNode * node) const;
     bool testExactOverlap(int overlap) const;
-    void tracePaths(bool forward,
+    void tracePaths(const graph::Adjacency &adjacency,
+                    bool forward,
                     int stepsRemaining,
                     std::vector<std::vector<DeBruijnNode *> > &allPaths,
-                    const DeBruijnNode * startingNode,
-                    std::vector<DeBruijnNode *> pathSoFar = {}) const;
+                    const DeBruijnNode * startingNode) const;
     bool leadsOnlyToNode(bool forward,
                          int stepsRemaining,
                          const DeBruijnNode * target,
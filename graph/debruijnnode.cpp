@@ -19,6 +19,7 @@
 #include "debruijnnode.h"
 #include "debruijnedge.h"
 #include "sequenceutils.h"
+#include "sequencestore.h"
 
 #include "hic/hicedge.h"
 
@@ -47,7 +48,8 @@ DeBruijnNode::DeBruijnNode(const int graphId, QString name, float depth, const S
           m_reverseComplement(nullptr),
           m_graphicsItemNode(nullptr),
           m_specialNode(false),
-          m_drawn(false) {
+          m_drawn(false),
+          m_sequenceIsReverseComplement(false) {
     m_length = length > 0 ? length : sequence.size();
 }
 
@@ -323,18 +325,42 @@ bool DeBruijnNode::isInDepthRange(double min, double max) const
 
 bool DeBruijnNode::sequenceIsMissing() const
 {
+    // Lazy sequences are known to be present in the input
+    if (m_sequenceStore)
+        return false;
+
     return m_sequence.empty() || m_sequence.missing();
 }
 
 
-const Sequence &DeBruijnNode::getSequence() const
+Sequence DeBruijnNode::getSequence() const
 {
+    if (m_sequenceStore)
+        return m_sequenceStore->get(m_sequenceId, m_sequenceIsReverseComplement);
+
     return m_sequence;
 }
 
-Sequence &DeBruijnNode::getSequence()
+void DeBruijnNode::setLazySequence(SequenceStore *store, uint32_t id, bool reverseComplement, unsigned length)
 {
-    return m_sequence;
+    m_sequence = Sequence();
+    m_sequenceStore = store;
+    m_sequenceId = id;
+    m_sequenceIsReverseComplement = reverseComplement;
+    m_length = length;
+}
+
+//Lazy sequences are not read in full for a single base.
+char DeBruijnNode::getBaseAt(int i) const
+{
+    if (i < 0)
+        return '\0';
+    if (m_sequenceStore)
+        return m_sequenceStore->base(m_sequenceId, unsigned(i), m_sequenceIsReverseComplement);
+    if (size_t(i) < m_sequence.size())
+        return m_sequence[i];
+
+    return '\0';
 }
 
 //If the node has an edge which leads to itself (creating a loop), this function
@@ -389,11 +415,12 @@ std::vector<DeBruijnNode *> DeBruijnNode::getAllConnectedPositiveNodes() const
 }
 
 float DeBruijnNode::getGC() const {
+    Sequence sequence = getSequence();
     size_t gc = 0;
-    for (size_t i = 0; i < m_sequence.size(); ++i) {
-        char c = m_sequence[i];
+    for (size_t i = 0; i < sequence.size(); ++i) {
+        char c = sequence[i];
         gc += (c == 'G' || c == 'C');
     }
 
-    return float(gc) / float(m_sequence.size());
+    return float(gc) / float(sequence.size());
 }
@@ -27,6 +27,7 @@
 
 class DeBruijnEdge;
 class GraphicsItemNode;
+class SequenceStore;
 class HiCEdge;
 //class AssemblyGraph;
 
@@ -47,8 +48,10 @@ public:
 
     float getGC() const;
 
-    const Sequence &getSequence() const;
-    Sequence &getSequence();
+    // Sequences of lazily loaded nodes are read from the sequence store on
+    // demand, so the sequence is returned by value
+    Sequence getSequence() const;
+    bool hasLazySequence() const {return m_sequenceStore != nullptr;}
 
     unsigned getLength() const {return m_length;}
     unsigned getLengthWithoutTrailingOverlap() const;
@@ -56,7 +59,7 @@ public:
     QByteArray getFasta(bool sign, bool newLines = true, bool evenIfEmpty = true) const;
     QByteArray getAAFasta(unsigned shift, bool sign, bool newLines, bool evenIfEmpty) const;
 
-    char getBaseAt(int i) const {if (i >= 0 && i < m_sequence.size()) return m_sequence[i]; else return '\0';} // NOTE
+    char getBaseAt(int i) const;
     DeBruijnNode * getReverseComplement() const {return m_reverseComplement;}
     DeBruijnNode *getCanonical() { return isPositiveNode() ? this : m_reverseComplement; }
 
@@ -94,8 +97,9 @@ public:
     DeBruijnEdge *getSelfLoopingEdge() const;
     int getDeadEndCount() const;
 
-    void setSequence(const QByteArray &newSeq) {m_sequence = Sequence(newSeq); m_length = m_sequence.size();}
-    void setSequence(const Sequence &newSeq) {m_sequence = newSeq; m_length = m_sequence.size();}
+    void setSequence(const QByteArray &newSeq) {setSequence(Sequence(newSeq));}
+    void setSequence(const Sequence &newSeq) {m_sequence = newSeq; m_length = m_sequence.size(); m_sequenceStore = nullptr;}
+    void setLazySequence(SequenceStore *store, uint32_t id, bool reverseComplement, unsigned length);
     void setReverseComplement(DeBruijnNode * rc) {m_reverseComplement = rc;}
     void setGraphicsItemNode(GraphicsItemNode * gin) {m_graphicsItemNode = gin;}
     void setAsSpecial() {m_specialNode = true;}
@@ -122,6 +126,8 @@ public:
 private:
     QString m_name;
     Sequence m_sequence;
+    SequenceStore *m_sequenceStore = nullptr;
+    uint32_t m_sequenceId = 0;
     DeBruijnNode * m_reverseComplement;
     adt::SmallPODVector<DeBruijnEdge *> m_edges;
     adt::SmallPODVector<HiCEdge *> m_hicEdges;
@@ -133,6 +139,7 @@ private:
     unsigned m_length = 0;
     bool m_specialNode : 1;
     bool m_drawn : 1;
+    bool m_sequenceIsReverseComplement : 1;
     int m_componentId = 0;
 
     QByteArray getNodeNameForFasta(bool sign) const;
@@ -0,0 +1,405 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "graphicsitembatch.h"
+#include "graphicsitemnode.h"
+#include "graphicsitemedgecommon.h"
+#include "debruijnedge.h"
+#include "debruijnnode.h"
+
+#include "program/settings.h"
+#include "ui/bandagegraphicsscene.h"
+
+#include <QGraphicsScene>
+#include <QStyleOptionGraphicsItem>
+#include <QPainter>
+#include <QPolygonF>
+#include <QLineF>
+#include <QPen>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <tuple>
+
+static QRectF pointsBounds(const QPointF *begin, const QPointF *end) {
+    if (begin == end)
+        return {};
+
+    double left = begin->x(), right = left, top = begin->y(), bottom = top;
+    for (const QPointF *p = begin + 1; p != end; ++p) {
+        left = std::min(left, p->x());
+        right = std::max(right, p->x());
+        top = std::min(top, p->y());
+        bottom = std::max(bottom, p->y());
+    }
+    return { QPointF(left, top), QPointF(right, bottom) };
+}
+
+static double distanceToSegment(QPointF p, QPointF a, QPointF b) {
+    QPointF ab = b - a, ap = p - a;
+    double length2 = QPointF::dotProduct(ab, ab);
+    double t = length2 > 0.0 ? std::clamp(QPointF::dotProduct(ap, ab) / length2, 0.0, 1.0) : 0.0;
+    QPointF d = ap - t * ab;
+    return std::sqrt(QPointF::dotProduct(d, d));
+}
+
+GraphicsItemBatch::GraphicsItemBatch(const std::vector<GraphicsItemNode *> &nodes,
+                                     const std::vector<GraphicsItemEdge *> &edges)
+        : m_nodeCount(nodes.size()) {
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+    setAcceptedMouseButtons(Qt::NoButton);
+    // Below the promoted edges (see promote())
+    setZValue(-2.0);
+
+    m_entries.reserve(nodes.size() + edges.size());
+    m_entryBounds.reserve(nodes.size() + edges.size());
+    for (auto *node : nodes) {
+        auto first = uint32_t(m_points.size());
+        m_points.insert(m_points.end(), node->m_linePoints.begin(), node->m_linePoints.end());
+        m_entries.push_back({ node, first, uint32_t(m_points.size()) });
+        m_entryBounds.push_back(pointsBounds(m_points.data() + first, m_points.data() + m_points.size()));
+        m_margin = std::max(m_margin, node->m_width);
+        node->m_batch = this;
+    }
+    for (auto *edge : edges) {
+        const QPainterPath &path = edge->path();
+        auto first = uint32_t(m_points.size());
+        for (int i = 0; i < path.elementCount(); ++i)
+            m_points.emplace_back(path.elementAt(i));
+        m_entries.push_back({ edge, first, uint32_t(m_points.size()) });
+        m_entryBounds.push_back(pointsBounds(m_points.data() + first, m_points.data() + m_points.size()));
+        m_margin = std::max(m_margin, edge->edgePen().widthF());
+        edge->m_batch = this;
+    }
+    m_state.assign(m_entries.size(), State::Batched);
+    m_selected.assign(m_nodeCount, false);
+
+    m_tree = RTree(m_entryBounds);
+    m_bounds = m_tree.bounds();
+}
+
+GraphicsItemBatch::~GraphicsItemBatch() {
+    // Promoted items belong to the scene
+    for (size_t id = 0; id < m_entries.size(); ++id) {
+        if (m_state[id] == State::Batched)
+            delete m_entries[id].item;
+    }
+
+    // Not a BandageGraphicsScene any more if the scene is being destroyed
+    if (auto *graphicsScene = dynamic_cast<BandageGraphicsScene *>(scene()))
+        graphicsScene->forgetBatch(this);
+}
+
+std::vector<uint32_t> GraphicsItemBatch::query(const QRectF &rect) const {
+    std::vector<uint32_t> result;
+    m_tree.query(rect, [&](uint32_t id) {
+        if (m_state[id] == State::Batched)
+            result.push_back(id);
+    });
+
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+namespace {
+    struct PenKey {
+        QRgb colour;
+        double width;
+        int style;
+
+        bool operator<(const PenKey &other) const {
+            return std::tie(colour, width, style) < std::tie(other.colour, other.width, other.style);
+        }
+    };
+    using BatchedLines = std::map<PenKey, std::vector<QLineF>>;
+}
+
+static void drawBatchedLines(QPainter *painter, const BatchedLines &lines, Qt::PenCapStyle cap) {
+    for (const auto &[key, segments] : lines) {
+        painter->setPen(QPen(QBrush(QColor::fromRgba(key.colour)), key.width,
+                             Qt::PenStyle(key.style), cap, Qt::BevelJoin));
+        painter->drawLines(segments.data(), int(segments.size()));
+    }
+}
+
+void GraphicsItemBatch::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) {
+    double lod = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform());
+    if (lod <= 0.0)
+        return;
+
+    std::vector<uint32_t> visible =
+            query(option->exposedRect.adjusted(-m_margin, -m_margin, m_margin, m_margin));
+    auto split = std::lower_bound(visible.begin(), visible.end(), uint32_t(m_nodeCount));
+
+    auto addSegments = [this](std::vector<QLineF> &segments, const Entry &entry) {
+        for (uint32_t i = entry.first + 1; i < entry.last; ++i)
+            segments.emplace_back(m_points[i - 1], m_points[i]);
+    };
+    auto paintItem = [&](QGraphicsItem *item) {
+        painter->save();
+        item->paint(painter, option, widget);
+        painter->restore();
+    };
+
+    // Edges underneath the nodes
+    BatchedLines lines;
+    std::vector<QGraphicsItem *> detailed;
+    for (auto it = split; it != visible.end(); ++it) {
+        const Entry &entry = m_entries[*it];
+        const QRectF &bounds = m_entryBounds[*it];
+        auto *edge = static_cast<GraphicsItemEdge *>(entry.item);
+        if (std::max(bounds.width(), bounds.height()) * lod >= g_settings->edgeDetailPixels) {
+            detailed.push_back(edge);
+            continue;
+        }
+
+        QPen pen = edge->edgePen();
+        addSegments(lines[{ pen.color().rgba(), pen.widthF(), int(pen.style()) }], entry);
+    }
+    drawBatchedLines(painter, lines, Qt::RoundCap);
+    for (auto *item : detailed)
+        paintItem(item);
+
+    // Zoomed out nodes are lines as wide as the node, rounded to half a
+    // pixel so that nodes of similar depth share a pen. Selected ones are
+    // drawn over a wider line of the selection colour, which shows around
+    // them like the selection outline
+    lines.clear();
+    detailed.clear();
+    BatchedLines selection;
+    for (auto it = visible.begin(); it != split; ++it) {
+        const Entry &entry = m_entries[*it];
+        auto *node = static_cast<GraphicsItemNode *>(entry.item);
+        if (!drawnAsLine(*it, lod)) {
+            detailed.push_back(node);
+            continue;
+        }
+
+        double pixels = std::max(0.5, std::round(node->m_width * lod * 2.0) / 2.0);
+        addSegments(lines[{ node->m_colour.rgba(), pixels / lod, int(Qt::SolidLine) }], entry);
+        if (m_selected[*it] && g_settings->selectionThickness > 0.0)
+            addSegments(selection[{ g_settings->selectionColour.rgba(),
+                                    pixels / lod + g_settings->selectionThickness, int(Qt::SolidLine) }], entry);
+    }
+    drawBatchedLines(painter, selection, Qt::SquareCap);
+    drawBatchedLines(painter, lines, Qt::FlatCap);
+    for (auto *item : detailed)
+        paintItem(item);
+}
+
+QGraphicsItem *GraphicsItemBatch::itemAt(QPointF point, double tolerance) const {
+    double reach = tolerance + m_margin;
+    std::vector<uint32_t> candidates =
+            query(QRectF(point.x() - reach, point.y() - reach, 2.0 * reach, 2.0 * reach));
+
+    auto near = [&](const Entry &entry, double width) {
+        if (entry.last - entry.first == 1)
+            return QLineF(point, m_points[entry.first]).length() <= width / 2.0 + tolerance;
+        for (uint32_t i = entry.first + 1; i < entry.last; ++i) {
+            if (distanceToSegment(point, m_points[i - 1], m_points[i]) <= width / 2.0 + tolerance)
+                return true;
+        }
+        return false;
+    };
+
+    // Nodes are drawn above edges, later entries above earlier ones
+    auto split = std::lower_bound(candidates.begin(), candidates.end(), uint32_t(m_nodeCount));
+    for (auto it = split; it != candidates.begin();) {
+        const Entry &entry = m_entries[*--it];
+        if (near(entry, static_cast<GraphicsItemNode *>(entry.item)->m_width))
+            return entry.item;
+    }
+    for (auto it = candidates.end(); it != split;) {
+        const Entry &entry = m_entries[*--it];
+        if (near(entry, static_cast<GraphicsItemEdge *>(entry.item)->edgePen().widthF()))
+            return entry.item;
+    }
+
+    return nullptr;
+}
+
+std::vector<GraphicsItemNode *> GraphicsItemBatch::nodesIn(const QPolygonF &area) const {
+    std::vector<GraphicsItemNode *> result;
+    for (uint32_t id : query(area.boundingRect())) {
+        if (!isNode(id))
+            break;
+
+        const Entry &entry = m_entries[id];
+        for (uint32_t i = entry.first; i < entry.last; ++i) {
+            if (area.containsPoint(m_points[i], Qt::OddEvenFill)) {
+                result.push_back(static_cast<GraphicsItemNode *>(entry.item));
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+bool GraphicsItemBatch::drawnAsLine(size_t id, double lod) const {
+    const Entry &entry = m_entries[id];
+    auto *node = static_cast<GraphicsItemNode *>(entry.item);
+    return entry.last - entry.first >= 2 && !node->drawnInDetail(lod) && !node->hasDecorations();
+}
+
+bool GraphicsItemBatch::select(const QPolygonF &area) {
+    bool changed = false;
+    for (auto *node : nodesIn(area)) {
+        changed |= !node->isSelected();
+        node->setSelected(true);
+    }
+
+    return changed;
+}
+
+bool GraphicsItemBatch::clearSelection() {
+    bool changed = false;
+    for (size_t id = 0; id < m_nodeCount; ++id) {
+        if (m_selected[id]) {
+            m_entries[id].item->setSelected(false);
+            changed = true;
+        }
+    }
+
+    return changed;
+}
+
+bool GraphicsItemBatch::invertSelection() {
+    bool changed = false;
+    for (size_t id = 0; id < m_nodeCount; ++id) {
+        if (m_state[id] == State::Batched) {
+            m_entries[id].item->setSelected(!m_selected[id]);
+            changed = true;
+        }
+    }
+
+    return changed;
+}
+
+std::vector<GraphicsItemNode *> GraphicsItemBatch::selectedNodes() const {
+    std::vector<GraphicsItemNode *> result;
+    for (size_t id = 0; id < m_nodeCount; ++id) {
+        if (m_selected[id])
+            result.push_back(static_cast<GraphicsItemNode *>(m_entries[id].item));
+    }
+
+    return result;
+}
+
+void GraphicsItemBatch::setSelected(const GraphicsItemNode *node, bool selected) {
+    size_t id = index(node);
+    if (id == m_entries.size() || m_state[id] != State::Batched || m_selected[id] == selected)
+        return;
+
+    m_selected[id] = selected;
+    update(m_entryBounds[id].adjusted(-m_margin, -m_margin, m_margin, m_margin));
+}
+
+void GraphicsItemBatch::promoteSelected() {
+    for (size_t id = 0; id < m_nodeCount; ++id) {
+        if (m_selected[id])
+            promote(m_entries[id].item);
+    }
+}
+
+size_t GraphicsItemBatch::index(const QGraphicsItem *item) const {
+    if (m_lookup.empty()) {
+        m_lookup.reserve(m_entries.size());
+        for (uint32_t id = 0; id < m_entries.size(); ++id)
+            m_lookup.emplace(m_entries[id].item, id);
+    }
+
+    auto it = m_lookup.find(item);
+    return it == m_lookup.end() ? m_entries.size() : it->second;
+}
+
+void GraphicsItemBatch::promote(QGraphicsItem *item) {
+    size_t id = index(item);
+    if (id == m_entries.size() || m_state[id] != State::Batched || !scene())
+        return;
+
+    m_state[id] = State::Promoted;
+    update(m_entryBounds[id].adjusted(-m_margin, -m_margin, m_margin, m_margin));
+    if (!isNode(id)) {
+        item->setZValue(-1.0);
+        scene()->addItem(item);
+        return;
+    }
+
+    // A selected node keeps its flag, the scene keeps track of it from now on
+    m_selected[id] = false;
+    scene()->addItem(item);
+    // Same edges as GraphicsItemNode::fixEdgePaths() moves along
+    auto *node = static_cast<GraphicsItemNode *>(item);
+    for (auto *edge : node->m_deBruijnNode->edges()) {
+        GraphicsItemEdge *graphicsItemEdge = edge->getGraphicsItemEdge();
+        if (!graphicsItemEdge && !g_settings->doubleMode)
+            graphicsItemEdge = edge->getReverseComplement()->getGraphicsItemEdge();
+        if (graphicsItemEdge && graphicsItemEdge->m_batch == this)
+            promote(graphicsItemEdge);
+    }
+}
+
+void GraphicsItemBatch::remove(QGraphicsItem *item) {
+    size_t id = index(item);
+    if (id == m_entries.size() || m_state[id] == State::Removed)
+        return;
+
+    if (m_state[id] == State::Batched)
+        update(m_entryBounds[id].adjusted(-m_margin, -m_margin, m_margin, m_margin));
+    if (isNode(id))
+        m_selected[id] = false;
+    m_state[id] = State::Removed;
+    m_tree.remove(uint32_t(id));
+}
+
+void GraphicsItemBatch::widen(double width) {
+    if (width <= m_margin)
+        return;
+
+    prepareGeometryChange();
+    m_margin = width;
+}
+
+void GraphicsItemBatch::moved(QGraphicsItem *item) {
+    size_t id = index(item);
+    if (id == m_entries.size() || m_state[id] != State::Promoted)
+        return;
+
+    QRectF bounds;
+    if (isNode(id)) {
+        const auto &linePoints = static_cast<GraphicsItemNode *>(item)->m_linePoints;
+        bounds = pointsBounds(linePoints.cdata(), linePoints.cdata() + linePoints.size());
+    } else
+        bounds = static_cast<GraphicsItemEdge *>(item)->path().controlPointRect();
+    m_tree.update(uint32_t(id), bounds);
+
+    QRectF treeBounds = m_tree.bounds();
+    if (treeBounds != m_bounds) {
+        prepareGeometryChange();
+        m_bounds = treeBounds;
+    }
+}
+
+void GraphicsItemBatch::prepareOutlines(double lod) const {
+    // Selected nodes drawn as lines do not need one
+    for (size_t id = 0; id < m_nodeCount; ++id) {
+        if (m_state[id] == State::Batched && !(m_selected[id] && drawnAsLine(id, lod)))
+            static_cast<GraphicsItemNode *>(m_entries[id].item)->prepareOutlines(lod);
+    }
+}
@@ -0,0 +1,127 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "rtree.h"
+
+#include <QGraphicsItem>
+#include <QPointF>
+#include <QPolygonF>
+#include <QRectF>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class GraphicsItemNode;
+class GraphicsItemEdge;
+
+// A single scene item drawing the nodes and edges of a very large graph (see
+// Settings::batchedSceneNodes), so they do not have to be added to the scene
+// and its index one by one. Their geometry is copied into flat arrays and
+// an R-tree over their bounds, which culls painting and answers picking and
+// rubber band queries, so the scene itself runs without an index. Zoomed
+// out, nodes and edges are drawn as lines batched by pen; otherwise, or if a
+// node has labels, annotations or path highlighting, the item's own paint()
+// is called.
+//
+// The batch owns its items until they are promoted: a promoted item is added
+// to the scene and from then on is drawn, selected and moved as usual. Nodes
+// are promoted together with their edges when they are clicked or dragged.
+// Promoted items stay in the tree and follow it when dragged, so the batch
+// bounds still cover them. Batched items are not in the scene, so
+// QGraphicsScene::selectedItems() and items() only ever see the promoted
+// ones: selected batched nodes are tracked (and drawn with the selection
+// pen) by the batch itself.
+class GraphicsItemBatch : public QGraphicsItem {
+public:
+    // Nodes and edges in the order they would have been added to the scene
+    GraphicsItemBatch(const std::vector<GraphicsItemNode *> &nodes,
+                      const std::vector<GraphicsItemEdge *> &edges);
+    ~GraphicsItemBatch() override;
+
+    QRectF boundingRect() const override { return m_bounds.adjusted(-m_margin, -m_margin, m_margin, m_margin); }
+    // Empty, so the scene never finds the batch itself under the cursor
+    QPainterPath shape() const override { return {}; }
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+    // Batched node or edge within tolerance of the point, nodes first and
+    // topmost first. nullptr if there is none
+    QGraphicsItem *itemAt(QPointF point, double tolerance) const;
+    // Batched nodes with a line point inside the area
+    std::vector<GraphicsItemNode *> nodesIn(const QPolygonF &area) const;
+
+    // Select the batched nodes with a line point inside the area, returns
+    // whether the selection changed
+    bool select(const QPolygonF &area);
+    // Deselect (or invert the selection of) all batched nodes, returns
+    // whether the selection changed
+    bool clearSelection();
+    bool invertSelection();
+    // Selected nodes that are still batched
+    std::vector<GraphicsItemNode *> selectedNodes() const;
+    // Record the selection of a batched node, see GraphicsItemNode::itemChange()
+    void setSelected(const GraphicsItemNode *node, bool selected);
+    // Promote the selected batched nodes, so they can be dragged
+    void promoteSelected();
+
+    // Hand the item over to the scene. Nodes bring their edges along, so
+    // the edges follow when the node is moved
+    void promote(QGraphicsItem *item);
+    // Forget a batched item that is about to be deleted
+    void remove(QGraphicsItem *item);
+    // Keep the bounding rectangle wide enough for the node width
+    void widen(double width);
+    // A promoted item was moved: update its bounds in the tree
+    void moved(QGraphicsItem *item);
+    // See GraphicsItemNode::prepareOutlines()
+    void prepareOutlines(double lod) const;
+
+private:
+    enum class State : uint8_t { Batched, Promoted, Removed };
+
+    // Points [first, last) of m_points, the line points of a node or the
+    // points of an edge path
+    struct Entry {
+        QGraphicsItem *item;
+        uint32_t first, last;
+    };
+
+    size_t index(const QGraphicsItem *item) const;
+    bool isNode(size_t id) const { return id < m_nodeCount; }
+    // Whether paint() draws the batched node as a plain line
+    bool drawnAsLine(size_t id, double lod) const;
+    // Ids of the batched entries whose bounds intersect the rect, in order
+    std::vector<uint32_t> query(const QRectF &rect) const;
+
+    std::vector<Entry> m_entries; // nodes, then edges
+    size_t m_nodeCount;
+    std::vector<QPointF> m_points;
+    std::vector<QRectF> m_entryBounds;
+    std::vector<State> m_state;
+    // Selected batched nodes
+    std::vector<bool> m_selected;
+
+    // Batched and promoted entries, promoted ones at their current place
+    RTree m_tree;
+    QRectF m_bounds;
+    double m_margin = 0.0;
+
+    // Built on first use
+    mutable std::unordered_map<const QGraphicsItem *, uint32_t> m_lookup;
+};
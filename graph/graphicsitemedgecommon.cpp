@@ -1,5 +1,6 @@
 #include "graphicsitemedgecommon.h"
 #include "graphicsitemnode.h"
+#include "graphicsitembatch.h"
 #include "debruijnedge.h"
 #include "debruijnnode.h"
 
@@ -10,11 +11,15 @@
 
 #include <QPainterPathStroker>
 #include <QGraphicsPathItem>
+#include <QStyleOptionGraphicsItem>
+#include <QVarLengthArray>
 #include <QPainter>
 #include <QPen>
 #include <QLineF>
 #include <QBrush>
 
+#include <algorithm>
+
 GraphicsItemEdgeCommon::GraphicsItemEdgeCommon(QGraphicsItem * parent)
     : QGraphicsPathItem(parent)
 {}
@@ -108,6 +113,22 @@ void GraphicsItemEdgeCommon::calculateAndSetPath(DeBruijnNode* startingNode, DeB
     setPath(path);
 }
 
+// Zoomed out to a few pixels (see Settings::edgeDetailPixels), the curves of
+// an edge are drawn as the polyline through their points.
+static void drawEdgePath(QPainter *painter, const QPainterPath &path) {
+    QRectF bounds = path.controlPointRect();
+    double lod = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform());
+    if (std::max(bounds.width(), bounds.height()) * lod >= g_settings->edgeDetailPixels) {
+        painter->drawPath(path);
+        return;
+    }
+
+    QVarLengthArray<QPointF, 8> polyline;
+    for (int i = 0; i < path.elementCount(); ++i)
+        polyline.append(path.elementAt(i));
+    painter->drawPolyline(polyline.constData(), int(polyline.size()));
+}
+
 GraphicsItemEdge::GraphicsItemEdge(DeBruijnEdge * deBruijnEdge, QGraphicsItem * parent)
     : GraphicsItemEdgeCommon(parent), m_deBruijnEdge(deBruijnEdge) {
     //m_edgeColor = g_assemblyGraph->getCustomColour(deBruijnEdge);
@@ -120,11 +141,14 @@ GraphicsItemEdge::GraphicsItemEdge(DeBruijnEdge * deBruijnEdge, QGraphicsItem *
     remakePath();
 }
 
-void GraphicsItemEdge::paint(QPainter * painter, const QStyleOptionGraphicsItem *, QWidget *) {
+QPen GraphicsItemEdge::edgePen() const {
     QColor penColour = isSelected() ? g_settings->selectionColour : m_edgeColor;
-    QPen edgePen(QBrush(penColour), m_width, m_penStyle, Qt::RoundCap);
-    painter->setPen(edgePen);
-    painter->drawPath(path());
+    return QPen(QBrush(penColour), m_width, m_penStyle, Qt::RoundCap);
+}
+
+void GraphicsItemEdge::paint(QPainter * painter, const QStyleOptionGraphicsItem *, QWidget *) {
+    painter->setPen(edgePen());
+    drawEdgePath(painter, path());
 }
 
 void GraphicsItemEdge::remakePath() {
@@ -139,6 +163,9 @@ void GraphicsItemEdge::remakePath() {
                 beforeStartLocation,
                 endLocation,
                 afterEndLocation);
+
+    if (m_batch)
+        m_batch->moved(this);
 }
 
 void GraphicsItemEdge::getControlPointLocations(const DeBruijnEdge *edge,
@@ -183,7 +210,7 @@ void GraphicsItemHiCEdge::paint(QPainter * painter, const QStyleOptionGraphicsIt
     penColour.setRgb(dark, dark, dark);
     QPen edgePen(QBrush(penColour), g_settings->edgeWidth, Qt::DotLine, Qt::RoundCap);
     painter->setPen(edgePen);
-    painter->drawPath(path());
+    drawEdgePath(painter, path());
 }
 
 QPainterPath GraphicsItemHiCEdge::shape() const {
@@ -2,9 +2,11 @@
 #define GRAPHICSITEMEDGECOMMON_H
 
 #include <QGraphicsPathItem>
+#include <QPen>
 
 class DeBruijnEdge;
 class DeBruijnNode;
+class GraphicsItemBatch;
 class HiCEdge;
 
 class GraphicsItemEdgeCommon : public QGraphicsPathItem {
@@ -35,6 +37,10 @@ public:
     explicit GraphicsItemEdge(DeBruijnEdge * deBruijnEdge, QGraphicsItem * parent = nullptr);
     void paint(QPainter * painter, const QStyleOptionGraphicsItem *, QWidget *) override;
     QPainterPath shape() const override;
+    QPen edgePen() const;
+
+    // Batch drawing the edge while it is not in the scene itself, if any
+    GraphicsItemBatch * m_batch = nullptr;
 
     void remakePath();
     DeBruijnEdge *edge() const { return m_deBruijnEdge; }
@@ -18,6 +18,7 @@
 
 #include "graphicsitemnode.h"
 #include "graphicsitemedgecommon.h"
+#include "graphicsitembatch.h"
 #include "debruijnnode.h"
 #include "debruijnedge.h"
 #include "assemblygraph.h"
@@ -36,6 +37,7 @@
 #include <QPainterPathStroker>
 #include <QPainter>
 #include <QPen>
+#include <QStyleOptionGraphicsItem>
 #include <QMessageBox>
 #include <QFontMetrics>
 
@@ -107,6 +109,8 @@ void GraphicsItemNode::setWidth(double depthRelativeToMeanDrawnDepth, double ave
                            depthPower, depthEffectOnWidth, averageNodeWidth);
     if (m_width < 0.0)
         m_width = 0.0;
+    if (m_batch)
+        m_batch->widen(m_width);
 }
 
 static bool anyNodeDisplayText() {
@@ -127,17 +131,30 @@ void GraphicsItemNode::paint(QPainter * painter, const QStyleOptionGraphicsItem
 //    painter->setPen(QPen(Qt::black, 1.0));
 //    painter->drawRect(boundingRect());
 
-    QPainterPath outlinePath = shape();
+    //Zoomed out, the node only covers a few pixels: draw it as a plain line
+    //without the outline and the arrowhead. Selected nodes are always drawn
+    //in full so the selection stays visible.
+    bool detailed = isSelected() || m_linePoints.size() < 2 || drawnInDetail(*painter);
+    if (detailed)
+    {
+        const QPainterPath &outlinePath = outline();
 
-    //Fill the node's colour
-    QBrush brush(m_colour);
-    painter->fillPath(outlinePath, brush);
+        //Fill the node's colour
+        QBrush brush(m_colour);
+        painter->fillPath(outlinePath, brush);
 
-    //If the node has an arrow, then it's necessary to use the outline
-    //as a clipping path so the colours don't extend past the edge of the
-    //node.
-    if (m_hasArrow)
-        painter->setClipPath(outlinePath);
+        //If the node has an arrow, then it's necessary to use the outline
+        //as a clipping path so the colours don't extend past the edge of the
+        //node.
+        if (m_hasArrow)
+            painter->setClipPath(outlinePath);
+    }
+    else
+    {
+        painter->setPen(QPen(QBrush(m_colour), m_width, Qt::SolidLine,
+                             Qt::FlatCap, Qt::BevelJoin));
+        painter->drawPolyline(m_linePoints.cdata(), int(m_linePoints.size()));
+    }
 
     for (const auto &annotationGroup : g_annotationsManager->getGroups()) {
         auto annotationSettings = g_settings->annotationsSettings[annotationGroup->id];
@@ -164,13 +181,12 @@ void GraphicsItemNode::paint(QPainter * painter, const QStyleOptionGraphicsItem
         outlineColour = g_settings->selectionColour;
         outlineThickness = g_settings->selectionThickness;
     }
-    if (outlineThickness > 0.0)
+    if (detailed && outlineThickness > 0.0)
     {
-        outlinePath = outlinePath.simplified();
         QPen outlinePen(QBrush(outlineColour), outlineThickness, Qt::SolidLine,
                         Qt::SquareCap, Qt::RoundJoin);
         painter->setPen(outlinePen);
-        painter->drawPath(outlinePath);
+        painter->drawPath(simplifiedOutline());
     }
 
 
@@ -266,6 +282,11 @@ void GraphicsItemNode::drawTextPathAtLocation(QPainter * painter, const QPainter
 }
 
 QPainterPath GraphicsItemNode::shape() const
+{
+    return outline();
+}
+
+QPainterPath GraphicsItemNode::makeOutline() const
 {
 
     //If there is only one segment, and it is shorter than half its
@@ -370,6 +391,8 @@ void GraphicsItemNode::mouseMoveEvent(QGraphicsSceneMouseEvent * event)
             double alpha = angleBetweenTwoLines(centralPos, lastPos, centralPos, newPos);
             roundPoints(centralPos, alpha);
             remakePath();
+            if (m_batch)
+                m_batch->moved(this);
             graphicsScene->possiblyExpandSceneRectangle(&nodesToMove);
 
             fixEdgePaths(&nodesToMove);
@@ -393,6 +416,8 @@ void GraphicsItemNode::mouseMoveEvent(QGraphicsSceneMouseEvent * event)
         {
             node->shiftPoints(difference);
             node->remakePath();
+            if (node->m_batch)
+                node->m_batch->moved(node);
             if (graphId != -1 && allNodesFromOneGraph && node->m_deBruijnNode->getGraphId() != graphId) {
                 allNodesFromOneGraph == false;
             }
@@ -510,6 +535,49 @@ QSize GraphicsItemNode::getNodeTextSize(const QString& text)
     return fontMetrics.size(0, text);
 }
 
+bool GraphicsItemNode::hasDecorations() const
+{
+    if (anyNodeDisplayText() || g_memory->pathDialogIsVisible || g_memory->queryPathDialogIsVisible)
+        return true;
+
+    for (const auto &annotationGroup : g_annotationsManager->getGroups()) {
+        if (!annotationGroup->getAnnotations(m_deBruijnNode).empty())
+            return true;
+        if (!g_settings->doubleMode &&
+            !annotationGroup->getAnnotations(m_deBruijnNode->getReverseComplement()).empty())
+            return true;
+    }
+
+    return false;
+}
+
+//A batched node stays out of the scene when selected, its batch keeps track
+//of the selection instead.
+QVariant GraphicsItemNode::itemChange(GraphicsItemChange change, const QVariant &value)
+{
+    if (change == ItemSelectedChange && m_batch && !scene())
+        m_batch->setSelected(this, value.toBool());
+
+    return CommonGraphicsItemNode::itemChange(change, value);
+}
+
+bool GraphicsItemNode::drawnInDetail(const QPainter &painter) const
+{
+    return drawnInDetail(QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter.worldTransform()));
+}
+
+bool GraphicsItemNode::drawnInDetail(double lod) const
+{
+    return m_width * lod >= g_settings->nodeDetailPixels;
+}
+
+void GraphicsItemNode::prepareOutlines(double lod) const
+{
+    // Same test as in paint()
+    if (isSelected() || m_linePoints.size() < 2 || drawnInDetail(lod))
+        simplifiedOutline();
+}
+
 //The bounding rectangle of a node has to be a little bit bigger than
 //the node's path, because of the outline.  The selection outline is
 //the largest outline we can expect, so use that to define the bounding
@@ -517,7 +585,7 @@ QSize GraphicsItemNode::getNodeTextSize(const QString& text)
 QRectF GraphicsItemNode::boundingRect() const
 {
     double extraSize = g_settings->selectionThickness / 2.0;
-    QRectF bound = shape().boundingRect();
+    QRectF bound = outline().boundingRect();
 
     bound.setTop(bound.top() - extraSize);
     bound.setBottom(bound.bottom() + extraSize);
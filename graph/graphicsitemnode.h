@@ -33,6 +33,7 @@
 #include <vector>
 
 class DeBruijnNode;
+class GraphicsItemBatch;
 class Path;
 
 class GraphicsItemNode : public CommonGraphicsItemNode
@@ -51,6 +52,8 @@ public:
                      QGraphicsItem * parent = nullptr);
 
     DeBruijnNode * m_deBruijnNode;
+    // Batch drawing the node while it is not in the scene itself, if any
+    GraphicsItemBatch * m_batch = nullptr;
 
     static QSize getNodeTextSize(const QString& text);
     static float getNodeWidth(double depthRelativeToMeanDrawnDepth,
@@ -69,10 +72,25 @@ public:
                   double averageNodeWidth = 5.0,
                   double depthPower = 0.5, double depthEffectOnWidth = 0.5);
     QRectF boundingRect() const override;
+    // Whether the node is wide enough on the painter's device to be drawn in
+    // full detail (see Settings::nodeDetailPixels)
+    bool drawnInDetail(const QPainter &painter) const;
+    bool drawnInDetail(double lod) const;
+    // Make the outlines paint() uses at the level of detail up front. They
+    // are otherwise cached on first use, which is not safe when the scene is
+    // painted from several threads
+    void prepareOutlines(double lod) const;
+    // Whether paint() draws more than the node itself: labels, annotations
+    // or path highlighting
+    bool hasDecorations() const;
     void fixEdgePaths(std::vector<GraphicsItemNode *> * nodes = nullptr) const;
     double indexToFraction(int64_t pos) const;
     void fixHiCEdgePaths(std::vector<GraphicsItemNode *> * nodes) const;
 
+protected:
+    QPainterPath makeOutline() const override;
+    QVariant itemChange(GraphicsItemChange change, const QVariant &value) override;
+
 private:
     void exactPathHighlightNode(QPainter * painter);
     void queryPathHighlightNode(QPainter * painter);
@@ -0,0 +1,321 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "graphstats.h"
+
+#include "adjacency.h"
+#include "assemblygraph.h"
+#include "debruijnedge.h"
+#include "debruijnnode.h"
+#include "nodestore.h"
+
+#include "program/settings.h"
+
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+namespace graph {
+    namespace {
+        // Union-find safe for concurrent unite() calls. Roots are always
+        // linked to the smaller index, so the parent links never form a
+        // cycle and a lost race simply retries from the new roots.
+        class ConcurrentUnionFind {
+        public:
+            explicit ConcurrentUnionFind(size_t size)
+                    : m_parent(size) {
+                for (size_t i = 0; i < size; ++i)
+                    m_parent[i].store(uint32_t(i), std::memory_order_relaxed);
+            }
+
+            uint32_t find(uint32_t x) {
+                while (true) {
+                    uint32_t parent = m_parent[x].load(std::memory_order_relaxed);
+                    if (parent == x)
+                        return x;
+                    // Path halving
+                    uint32_t grandparent = m_parent[parent].load(std::memory_order_relaxed);
+                    if (grandparent != parent)
+                        m_parent[x].compare_exchange_weak(parent, grandparent, std::memory_order_relaxed);
+                    x = grandparent;
+                }
+            }
+
+            void unite(uint32_t a, uint32_t b) {
+                while (true) {
+                    a = find(a); b = find(b);
+                    if (a == b)
+                        return;
+                    if (a < b)
+                        std::swap(a, b);
+                    if (m_parent[a].compare_exchange_strong(a, b, std::memory_order_relaxed))
+                        return;
+                }
+            }
+
+        private:
+            std::vector<std::atomic<uint32_t>> m_parent;
+        };
+
+        struct NodeTotals {
+            unsigned deadEnds = 0;
+            long long totalLength = 0;
+            long long totalLengthNoOverlaps = 0;
+            long long totalLengthOrphanedNodes = 0;
+        };
+
+        struct OverlapRange {
+            int smallest = std::numeric_limits<int>::max();
+            int largest = 0;
+        };
+
+        struct WeightedDepth {
+            double depth;
+            uint32_t length;
+        };
+    }
+
+    static constexpr size_t BlockSize = 16384;
+
+    static size_t blockCount(size_t size) {
+        return (size + BlockSize - 1) / BlockSize;
+    }
+
+    // Runs f(begin, end, block) for the blocks of [0, size)
+    template<class F>
+    static void parallelBlocks(QThreadPool &pool, size_t size, F f) {
+        std::vector<size_t> blocks(blockCount(size));
+        std::iota(blocks.begin(), blocks.end(), 0);
+        QtConcurrent::blockingMap(&pool, blocks, [&](size_t block) {
+            f(block * BlockSize, std::min((block + 1) * BlockSize, size), block);
+        });
+    }
+
+    // Same as interpolating v[floor(index)] and v[floor(index) + 1] of the
+    // sorted vector, but only partially orders v
+    template<class T>
+    static double quantile(std::vector<T> &v, double index) {
+        if (v.empty())
+            return 0.0;
+        if (v.size() == 1)
+            return double(v.front());
+
+        auto wholePart = ptrdiff_t(std::floor(index));
+        if (wholePart < 0)
+            return double(*std::min_element(v.begin(), v.end()));
+        if (wholePart >= ptrdiff_t(v.size()) - 1)
+            return double(*std::max_element(v.begin(), v.end()));
+
+        double fractionalPart = index - double(wholePart);
+        auto nth = v.begin() + wholePart;
+        std::nth_element(v.begin(), nth, v.end());
+        double piece1 = double(*nth);
+        double piece2 = double(*std::min_element(nth + 1, v.end()));
+
+        return piece1 * (1.0 - fractionalPart) + piece2 * fractionalPart;
+    }
+
+    // Returns the first element (in the order defined by less) at which the
+    // running sum of weights reaches the threshold, or end if the total weight
+    // is smaller. Expected linear time, the range is partially reordered.
+    template<class It, class Less, class Weight>
+    static It weightedSelect(It begin, It end, Less less, Weight weight, double threshold) {
+        It notFound = end;
+        while (end - begin > 1) {
+            It mid = begin + (end - begin) / 2;
+            std::nth_element(begin, mid, end, less);
+
+            double left = 0;
+            for (It it = begin; it != mid; ++it)
+                left += double(weight(*it));
+            if (left >= threshold) {
+                end = mid;
+                continue;
+            }
+
+            threshold -= left;
+            if (double(weight(*mid)) >= threshold)
+                return mid;
+            threshold -= double(weight(*mid));
+            begin = mid + 1;
+        }
+
+        if (begin != end && double(weight(*begin)) >= threshold)
+            return begin;
+        return notFound;
+    }
+
+    static double depthAtIndex(std::vector<WeightedDepth> &depths, long long targetIndex) {
+        auto it = weightedSelect(depths.begin(), depths.end(),
+                                 [](const WeightedDepth &a, const WeightedDepth &b) { return a.depth < b.depth; },
+                                 [](const WeightedDepth &d) { return d.length; },
+                                 double(targetIndex + 1));
+        return it != depths.end() ? it->depth : 0.0;
+    }
+
+    Statistics computeStatistics(const AssemblyGraph &graph) {
+        Statistics stats;
+        auto snapshot = graph.adjacency();
+        const Adjacency &adjacency = *snapshot;
+        const NodeStore &nodes = adjacency.nodes();
+
+        QThreadPool pool;
+        pool.setMaxThreadCount(int(g_settings->threadCount()));
+
+        std::vector<NodeStore::Id> positive;
+        positive.reserve(nodes.size() / 2);
+        for (NodeStore::Id id = 0; id < nodes.size(); ++id) {
+            if (nodes.exists(id) && !nodes.isNegative(id))
+                positive.push_back(id);
+        }
+
+        // Edge overlaps. Both edges of a complementary pair are counted, same
+        // as AssemblyGraph::getOverlapRange() does.
+        std::vector<int> overlaps(adjacency.edgeCount());
+        std::vector<OverlapRange> overlapRanges(blockCount(overlaps.size()));
+        parallelBlocks(pool, overlaps.size(), [&](size_t begin, size_t end, size_t block) {
+            OverlapRange &range = overlapRanges[block];
+            for (size_t edge = begin; edge < end; ++edge) {
+                int overlap = overlaps[edge] = adjacency.edge(Adjacency::EdgeId(edge))->getOverlap();
+                range.smallest = std::min(range.smallest, overlap);
+                range.largest = std::max(range.largest, overlap);
+            }
+        });
+        OverlapRange overlapRange;
+        for (const auto &range : overlapRanges) {
+            overlapRange.smallest = std::min(overlapRange.smallest, range.smallest);
+            overlapRange.largest = std::max(overlapRange.largest, range.largest);
+        }
+        stats.smallestOverlap = overlapRange.smallest == std::numeric_limits<int>::max() ? 0 : overlapRange.smallest;
+        stats.largestOverlap = overlapRange.largest;
+
+        // Per-node attributes and totals
+        std::vector<uint32_t> lengths(positive.size()), trailingLengths(positive.size());
+        std::vector<WeightedDepth> depths(positive.size());
+        std::vector<NodeTotals> blockTotals(blockCount(positive.size()));
+        parallelBlocks(pool, positive.size(), [&](size_t begin, size_t end, size_t block) {
+            NodeTotals &totals = blockTotals[block];
+            for (size_t i = begin; i < end; ++i) {
+                NodeStore::Id id = positive[i];
+                uint32_t length = nodes.length(id);
+                lengths[i] = length;
+                depths[i] = { nodes.node(id)->getDepth(), length };
+
+                int maxOutgoingOverlap = 0, maxOverlap = 0;
+                for (auto edge : adjacency.outEdges(id))
+                    maxOutgoingOverlap = std::max(maxOutgoingOverlap, overlaps[edge]);
+                for (auto edge : adjacency.inEdges(id))
+                    maxOverlap = std::max(maxOverlap, overlaps[edge]);
+                maxOverlap = std::max(maxOverlap, maxOutgoingOverlap);
+                trailingLengths[i] = unsigned(maxOutgoingOverlap) > length ? 0 : length - unsigned(maxOutgoingOverlap);
+
+                // Same as DeBruijnNode::getDeadEndCount()
+                uint32_t outDegree = adjacency.outDegree(id), inDegree = adjacency.inDegree(id);
+                unsigned deadEnds = (outDegree + inDegree == 0) ? 2 : (outDegree && inDegree) ? 0 : 1;
+
+                totals.deadEnds += deadEnds;
+                totals.totalLength += length;
+                totals.totalLengthNoOverlaps += (long long)length - maxOverlap;
+                if (deadEnds == 2)
+                    totals.totalLengthOrphanedNodes += length;
+            }
+        });
+        for (const auto &totals : blockTotals) {
+            stats.deadEnds += totals.deadEnds;
+            stats.totalLength += totals.totalLength;
+            stats.totalLengthNoOverlaps += totals.totalLengthNoOverlaps;
+            stats.totalLengthOrphanedNodes += totals.totalLengthOrphanedNodes;
+        }
+
+        stats.nodeCount = int(positive.size());
+        stats.edgeCount = graph.m_edgeCount;
+        stats.percentageDeadEnds = 100.0 * double(stats.deadEnds) / (2 * stats.nodeCount);
+
+        // Connected components over the complementary pairs
+        {
+            ConcurrentUnionFind components(nodes.size() / 2);
+            parallelBlocks(pool, adjacency.edgeCount(), [&](size_t begin, size_t end, size_t) {
+                for (size_t edge = begin; edge < end; ++edge)
+                    components.unite(adjacency.source(Adjacency::EdgeId(edge)) / 2,
+                                     adjacency.target(Adjacency::EdgeId(edge)) / 2);
+            });
+
+            std::vector<long long> componentLengths(nodes.size() / 2, -1);
+            for (size_t i = 0; i < positive.size(); ++i) {
+                long long &componentLength = componentLengths[components.find(positive[i] / 2)];
+                if (componentLength < 0) {
+                    componentLength = 0;
+                    ++stats.componentCount;
+                }
+                componentLength += lengths[i];
+                stats.largestComponentLength = std::max(stats.largestComponentLength, componentLength);
+            }
+        }
+
+        if (stats.totalLength == 0)
+            return stats;
+
+        // Node length distribution
+        auto [shortest, longest] = std::minmax_element(lengths.begin(), lengths.end());
+        stats.shortestNode = int(*shortest);
+        stats.longestNode = int(*longest);
+        stats.firstQuartile = int(std::round(quantile(lengths, double(lengths.size() - 1) / 4.0)));
+        stats.median = int(std::round(quantile(lengths, double(lengths.size() - 1) / 2.0)));
+        stats.thirdQuartile = int(std::round(quantile(lengths, double(lengths.size() - 1) * 3.0 / 4.0)));
+
+        auto n50 = weightedSelect(lengths.begin(), lengths.end(),
+                                  std::greater<uint32_t>(), [](uint32_t length) { return length; },
+                                  double(stats.totalLength) / 2.0);
+        if (n50 != lengths.end())
+            stats.n50 = int(*n50);
+
+        // Median depth by base. The depths are needed below in the node order,
+        // so the selection works on a copy.
+        if (depths.size() == 1) {
+            stats.medianDepthByBase = depths.front().depth;
+        } else {
+            std::vector<WeightedDepth> byBase(depths);
+            if (stats.totalLength % 2 == 0) {
+                double depth1 = depthAtIndex(byBase, stats.totalLength / 2 - 1);
+                double depth2 = depthAtIndex(byBase, stats.totalLength / 2);
+                stats.medianDepthByBase = (depth1 + depth2) / 2.0;
+            } else
+                stats.medianDepthByBase = depthAtIndex(byBase, (stats.totalLength - 1) / 2);
+        }
+
+        if (stats.medianDepthByBase == 0.0)
+            return stats;
+
+        std::vector<long long> estimates(blockCount(positive.size()), 0);
+        parallelBlocks(pool, positive.size(), [&](size_t begin, size_t end, size_t block) {
+            long long &estimate = estimates[block];
+            for (size_t i = begin; i < end; ++i) {
+                auto closestIntegerDepth = (long long)std::round(depths[i].depth / stats.medianDepthByBase);
+                estimate += trailingLengths[i] * closestIntegerDepth;
+            }
+        });
+        stats.estimatedSequenceLength = std::accumulate(estimates.begin(), estimates.end(), 0LL);
+
+        return stats;
+    }
+}
@@ -21,6 +21,7 @@
 
 #include "io/gfa.h"
 #include "io/gaf.h"
+#include "io/linereader.h"
 
 #include <csv/csv.hpp>
 
@@ -34,17 +35,16 @@ namespace io {
         std::string prefix = "";
         if (g_settings->multyGraphMode)
             prefix = std::to_string(graph.getGraphId()) + "_";
-        QFile inputFile(fileName);
-        if (!inputFile.open(QIODevice::ReadOnly))
+        LineReader reader(fileName.toStdString());
+        if (!reader.isOpen())
             return false;
 
-        QTextStream in(&inputFile);
-        while (!in.atEnd()) {
-            QByteArray line = in.readLine().toLatin1();
-            if (line.length() == 0)
+        std::string_view line;
+        while (reader.readLine(line)) {
+            if (line.empty())
                 continue;
 
-            auto val = gfa::parseRecord(line.data(), line.length());
+            auto val = gfa::parseRecord(line.data(), line.size());
             if (!val)
                 continue;
 
@@ -68,17 +68,16 @@ namespace io {
         std::string prefix = "";
         if (g_settings->multyGraphMode)
             prefix = std::to_string(graph.getGraphId()) + "_";
-        QFile inputFile(fileName);
-        if (!inputFile.open(QIODevice::ReadOnly))
+        LineReader reader(fileName.toStdString());
+        if (!reader.isOpen())
             return false;
 
-        QTextStream in(&inputFile);
-        while (!in.atEnd()) {
-            QByteArray line = in.readLine().toLatin1();
-            if (line.length() == 0)
+        std::string_view line;
+        while (reader.readLine(line)) {
+            if (line.empty())
                 continue;
 
-            auto path = gaf::parseRecord(line.data(), line.length());
+            auto path = gaf::parseRecord(line.data(), line.size());
             if (!path)
                 continue;
 
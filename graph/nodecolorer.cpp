@@ -19,6 +19,7 @@
 #include "nodecolorers.h"
 
 #include "assemblygraph.h"
+#include "adjacency.h"
 #include "debruijnnode.h"
 #include "graphicsitemnode.h"
 
@@ -244,6 +245,12 @@ void ContiguityNodeColorer::determineContiguity(DeBruijnNode* node) {
     //to this node.
     std::set<DeBruijnNode *> allCheckedNodes;
 
+    const AssemblyGraph *graph = m_graphs.data()->m_graphMap.value(node->getGraphId());
+    if (!graph)
+        return;
+    auto snapshot = graph->adjacency();
+    const auto &adjacency = *snapshot;
+
     //For each path leaving this node, find all possible paths
     //outward.  Nodes in any of the paths for an edge are
     //MAYBE_CONTIGUOUS.  Nodes in all of the paths for an edge
@@ -252,7 +259,7 @@ void ContiguityNodeColorer::determineContiguity(DeBruijnNode* node) {
         bool outgoingEdge = (node == edge->getStartingNode());
 
         std::vector<std::vector<DeBruijnNode *>> allPaths;
-        edge->tracePaths(outgoingEdge, g_settings->contiguitySearchSteps, allPaths, node);
+        edge->tracePaths(adjacency, outgoingEdge, g_settings->contiguitySearchSteps, allPaths, node);
 
         // Set all nodes in the paths as MAYBE_CONTIGUOUS
         for (auto &path : allPaths) {
@@ -0,0 +1,149 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "nodestore.h"
+
+#include "assemblygraph.h"
+#include "debruijnnode.h"
+
+namespace graph {
+    static bool hasSign(std::string_view name) {
+        return !name.empty() && (name.back() == '+' || name.back() == '-');
+    }
+
+    static std::string_view stripSign(std::string_view name) {
+        if (hasSign(name))
+            name.remove_suffix(1);
+        return name;
+    }
+
+    NodeStore::NodeStore(const AssemblyGraph &graph) {
+        size_t count = graph.m_deBruijnGraphNodes.size();
+        m_lengths.reserve(count); m_depths.reserve(count); m_flags.reserve(count);
+        m_nameOffsets.reserve(count); m_nameLengths.reserve(count);
+        m_nodes.reserve(count);
+
+        for (DeBruijnNode *node : graph.m_deBruijnGraphNodes) {
+            DeBruijnNode *rc = node->getReverseComplement();
+            if (rc == node)
+                rc = nullptr;
+            // Pairs are added via their positive nodes
+            if (rc && node->isNegativeNode() && rc->isPositiveNode())
+                continue;
+            addPair(node, rc);
+        }
+
+        // The pool is not going to change anymore, so it is safe to refer to it
+        m_nameIndex.reserve(m_nodes.size() / 2);
+        m_ids.reserve(m_nodes.size());
+        for (Id id = 0; id < m_nodes.size(); ++id) {
+            if (!exists(id))
+                continue;
+            m_nameIndex.emplace(baseName(id), id);
+            m_ids.emplace(m_nodes[id], id);
+        }
+    }
+
+    void NodeStore::addPair(DeBruijnNode *node, DeBruijnNode *rc) {
+        for (DeBruijnNode *n : { node, rc }) {
+            if (!n) {
+                m_lengths.push_back(0);
+                m_depths.push_back(0);
+                m_flags.push_back(Absent);
+                m_nameOffsets.push_back(0);
+                m_nameLengths.push_back(0);
+                m_nodes.push_back(nullptr);
+                continue;
+            }
+
+            std::string name = n->getName().toStdString();
+            std::string_view base = stripSign(name);
+            // Reverse complements usually differ only by the sign
+            if (n == rc && base == baseName(Id(m_nodes.size() - 1))) {
+                m_nameOffsets.push_back(m_nameOffsets.back());
+            } else {
+                m_nameOffsets.push_back(m_names.size());
+                m_names.append(base);
+            }
+            m_nameLengths.push_back(uint32_t(base.size()));
+
+            uint8_t flags = 0;
+            if (n->isNegativeNode())
+                flags |= Negative;
+            if (n->sequenceIsMissing())
+                flags |= SequenceMissing;
+            if (n->hasLazySequence())
+                flags |= LazySequence;
+
+            m_lengths.push_back(n->getLength());
+            m_depths.push_back(float(n->getDepth()));
+            m_flags.push_back(flags);
+            m_nodes.push_back(n);
+        }
+    }
+
+    std::string NodeStore::name(Id id) const {
+        std::string res(baseName(id));
+        res.push_back(isNegative(id) ? '-' : '+');
+        return res;
+    }
+
+    NodeStore::Id NodeStore::find(std::string_view name) const {
+        if (!hasSign(name))
+            return InvalidId;
+
+        std::string_view base = stripSign(name);
+        auto it = m_nameIndex.find(base);
+        if (it == m_nameIndex.end())
+            return InvalidId;
+
+        bool negative = name.back() == '-';
+        for (Id id : { it->second, reverseComplement(it->second) }) {
+            if (exists(id) && isNegative(id) == negative && baseName(id) == base)
+                return id;
+        }
+
+        return InvalidId;
+    }
+
+    NodeStore::Id NodeStore::id(const DeBruijnNode *node) const {
+        auto it = m_ids.find(node);
+        return it != m_ids.end() ? it->second : InvalidId;
+    }
+
+    Sequence NodeStore::sequence(Id id) const {
+        return m_nodes[id]->getSequence();
+    }
+
+    template<class T>
+    static size_t vectorMemory(const std::vector<T> &v) {
+        return v.capacity() * sizeof(T);
+    }
+
+    template<class Map>
+    static size_t mapMemory(const Map &m) {
+        // Slots plus one control byte per slot
+        return m.capacity() * (sizeof(typename Map::value_type) + 1);
+    }
+
+    size_t NodeStore::memoryUsage() const {
+        return vectorMemory(m_lengths) + vectorMemory(m_depths) + vectorMemory(m_flags) +
+               vectorMemory(m_nameOffsets) + vectorMemory(m_nameLengths) + m_names.capacity() +
+               vectorMemory(m_nodes) +
+               mapMemory(m_nameIndex) + mapMemory(m_ids);
+    }
+}
@@ -0,0 +1,111 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "seq/sequence.hpp"
+#include "parallel_hashmap/phmap.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+class AssemblyGraph;
+class DeBruijnNode;
+
+namespace graph {
+    // Read-only scan index of the graph nodes, built from the DeBruijnNode
+    // objects. It does not replace them: they remain the primary storage,
+    // and the index costs memory on top of them.
+    //
+    // Nodes are identified by dense 32-bit ids, the node and its reverse
+    // complement get ids 2k and 2k + 1, so the reverse complement of id is
+    // id ^ 1. Lengths, depths and flags are copied into contiguous arrays
+    // for whole-graph scans and id-based traversals (see graph::Adjacency),
+    // and the names are copied into a single pool (once per node pair).
+    // Sequences stay with the nodes. The index does not follow subsequent
+    // graph edits, AssemblyGraph::nodeStore() takes care of rebuilding it.
+    // node() / id() convert between ids and the node objects.
+    class NodeStore {
+    public:
+        using Id = uint32_t;
+        static constexpr Id InvalidId = ~Id(0);
+
+        enum Flags : uint8_t {
+            Negative = 1 << 0,
+            SequenceMissing = 1 << 1,
+            LazySequence = 1 << 2,
+            // The node has no reverse complement, the slot is empty
+            Absent = 1 << 3,
+        };
+
+        NodeStore() = default;
+        explicit NodeStore(const AssemblyGraph &graph);
+
+        [[nodiscard]] static Id reverseComplement(Id id) { return id ^ 1; }
+
+        // Number of ids, including the empty slots
+        [[nodiscard]] size_t size() const { return m_nodes.size(); }
+        [[nodiscard]] bool empty() const { return m_nodes.empty(); }
+        [[nodiscard]] bool exists(Id id) const { return !(m_flags[id] & Absent); }
+
+        [[nodiscard]] uint32_t length(Id id) const { return m_lengths[id]; }
+        [[nodiscard]] float depth(Id id) const { return m_depths[id]; }
+        [[nodiscard]] uint8_t flags(Id id) const { return m_flags[id]; }
+        [[nodiscard]] bool isNegative(Id id) const { return m_flags[id] & Negative; }
+        [[nodiscard]] bool sequenceIsMissing(Id id) const { return m_flags[id] & SequenceMissing; }
+
+        // Name without the trailing sign
+        [[nodiscard]] std::string_view baseName(Id id) const {
+            return { m_names.data() + m_nameOffsets[id], m_nameLengths[id] };
+        }
+        [[nodiscard]] std::string name(Id id) const;
+
+        // Returns InvalidId if there is no such node
+        [[nodiscard]] Id find(std::string_view name) const;
+
+        [[nodiscard]] const std::vector<uint32_t> &lengths() const { return m_lengths; }
+        [[nodiscard]] const std::vector<float> &depths() const { return m_depths; }
+
+        // The node objects behind the ids
+        [[nodiscard]] DeBruijnNode *node(Id id) const { return m_nodes[id]; }
+        [[nodiscard]] Id id(const DeBruijnNode *node) const;
+        // Sequences are materialized by the nodes (they could be lazy)
+        [[nodiscard]] Sequence sequence(Id id) const;
+
+        // Memory used by the index on top of the nodes, in bytes
+        [[nodiscard]] size_t memoryUsage() const;
+
+    private:
+        void addPair(DeBruijnNode *node, DeBruijnNode *rc);
+
+        std::vector<uint32_t> m_lengths;
+        std::vector<float> m_depths;
+        std::vector<uint8_t> m_flags;
+        std::vector<uint64_t> m_nameOffsets;
+        std::vector<uint32_t> m_nameLengths;
+        std::string m_names;
+
+        std::vector<DeBruijnNode *> m_nodes;
+        // Base name => the first id having it
+        phmap::flat_hash_map<std::string_view, Id> m_nameIndex;
+        phmap::flat_hash_map<const DeBruijnNode *, Id> m_ids;
+    };
+}
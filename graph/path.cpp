@@ -20,6 +20,7 @@
 #include "debruijnnode.h"
 #include "debruijnedge.h"
 #include "assemblygraph.h"
+#include "adjacency.h"
 #include "sequenceutils.h"
 
 #include "program/settings.h"
@@ -564,7 +565,7 @@ bool Path::canNodeFitAtStart(DeBruijnNode * node, Path *extendedPath) const {
 //This function takes the current path and extends it in all possible ways by
 //adding one more node, then returning a list of the new paths.  How many paths
 //it returns depends on the number of edges leaving the last node in the path.
-QList<Path> Path::extendPathInAllPossibleWays() const
+QList<Path> Path::extendPathInAllPossibleWays(const graph::Adjacency &adjacency) const
 {
     QList<Path> returnList;
 
@@ -576,18 +577,20 @@ QList<Path> Path::extendPathInAllPossibleWays() const
     if (isCircular())
         return returnList;
 
-    DeBruijnNode * lastNode = m_nodes.back();
-    std::vector<DeBruijnEdge *> nextEdges = lastNode->getLeavingEdges();
-    for (auto nextEdge : nextEdges)
+    const graph::NodeStore &nodes = adjacency.nodes();
+    graph::NodeStore::Id lastNode = nodes.id(m_nodes.back());
+    if (lastNode == graph::NodeStore::InvalidId)
+        return returnList;
+
+    returnList.reserve(adjacency.outDegree(lastNode));
+    for (graph::Adjacency::EdgeId nextEdge : adjacency.outEdges(lastNode))
     {
-        DeBruijnNode * nextNode = nextEdge->getEndingNode();
+        DeBruijnNode * nextNode = nodes.node(adjacency.target(nextEdge));
 
-        Path newPath(*this);
-        newPath.m_edges.push_back(nextEdge);
+        Path &newPath = returnList.emplace_back(*this);
+        newPath.m_edges.push_back(adjacency.edge(nextEdge));
         newPath.m_nodes.push_back(nextNode);
         newPath.m_endLocation = GraphLocation::endOfNode(nextNode);
-
-        returnList.push_back(newPath);
     }
 
     return returnList;
@@ -624,12 +627,15 @@ bool Path::hasNodeSubset(const Path& other) const {
 
 //This function builds all possible paths between the given start and end,
 //within the given restrictions.
-QList<Path> Path::getAllPossiblePaths(GraphLocation startLocation,
+QList<Path> Path::getAllPossiblePaths(const AssemblyGraph &graph,
+                                      GraphLocation startLocation,
                                       GraphLocation endLocation,
                                       int nodeSearchDepth,
                                       int minDistance, int maxDistance) {
     QList<Path> finishedPaths;
     QList<Path> unfinishedPaths;
+    auto snapshot = graph.adjacency();
+    const auto &adjacency = *snapshot;
 
     unfinishedPaths.emplace_back(startLocation);
 
@@ -666,7 +672,7 @@ QList<Path> Path::getAllPossiblePaths(GraphLocation startLocation,
         //Make new unfinished paths by extending each of the paths.
         QList<Path> newUnfinishedPaths;
         for (auto & unfinishedPath : unfinishedPaths)
-            newUnfinishedPaths.append(unfinishedPath.extendPathInAllPossibleWays());
+            newUnfinishedPaths.append(unfinishedPath.extendPathInAllPossibleWays(adjacency));
         unfinishedPaths = newUnfinishedPaths;
     }
 
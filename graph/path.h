@@ -30,6 +30,9 @@
 class DeBruijnNode;
 class DeBruijnEdge;
 class AssemblyGraph;
+namespace graph {
+    class Adjacency;
+}
 
 class Path {
 public:
@@ -72,7 +75,7 @@ public:
     [[nodiscard]] QByteArray getAAFasta(unsigned shift, QString name = "") const;
     [[nodiscard]] QString getString(bool spaces) const;
     int getLength() const;
-    QList<Path> extendPathInAllPossibleWays() const;
+    QList<Path> extendPathInAllPossibleWays(const graph::Adjacency &adjacency) const;
     bool canNodeFitOnEnd(DeBruijnNode * node, Path * extendedPath) const;
     bool canNodeFitAtStart(DeBruijnNode * node, Path * extendedPath) const;
 
@@ -97,9 +100,12 @@ public:
     bool addNode(DeBruijnNode * newNode, bool strandSpecific, bool makeCircularIfPossible);
     void extendPathToIncludeEntirityOfNodes();
     void trim(int start = 0, int end = 0);
+    void setStartLocation(GraphLocation location) {m_startLocation = location;}
+    void setEndLocation(GraphLocation location) {m_endLocation = location;}
 
     //STATIC
-    static QList<Path> getAllPossiblePaths(GraphLocation startLocation,
+    static QList<Path> getAllPossiblePaths(const AssemblyGraph &graph,
+                                           GraphLocation startLocation,
                                            GraphLocation endLocation,
                                            int nodeSearchDepth,
                                            int minDistance, int maxDistance);
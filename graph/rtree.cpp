@@ -0,0 +1,194 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "rtree.h"
+
+#include <cmath>
+#include <tuple>
+
+RTree::RTree(const std::vector<QRectF> &bounds)
+        : m_slot(bounds.size(), 0), m_size(bounds.size()) {
+    m_boxes.reserve(bounds.size());
+    for (const QRectF &rect : bounds)
+        m_boxes.emplace_back(rect);
+    build();
+}
+
+QRectF RTree::bounds() const {
+    Box box;
+    if (!m_nodes.empty())
+        box = m_nodes[m_root].box;
+    for (uint32_t id : m_overflow)
+        box.unite(m_boxes[id]);
+
+    if (box.empty())
+        return {};
+    return { QPointF(box.minX, box.minY), QPointF(box.maxX, box.maxY) };
+}
+
+// Sort-Tile-Recursive order: the items sorted by x are cut into about
+// sqrt(groups) vertical slices, and each slice is sorted by y, so that
+// consecutive runs of Fanout items make compact groups.
+template<class BoxOf>
+static void tileOrder(std::vector<uint32_t> &items, BoxOf boxOf) {
+    auto byX = [&](uint32_t a, uint32_t b) {
+        return std::make_tuple(boxOf(a).minX + boxOf(a).maxX, a) < std::make_tuple(boxOf(b).minX + boxOf(b).maxX, b);
+    };
+    auto byY = [&](uint32_t a, uint32_t b) {
+        return std::make_tuple(boxOf(a).minY + boxOf(a).maxY, a) < std::make_tuple(boxOf(b).minY + boxOf(b).maxY, b);
+    };
+
+    size_t groups = (items.size() + RTree::Fanout - 1) / RTree::Fanout;
+    size_t sliceSize = size_t(std::ceil(std::sqrt(double(groups)))) * RTree::Fanout;
+    std::sort(items.begin(), items.end(), byX);
+    for (size_t start = 0; start < items.size(); start += sliceSize) {
+        auto end = items.begin() + std::min(start + sliceSize, items.size());
+        std::sort(items.begin() + start, end, byY);
+    }
+}
+
+void RTree::build() {
+    m_nodes.clear();
+    m_entries.clear();
+    m_overflow.clear();
+    m_changes = 0;
+    for (uint32_t id = 0; id < m_slot.size(); ++id) {
+        if (m_slot[id] != Absent)
+            m_entries.push_back(id);
+    }
+    if (m_entries.empty())
+        return;
+
+    // Leaves over runs of the entries in tile order
+    tileOrder(m_entries, [this](uint32_t id) -> const Box & { return m_boxes[id]; });
+    for (uint32_t first = 0; first < m_entries.size(); first += Fanout) {
+        Node leaf{ Box(), first, std::min<uint32_t>(Fanout, uint32_t(m_entries.size()) - first), 0, true };
+        for (uint32_t i = leaf.first; i < leaf.first + leaf.count; ++i) {
+            leaf.box.unite(m_boxes[m_entries[i]]);
+            m_slot[m_entries[i]] = uint32_t(m_nodes.size());
+        }
+        m_nodes.push_back(leaf);
+    }
+
+    // Every level is put in tile order and grouped into the next one, until
+    // a single root is left
+    uint32_t levelBegin = 0, levelEnd = uint32_t(m_nodes.size());
+    std::vector<uint32_t> order;
+    std::vector<Node> level;
+    while (levelEnd - levelBegin > 1) {
+        order.resize(levelEnd - levelBegin);
+        for (uint32_t i = 0; i < order.size(); ++i)
+            order[i] = levelBegin + i;
+        tileOrder(order, [this](uint32_t node) -> const Box & { return m_nodes[node].box; });
+
+        level.clear();
+        for (uint32_t node : order)
+            level.push_back(m_nodes[node]);
+        for (uint32_t i = 0; i < level.size(); ++i) {
+            uint32_t index = levelBegin + i;
+            m_nodes[index] = level[i];
+            const Node &node = m_nodes[index];
+            for (uint32_t child = node.first; child < node.first + node.count; ++child) {
+                if (node.leaf)
+                    m_slot[m_entries[child]] = index;
+                else
+                    m_nodes[child].parent = index;
+            }
+        }
+
+        for (uint32_t first = levelBegin; first < levelEnd; first += Fanout) {
+            Node parent{ Box(), first, std::min(Fanout, levelEnd - first), 0, false };
+            for (uint32_t child = parent.first; child < parent.first + parent.count; ++child) {
+                parent.box.unite(m_nodes[child].box);
+                m_nodes[child].parent = uint32_t(m_nodes.size());
+            }
+            m_nodes.push_back(parent);
+        }
+
+        levelBegin = levelEnd;
+        levelEnd = uint32_t(m_nodes.size());
+    }
+    m_root = levelBegin;
+}
+
+void RTree::refit(uint32_t index) {
+    while (true) {
+        Node &node = m_nodes[index];
+        Box box;
+        for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+            if (!node.leaf)
+                box.unite(m_nodes[i].box);
+            else if (m_slot[m_entries[i]] == index)
+                box.unite(m_boxes[m_entries[i]]);
+        }
+
+        if (box == node.box)
+            return;
+        node.box = box;
+        if (index == m_root)
+            return;
+        index = node.parent;
+    }
+}
+
+void RTree::changed() {
+    if (++m_changes > std::max<size_t>(64, m_size / 4))
+        build();
+}
+
+void RTree::insert(uint32_t id, const QRectF &rect) {
+    if (contains(id)) {
+        update(id, rect);
+        return;
+    }
+
+    if (id >= m_slot.size()) {
+        m_slot.resize(id + 1, Absent);
+        m_boxes.resize(id + 1);
+    }
+    m_boxes[id] = Box(rect);
+    m_slot[id] = Overflow;
+    m_overflow.push_back(id);
+    ++m_size;
+    changed();
+}
+
+void RTree::update(uint32_t id, const QRectF &rect) {
+    if (!contains(id)) {
+        insert(id, rect);
+        return;
+    }
+
+    m_boxes[id] = Box(rect);
+    if (m_slot[id] != Overflow)
+        refit(m_slot[id]);
+    changed();
+}
+
+void RTree::remove(uint32_t id) {
+    if (!contains(id))
+        return;
+
+    uint32_t slot = m_slot[id];
+    m_slot[id] = Absent;
+    --m_size;
+    if (slot == Overflow)
+        m_overflow.erase(std::find(m_overflow.begin(), m_overflow.end(), id));
+    else
+        refit(slot);
+    changed();
+}
@@ -0,0 +1,133 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <QRectF>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// R-tree over the bounding rectangles of scene geometry, identified by dense
+// ids. It is bulk-loaded with Sort-Tile-Recursive packing, so the leaves are
+// full and hardly overlap. Updates refit the boxes up the tree, inserts go to
+// a small overflow list, and the tree is packed again once the changes add
+// up to a quarter of its size. Rectangles are closed, so points and
+// horizontal or vertical lines are found as well.
+class RTree {
+public:
+    static constexpr uint32_t Fanout = 16;
+
+    RTree() = default;
+    // Id i has bounds[i]
+    explicit RTree(const std::vector<QRectF> &bounds);
+
+    [[nodiscard]] size_t size() const { return m_size; }
+    [[nodiscard]] bool contains(uint32_t id) const { return id < m_slot.size() && m_slot[id] != Absent; }
+    // Bounding rectangle of everything in the tree
+    [[nodiscard]] QRectF bounds() const;
+
+    void insert(uint32_t id, const QRectF &rect);
+    void update(uint32_t id, const QRectF &rect);
+    void remove(uint32_t id);
+
+    // Calls visit(id) for every id whose rectangle intersects rect, in no
+    // particular order
+    template<class Visitor>
+    void query(const QRectF &rect, Visitor &&visit) const {
+        Box box(rect);
+        if (!m_nodes.empty()) {
+            std::vector<uint32_t> stack = { m_root };
+            while (!stack.empty()) {
+                uint32_t index = stack.back();
+                const Node &node = m_nodes[index];
+                stack.pop_back();
+                if (!node.box.intersects(box))
+                    continue;
+
+                for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+                    if (!node.leaf)
+                        stack.push_back(i);
+                    else if (uint32_t id = m_entries[i]; m_slot[id] == index && m_boxes[id].intersects(box))
+                        visit(id);
+                }
+            }
+        }
+
+        for (uint32_t id : m_overflow) {
+            if (m_boxes[id].intersects(box))
+                visit(id);
+        }
+    }
+
+private:
+    struct Box {
+        double minX = 0.0, minY = 0.0, maxX = -1.0, maxY = -1.0;
+
+        Box() = default;
+        explicit Box(const QRectF &rect)
+                : minX(std::min(rect.left(), rect.right())), minY(std::min(rect.top(), rect.bottom())),
+                  maxX(std::max(rect.left(), rect.right())), maxY(std::max(rect.top(), rect.bottom())) {}
+
+        [[nodiscard]] bool empty() const { return minX > maxX; }
+        [[nodiscard]] bool intersects(const Box &other) const {
+            return minX <= other.maxX && other.minX <= maxX && minY <= other.maxY && other.minY <= maxY;
+        }
+        void unite(const Box &other) {
+            if (other.empty())
+                return;
+            if (empty()) {
+                *this = other;
+                return;
+            }
+            minX = std::min(minX, other.minX);
+            minY = std::min(minY, other.minY);
+            maxX = std::max(maxX, other.maxX);
+            maxY = std::max(maxY, other.maxY);
+        }
+        bool operator==(const Box &other) const {
+            return minX == other.minX && minY == other.minY && maxX == other.maxX && maxY == other.maxY;
+        }
+    };
+
+    // Children are nodes [first, first + count) or, for leaves, entries
+    struct Node {
+        Box box;
+        uint32_t first, count;
+        uint32_t parent;
+        bool leaf;
+    };
+
+    static constexpr uint32_t Absent = UINT32_MAX, Overflow = UINT32_MAX - 1;
+
+    void build();
+    void refit(uint32_t node);
+    void changed();
+
+    std::vector<Box> m_boxes;
+    // Leaf of every id, or Absent or Overflow. Leaves keep the entries of
+    // removed ids until the next build, so only those still pointing back
+    // to the leaf count
+    std::vector<uint32_t> m_slot;
+    std::vector<uint32_t> m_entries;
+    std::vector<Node> m_nodes;
+    std::vector<uint32_t> m_overflow;
+    uint32_t m_root = 0;
+    size_t m_size = 0;
+    size_t m_changes = 0;
+};
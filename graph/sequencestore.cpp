@@ -0,0 +1,196 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "sequencestore.h"
+
+#include "io/randomaccessreader.h"
+
+#include <QtGlobal>
+
+#include <algorithm>
+#include <stdexcept>
+
+SequenceStore::SequenceStore(size_t budget)
+        : m_budget(budget) {}
+
+SequenceStore::~SequenceStore() = default;
+
+uint32_t SequenceStore::addFile(const std::string &fileName) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Files are opened lazily, on the first read
+    m_files.emplace_back();
+    m_fileNames.push_back(fileName);
+    return uint32_t(m_files.size() - 1);
+}
+
+SequenceStore::Id SequenceStore::add(uint32_t file, uint64_t offset, uint64_t length,
+                                     uint32_t lineBases, uint32_t lineWidth) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (file >= m_fileNames.size())
+        throw std::out_of_range("invalid sequence file");
+    if (lineBases > 0 && lineWidth <= lineBases)
+        throw std::invalid_argument("invalid sequence line width");
+
+    m_entries.push_back({offset, length, file, lineBases, lineWidth});
+    return Id(m_entries.size() - 1);
+}
+
+size_t SequenceStore::size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+}
+
+uint64_t SequenceStore::length(Id id) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.at(id).length;
+}
+
+void SequenceStore::setBudget(size_t budget) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_budget = budget;
+    evict();
+}
+
+size_t SequenceStore::budget() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_budget;
+}
+
+size_t SequenceStore::cached() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_cached;
+}
+
+static size_t cost(const Sequence &sequence) {
+    return sequence.capacity() + sizeof(Sequence) + 64;
+}
+
+void SequenceStore::evict() {
+    while (m_cached > m_budget && !m_lru.empty()) {
+        auto it = m_cache.find(m_lru.back());
+        m_cached -= cost(it->second.sequence);
+        m_cache.erase(it);
+        m_lru.pop_back();
+    }
+}
+
+char SequenceStore::base(Id id, uint64_t position, bool reverseComplement) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const Entry &entry = m_entries.at(id);
+    if (position >= entry.length)
+        return '\0';
+    if (reverseComplement)
+        position = entry.length - 1 - position;
+
+    char base;
+    if (auto it = m_cache.find(id); it != m_cache.end())
+        base = it->second.sequence[position];
+    else {
+        try {
+            base = readBase(entry, position);
+        } catch (const std::exception &e) {
+            qWarning("Cannot load sequence: %s", e.what());
+            return 'N';
+        }
+    }
+
+    if (!reverseComplement)
+        return base;
+    switch (base) {
+        case 'A': return 'T';
+        case 'C': return 'G';
+        case 'G': return 'C';
+        case 'T': return 'A';
+        default: return 'N';
+    }
+}
+
+io::RandomAccessReader &SequenceStore::reader(uint32_t file) {
+    auto &reader = m_files[file];
+    if (!reader)
+        reader = std::make_unique<io::RandomAccessReader>(m_fileNames[file]);
+    if (!reader->isOpen())
+        throw std::runtime_error("failed to open file: " + m_fileNames[file]);
+
+    return *reader;
+}
+
+Sequence SequenceStore::read(const Entry &entry) {
+    io::RandomAccessReader &reader = this->reader(entry.file);
+    if (!entry.lineBases) {
+        if (reader.read(entry.offset, entry.length, m_buffer) != entry.length)
+            throw std::runtime_error("unexpected end of file: " + m_fileNames[entry.file]);
+        return Sequence(m_buffer);
+    }
+
+    // Line-wrapped sequence, drop the line terminators
+    uint64_t span = entry.length / entry.lineBases * entry.lineWidth + entry.length % entry.lineBases;
+    reader.read(entry.offset, span, m_buffer);
+    m_buffer.erase(std::remove_if(m_buffer.begin(), m_buffer.end(),
+                                  [](char c) { return c == '\n' || c == '\r'; }),
+                   m_buffer.end());
+    if (m_buffer.size() < entry.length)
+        throw std::runtime_error("unexpected end of file: " + m_fileNames[entry.file]);
+    m_buffer.resize(entry.length);
+
+    return Sequence(m_buffer);
+}
+
+char SequenceStore::readBase(const Entry &entry, uint64_t position) {
+    // Skip the line terminators of line-wrapped sequences
+    uint64_t offset = entry.offset + position;
+    if (entry.lineBases)
+        offset = entry.offset + position / entry.lineBases * entry.lineWidth + position % entry.lineBases;
+    if (reader(entry.file).read(offset, 1, m_buffer) != 1)
+        throw std::runtime_error("unexpected end of file: " + m_fileNames[entry.file]);
+
+    // Normalized as whole sequences are
+    return Sequence(m_buffer)[0];
+}
+
+Sequence SequenceStore::get(Id id, bool reverseComplement) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const Entry &entry = m_entries.at(id);
+    Sequence sequence;
+    if (auto it = m_cache.find(id); it != m_cache.end()) {
+        m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+        sequence = it->second.sequence;
+    } else {
+        try {
+            sequence = read(entry);
+        } catch (const std::exception &e) {
+            qWarning("Cannot load sequence: %s", e.what());
+            return Sequence(entry.length, /* allNs */ true);
+        }
+
+        // Sequences larger than the whole budget are not cached at all. The
+        // returned sequence does not depend on the cache, so it stays valid
+        // after eviction.
+        if (cost(sequence) <= m_budget) {
+            m_lru.push_front(id);
+            m_cache.emplace(id, CacheEntry{sequence, m_lru.begin()});
+            m_cached += cost(sequence);
+            evict();
+        }
+    }
+
+    return reverseComplement ? sequence.GetReverseComplement() : sequence;
+}
@@ -0,0 +1,104 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "seq/sequence.hpp"
+#include "parallel_hashmap/phmap.h"
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+namespace io {
+    class RandomAccessReader;
+}
+
+// Storage for sequences that are not kept in memory, but are read from the
+// input file on demand. Each sequence is described by its location in the
+// (decompressed) file. Sequences read are kept in an LRU cache bounded by
+// the memory budget. All methods are thread-safe.
+class SequenceStore {
+public:
+    using Id = uint32_t;
+
+    // Budget is the amount of memory (in bytes) used for cached sequences
+    explicit SequenceStore(size_t budget);
+    ~SequenceStore();
+
+    uint32_t addFile(const std::string &fileName);
+
+    // Adds a sequence of the given length starting at offset. For
+    // line-wrapped FASTA lineBases / lineWidth are the number of bases /
+    // bytes (including the terminator) per line as in .fai index, zero
+    // means that the sequence is not wrapped.
+    Id add(uint32_t file, uint64_t offset, uint64_t length,
+           uint32_t lineBases = 0, uint32_t lineWidth = 0);
+
+    [[nodiscard]] size_t size() const;
+    [[nodiscard]] uint64_t length(Id id) const;
+
+    // Returns the sequence (or its reverse complement), reading it from the
+    // file if necessary. If the sequence could not be read, sequence of Ns
+    // of the proper length is returned.
+    Sequence get(Id id, bool reverseComplement = false);
+    // A single base of the sequence (or its reverse complement). Unless the
+    // sequence is cached only the base itself is read, and the cache is left
+    // as is. 'N' if it could not be read
+    char base(Id id, uint64_t position, bool reverseComplement = false);
+
+    void setBudget(size_t budget);
+    [[nodiscard]] size_t budget() const;
+    // Memory currently used by cached sequences
+    [[nodiscard]] size_t cached() const;
+
+private:
+    struct Entry {
+        uint64_t offset;
+        uint64_t length;
+        uint32_t file;
+        uint32_t lineBases;
+        uint32_t lineWidth;
+    };
+
+    struct CacheEntry {
+        Sequence sequence;
+        std::list<Id>::iterator lru;
+    };
+
+    // Opened on first use
+    io::RandomAccessReader &reader(uint32_t file);
+    Sequence read(const Entry &entry);
+    char readBase(const Entry &entry, uint64_t position);
+    void evict();
+
+    mutable std::mutex m_mutex;
+    std::vector<std::unique_ptr<io::RandomAccessReader>> m_files;
+    std::vector<std::string> m_fileNames;
+    std::vector<Entry> m_entries;
+
+    size_t m_budget;
+    size_t m_cached = 0;
+    // Most recently used sequences are at front
+    std::list<Id> m_lru;
+    phmap::flat_hash_map<Id, CacheEntry> m_cache;
+    std::string m_buffer;
+};
@@ -0,0 +1,748 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "snapshot.h"
+
+#include "assemblygraph.h"
+#include "debruijnedge.h"
+#include "debruijnnode.h"
+#include "path.h"
+
+#include "io/gfa.h"
+#include "program/settings.h"
+#include "seq/sequence.hpp"
+
+#include "parallel_hashmap/phmap.h"
+
+#include <QFile>
+#include <QScopeGuard>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <array>
+#include <cstring>
+#include <numeric>
+#include <string_view>
+#include <vector>
+
+namespace snapshot {
+    // The file starts with the header followed by the section table. Every
+    // section is an 8-byte aligned array of plain records, records reference
+    // strings, nodes and edges by their indices. The data is stored in native
+    // byte order, so snapshots are not portable between machines of different
+    // endianness.
+    static constexpr char Magic[8] = { 'B', 'A', 'N', 'D', 'A', 'G', 'E', '\x1a' };
+    static constexpr uint32_t Version = 1;
+    static constexpr uint32_t ByteOrderMark = 0x01020304;
+    static constexpr uint32_t None = UINT32_MAX;
+
+    enum Section : uint32_t {
+        StringOffsets, StringData,
+        Sequences, SequenceWords, NRuns,
+        Nodes, Edges, AdjacencyOffsets, Adjacency,
+        NodeColours, NodeLabels, EdgeColours, EdgeStyles,
+        NodeTags, EdgeTags,
+        Paths, PathNodes,
+        GraphInfo,
+        LayoutNodes, LayoutPoints,
+        SectionCount
+    };
+
+    enum HeaderFlags : uint32_t {
+        CustomLabels = 1, CustomColours = 2, HasLayout = 4
+    };
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrder;
+        uint32_t flags;
+        uint32_t sectionCount;
+    };
+
+    struct SectionEntry {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    struct SequenceRecord {
+        uint64_t words;    // index of the first word in SequenceWords
+        uint64_t nRuns;    // index of the first (start, length) pair in NRuns
+        uint32_t size;
+        uint32_t nRunCount;
+    };
+
+    enum NodeFlags : uint32_t {
+        // The sequence is the reverse complement of the one of rc node
+        ReverseComplementView = 1
+    };
+
+    struct NodeRecord {
+        uint32_t name;
+        uint32_t rc;
+        uint32_t length;
+        uint32_t sequence;
+        float depth;
+        uint32_t flags;
+    };
+
+    struct EdgeRecord {
+        uint32_t from, to, rc;
+        int32_t overlap;
+        uint32_t overlapType;
+    };
+
+    struct ColourRecord {
+        uint32_t owner;
+        uint32_t argb;
+    };
+
+    struct LabelRecord {
+        uint32_t node;
+        uint32_t label;
+    };
+
+    struct StyleRecord {
+        uint32_t edge;
+        float width;
+        uint32_t lineStyle;
+    };
+
+    enum TagKind : uint8_t {
+        IntTag, StringTag, FloatTag
+    };
+
+    struct TagRecord {
+        uint32_t owner;
+        char name[2];
+        char type;
+        uint8_t kind;
+        uint64_t value;    // integer value, string index or float bits
+    };
+
+    struct PathRecord {
+        uint64_t nodes;    // index of the first node in PathNodes
+        uint32_t name;
+        uint32_t nodeCount;
+        uint32_t startNode;
+        int32_t startPosition;
+        uint32_t endNode;
+        int32_t endPosition;
+        uint32_t circular;
+        uint32_t reserved;
+    };
+
+    struct GraphInfoRecord {
+        uint32_t depthTag;
+        uint32_t sequencesLoadedFromFasta;
+    };
+
+    struct LayoutRecord {
+        uint64_t points;   // index of the first point in LayoutPoints
+        uint32_t node;
+        uint32_t count;
+    };
+
+    struct PointRecord {
+        double x, y;
+    };
+
+    static_assert(sizeof(Header) % 8 == 0 && sizeof(TagRecord) == 16 && sizeof(PathRecord) == 40,
+                  "unexpected snapshot records layout");
+
+    bool isSnapshot(const QString &filename) {
+        QFile file(filename);
+        if (!file.open(QIODevice::ReadOnly))
+            return false;
+
+        char magic[sizeof(Magic)];
+        return file.read(magic, sizeof(magic)) == sizeof(magic) &&
+               std::memcmp(magic, Magic, sizeof(Magic)) == 0;
+    }
+
+    class StringTable {
+    public:
+        uint32_t intern(std::string_view str) {
+            auto [it, inserted] = index_.try_emplace(std::string(str), uint32_t(offsets_.size() - 1));
+            if (inserted) {
+                data_.insert(data_.end(), str.begin(), str.end());
+                offsets_.push_back(data_.size());
+            }
+            return it->second;
+        }
+
+        uint32_t intern(const QString &str) { return intern(str.toStdString()); }
+
+        const std::vector<uint64_t> &offsets() const { return offsets_; }
+        const std::vector<char> &data() const { return data_; }
+
+    private:
+        phmap::flat_hash_map<std::string, uint32_t> index_;
+        std::vector<uint64_t> offsets_{0};
+        std::vector<char> data_;
+    };
+
+    // Sections are written one by one, the header with the section table is
+    // written last.
+    class Writer {
+    public:
+        explicit Writer(QFile &file)
+                : file_(file) {
+            table_.fill({0, 0});
+            std::vector<char> zeros(sizeof(Header) + sizeof(table_), 0);
+            write(zeros.data(), zeros.size());
+        }
+
+        template<class T>
+        void section(Section id, const std::vector<T> &data) {
+            static constexpr char padding[8] = {};
+            if (qint64 pos = file_.pos(); pos % 8)
+                write(padding, size_t(8 - pos % 8));
+
+            table_[id] = { uint64_t(file_.pos()), uint64_t(data.size() * sizeof(T)) };
+            write(data.data(), data.size() * sizeof(T));
+        }
+
+        bool finish(uint32_t flags) {
+            Header header;
+            std::memcpy(header.magic, Magic, sizeof(Magic));
+            header.version = Version;
+            header.byteOrder = ByteOrderMark;
+            header.flags = flags;
+            header.sectionCount = SectionCount;
+
+            ok_ &= file_.seek(0);
+            write(&header, sizeof(header));
+            write(table_.data(), sizeof(table_));
+            return ok_;
+        }
+
+    private:
+        void write(const void *data, size_t size) {
+            if (size)
+                ok_ &= file_.write(static_cast<const char*>(data), qint64(size)) == qint64(size);
+        }
+
+        QFile &file_;
+        std::array<SectionEntry, SectionCount> table_;
+        bool ok_ = true;
+    };
+
+    template<class Owner, class Tags>
+    static std::vector<TagRecord> tagRecords(const Tags &tags,
+                                             const phmap::flat_hash_map<const Owner*, uint32_t> &ids,
+                                             StringTable &strings) {
+        std::vector<TagRecord> res;
+        for (const auto &[owner, ownerTags] : tags) {
+            auto id = ids.find(owner);
+            if (id == ids.end())
+                continue;
+
+            for (const auto &tag : ownerTags) {
+                TagRecord record{};
+                record.owner = id->second;
+                record.name[0] = tag.name[0]; record.name[1] = tag.name[1];
+                record.type = tag.type;
+                if (const auto *i = std::get_if<int64_t>(&tag.val)) {
+                    record.kind = IntTag;
+                    record.value = uint64_t(*i);
+                } else if (const auto *s = std::get_if<std::string>(&tag.val)) {
+                    record.kind = StringTag;
+                    record.value = strings.intern(*s);
+                } else {
+                    uint32_t bits;
+                    float f = std::get<float>(tag.val);
+                    std::memcpy(&bits, &f, sizeof(bits));
+                    record.kind = FloatTag;
+                    record.value = bits;
+                }
+                res.push_back(record);
+            }
+        }
+
+        return res;
+    }
+
+    bool save(const QString &filename,
+              const AssemblyGraph &graph,
+              const GraphLayout *layout) {
+        QFile file(filename);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+            return false;
+
+        StringTable strings;
+        uint32_t flags = layout ? HasLayout : 0;
+
+        // Nodes
+        std::vector<const DeBruijnNode*> nodes;
+        phmap::flat_hash_map<const DeBruijnNode*, uint32_t> nodeIds;
+        std::vector<NodeRecord> nodeRecords;
+        nodes.reserve(graph.m_deBruijnGraphNodes.size());
+        nodeRecords.reserve(graph.m_deBruijnGraphNodes.size());
+        for (auto it = graph.m_deBruijnGraphNodes.begin(); it != graph.m_deBruijnGraphNodes.end(); ++it) {
+            nodeIds.emplace(*it, uint32_t(nodes.size()));
+            nodes.push_back(*it);
+            nodeRecords.push_back({ strings.intern(it.key()), None, (*it)->getLength(), None,
+                                    float((*it)->getDepth()), 0 });
+        }
+
+        std::vector<SequenceRecord> sequences;
+        std::vector<uint64_t> words;
+        std::vector<uint32_t> nRuns;
+        std::vector<ColourRecord> nodeColours;
+        std::vector<LabelRecord> nodeLabels;
+        for (uint32_t id = 0; id < nodes.size(); ++id) {
+            const DeBruijnNode *node = nodes[id];
+            NodeRecord &record = nodeRecords[id];
+            const Sequence &seq = node->getSequence();
+
+            const DeBruijnNode *rc = node->getReverseComplement();
+            if (rc)
+                record.rc = nodeIds.at(rc);
+
+            // Reverse complementary nodes usually share the sequence storage,
+            // so only one of them needs to be stored
+            if (rc && record.rc < id && !seq.empty() &&
+                !(nodeRecords[record.rc].flags & ReverseComplementView) &&
+                seq.IsReverseComplementView(rc->getSequence())) {
+                record.flags |= ReverseComplementView;
+            } else {
+                record.sequence = uint32_t(sequences.size());
+                size_t wordsBegin = words.size(), nRunsBegin = nRuns.size();
+                seq.Pack(words, nRuns);
+                sequences.push_back({ wordsBegin, nRunsBegin / 2, uint32_t(seq.size()),
+                                      uint32_t((nRuns.size() - nRunsBegin) / 2) });
+            }
+
+            if (graph.hasCustomColour(node)) {
+                flags |= CustomColours;
+                nodeColours.push_back({ id, node->m_customColor.rgba() });
+            }
+            if (!node->m_customLabel.isEmpty()) {
+                flags |= CustomLabels;
+                nodeLabels.push_back({ id, strings.intern(node->m_customLabel) });
+            }
+        }
+
+        // Edges, the order of edges of each node is preserved
+        std::vector<const DeBruijnEdge*> edges;
+        phmap::flat_hash_map<const DeBruijnEdge*, uint32_t> edgeIds;
+        edges.reserve(graph.m_deBruijnGraphEdges.size());
+        for (const auto &entry : graph.m_deBruijnGraphEdges) {
+            edgeIds.emplace(entry.second, uint32_t(edges.size()));
+            edges.push_back(entry.second);
+        }
+
+        std::vector<EdgeRecord> edgeRecords;
+        edgeRecords.reserve(edges.size());
+        for (const auto *edge : edges) {
+            auto rc = edge->getReverseComplement() ? edgeIds.find(edge->getReverseComplement()) : edgeIds.end();
+            edgeRecords.push_back({ nodeIds.at(edge->getStartingNode()), nodeIds.at(edge->getEndingNode()),
+                                    rc != edgeIds.end() ? rc->second : None,
+                                    edge->getOverlap(), uint32_t(edge->getOverlapType()) });
+        }
+
+        std::vector<uint64_t> adjacencyOffsets{0};
+        std::vector<uint32_t> adjacency;
+        adjacencyOffsets.reserve(nodes.size() + 1);
+        for (const auto *node : nodes) {
+            for (const auto *edge : node->edges()) {
+                auto id = edgeIds.find(edge);
+                if (id != edgeIds.end())
+                    adjacency.push_back(id->second);
+            }
+            adjacencyOffsets.push_back(adjacency.size());
+        }
+
+        std::vector<ColourRecord> edgeColours;
+        for (const auto &[edge, colour] : graph.m_edgeColors) {
+            auto id = edgeIds.find(edge);
+            if (id != edgeIds.end() && colour.isValid())
+                edgeColours.push_back({ id->second, colour.rgba() });
+        }
+
+        std::vector<StyleRecord> edgeStyles;
+        for (const auto &[edge, style] : graph.m_edgeStyles) {
+            auto id = edgeIds.find(edge);
+            if (id != edgeIds.end())
+                edgeStyles.push_back({ id->second, style.width, uint32_t(style.lineStyle) });
+        }
+
+        auto nodeTags = tagRecords(graph.m_nodeTags, nodeIds, strings);
+        auto edgeTags = tagRecords(graph.m_edgeTags, edgeIds, strings);
+
+        // Paths
+        std::vector<PathRecord> paths;
+        std::vector<uint32_t> pathNodes;
+        for (auto it = graph.m_deBruijnGraphPaths.begin(); it != graph.m_deBruijnGraphPaths.end(); ++it) {
+            const Path *path = *it;
+            PathRecord record{};
+            record.name = strings.intern(it.key());
+            record.nodes = pathNodes.size();
+            record.nodeCount = uint32_t(path->nodes().size());
+            record.circular = path->isCircular();
+            for (const auto *node : path->nodes())
+                pathNodes.push_back(nodeIds.at(node));
+
+            GraphLocation start = path->getStartLocation(), end = path->getEndLocation();
+            record.startNode = start.getNode() ? nodeIds.at(start.getNode()) : None;
+            record.startPosition = start.getPosition();
+            record.endNode = end.getNode() ? nodeIds.at(end.getNode()) : None;
+            record.endPosition = end.getPosition();
+            paths.push_back(record);
+        }
+
+        std::vector<GraphInfoRecord> info{
+            { strings.intern(graph.m_depthTag), uint32_t(graph.m_sequencesLoadedFromFasta) }
+        };
+
+        // Layout
+        std::vector<LayoutRecord> layoutNodes;
+        std::vector<PointRecord> layoutPoints;
+        if (layout) {
+            for (const auto &[node, segments] : *layout) {
+                auto id = nodeIds.find(node);
+                if (id == nodeIds.end())
+                    continue;
+
+                layoutNodes.push_back({ layoutPoints.size(), id->second, uint32_t(segments.size()) });
+                for (QPointF point : segments)
+                    layoutPoints.push_back({ point.x(), point.y() });
+            }
+        }
+
+        Writer writer(file);
+        writer.section(StringOffsets, strings.offsets());
+        writer.section(StringData, strings.data());
+        writer.section(Sequences, sequences);
+        writer.section(SequenceWords, words);
+        writer.section(NRuns, nRuns);
+        writer.section(Nodes, nodeRecords);
+        writer.section(Edges, edgeRecords);
+        writer.section(AdjacencyOffsets, adjacencyOffsets);
+        writer.section(Adjacency, adjacency);
+        writer.section(NodeColours, nodeColours);
+        writer.section(NodeLabels, nodeLabels);
+        writer.section(EdgeColours, edgeColours);
+        writer.section(EdgeStyles, edgeStyles);
+        writer.section(NodeTags, nodeTags);
+        writer.section(EdgeTags, edgeTags);
+        writer.section(Paths, paths);
+        writer.section(PathNodes, pathNodes);
+        writer.section(GraphInfo, info);
+        writer.section(LayoutNodes, layoutNodes);
+        writer.section(LayoutPoints, layoutPoints);
+
+        return writer.finish(flags);
+    }
+
+    template<class T>
+    struct Array {
+        const T *data = nullptr;
+        size_t size = 0;
+
+        const T *begin() const { return data; }
+        const T *end() const { return data + size; }
+
+        const T &operator[](size_t idx) const {
+            if (idx >= size)
+                throw AssemblyGraphError("invalid snapshot: index out of bounds");
+            return data[idx];
+        }
+
+        Array slice(uint64_t begin, uint64_t count) const {
+            if (begin > size || count > size - begin)
+                throw AssemblyGraphError("invalid snapshot: range out of bounds");
+            return { data + begin, size_t(count) };
+        }
+    };
+
+    // Read-only memory mapped snapshot. All accesses to the data are bounds
+    // checked, so a corrupted file results in an exception.
+    class MappedSnapshot {
+    public:
+        explicit MappedSnapshot(const QString &filename)
+                : file_(filename) {
+            if (!file_.open(QIODevice::ReadOnly))
+                throw AssemblyGraphError("failed to open file: " + filename.toStdString());
+
+            size_ = uint64_t(file_.size());
+            if (size_ < sizeof(Header))
+                throw AssemblyGraphError("invalid snapshot: file is too short");
+
+            data_ = file_.map(0, file_.size());
+            if (!data_)
+                throw AssemblyGraphError("failed to map file: " + filename.toStdString());
+
+            std::memcpy(&header_, data_, sizeof(header_));
+            if (std::memcmp(header_.magic, Magic, sizeof(Magic)) != 0)
+                throw AssemblyGraphError("not a Bandage snapshot: " + filename.toStdString());
+            if (header_.byteOrder != ByteOrderMark)
+                throw AssemblyGraphError("snapshot was created on a machine with different byte order");
+            if (header_.version != Version)
+                throw AssemblyGraphError("unsupported snapshot version: " + std::to_string(header_.version));
+            if (header_.sectionCount < SectionCount ||
+                (size_ - sizeof(Header)) / sizeof(SectionEntry) < header_.sectionCount)
+                throw AssemblyGraphError("invalid snapshot: truncated section table");
+        }
+
+        [[nodiscard]] uint32_t flags() const { return header_.flags; }
+
+        template<class T>
+        Array<T> section(Section id) const {
+            SectionEntry entry;
+            std::memcpy(&entry, data_ + sizeof(Header) + id * sizeof(SectionEntry), sizeof(entry));
+            if (entry.offset > size_ || entry.size > size_ - entry.offset ||
+                entry.offset % alignof(T) || entry.size % sizeof(T))
+                throw AssemblyGraphError("invalid snapshot: malformed section " + std::to_string(id));
+
+            return { reinterpret_cast<const T*>(data_ + entry.offset), size_t(entry.size / sizeof(T)) };
+        }
+
+        // Interned string by index
+        [[nodiscard]] std::string_view string(uint32_t id) const {
+            auto begin = offsets_[id], end = offsets_[size_t(id) + 1];
+            if (begin > end || end > strings_.size)
+                throw AssemblyGraphError("invalid snapshot: malformed string table");
+            return { strings_.data + begin, size_t(end - begin) };
+        }
+
+        void loadStrings() {
+            offsets_ = section<uint64_t>(StringOffsets);
+            strings_ = section<char>(StringData);
+        }
+
+    private:
+        QFile file_;
+        const uchar *data_ = nullptr;
+        uint64_t size_ = 0;
+        Header header_;
+        Array<uint64_t> offsets_;
+        Array<char> strings_;
+    };
+
+    static std::string graphPrefix(const AssemblyGraph &graph) {
+        if (g_settings->multyGraphMode)
+            return std::to_string(graph.getGraphId()) + "_";
+        return {};
+    }
+
+    Flags load(const QString &filename,
+               AssemblyGraph &graph) {
+        MappedSnapshot mapped(filename);
+        mapped.loadStrings();
+
+        auto nodeRecords = mapped.section<NodeRecord>(Nodes);
+        auto sequences = mapped.section<SequenceRecord>(Sequences);
+        auto words = mapped.section<uint64_t>(SequenceWords);
+        auto nRuns = mapped.section<uint32_t>(NRuns);
+        std::string prefix = graphPrefix(graph);
+
+        // Validate everything the parallel part relies on in advance
+        for (const auto &record : nodeRecords) {
+            mapped.string(record.name);
+            if (record.rc != None && record.rc >= nodeRecords.size)
+                throw AssemblyGraphError("invalid snapshot: malformed node");
+            if (record.flags & ReverseComplementView) {
+                if (record.rc == None || nodeRecords[record.rc].flags & ReverseComplementView)
+                    throw AssemblyGraphError("invalid snapshot: malformed node");
+                continue;
+            }
+
+            const SequenceRecord &seq = sequences[record.sequence];
+            auto seqNRuns = nRuns.slice(2 * seq.nRuns, 2 * uint64_t(seq.nRunCount));
+            words.slice(seq.words, Sequence::PackedSize(seq.size, seqNRuns.data, seq.nRunCount));
+            for (size_t i = 0; i < seq.nRunCount; ++i)
+                if (seqNRuns.data[2 * i] > seq.size || seqNRuns.data[2 * i + 1] > seq.size - seqNRuns.data[2 * i])
+                    throw AssemblyGraphError("invalid snapshot: malformed sequence");
+        }
+
+        // Nodes that own their sequences are created in parallel, this is
+        // mostly copying of the packed sequence data
+        std::vector<DeBruijnNode*> nodes(nodeRecords.size, nullptr);
+        auto nodesGuard = qScopeGuard([&nodes] {
+            for (auto *node : nodes)
+                delete node;
+        });
+
+        auto makeNode = [&](const NodeRecord &record, const Sequence &seq) {
+            std::string name = prefix + std::string(mapped.string(record.name));
+            return new DeBruijnNode(graph.getGraphId(), QString::fromStdString(name),
+                                    record.depth, seq, record.length);
+        };
+
+        constexpr size_t BlockSize = 4096;
+        std::vector<size_t> blocks((nodes.size() + BlockSize - 1) / BlockSize);
+        std::iota(blocks.begin(), blocks.end(), 0);
+        QThreadPool pool;
+        pool.setMaxThreadCount(int(g_settings->threadCount()));
+        QtConcurrent::blockingMap(&pool, blocks, [&](size_t block) {
+            for (size_t id = block * BlockSize, e = std::min(id + BlockSize, nodes.size()); id < e; ++id) {
+                const NodeRecord &record = nodeRecords.data[id];
+                if (record.flags & ReverseComplementView)
+                    continue;
+
+                const SequenceRecord &seq = sequences.data[record.sequence];
+                nodes[id] = makeNode(record, Sequence(seq.size, words.data + seq.words,
+                                                      nRuns.data + 2 * seq.nRuns, seq.nRunCount));
+            }
+        });
+
+        for (size_t id = 0; id < nodes.size(); ++id) {
+            const NodeRecord &record = nodeRecords[id];
+            if (record.flags & ReverseComplementView)
+                nodes[id] = makeNode(record, nodes[record.rc]->getSequence().GetReverseComplement());
+        }
+
+        for (size_t id = 0; id < nodes.size(); ++id) {
+            const NodeRecord &record = nodeRecords[id];
+            if (record.rc != None)
+                nodes[id]->setReverseComplement(nodes.at(record.rc));
+        }
+
+        // Edges
+        auto edgeRecords = mapped.section<EdgeRecord>(Edges);
+        std::vector<DeBruijnEdge*> edges;
+        auto edgesGuard = qScopeGuard([&edges] {
+            for (auto *edge : edges)
+                delete edge;
+        });
+        edges.reserve(edgeRecords.size);
+        for (const auto &record : edgeRecords) {
+            if (record.overlapType > JUMP)
+                throw AssemblyGraphError("invalid snapshot: unknown overlap type");
+            auto *edge = new DeBruijnEdge(nodes.at(record.from), nodes.at(record.to));
+            edges.push_back(edge);
+            edge->setOverlap(record.overlap);
+            edge->setOverlapType(EdgeOverlapType(record.overlapType));
+        }
+
+        for (size_t id = 0; id < edges.size(); ++id) {
+            if (uint32_t rc = edgeRecords[id].rc; rc != None)
+                edges[id]->setReverseComplement(edges.at(rc));
+        }
+
+        auto adjacencyOffsets = mapped.section<uint64_t>(AdjacencyOffsets);
+        auto adjacency = mapped.section<uint32_t>(Adjacency);
+        if (adjacencyOffsets.size != nodes.size() + 1)
+            throw AssemblyGraphError("invalid snapshot: malformed adjacency");
+        for (size_t id = 0; id < nodes.size(); ++id) {
+            uint64_t begin = adjacencyOffsets[id], end = adjacencyOffsets[id + 1];
+            if (end < begin)
+                throw AssemblyGraphError("invalid snapshot: malformed adjacency");
+            for (uint32_t edge : adjacency.slice(begin, end - begin))
+                nodes[id]->addEdge(edges.at(edge));
+        }
+
+        // Now everything is consistent and could be handed over to the graph
+        for (size_t id = 0; id < nodes.size(); ++id)
+            graph.m_deBruijnGraphNodes.emplace(prefix + std::string(mapped.string(nodeRecords[id].name)), nodes[id]);
+        for (auto *edge : edges)
+            graph.m_deBruijnGraphEdges.emplace(std::make_pair(edge->getStartingNode(), edge->getEndingNode()), edge);
+        nodesGuard.dismiss();
+        edgesGuard.dismiss();
+
+        for (const auto &record : mapped.section<ColourRecord>(NodeColours))
+            graph.setCustomColour(nodes.at(record.owner), QColor::fromRgba(record.argb));
+        for (const auto &record : mapped.section<LabelRecord>(NodeLabels))
+            graph.setCustomLabel(nodes.at(record.node), QString::fromStdString(std::string(mapped.string(record.label))));
+        for (const auto &record : mapped.section<ColourRecord>(EdgeColours))
+            graph.setCustomColour(edges.at(record.owner), QColor::fromRgba(record.argb));
+        for (const auto &record : mapped.section<StyleRecord>(EdgeStyles)) {
+            graph.setCustomStyle(edges.at(record.edge), record.width);
+            graph.setCustomStyle(edges.at(record.edge), Qt::PenStyle(record.lineStyle));
+        }
+
+        auto makeTag = [&mapped](const TagRecord &record) {
+            std::string_view name(record.name, 2), type(&record.type, 1);
+            switch (record.kind) {
+                case IntTag:
+                    return gfa::tag(name, type, int64_t(record.value));
+                case StringTag:
+                    return gfa::tag(name, type, std::string(mapped.string(uint32_t(record.value))));
+                case FloatTag: {
+                    float f;
+                    uint32_t bits = uint32_t(record.value);
+                    std::memcpy(&f, &bits, sizeof(f));
+                    return gfa::tag(name, type, f);
+                }
+                default:
+                    throw AssemblyGraphError("invalid snapshot: unknown tag kind");
+            }
+        };
+        for (const auto &record : mapped.section<TagRecord>(NodeTags))
+            graph.m_nodeTags[nodes.at(record.owner)].push_back(makeTag(record));
+        for (const auto &record : mapped.section<TagRecord>(EdgeTags))
+            graph.m_edgeTags[edges.at(record.owner)].push_back(makeTag(record));
+
+        // Paths
+        auto pathNodes = mapped.section<uint32_t>(PathNodes);
+        for (const auto &record : mapped.section<PathRecord>(Paths)) {
+            std::vector<DeBruijnNode*> nodesInPath;
+            nodesInPath.reserve(record.nodeCount);
+            for (uint32_t node : pathNodes.slice(record.nodes, record.nodeCount))
+                nodesInPath.push_back(nodes.at(node));
+
+            auto path = Path::makeFromOrderedNodes(nodesInPath, record.circular);
+            if (!path.isEmpty()) {
+                if (record.startNode != None)
+                    path.setStartLocation(GraphLocation(nodes.at(record.startNode), record.startPosition));
+                if (record.endNode != None)
+                    path.setEndLocation(GraphLocation(nodes.at(record.endNode), record.endPosition));
+            }
+            graph.m_deBruijnGraphPaths[std::string(mapped.string(record.name))] = new Path(std::move(path));
+        }
+
+        auto info = mapped.section<GraphInfoRecord>(GraphInfo);
+        if (info.size) {
+            graph.m_depthTag = QString::fromStdString(std::string(mapped.string(info[0].depthTag)));
+            if (info[0].sequencesLoadedFromFasta > TRIED)
+                throw AssemblyGraphError("invalid snapshot: malformed graph information");
+            graph.m_sequencesLoadedFromFasta = SequencesLoadedFromFasta(info[0].sequencesLoadedFromFasta);
+        }
+
+        Flags flags;
+        flags.hasCustomLabels = mapped.flags() & CustomLabels;
+        flags.hasCustomColours = mapped.flags() & CustomColours;
+        flags.hasLayout = mapped.flags() & HasLayout;
+        return flags;
+    }
+
+    bool loadLayout(const QString &filename,
+                    GraphLayout &layout) {
+        MappedSnapshot mapped(filename);
+        if (!(mapped.flags() & HasLayout))
+            throw std::runtime_error("snapshot does not contain a layout");
+
+        mapped.loadStrings();
+        auto nodeRecords = mapped.section<NodeRecord>(Nodes);
+        auto points = mapped.section<PointRecord>(LayoutPoints);
+        const AssemblyGraph &graph = layout.graph();
+        std::string prefix = graphPrefix(graph);
+        for (const auto &record : mapped.section<LayoutRecord>(LayoutNodes)) {
+            std::string name = prefix + std::string(mapped.string(nodeRecords[record.node].name));
+            auto it = graph.m_deBruijnGraphNodes.find(name);
+            if (it == graph.m_deBruijnGraphNodes.end())
+                throw std::runtime_error("graph does not contain node: " + name);
+
+            for (const auto &point : points.slice(record.points, record.count))
+                layout.add(*it, { point.x, point.y });
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,52 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "layout/graphlayout.h"
+
+#include <QString>
+
+class AssemblyGraph;
+
+// Native binary graph snapshot (.bandage files). The snapshot keeps the graph
+// in a ready-to-use form: sequences are stored 2-bit packed, names are
+// interned and nodes / edges are referenced by their indices, so loading is
+// a matter of mapping the file and creating the objects.
+namespace snapshot {
+    struct Flags {
+        bool hasCustomLabels = false;
+        bool hasCustomColours = false;
+        bool hasLayout = false;
+    };
+
+    // Cursory check of the file magic
+    bool isSnapshot(const QString &filename);
+
+    bool save(const QString &filename,
+              const AssemblyGraph &graph,
+              const GraphLayout *layout = nullptr);
+
+    // Throws AssemblyGraphError if the file is not a valid snapshot
+    Flags load(const QString &filename,
+               AssemblyGraph &graph);
+
+    // Loads the layout stored in the snapshot for nodes of layout.graph().
+    // Throws std::runtime_error on errors
+    bool loadLayout(const QString &filename,
+                    GraphLayout &layout);
+}
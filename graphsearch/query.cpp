@@ -20,6 +20,9 @@
 #include "program/settings.h"
 #include "graph/path.h"
 #include "graph/debruijnnode.h"
+#include "graph/assemblygraph.h"
+#include "graph/assemblygraphlist.h"
+#include "program/globals.h"
 #include <limits>
 #include <utility>
 #include <vector>
@@ -147,7 +150,14 @@ void Query::findQueryPaths() {
             else //neither are on
                 maxLength = std::numeric_limits<int>::max();
 
-            possiblePaths.append(Path::getAllPossiblePaths(startLocation,
+            //Hits of different graphs can not be connected by a path
+            int graphId = startLocation.getNode()->getGraphId();
+            const AssemblyGraph *graph = g_assemblyGraph->m_graphMap.value(graphId);
+            if (!graph || endLocation.getNode()->getGraphId() != graphId)
+                continue;
+
+            possiblePaths.append(Path::getAllPossiblePaths(*graph,
+                                                           startLocation,
                                                            endLocation,
                                                            g_settings->maxQueryPathNodes - 1,
                                                            minLength,
@@ -1,25 +1,28 @@
 #include "hicmanager.h"
 
+#include "io/linereader.h"
+
 HiCManager::HiCManager()
 {}
 
 bool HiCManager::load(AssemblyGraph &graph, QString filename, QString* errormsg)
 {
     findComponents(graph);
-    QFile hiCMatrix(filename);
-    if (!hiCMatrix.open(QIODevice::ReadOnly))
+    io::LineReader reader(filename.toStdString());
+    if (!reader.isOpen())
     {
         *errormsg = "Unable to read from specified file.";
         return false;
     }
 
-    QTextStream in(&hiCMatrix);
     QApplication::processEvents();
-    QString line = in.readLine();
+    std::string_view lineView;
+    reader.readLine(lineView); // header
     int maxWeight = 0;
 
-    while ((line = in.readLine()) != "") {
-        QStringList data = line.split(QRegularExpression("\t"));
+    while (reader.readLine(lineView) && !lineView.empty()) {
+        QString line = QString::fromLatin1(lineView.data(), qsizetype(lineView.size()));
+        QStringList data = line.split('\t');
         QString firstNodeName;
         QString secondNodeName;
         if(data.at(0).left(2) == "Id")
@@ -27,6 +27,10 @@
 #include <lexy/input/argv_input.hpp>
 #include <lexy_ext/report_error.hpp>
 #include <optional>
+#include <limits>
+
+#include <cstring>
+#include <cstdlib>
 
 #include "cigar.inl"
 
@@ -208,7 +212,311 @@ struct record {
 }; // namespace grammar
 
 
-std::optional<gfa::record> parseRecord(const char* line, size_t len) {
+namespace fast {
+// Hand-written parser for the most common record shapes: segments and links
+// with i/f/Z/A tags. It accepts exactly the same language as the grammar
+// above (for these records) and produces identical results. Everything else
+// (other records, other tag types, malformed input) is rejected, so the
+// caller could fall back to the generic parser which also takes care of
+// error reporting.
+
+static constexpr uint64_t ones = 0x0101010101010101ULL;
+static constexpr uint64_t highBits = 0x8080808080808080ULL;
+
+// Returns the length of the prefix consisting of ASCII letters. Checks 8
+// characters at once.
+static size_t alphaPrefix(const char *s, size_t len) {
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t w;
+        std::memcpy(&w, s + i, sizeof(w));
+        uint64_t lower = w | (0x20 * ones);
+        // High bits are set for characters >= 'a' and >= '{' respectively.
+        // No carries are possible as all characters are below 0x80.
+        uint64_t geA = lower + (0x80 - 'a') * ones, geZ = lower + (0x80 - '{') * ones;
+        if ((w & highBits) || ((geA & ~geZ) & highBits) != highBits)
+            break;
+    }
+
+    for (; i < len; ++i) {
+        unsigned char c = s[i] | 0x20;
+        if (c < 'a' || c > 'z')
+            break;
+    }
+
+    return i;
+}
+
+struct cursor {
+    const char *pos, *end;
+
+    [[nodiscard]] bool atEnd() const { return pos == end; }
+    [[nodiscard]] char peek() const { return pos != end ? *pos : '\0'; }
+
+    bool consume(char c) {
+        if (peek() != c)
+            return false;
+        ++pos;
+        return true;
+    }
+
+    // Current field (up to the next tab or the end of line)
+    [[nodiscard]] std::string_view field() const {
+        const char *tab = static_cast<const char*>(std::memchr(pos, '\t', end - pos));
+        return { pos, size_t((tab ? tab : end) - pos) };
+    }
+
+    // The field is followed by the end of line or by tab
+    bool endOfField() {
+        return atEnd() || consume('\t');
+    }
+};
+
+static bool isGraph(char c) {
+    return c >= '!' && c <= '~';
+}
+
+// [!-)+-<>-~][!-~]* with ',' and ';' excluded
+static std::optional<std::string_view> segmentName(cursor &c) {
+    std::string_view name = c.field();
+    if (name.empty())
+        return {};
+
+    char first = name.front();
+    if (first == '=' || first == '*')
+        return {};
+    for (char ch : name)
+        if (!isGraph(ch) || ch == ',' || ch == ';')
+            return {};
+
+    c.pos += name.size();
+    return name;
+}
+
+static std::optional<std::string_view> orientation(cursor &c) {
+    char o = c.peek();
+    if (o != '+' && o != '-')
+        return {};
+
+    return std::string_view{c.pos++, 1};
+}
+
+template<class T>
+static std::optional<T> digits(cursor &c, bool noLeadingZero) {
+    const char *start = c.pos;
+    T val = 0;
+    while (!c.atEnd() && *c.pos >= '0' && *c.pos <= '9') {
+        T digit = *c.pos - '0';
+        if (val > (std::numeric_limits<T>::max() - digit) / 10)
+            return {};
+        val = val * 10 + digit;
+        ++c.pos;
+    }
+
+    if (c.pos == start ||
+        (noLeadingZero && *start == '0' && c.pos - start > 1))
+        return {};
+
+    return val;
+}
+
+static std::optional<cigar_string> cigar(cursor &c) {
+    cigar_string res;
+    while (!c.atEnd() && *c.pos != '\t') {
+        if (c.consume('.')) {
+            res.push_back(cigarop{0, 0});
+            continue;
+        }
+
+        auto count = digits<uint32_t>(c, false);
+        if (!count || c.atEnd())
+            return {};
+
+        switch (char op = *c.pos++) {
+            case 'M': case 'I': case 'D': case 'N': case 'S':
+            case 'H': case 'P': case 'X': case '=': case 'J':
+                res.push_back(cigarop{*count, op});
+                break;
+            default:
+                return {};
+        }
+    }
+
+    if (res.empty())
+        return {};
+
+    return res;
+}
+
+// Skips [0-9]+, returns the number of digits skipped
+static size_t skipDigits(cursor &c) {
+    const char *start = c.pos;
+    while (!c.atEnd() && *c.pos >= '0' && *c.pos <= '9')
+        ++c.pos;
+    return c.pos - start;
+}
+
+static std::optional<float> floatValue(cursor &c) {
+    // -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-][0-9]+)?
+    const char *start = c.pos;
+    c.consume('-');
+    const char *intStart = c.pos;
+    size_t intDigits = skipDigits(c);
+    if (!intDigits || (*intStart == '0' && intDigits > 1))
+        return {};
+    if (c.consume('.') && !skipDigits(c))
+        return {};
+    if (c.consume('e') || c.consume('E')) {
+        if (!c.consume('+') && !c.consume('-'))
+            return {};
+        if (!skipDigits(c))
+            return {};
+    }
+
+    // The line is not necessarily null-terminated
+    char buf[64];
+    size_t len = c.pos - start;
+    if (len >= sizeof(buf))
+        return {};
+    std::memcpy(buf, start, len);
+    buf[len] = '\0';
+
+    return float(::atof(buf));
+}
+
+static std::optional<gfa::tag> tagValue(cursor &c) {
+    if (c.end - c.pos < 5)
+        return {};
+
+    const char *p = c.pos;
+    auto isAlpha = [](char ch) { return (ch | 0x20) >= 'a' && (ch | 0x20) <= 'z'; };
+    auto isAlnum = [&](char ch) { return isAlpha(ch) || (ch >= '0' && ch <= '9'); };
+    if (!isAlpha(p[0]) || !isAlnum(p[1]) || p[2] != ':' || p[4] != ':')
+        return {};
+
+    std::string_view name{p, 2}, type{p + 3, 1};
+    c.pos += 5;
+    switch (type.front()) {
+        case 'i': {
+            bool negative = c.consume('-');
+            auto val = digits<int64_t>(c, true);
+            if (!val)
+                return {};
+            return gfa::tag{name, type, negative ? -*val : *val};
+        }
+        case 'f': {
+            auto val = floatValue(c);
+            if (!val)
+                return {};
+            return gfa::tag{name, type, *val};
+        }
+        case 'A': {
+            if (c.atEnd() || !isAlnum(*c.pos))
+                return {};
+            return gfa::tag{name, type, std::string(c.pos++, 1)};
+        }
+        case 'Z': {
+            std::string_view val = c.field();
+            if (val.empty())
+                return {};
+            for (char ch : val)
+                if (ch < ' ' || ch > '~')
+                    return {};
+            c.pos += val.size();
+            return gfa::tag{name, type, std::string(val)};
+        }
+        default:
+            return {};
+    }
+}
+
+// Tags after the mandatory fields, the tab after the last mandatory field
+// is already consumed. Trailing tab is allowed.
+static bool tags(cursor &c, std::vector<gfa::tag> &res) {
+    while (!c.atEnd()) {
+        auto tag = tagValue(c);
+        if (!tag || !c.endOfField())
+            return false;
+        res.push_back(std::move(*tag));
+    }
+
+    return true;
+}
+
+static std::optional<gfa::record> segment(cursor &c) {
+    auto name = segmentName(c);
+    if (!name || !c.consume('\t'))
+        return {};
+
+    std::string_view seq;
+    if (!c.consume('*')) {
+        size_t len = alphaPrefix(c.pos, c.end - c.pos);
+        if (!len)
+            return {};
+        seq = { c.pos, len };
+        c.pos += len;
+    }
+
+    std::vector<gfa::tag> tagValues;
+    if (!c.atEnd() && (!c.consume('\t') || c.atEnd() || !tags(c, tagValues)))
+        return {};
+
+    if (seq.empty())
+        return gfa::record{std::in_place_type<gfa::segment>, *name, std::move(tagValues)};
+
+    return gfa::record{std::in_place_type<gfa::segment>, *name, seq, std::move(tagValues)};
+}
+
+static std::optional<gfa::record> link(cursor &c) {
+    auto lhs = segmentName(c);
+    if (!lhs || !c.consume('\t'))
+        return {};
+    auto lhsOrient = orientation(c);
+    if (!lhsOrient || !c.consume('\t'))
+        return {};
+    auto rhs = segmentName(c);
+    if (!rhs || !c.consume('\t'))
+        return {};
+    auto rhsOrient = orientation(c);
+    if (!rhsOrient || !c.consume('\t'))
+        return {};
+
+    std::optional<cigar_string> overlap;
+    if (!c.consume('*')) {
+        overlap = cigar(c);
+        if (!overlap)
+            return {};
+    }
+
+    std::vector<gfa::tag> tagValues;
+    if (!c.atEnd() && (!c.consume('\t') || c.atEnd() || !tags(c, tagValues)))
+        return {};
+
+    if (!overlap)
+        return gfa::record{std::in_place_type<gfa::link>,
+                           *lhs, *lhsOrient, *rhs, *rhsOrient, std::move(tagValues)};
+
+    return gfa::record{std::in_place_type<gfa::link>,
+                       *lhs, *lhsOrient, *rhs, *rhsOrient, std::move(*overlap), std::move(tagValues)};
+}
+
+static std::optional<gfa::record> parseRecord(const char *line, size_t len) {
+    if (len < 2 || line[1] != '\t')
+        return {};
+
+    cursor c{line + 2, line + len};
+    switch (line[0]) {
+        case 'S':
+            return segment(c);
+        case 'L':
+            return link(c);
+        default:
+            return {};
+    }
+}
+} // namespace fast
+
+std::optional<gfa::record> parseRecordGeneric(const char* line, size_t len) {
     lexy::visualization_options opts;
     opts.max_lexeme_width = 35;
 
@@ -219,4 +527,11 @@ std::optional<gfa::record> parseRecord(const char* line, size_t len) {
     return {};
 }
 
+std::optional<gfa::record> parseRecord(const char* line, size_t len) {
+    if (auto result = fast::parseRecord(line, len))
+        return result;
+
+    return parseRecordGeneric(line, len);
+}
+
 };
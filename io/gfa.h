@@ -196,5 +196,10 @@ struct path {
 
 using record = std::variant<header, segment, link, gaplink, path>;
 
+// Parses a single line (without the line terminator). Common shapes of
+// segment and link records are handled by a specialized parser, everything
+// else goes through the generic grammar.
 std::optional<gfa::record> parseRecord(const char* line, size_t len);
+// Same as above, but always uses the generic grammar
+std::optional<gfa::record> parseRecordGeneric(const char* line, size_t len);
 } // namespace gfa
@@ -0,0 +1,132 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage
+
+// Bandage is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "linereader.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <climits>
+#include <cstring>
+
+namespace io {
+    // zlib internal buffer size. The reads we issue are much larger than
+    // this, so zlib would inflate directly into our block buffer.
+    static constexpr unsigned ZlibBufferSize = 256 << 10;
+
+    LineReader::LineReader(const std::string &fileName, size_t blockSize)
+            : fp_(gzopen(fileName.c_str(), "rb"), gzclose),
+              buf_(std::max<size_t>(blockSize, 1)) {
+        if (fp_)
+            gzbuffer(fp_.get(), ZlibBufferSize);
+    }
+
+    // Moves the unconsumed tail of the buffer to the front and appends the
+    // next block of decompressed data. The buffer is grown if a single line
+    // does not fit into it. Returns false if no more data is available.
+    bool LineReader::fill() {
+        if (eof_ || !fp_)
+            return false;
+
+        size_t tail = end_ - begin_;
+        if (begin_ > 0) {
+            std::memmove(buf_.data(), buf_.data() + begin_, tail);
+            begin_ = 0; end_ = tail;
+        }
+
+        if (end_ == buf_.size())
+            buf_.resize(buf_.size() * 2);
+
+        size_t toRead = std::min<size_t>(buf_.size() - end_, INT_MAX);
+        int read = gzread(fp_.get(), buf_.data() + end_, unsigned(toRead));
+        if (read < 0) {
+            int err = 0;
+            const char *msg = gzerror(fp_.get(), &err);
+            throw std::runtime_error(std::string("failed to read input: ") + msg);
+        }
+
+        if (read == 0) {
+            eof_ = true;
+            return false;
+        }
+
+        end_ += read;
+        return true;
+    }
+
+    bool LineReader::readLine(std::string_view &line) {
+        // Number of bytes after begin_ already known to contain no newline
+        size_t scanned = 0;
+        while (true) {
+            const char *start = buf_.data() + begin_;
+            size_t avail = end_ - begin_;
+            const char *nl = avail > scanned ?
+                             static_cast<const char*>(std::memchr(start + scanned, '\n', avail - scanned)) : nullptr;
+            if (nl || !fill()) {
+                size_t len, consumed;
+                if (nl) {
+                    len = nl - start; consumed = len + 1;
+                } else {
+                    // Last line without terminator (or the end of input)
+                    start = buf_.data() + begin_;
+                    len = consumed = end_ - begin_;
+                    if (!len)
+                        return false;
+                }
+
+                begin_ += consumed;
+                lineOffset_ = offset_;
+                offset_ += consumed;
+                if (len && start[len - 1] == '\r')
+                    len -= 1;
+
+                line = { start, len };
+                return true;
+            }
+
+            scanned = avail;
+        }
+    }
+
+    bool LineReader::readChunk(std::vector<char> &chunk, size_t minSize) {
+        chunk.clear();
+        while (chunk.size() < minSize) {
+            if (begin_ == end_ && !fill())
+                break;
+
+            // Take everything up to the last newline in the buffer
+            const char *start = buf_.data() + begin_;
+            size_t len = end_ - begin_;
+            while (len && start[len - 1] != '\n')
+                len -= 1;
+
+            if (!len) {
+                // No complete line is buffered. Try to read more and take
+                // the unterminated tail if we're at the end of input.
+                if (fill())
+                    continue;
+                len = end_ - begin_;
+                start = buf_.data() + begin_;
+            }
+
+            chunk.insert(chunk.end(), start, start + len);
+            begin_ += len;
+            offset_ += len;
+        }
+
+        return !chunk.empty();
+    }
+}
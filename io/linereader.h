@@ -0,0 +1,71 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage
+
+// Bandage is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+#include <zlib.h>
+
+namespace io {
+    // Line-oriented reader for plain, gzip and BGZF (multi-member gzip) files.
+    // The input is decompressed in large blocks and lines are located via
+    // memchr(), so no per-character calls into zlib happen. Returned lines
+    // are views into the internal buffer and are only valid until the next
+    // call to readLine(). Line terminators ("\n" or "\r\n") are stripped.
+    class LineReader {
+    public:
+        static constexpr size_t DefaultBlockSize = 4 << 20;
+
+        explicit LineReader(const std::string &fileName,
+                            size_t blockSize = DefaultBlockSize);
+
+        [[nodiscard]] bool isOpen() const { return bool(fp_); }
+
+        // Returns false when the end of input is reached. Throws
+        // std::runtime_error on decompression / read errors.
+        bool readLine(std::string_view &line);
+
+        // Replaces the contents of chunk with a run of whole lines (with
+        // their terminators) of at least minSize bytes, unless the end of
+        // input is reached earlier. Might be freely intermixed with
+        // readLine(). Returns false when the end of input is reached.
+        bool readChunk(std::vector<char> &chunk, size_t minSize);
+
+        // Offset of the start of the last returned line in the decompressed
+        // stream.
+        [[nodiscard]] uint64_t lineOffset() const { return lineOffset_; }
+        // Total number of decompressed bytes consumed so far.
+        [[nodiscard]] uint64_t offset() const { return offset_; }
+
+    private:
+        bool fill();
+
+        std::unique_ptr<std::remove_pointer<gzFile>::type, decltype(&gzclose)> fp_;
+        std::vector<char> buf_;
+        size_t begin_ = 0, end_ = 0;
+        uint64_t lineOffset_ = 0, offset_ = 0;
+        bool eof_ = false;
+    };
+}
@@ -0,0 +1,260 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage
+
+// Bandage is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "randomaccessreader.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <climits>
+#include <cstring>
+
+#include <zlib.h>
+
+namespace io {
+    // Maximum distance of deflate back references
+    static constexpr unsigned WindowSize = 32768;
+    static constexpr size_t InputSize = 256 << 10;
+
+    static bool seek(FILE *fp, uint64_t offset) {
+#ifdef _WIN32
+        return _fseeki64(fp, int64_t(offset), SEEK_SET) == 0;
+#else
+        return fseeko(fp, off_t(offset), SEEK_SET) == 0;
+#endif
+    }
+
+    namespace {
+        struct Inflater {
+            z_stream strm{};
+            bool initialized = false;
+
+            ~Inflater() {
+                if (initialized)
+                    inflateEnd(&strm);
+            }
+
+            // windowBits: 31 for gzip member, -15 for raw deflate data
+            void start(int windowBits) {
+                int ret = initialized ? inflateReset2(&strm, windowBits) : inflateInit2(&strm, windowBits);
+                if (ret != Z_OK)
+                    throw std::runtime_error("failed to initialize decompression");
+                initialized = true;
+            }
+        };
+    }
+
+    RandomAccessReader::RandomAccessReader(const std::string &fileName, uint64_t span)
+            : fp_(fopen(fileName.c_str(), "rb"), fclose),
+              span_(std::max<uint64_t>(span, WindowSize)) {
+        if (!fp_)
+            return;
+
+        unsigned char magic[2];
+        compressed_ = fread(magic, 1, 2, fp_.get()) == 2 && magic[0] == 0x1f && magic[1] == 0x8b;
+    }
+
+    // Inflates the whole file once recording an access point every span_
+    // bytes of output. Points are only possible at deflate block boundaries
+    // (where Z_BLOCK makes inflate() stop) and at the gzip member starts.
+    void RandomAccessReader::buildIndex() {
+        FILE *fp = fp_.get();
+        if (!seek(fp, 0))
+            throw std::runtime_error("failed to seek input");
+
+        index_.clear();
+        index_.push_back({0, 0, 0, true, {}});
+
+        Inflater inflater;
+        inflater.start(31);
+        z_stream &strm = inflater.strm;
+
+        std::vector<unsigned char> input(InputSize), window(WindowSize);
+        uint64_t totalIn = 0, totalOut = 0, last = 0;
+        bool memberEnded = false;
+        while (true) {
+            if (strm.avail_in == 0) {
+                strm.avail_in = unsigned(fread(input.data(), 1, input.size(), fp));
+                if (ferror(fp))
+                    throw std::runtime_error("failed to read input");
+                if (strm.avail_in == 0)
+                    break;
+                strm.next_in = input.data();
+            }
+
+            if (strm.avail_out == 0) {
+                strm.avail_out = WindowSize;
+                strm.next_out = window.data();
+            }
+
+            totalIn += strm.avail_in; totalOut += strm.avail_out;
+            int ret = inflate(&strm, Z_BLOCK);
+            totalIn -= strm.avail_in; totalOut -= strm.avail_out;
+
+            if (ret == Z_NEED_DICT || ret == Z_DATA_ERROR || ret == Z_MEM_ERROR) {
+                // Trailing garbage after the last member is ignored, same as
+                // gzread() does
+                if (memberEnded && strm.total_out == 0)
+                    return;
+                throw std::runtime_error("failed to decompress input");
+            }
+
+            if (ret == Z_STREAM_END) {
+                memberEnded = true;
+                if (inflateReset(&strm) != Z_OK)
+                    throw std::runtime_error("failed to decompress input");
+                if (totalOut - last > span_) {
+                    index_.push_back({totalOut, totalIn, 0, true, {}});
+                    last = totalOut;
+                }
+                continue;
+            }
+
+            // At the end of a block which is not the last one of the member
+            if ((strm.data_type & 128) && !(strm.data_type & 64) &&
+                totalOut - last > span_) {
+                AccessPoint point{totalOut, totalIn, strm.data_type & 7, false,
+                                  std::vector<unsigned char>(WindowSize)};
+                // The window is circular, the oldest data starts right after
+                // the last output
+                size_t left = strm.avail_out;
+                std::memcpy(point.window.data(), window.data() + WindowSize - left, left);
+                std::memcpy(point.window.data() + left, window.data(), WindowSize - left);
+                index_.push_back(std::move(point));
+                last = totalOut;
+            }
+        }
+
+        if (!memberEnded || strm.total_in > 0)
+            throw std::runtime_error("unexpected end of compressed input");
+    }
+
+    size_t RandomAccessReader::extract(const AccessPoint &point,
+                                       uint64_t offset, size_t size, char *out) {
+        FILE *fp = fp_.get();
+        if (!seek(fp, point.in - (point.bits ? 1 : 0)))
+            throw std::runtime_error("failed to seek input");
+
+        Inflater inflater;
+        z_stream &strm = inflater.strm;
+        bool raw = !point.member;
+        if (raw) {
+            inflater.start(-15);
+            if (point.bits) {
+                int c = fgetc(fp);
+                if (c == EOF)
+                    throw std::runtime_error("failed to read input");
+                inflatePrime(&strm, point.bits, c >> (8 - point.bits));
+            }
+            inflateSetDictionary(&strm, point.window.data(), WindowSize);
+        } else
+            inflater.start(31);
+
+        std::vector<unsigned char> input(InputSize);
+        std::vector<char> discard(WindowSize);
+        uint64_t skip = offset - point.out;
+        size_t got = 0, trailer = 0;
+        bool memberEnded = false;
+        while (got < size) {
+            if (strm.avail_in == 0) {
+                strm.avail_in = unsigned(fread(input.data(), 1, input.size(), fp));
+                if (ferror(fp))
+                    throw std::runtime_error("failed to read input");
+                if (strm.avail_in == 0) {
+                    if (memberEnded && trailer == 0 && strm.total_in == 0)
+                        break;
+                    throw std::runtime_error("unexpected end of compressed input");
+                }
+                strm.next_in = input.data();
+            }
+
+            // Raw inflate stops before the gzip trailer of the member, skip
+            // it and continue with the next member
+            if (trailer) {
+                size_t n = std::min<size_t>(trailer, strm.avail_in);
+                strm.next_in += n; strm.avail_in -= unsigned(n);
+                trailer -= n;
+                if (!trailer) {
+                    inflater.start(31);
+                    raw = false;
+                }
+                continue;
+            }
+
+            if (skip) {
+                strm.next_out = reinterpret_cast<unsigned char *>(discard.data());
+                strm.avail_out = unsigned(std::min<uint64_t>(skip, discard.size()));
+            } else {
+                strm.next_out = reinterpret_cast<unsigned char *>(out + got);
+                strm.avail_out = unsigned(std::min<size_t>(size - got, UINT_MAX));
+            }
+
+            unsigned avail = strm.avail_out;
+            int ret = inflate(&strm, Z_NO_FLUSH);
+            size_t produced = avail - strm.avail_out;
+            if (skip)
+                skip -= produced;
+            else
+                got += produced;
+
+            if (ret == Z_NEED_DICT || ret == Z_DATA_ERROR || ret == Z_MEM_ERROR) {
+                if (memberEnded && strm.total_out == 0)
+                    break;
+                throw std::runtime_error("failed to decompress input");
+            }
+
+            if (ret == Z_STREAM_END) {
+                memberEnded = true;
+                if (raw)
+                    trailer = 8;
+                else if (inflateReset(&strm) != Z_OK)
+                    throw std::runtime_error("failed to decompress input");
+            }
+        }
+
+        return got;
+    }
+
+    size_t RandomAccessReader::read(uint64_t offset, size_t size, std::string &out) {
+        out.clear();
+        if (!fp_)
+            throw std::runtime_error("input is not open");
+
+        if (!compressed_) {
+            if (!seek(fp_.get(), offset))
+                throw std::runtime_error("failed to seek input");
+            out.resize(size);
+            size_t read = fread(out.data(), 1, size, fp_.get());
+            if (ferror(fp_.get()))
+                throw std::runtime_error("failed to read input");
+            out.resize(read);
+            return read;
+        }
+
+        if (!indexed_) {
+            buildIndex();
+            indexed_ = true;
+        }
+
+        auto point = std::upper_bound(index_.begin(), index_.end(), offset,
+                                      [](uint64_t offset, const AccessPoint &point) {
+                                          return offset < point.out;
+                                      });
+        out.resize(size);
+        out.resize(extract(*std::prev(point), offset, size, out.data()));
+        return out.size();
+    }
+}
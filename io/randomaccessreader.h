@@ -0,0 +1,72 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage
+
+// Bandage is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <string>
+#include <memory>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+namespace io {
+    // Random access to the decompressed contents of plain, gzip and BGZF
+    // (multi-member gzip) files. Offsets are the same as the ones reported by
+    // io::LineReader. For compressed files an index of access points (deflate
+    // block boundaries with the preceding 32k of output) is built on the
+    // first read, so a read only needs to inflate from the closest preceding
+    // access point. The reader is not thread-safe.
+    class RandomAccessReader {
+    public:
+        // Distance between the access points in the decompressed stream
+        static constexpr uint64_t DefaultSpan = 4 << 20;
+
+        explicit RandomAccessReader(const std::string &fileName,
+                                    uint64_t span = DefaultSpan);
+
+        [[nodiscard]] bool isOpen() const { return bool(fp_); }
+        [[nodiscard]] bool isCompressed() const { return compressed_; }
+
+        // Replaces the contents of out with up to size bytes starting at the
+        // given offset. Less bytes are returned if the end of input is
+        // reached. Throws std::runtime_error on read / decompression errors.
+        size_t read(uint64_t offset, size_t size, std::string &out);
+
+        // Number of access points, once the first read built the index
+        [[nodiscard]] size_t accessPoints() const { return index_.size(); }
+
+    private:
+        struct AccessPoint {
+            uint64_t out;    // Offset in the decompressed stream
+            uint64_t in;     // Offset of the first full byte in the file
+            int bits;        // Number of bits of the preceding byte to use
+            bool member;     // Start of a gzip member (no window needed)
+            std::vector<unsigned char> window;
+        };
+
+        void buildIndex();
+        size_t extract(const AccessPoint &point, uint64_t offset, size_t size, char *out);
+
+        std::unique_ptr<FILE, decltype(&fclose)> fp_;
+        bool compressed_ = false;
+        bool indexed_ = false;
+        uint64_t span_;
+        std::vector<AccessPoint> index_;
+    };
+}
@@ -0,0 +1,170 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "coarsening.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace layout {
+    // Whether the node is kept in the coarse graph: path ends, branching
+    // nodes and nodes with self-loops
+    static bool isKept(ogdf::node v) {
+        if (v->degree() != 2)
+            return true;
+
+        for (ogdf::adjEntry adj : v->adjEntries) {
+            if (adj->twinNode() == v)
+                return true;
+        }
+
+        return false;
+    }
+
+    CoarseGraph::CoarseGraph(const ogdf::GraphAttributes &GA,
+                             const ogdf::EdgeArray<double> &edgeLengths)
+            : m_GA(m_G, GA.attributes()), m_edgeLengths(m_G),
+              m_copies(GA.constGraph(), nullptr) {
+        const ogdf::Graph &G = GA.constGraph();
+
+        ogdf::NodeArray<bool> kept(G, false);
+        for (ogdf::node v : G.nodes) {
+            kept[v] = isKept(v);
+            if (kept[v])
+                copy(GA, v);
+        }
+
+        // Follows the path starting with the given edge up to the next kept
+        // node
+        ogdf::EdgeArray<bool> visited(G, false);
+        auto addChain = [&](ogdf::node start, ogdf::adjEntry adj) {
+            Chain chain;
+            chain.nodes.push_back(start);
+            chain.offsets.push_back(0);
+            while (true) {
+                ogdf::edge e = adj->theEdge();
+                visited[e] = true;
+
+                ogdf::node v = adj->twinNode();
+                chain.nodes.push_back(v);
+                chain.offsets.push_back(chain.offsets.back() + edgeLengths[e]);
+                if (kept[v])
+                    break;
+
+                // Degree-2 node without self-loops, leave it by the other edge
+                adj = adj->twin()->cyclicSucc();
+            }
+
+            size_t n = chain.nodes.size() - 1;
+            size_t k = size_t(std::ceil(std::sqrt(double(n))));
+            double length = chain.offsets.back();
+
+            chain.coarse.push_back(m_copies[chain.nodes.front()]);
+            size_t segment = 0;
+            for (size_t j = 1; j < k; ++j) {
+                double offset = length * double(j) / double(k);
+                while (segment + 1 < n && chain.offsets[segment + 1] < offset)
+                    ++segment;
+
+                ogdf::node from = chain.nodes[segment], to = chain.nodes[segment + 1];
+                double segmentLength = chain.offsets[segment + 1] - chain.offsets[segment];
+                double f = segmentLength > 0 ? (offset - chain.offsets[segment]) / segmentLength : 0;
+
+                ogdf::node c = m_G.newNode();
+                m_GA.x(c) = GA.x(from) + f * (GA.x(to) - GA.x(from));
+                m_GA.y(c) = GA.y(from) + f * (GA.y(to) - GA.y(from));
+                m_GA.width(c) = GA.width(from);
+                m_GA.height(c) = GA.height(from);
+                chain.coarse.push_back(c);
+            }
+            chain.coarse.push_back(m_copies[chain.nodes.back()]);
+
+            for (size_t j = 0; j < k; ++j) {
+                ogdf::edge e = m_G.newEdge(chain.coarse[j], chain.coarse[j + 1]);
+                m_edgeLengths[e] = length / double(k);
+            }
+
+            m_chains.emplace_back(std::move(chain));
+        };
+
+        for (ogdf::node v : G.nodes) {
+            if (!kept[v])
+                continue;
+            for (ogdf::adjEntry adj : v->adjEntries) {
+                if (!visited[adj->theEdge()])
+                    addChain(v, adj);
+            }
+        }
+
+        // Whatever is left are cycles without kept nodes, break every cycle
+        // at its first node
+        for (ogdf::node v : G.nodes) {
+            if (kept[v] || visited[v->firstAdj()->theEdge()])
+                continue;
+
+            kept[v] = true;
+            copy(GA, v);
+            addChain(v, v->firstAdj());
+        }
+    }
+
+    ogdf::node CoarseGraph::copy(const ogdf::GraphAttributes &GA, ogdf::node v) {
+        ogdf::node c = m_G.newNode();
+        m_GA.x(c) = GA.x(v);
+        m_GA.y(c) = GA.y(v);
+        m_GA.width(c) = GA.width(v);
+        m_GA.height(c) = GA.height(v);
+        m_copies[v] = c;
+
+        return c;
+    }
+
+    void CoarseGraph::expand(ogdf::GraphAttributes &GA, int refinementIterations) const {
+        for (ogdf::node v : GA.constGraph().nodes) {
+            if (ogdf::node c = m_copies[v]) {
+                GA.x(v) = m_GA.x(c);
+                GA.y(v) = m_GA.y(c);
+            }
+        }
+
+        for (const Chain &chain : m_chains) {
+            size_t n = chain.nodes.size() - 1, k = chain.coarse.size() - 1;
+            double length = chain.offsets.back();
+            for (size_t i = 1; i < n; ++i) {
+                double t = (length > 0 ? chain.offsets[i] / length : double(i) / double(n)) * double(k);
+                size_t segment = std::min(size_t(t), k - 1);
+                double f = t - double(segment);
+
+                ogdf::node from = chain.coarse[segment], to = chain.coarse[segment + 1];
+                GA.x(chain.nodes[i]) = m_GA.x(from) + f * (m_GA.x(to) - m_GA.x(from));
+                GA.y(chain.nodes[i]) = m_GA.y(from) + f * (m_GA.y(to) - m_GA.y(from));
+            }
+
+            for (int iteration = 0; iteration < refinementIterations; ++iteration) {
+                for (size_t i = 1; i < n; ++i) {
+                    ogdf::node prev = chain.nodes[i - 1], v = chain.nodes[i], next = chain.nodes[i + 1];
+                    double before = chain.offsets[i] - chain.offsets[i - 1],
+                           after = chain.offsets[i + 1] - chain.offsets[i];
+                    double w = before + after > 0 ? before / (before + after) : 0.5;
+
+                    GA.x(v) = 0.5 * (GA.x(v) + GA.x(prev) + w * (GA.x(next) - GA.x(prev)));
+                    GA.y(v) = 0.5 * (GA.y(v) + GA.y(prev) + w * (GA.y(next) - GA.y(prev)));
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,69 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "ogdf/basic/Graph.h"
+#include "ogdf/basic/GraphAttributes.h"
+
+#include <vector>
+
+namespace layout {
+    // Coarse version of an OGDF graph used by the multilevel layout. Every
+    // maximal path through degree-2 nodes (segments of a graph node and
+    // non-branching chains of graph nodes) is replaced by a path of
+    // ceil(sqrt(n)) edges, where n is the number of edges of the original
+    // path, so long paths are coarsened more. The total length of a path is
+    // kept. Path ends and branching nodes are kept as they are.
+    class CoarseGraph {
+    public:
+        // The original graph must stay alive while the coarse one is used.
+        // Initial positions of the coarse nodes are taken from GA.
+        CoarseGraph(const ogdf::GraphAttributes &GA,
+                    const ogdf::EdgeArray<double> &edgeLengths);
+
+        ogdf::GraphAttributes &attributes() { return m_GA; }
+        const ogdf::EdgeArray<double> &edgeLengths() const { return m_edgeLengths; }
+        int numberOfNodes() const { return m_G.numberOfNodes(); }
+
+        // Transfers the coarse layout to the original graph. Kept nodes take
+        // the positions of their coarse copies, path nodes are interpolated
+        // along the coarse path and then smoothed by a few refinement
+        // iterations that pull every node towards its place on the line
+        // between its neighbours.
+        void expand(ogdf::GraphAttributes &GA, int refinementIterations = 3) const;
+
+    private:
+        struct Chain {
+            // Original nodes, both ends included
+            std::vector<ogdf::node> nodes;
+            // Distance of every node from the start of the chain
+            std::vector<double> offsets;
+            // Coarse nodes, both ends included
+            std::vector<ogdf::node> coarse;
+        };
+
+        ogdf::node copy(const ogdf::GraphAttributes &GA, ogdf::node v);
+
+        ogdf::Graph m_G;
+        ogdf::GraphAttributes m_GA;
+        ogdf::EdgeArray<double> m_edgeLengths;
+        // Coarse copies of the kept nodes
+        ogdf::NodeArray<ogdf::node> m_copies;
+        std::vector<Chain> m_chains;
+    };
+}
@@ -0,0 +1,216 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "communities.h"
+
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+namespace layout {
+    // Number of edges to every neighbouring community, in the order the
+    // communities are first seen. Degrees are small, so a vector is enough
+    using Tally = std::vector<std::pair<int, int>>;
+
+    static void countNeighbours(ogdf::node v, const ogdf::NodeArray<int> &community, Tally &tally) {
+        tally.clear();
+        for (ogdf::adjEntry adj : v->adjEntries) {
+            ogdf::node u = adj->twinNode();
+            if (u == v)
+                continue;
+
+            int c = community[u];
+            auto it = std::find_if(tally.begin(), tally.end(),
+                                   [c](const auto &entry) { return entry.first == c; });
+            if (it == tally.end())
+                tally.emplace_back(c, 1);
+            else
+                ++it->second;
+        }
+    }
+
+    Communities::Communities(const ogdf::Graph &G, int maxSize, int rounds)
+            : m_community(G, -1) {
+        maxSize = std::max(maxSize, 1);
+
+        // BFS forest of the graph. Children of a node are consecutive in
+        // the BFS order
+        std::vector<ogdf::node> order;
+        std::vector<std::pair<int, int>> children(G.numberOfNodes());
+        order.reserve(G.numberOfNodes());
+        {
+            ogdf::NodeArray<bool> seen(G, false);
+            for (ogdf::node s : G.nodes) {
+                if (seen[s])
+                    continue;
+
+                seen[s] = true;
+                order.push_back(s);
+                for (size_t head = order.size() - 1; head < order.size(); ++head) {
+                    int first = int(order.size());
+                    for (ogdf::adjEntry adj : order[head]->adjEntries) {
+                        ogdf::node u = adj->twinNode();
+                        if (!seen[u]) {
+                            seen[u] = true;
+                            order.push_back(u);
+                        }
+                    }
+                    children[head] = { first, int(order.size()) };
+                }
+            }
+        }
+
+        // Kundu-Misra: bottom up, a subtree heavier than maxSize is relieved
+        // of its heaviest child subtrees, which become communities. This
+        // gives the least number of connected parts of at most maxSize nodes
+        std::vector<int> weight(order.size(), 1);
+        std::vector<bool> cut(order.size(), false);
+        std::vector<int> heaviest;
+        for (size_t i = order.size(); i-- > 0;) {
+            auto [first, last] = children[i];
+            for (int child = first; child < last; ++child)
+                weight[i] += weight[child];
+            if (weight[i] <= maxSize)
+                continue;
+
+            heaviest.resize(last - first);
+            std::iota(heaviest.begin(), heaviest.end(), first);
+            std::stable_sort(heaviest.begin(), heaviest.end(),
+                             [&](int a, int b) { return weight[a] > weight[b]; });
+            for (int child : heaviest) {
+                if (weight[i] <= maxSize)
+                    break;
+                cut[child] = true;
+                weight[i] -= weight[child];
+            }
+        }
+
+        std::vector<int> sizes;
+        for (size_t i = 0; i < order.size(); ++i) {
+            auto [first, last] = children[i];
+            if (m_community[order[i]] == -1 || cut[i]) {
+                m_community[order[i]] = int(sizes.size());
+                sizes.push_back(0);
+            }
+            ++sizes[m_community[order[i]]];
+            for (int child = first; child < last; ++child)
+                m_community[order[child]] = m_community[order[i]];
+        }
+
+        // Leftovers are merged into their most connected neighbour that has
+        // room for them. Merging adjacent connected communities keeps them
+        // connected
+        int capacity = maxSize + maxSize / 4;
+        std::vector<int> parent(sizes.size());
+        std::iota(parent.begin(), parent.end(), 0);
+        auto find = [&](int c) {
+            while (parent[c] != c)
+                c = parent[c] = parent[parent[c]];
+            return c;
+        };
+
+        std::vector<std::vector<ogdf::node>> regions(sizes.size());
+        for (ogdf::node v : G.nodes)
+            regions[m_community[v]].push_back(v);
+
+        std::vector<int> links(sizes.size(), 0);
+        std::vector<int> neighbours;
+        for (int c = 0; c < int(sizes.size()); ++c) {
+            if (find(c) != c || sizes[c] * 4 >= maxSize)
+                continue;
+
+            neighbours.clear();
+            for (ogdf::node v : regions[c]) {
+                for (ogdf::adjEntry adj : v->adjEntries) {
+                    int d = find(m_community[adj->twinNode()]);
+                    if (d == c)
+                        continue;
+                    if (links[d]++ == 0)
+                        neighbours.push_back(d);
+                }
+            }
+
+            int best = -1;
+            for (int d : neighbours) {
+                if (sizes[d] + sizes[c] <= capacity &&
+                    (best == -1 || links[d] > links[best] || (links[d] == links[best] && d < best)))
+                    best = d;
+            }
+            for (int d : neighbours)
+                links[d] = 0;
+            if (best == -1)
+                continue;
+
+            parent[c] = best;
+            sizes[best] += sizes[c];
+        }
+
+        for (ogdf::node v : G.nodes)
+            m_community[v] = find(m_community[v]);
+
+        // Label propagation on the boundary. A node with at most one
+        // neighbour in its own community is a leaf of it, so moving it to an
+        // adjacent community keeps both connected
+        Tally tally;
+        for (int round = 0; round < rounds; ++round) {
+            bool changed = false;
+            for (ogdf::node v : G.nodes) {
+                int own = m_community[v];
+                countNeighbours(v, m_community, tally);
+
+                int ownCount = 0;
+                for (const auto &[c, count] : tally) {
+                    if (c == own)
+                        ownCount = count;
+                }
+                if (ownCount > 1 || sizes[own] == 1)
+                    continue;
+
+                int best = -1, bestCount = ownCount;
+                for (const auto &[c, count] : tally) {
+                    if (c != own && sizes[c] < capacity &&
+                        (count > bestCount || (count == bestCount && best != -1 && c < best))) {
+                        best = c;
+                        bestCount = count;
+                    }
+                }
+                if (best == -1)
+                    continue;
+
+                m_community[v] = best;
+                --sizes[own];
+                ++sizes[best];
+                changed = true;
+            }
+
+            if (!changed)
+                break;
+        }
+
+        // Dense numbering in the order of the first members
+        std::vector<int> index(sizes.size(), -1);
+        for (ogdf::node v : G.nodes) {
+            int &c = index[m_community[v]];
+            if (c == -1) {
+                c = int(m_members.size());
+                m_members.emplace_back();
+            }
+            m_community[v] = c;
+            m_members[c].push_back(v);
+        }
+    }
+}
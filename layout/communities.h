@@ -0,0 +1,47 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "ogdf/basic/Graph.h"
+
+#include <vector>
+
+namespace layout {
+    // Partition of an OGDF graph into connected communities of about maxSize
+    // nodes, used by the hierarchical layout. A BFS spanning forest is split
+    // into the least number of subtrees of at most maxSize nodes (Kundu and
+    // Misra), parts smaller than a quarter of maxSize are merged into the
+    // neighbour they have most edges to (if it stays within a quarter over
+    // maxSize) and a few rounds of label propagation move boundary nodes to
+    // the neighbouring community most of their edges go to. Only nodes with
+    // at most one neighbour in their own community are moved, so communities
+    // stay connected. The partition only depends on the node and edge order.
+    class Communities {
+    public:
+        Communities(const ogdf::Graph &G, int maxSize, int rounds = 4);
+
+        int count() const { return int(m_members.size()); }
+        int community(ogdf::node v) const { return m_community[v]; }
+        // In the node order of the graph
+        const std::vector<ogdf::node> &members(int community) const { return m_members[community]; }
+
+    private:
+        ogdf::NodeArray<int> m_community;
+        std::vector<std::vector<ogdf::node>> m_members;
+    };
+}
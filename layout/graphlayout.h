@@ -36,6 +36,7 @@ public:
     bool contains(const DeBruijnNode *node) const { return m_data.contains(node); }
     void add(DeBruijnNode *node, T point) { m_data[node].emplace_back(point); }
     size_t size() const { return m_data.size(); }
+    void clear() { m_data.clear(); }
 
     const auto& segments(const DeBruijnNode *node) const { return m_data.at(node); }
     auto& segments(DeBruijnNode *node) { return m_data[node]; }
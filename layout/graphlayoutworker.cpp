@@ -17,6 +17,11 @@
 // along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "graphlayoutworker.h"
+#include "coarsening.h"
+#include "communities.h"
+#include "hull.h"
+#include "paths.h"
+#include "graph/adjacency.h"
 #include "graph/assemblygraph.h"
 #include "graph/debruijnnode.h"
 #include "graph/debruijnedge.h"
@@ -27,20 +32,31 @@
 
 #include "painting/textgraphicsitemnode.h"
 
-#include "ogdf/basic/GraphCopy.h"
+#include "ogdf/basic/Graph.h"
 #include "ogdf/basic/simple_graph_alg.h"
 #include "ogdf/energybased/FMMMLayout.h"
 #include "ogdf/energybased/fmmm/MAARPacking.h"
 #include "ogdf/energybased/FastMultipoleEmbedder.h"
 #include "ogdf/energybased/fmmm/FMMMOptions.h"
 
-#include <QFutureSynchronizer>
+#include <QDataStream>
+#include <QThreadPool>
 #include <QtConcurrent>
 
 #include <QFont>
 #include <QFontMetrics>
 
-#include <ctime>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
 
 #include<QDebug>
 
@@ -60,19 +76,14 @@ public:
         init(m_layout);
     }
 
-    void cancel() override {
-        m_layout.fixedIterations(0);
-        m_layout.fineTuningIterations(0);
-        m_layout.threshold(std::numeric_limits<double>::max());
-    }
-
     void run(ogdf::GraphAttributes &GA, const ogdf::EdgeArray<double> &edges) override {
         m_layout.call(GA, edges);
     }
 
 private:
     void init(ogdf::FMMMLayout &layout) const {
-        layout.randSeed(clock());
+        layout.randSeed(int(m_seed));
+        layout.interruptFlag(m_cancelled);
         layout.useHighLevelOptions(false);
         layout.unitEdgeLength(1.0);
         layout.allowedPositions(ogdf::FMMMOptions::AllowedPositions::All);
@@ -81,7 +92,7 @@ private:
         layout.stepsForRotatingComponents(50); // Helps to make linear graph components more horizontal.
         layout.initialPlacementForces(m_useLinearLayout ?
                                       ogdf::FMMMOptions::InitialPlacementForces::KeepPositions :
-                                      ogdf::FMMMOptions::InitialPlacementForces::RandomTime);
+                                      ogdf::FMMMOptions::InitialPlacementForces::RandomRandIterNr);
 
         switch (m_graphLayoutQuality) {
             case 0:
@@ -110,17 +121,126 @@ private:
                 layout.nmPrecision(8);
                 break;
         }
+
+        layout.setSingleLevel(m_refinement == Refinement::Local);
+        if (m_refinement != Refinement::None)
+            layout.initialPlacementForces(ogdf::FMMMOptions::InitialPlacementForces::KeepPositions);
+        if (m_refinement == Refinement::Local) {
+            layout.stepsForRotatingComponents(0);
+            layout.fixedIterations(10);
+            layout.fineTuningIterations(5);
+        }
     }
 
     ogdf::FMMMLayout m_layout;
 };
 
+// Multilevel fast multipole embedder. Unlike FMMM it computes the forces of a
+// single component on several threads, which is what matters for graphs with
+// a giant component. Layouts are reproducible for the same number of threads.
+class FMEGraphLayout : public GraphLayouter {
+public:
+    FMEGraphLayout(int graphLayoutQuality, bool useLinearLayout,
+                   double graphLayoutComponentSeparation, double aspectRatio,
+                   unsigned threadCount)
+            : GraphLayouter(graphLayoutQuality, useLinearLayout,
+                            graphLayoutComponentSeparation, aspectRatio),
+              m_threadCount(threadCount) {}
+
+    void init() override {
+        static const uint32_t iterations[] = { 25, 50, 100, 200, 400 };
+        static const uint32_t precision[] = { 2, 2, 4, 6, 8 };
+        int quality = std::clamp(m_graphLayoutQuality, 0, 4);
+        m_iterations = iterations[quality];
+        m_precision = precision[quality];
+        if (m_refinement == Refinement::Local)
+            m_iterations /= 4;
+    }
+
+    // Components of this many nodes are laid out on all m_threadCount threads
+    static constexpr int MinParallelNodes = 4096;
+
+    void run(ogdf::GraphAttributes &GA, const ogdf::EdgeArray<double> &edges) override {
+        const ogdf::Graph &G = GA.constGraph();
+        // Small components are not worth the threads, there are many of them
+        // to keep the other workers busy
+        unsigned threads = G.numberOfNodes() >= MinParallelNodes ? m_threadCount : 1;
+        ogdf::setSeed(int(m_seed));
+
+        bool keepPositions = m_useLinearLayout || m_refinement != Refinement::None;
+        if (!keepPositions && G.numberOfNodes() > MinMultilevelNodes) {
+            ogdf::FastMultipoleMultilevelEmbedder multilevel;
+            multilevel.maxNumThreads(int(threads));
+            multilevel.interruptFlag(m_cancelled);
+            multilevel.call(GA);
+
+            // The multilevel embedder derives edge lengths from the node
+            // sizes, scale its layout to the desired ones
+            double desired = 0, actual = 0;
+            for (ogdf::edge e : G.edges) {
+                desired += edges[e];
+                actual += std::hypot(GA.x(e->source()) - GA.x(e->target()),
+                                     GA.y(e->source()) - GA.y(e->target()));
+            }
+            if (actual > 0) {
+                for (ogdf::node v : G.nodes) {
+                    GA.x(v) *= desired / actual;
+                    GA.y(v) *= desired / actual;
+                }
+            }
+        }
+
+        // Single level refinement with the actual edge lengths. Node sizes
+        // add to the edge lengths in FME, so they are kept negligible.
+        ogdf::EdgeArray<float> edgeLengths(G);
+        for (ogdf::edge e : G.edges)
+            edgeLengths[e] = float(edges[e]);
+        ogdf::NodeArray<float> nodeSizes(G, 0.01f);
+
+        ogdf::FastMultipoleEmbedder embedder;
+        embedder.setNumberOfThreads(threads);
+        embedder.setRandomize(!keepPositions && G.numberOfNodes() <= MinMultilevelNodes);
+        embedder.setNumIterations(m_iterations);
+        embedder.setMultipolePrec(m_precision);
+        embedder.setInterruptFlag(m_cancelled);
+        embedder.call(GA, edgeLengths, nodeSizes);
+    }
+
+private:
+    // The multilevel embedder falls back to a single level below this
+    static constexpr int MinMultilevelNodes = 25;
+
+    unsigned m_threadCount;
+    uint32_t m_iterations = 100;
+    uint32_t m_precision = 4;
+};
+
 GraphLayoutWorker::GraphLayoutWorker(int graphLayoutQuality, bool useLinearLayout,
                                      double graphLayoutComponentSeparation, double aspectRatio)
         : m_graphLayoutQuality(graphLayoutQuality),
           m_useLinearLayout(useLinearLayout),
           m_graphLayoutComponentSeparation(graphLayoutComponentSeparation),
-          m_aspectRatio(aspectRatio) {}
+          m_aspectRatio(aspectRatio),
+          m_cache(g_settings->layoutCacheDir, qint64(g_settings->layoutCacheSize.val) * 1024 * 1024),
+          m_seed(unsigned(g_settings->layoutSeed.val)),
+          m_multilevel(g_settings->multilevelLayout),
+          m_hierarchicalNodes(g_settings->hierarchicalLayoutNodes),
+          m_engine(g_settings->graphLayoutEngine),
+          m_threadCount(g_settings->threadCount()) {}
+
+std::unique_ptr<GraphLayouter> GraphLayoutWorker::makeLayouter(unsigned threadCount) const {
+    std::unique_ptr<GraphLayouter> layouter;
+    if (m_engine == FAST_MULTIPOLE_LAYOUT)
+        layouter = std::make_unique<FMEGraphLayout>(m_graphLayoutQuality, m_useLinearLayout,
+                                                    m_graphLayoutComponentSeparation, m_aspectRatio,
+                                                    threadCount);
+    else
+        layouter = std::make_unique<FMMGraphLayout>(m_graphLayoutQuality, m_useLinearLayout,
+                                                    m_graphLayoutComponentSeparation, m_aspectRatio);
+    layouter->setCancellationFlag(&m_cancelled);
+
+    return layouter;
+}
 
 // FIXME: move to settings
 static double getNodeLengthPerMegabase() {
@@ -263,75 +383,102 @@ static void addToOgdfGraph(const HiCEdge *edge,
     }
 }
 
+std::string layout::naturalSortKey(std::string_view name) {
+    auto isDigit = [](char c) { return c >= '0' && c <= '9'; };
+
+    std::string key;
+    key.reserve(name.size() + 8);
+    for (size_t i = 0; i < name.size();) {
+        if (!isDigit(name[i])) {
+            char c = name[i++];
+            key.push_back(c >= 'a' && c <= 'z' ? char(c - 'a' + 'A') : c);
+            continue;
+        }
+
+        size_t start = i;
+        while (i < name.size() && isDigit(name[i]))
+            ++i;
+        // Leading zeros do not count, longer numbers are larger
+        while (start + 1 < i && name[start] == '0')
+            ++start;
+        auto digits = uint32_t(i - start);
+        key.push_back('\x01');
+        for (int shift = 24; shift >= 0; shift -= 8)
+            key.push_back(char((digits >> shift) & 0xFF));
+        key.append(name.substr(start, digits));
+    }
+
+    return key;
+}
+
+// Drawn nodes are added left-to-right in the natural order of their names.
+// Every node starts right after the rightmost end of its upstream nodes placed
+// so far (or after the previous node, if there are none); nodes starting in
+// the same column are stacked.
 void determineLinearNodePositions(ogdf::Graph &ogdfGraph,
                                   ogdf::GraphAttributes &ogdfGraphAttributes,
                                   ogdf::EdgeArray<double> &ogdfEdgeLengths,
                                   OGDFGraphLayout &layout) {
     const AssemblyGraph &graph = layout.graph();
-    QList<DeBruijnNode *> sortedDrawnNodes;
+    auto snapshot = graph.adjacency();
+    const graph::Adjacency &adjacency = *snapshot;
+    const graph::NodeStore &nodes = adjacency.nodes();
 
-    // We first try to sort the nodes numerically.
-    QList<QPair<int, DeBruijnNode *>> numericallySortedDrawnNodes;
-    bool successfulIntConversion = true;
+    // Ties keep the trie order, so the layout is reproducible
+    std::vector<std::pair<std::string, graph::NodeStore::Id>> sortedDrawnNodes;
     for (auto *node : graph.m_deBruijnGraphNodes) {
         if (!node->isDrawn())
             continue;
-
-        int nodeInt = node->getNameWithoutSign().toInt(&successfulIntConversion);
-        if (!successfulIntConversion)
-            break;
-        numericallySortedDrawnNodes.emplace_back(nodeInt, node);
-    }
-
-    if (successfulIntConversion) {
-        std::sort(numericallySortedDrawnNodes.begin(), numericallySortedDrawnNodes.end(),
-                  [](const auto &a, const auto &b) {return a.first < b.first;});
-        sortedDrawnNodes.reserve(numericallySortedDrawnNodes.size());
-        for (const auto &entry : numericallySortedDrawnNodes)
-            sortedDrawnNodes.push_back(entry.second);
-    } // If any of the conversions from node name to integer failed, then we instead sort the nodes alphabetically.
-    else {
-        for (auto *node : graph.m_deBruijnGraphNodes) {
-            if (!node->isDrawn())
-                continue;
-            sortedDrawnNodes.push_back(node);
-        }
-        std::sort(sortedDrawnNodes.begin(), sortedDrawnNodes.end(),
-                  [](const DeBruijnNode *a, const DeBruijnNode *b) {
-            return QString::localeAwareCompare(a->getNameWithoutSign().toUpper(), b->getNameWithoutSign().toUpper()) < 0;});
+        graph::NodeStore::Id id = nodes.id(node);
+        sortedDrawnNodes.emplace_back(layout::naturalSortKey(nodes.baseName(id)), id);
     }
+    std::stable_sort(sortedDrawnNodes.begin(), sortedDrawnNodes.end(),
+                     [](const auto &a, const auto &b) { return a.first < b.first; });
 
-    // Now we add the drawn nodes to the OGDF graph, given them initial positions based on their sort order.
-    QSet<QPair<long long, long long> > usedStartPositions;
+    // End of every node placed so far (NaN if it is not placed) and the number
+    // of nodes starting in every column
+    std::vector<double> endXPos(nodes.size(), std::numeric_limits<double>::quiet_NaN());
+    phmap::flat_hash_map<long long, unsigned> columnHeights;
     double lastXPos = 0.0;
-    for (auto *node : sortedDrawnNodes) {
+    for (const auto &entry : sortedDrawnNodes) {
+        graph::NodeStore::Id id = entry.second;
+        DeBruijnNode *node = nodes.node(id);
         if (layout.contains(node) || layout.contains(node->getReverseComplement()))
             continue;
-        std::vector<DeBruijnNode *> upstreamNodes = node->getUpstreamNodes();
-        for (size_t j = 0; j < upstreamNodes.size(); ++j) {
-            DeBruijnNode * upstreamNode = upstreamNodes[j];
-            if (!layout.contains(upstreamNode))
-                continue;
 
-            ogdf::node upstreamEnd = layout.segments(upstreamNode).back();
-            double upstreamEndPos = ogdfGraphAttributes.x(upstreamEnd);
-            if (j == 0)
-                lastXPos = upstreamEndPos;
-            else
-                lastXPos = std::max(lastXPos, upstreamEndPos);
+        bool upstreamPlaced = false;
+        double upstreamEndPos = std::numeric_limits<double>::lowest();
+        for (graph::NodeStore::Id upstream : adjacency.inNodes(id)) {
+            if (std::isnan(endXPos[upstream]))
+                continue;
+            upstreamPlaced = true;
+            upstreamEndPos = std::max(upstreamEndPos, endXPos[upstream]);
         }
+        if (upstreamPlaced)
+            lastXPos = upstreamEndPos;
+
         double xPos = lastXPos + g_settings->edgeLength;
-        double yPos = 0.0;
-        long long intXPos = (long long)(xPos * 100.0);
-        long long intYPos = (long long)(yPos * 100.0);
-        while (usedStartPositions.contains({intXPos, intYPos})) {
-            yPos += g_settings->edgeLength;
-            intYPos = (long long)(yPos * 100.0);
-        }
+        unsigned &columnHeight = columnHeights[(long long)(xPos * 100.0)];
+        double yPos = columnHeight++ * g_settings->edgeLength;
         addToOgdfGraph(node, ogdfGraph, ogdfGraphAttributes, ogdfEdgeLengths, layout, xPos, yPos, true);
-        usedStartPositions.insert(QPair<long long, long long>(intXPos, intYPos));
-        lastXPos = ogdfGraphAttributes.x(layout.segments(node).back());
+        lastXPos = endXPos[id] = ogdfGraphAttributes.x(layout.segments(node).back());
+    }
+}
+
+GraphLayout layout::linearPositions(const AssemblyGraph &graph) {
+    ogdf::Graph G;
+    ogdf::GraphAttributes GA(G, ogdf::GraphAttributes::nodeGraphics | ogdf::GraphAttributes::edgeGraphics);
+    ogdf::EdgeArray<double> edgeLengths(G);
+    OGDFGraphLayout positions(graph);
+    determineLinearNodePositions(G, GA, edgeLengths, positions);
+
+    GraphLayout res(graph);
+    for (const auto &entry : positions) {
+        for (ogdf::node segment : entry.second)
+            res.add(entry.first, { GA.x(segment), GA.y(segment) });
     }
+
+    return res;
 }
 
 static void buildGraph(ogdf::Graph &ogdfGraph,
@@ -358,24 +505,28 @@ static void buildGraph(ogdf::Graph &ogdfGraph,
     }
 
     // Then loop through each edge determining its drawn status and adding it to OGDF if it is drawn.
-    for (const auto &entry : graph.m_deBruijnGraphEdges) {
-        const DeBruijnEdge *edge = entry.second;
-        if (!edge->isDrawn())
-            continue;
+    // Edges are taken from their starting nodes: unlike the edge hash maps (keyed
+    // by pointers) this order is the same in every run, so is the layout.
+    for (const auto *node : graph.m_deBruijnGraphNodes) {
+        for (const auto *edge : node->edges()) {
+            if (edge->getStartingNode() != node || !edge->isDrawn())
+                continue;
 
-        if (edge->getOverlapType() == JUMP)
-            continue;
+            if (edge->getOverlapType() == JUMP)
+                continue;
 
-        addToOgdfGraph(edge,ogdfGraph, ogdfEdgeLengths, layout);
+            addToOgdfGraph(edge, ogdfGraph, ogdfEdgeLengths, layout);
+        }
     }
 
     // Then loop through each hi-c edge determining its drawn status and adding it to OGDF if it is drawn.
-    for (const auto &entry : graph.m_hicGraphEdges) {
-        const HiCEdge *edge = entry.second;
-        if (!edge->isDrawn())
-            continue;
+    for (const auto *node : graph.m_deBruijnGraphNodes) {
+        for (const auto *edge : node->hicEdges()) {
+            if (edge->getStartingNode() != node || !edge->isDrawn())
+                continue;
 
-        addToOgdfGraph(edge,ogdfGraph, ogdfEdgeLengths, layout);
+            addToOgdfGraph(edge, ogdfGraph, ogdfEdgeLengths, layout);
+        }
     }
 }
 
@@ -451,6 +602,9 @@ static double calculateArea(double width, double height, int comp_nr,
     return width * height * scaling;
 }
 
+// Finds the rotation of every component with the smallest bounding rectangle
+// area (or aspect ratio area for a single component) from the convex hulls
+// of the components. GA is written once per node, with the final rotation.
 static ogdf::List<fmmm::Rectangle>
 rotateComponentsAndCalculateBoundingRectangles(
         ogdf::GraphAttributes &GA,
@@ -458,95 +612,90 @@ rotateComponentsAndCalculateBoundingRectangles(
         double graphLayoutComponentSeparation, double aspectRatio,
         int stepsForRotatingComponents = 50) {
     int numCCs = nodesInCC.size();
-    const ogdf::Graph &G = const_cast<ogdf::Graph &>(GA.constGraph());
-
-    ogdf::List<fmmm::Rectangle> R;
-
-    for (int i = 0; i < numCCs; i++) {
-        fmmm::Rectangle r_act, r_best;
-        ogdf::DPoint new_pos, new_dlc;
-
-        ogdf::NodeArray<ogdf::DPoint> best_coords(G), old_coords(G);
-        //init r_best, best_area and best_(old)coords
-        r_best = calculateBoundingRectangle(GA, nodesInCC[i],
-                                            graphLayoutComponentSeparation, i);
-        double best_area = calculateArea(r_best.get_width(), r_best.get_height(),
-                                         numCCs, aspectRatio);
-        for (ogdf::node v: nodesInCC[i])
-            old_coords[v] = best_coords[v] = GA.point(v);
-
-        //rotate the components
-        for (int j = 1; j <= stepsForRotatingComponents; j++) {
-            //calculate new positions for the nodes, the new rectangle and area
-            double angle = ogdf::Math::pi_2 * (double(j) / double(stepsForRotatingComponents + 1));
-            double sin_j = sin(angle);
-            double cos_j = cos(angle);
-            for (ogdf::node v: nodesInCC[i]) {
-                new_pos.m_x = cos_j * old_coords[v].m_x
-                              - sin_j * old_coords[v].m_y;
-                new_pos.m_y = sin_j * old_coords[v].m_x
-                              + cos_j * old_coords[v].m_y;
-                GA.x(v) = new_pos.m_x;
-                GA.y(v) = new_pos.m_y;
-            }
-
-            r_act = calculateBoundingRectangle(GA, nodesInCC[i],
-                                               graphLayoutComponentSeparation, i);
-            double act_area = calculateArea(r_act.get_width(), r_act.get_height(),
-                                            numCCs, aspectRatio);
+    std::vector<fmmm::Rectangle> rectangles(numCCs);
+
+    auto rotateComponent = [&](int i) {
+        // Nodes are drawn as discs of max_boundary radius (see
+        // calculateBoundingRectangle), the hull is taken over their centers
+        double max_boundary = 0;
+        std::vector<ogdf::DPoint> points;
+        points.reserve(nodesInCC[i].size());
+        for (ogdf::node v: nodesInCC[i]) {
+            max_boundary = std::max({ max_boundary, GA.width(v) / 2, GA.height(v) / 2 });
+            points.push_back(GA.point(v));
+        }
+        std::vector<ogdf::DPoint> hull = layout::convexHull(std::move(points));
+        double margin = 2 * max_boundary + graphLayoutComponentSeparation;
 
-            double act_area_PI_half_rotated;
+        auto area = [&](double width, double height) {
+            double act_area = calculateArea(width + margin, height + margin, numCCs, aspectRatio);
+            // A single component could be rotated further by PI/2, see below
             if (numCCs == 1)
-                act_area_PI_half_rotated = calculateArea(r_act.get_height(),
-                                                         r_act.get_width(),
-                                                         numCCs, aspectRatio);
-
-            // store placement of the nodes with minimal area (in case that
-            // number_of_components >1) else store placement with minimal aspect ratio area
+                act_area = std::min(act_area, calculateArea(height + margin, width + margin, numCCs, aspectRatio));
+            return act_area;
+        };
+
+        double x_min, x_max, y_min, y_max;
+        layout::rotatedExtents(hull, 0, x_min, x_max, y_min, y_max);
+        double best_angle = 0;
+        double best_area = area(x_max - x_min, y_max - y_min);
+        layout::visitHullEdgeRectangles(hull, [&](double angle, double width, double height) {
+            double act_area = area(width, height);
             if (act_area < best_area) {
-                r_best = r_act;
+                best_angle = angle;
                 best_area = act_area;
-                for (ogdf::node v: nodesInCC[i])
-                    best_coords[v] = GA.point(v);
-            } else if ((numCCs == 1) && (act_area_PI_half_rotated <
-                                         best_area)) { //test if rotating further with PI_half would be an improvement
-                r_best = r_act;
-                best_area = act_area_PI_half_rotated;
-                for (ogdf::node v: nodesInCC[i])
-                    best_coords[v] = GA.point(v);
-                //the needed rotation step follows in the next if statement
             }
-        }
-
-        //tipp the smallest rectangle over by angle PI/2 around the origin if it makes the
-        //aspect_ratio of r_best more similar to the desired aspect_ratio
-        double ratio = r_best.get_width() / r_best.get_height();
-        if ((aspectRatio < 1 && ratio > 1) || (aspectRatio >= 1 && ratio < 1)) {
-            for (ogdf::node v: nodesInCC[i]) {
-                new_pos.m_x = best_coords[v].m_y * (-1);
-                new_pos.m_y = best_coords[v].m_x;
-                best_coords[v] = new_pos;
+        });
+
+        // The aspect ratio area of a single component is not necessarily
+        // minimal at a hull edge, so the fixed angles are tried as well
+        if (numCCs == 1) {
+            for (int j = 1; j <= stepsForRotatingComponents; j++) {
+                double angle = ogdf::Math::pi_2 * (double(j) / double(stepsForRotatingComponents + 1));
+                layout::rotatedExtents(hull, angle, x_min, x_max, y_min, y_max);
+                double act_area = area(x_max - x_min, y_max - y_min);
+                if (act_area < best_area) {
+                    best_angle = angle;
+                    best_area = act_area;
+                }
             }
+        }
 
-            //calculate new rectangle
-            new_dlc.m_x = r_best.get_old_dlc_position().m_y * (-1) - r_best.get_height();
-            new_dlc.m_y = r_best.get_old_dlc_position().m_x;
+        layout::rotatedExtents(hull, best_angle, x_min, x_max, y_min, y_max);
+        double width = x_max - x_min + margin, height = y_max - y_min + margin;
+        ogdf::DPoint dlc(x_min - margin / 2, y_min - margin / 2);
 
-            double new_width = r_best.get_height();
-            double new_height = r_best.get_width();
-            r_best.set_width(new_width);
-            r_best.set_height(new_height);
-            r_best.set_old_dlc_position(new_dlc);
+        //tipp the smallest rectangle over by angle PI/2 around the origin if it makes the
+        //aspect_ratio of the rectangle more similar to the desired aspect_ratio
+        double ratio = width / height;
+        bool tip = (aspectRatio < 1 && ratio > 1) || (aspectRatio >= 1 && ratio < 1);
+        if (tip) {
+            dlc = ogdf::DPoint(-dlc.m_y - height, dlc.m_x);
+            std::swap(width, height);
         }
 
-        //save the computed information in A_sub and R
+        double sin_a = sin(best_angle), cos_a = cos(best_angle);
         for (ogdf::node v: nodesInCC[i]) {
-            GA.x(v) = best_coords[v].m_x;
-            GA.y(v) = best_coords[v].m_y;
+            double x = cos_a * GA.x(v) - sin_a * GA.y(v), y = sin_a * GA.x(v) + cos_a * GA.y(v);
+            GA.x(v) = tip ? -y : x;
+            GA.y(v) = tip ? x : y;
         }
 
-        R.pushBack(r_best);
-    }
+        rectangles[i].set_rectangle(width, height, dlc.m_x, dlc.m_y, i);
+    };
+
+    // Components do not share nodes, so they are rotated in parallel, in
+    // chunks to amortize the scheduling of tiny components
+    const int chunk = 64;
+    layout::WorkStealingScheduler().run((numCCs + chunk - 1) / chunk, g_settings->threadCount(),
+                                        [&](size_t c) {
+        for (int i = int(c) * chunk; i < std::min(numCCs, int(c + 1) * chunk); ++i)
+            rotateComponent(i);
+    });
+
+    ogdf::List<fmmm::Rectangle> R;
+    for (const auto &r : rectangles)
+        R.pushBack(r);
 
     return R;
 }
@@ -591,129 +740,916 @@ static void reassembleDrawings(ogdf::GraphAttributes &GA,
     }
 }
 
+// Derives independent seeds for graphs and components (splitmix64 finalizer)
+static unsigned deriveSeed(uint64_t seed, uint64_t index) {
+    uint64_t z = seed + 0x9e3779b97f4a7c15ULL * (index + 1);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return unsigned((z ^ (z >> 31)) & 0x7fffffff);
+}
+
+// Position of every node of a component in the given list of its nodes (-1 if
+// it is not there)
+static auto localIndices(const ogdf::NodeArray<int> &indexInCC, int componentSize,
+                         const std::vector<ogdf::node> &nodes) {
+    std::vector<int> local(componentSize, -1);
+    for (size_t i = 0; i < nodes.size(); ++i)
+        local[indexInCC[nodes[i]]] = int(i);
+
+    return [&indexInCC, local = std::move(local)](ogdf::node v) { return local[indexInCC[v]]; };
+}
+
+namespace {
+    // OGDF graph of a single AssemblyGraph. Components are laid out
+    // independently and write into the disjoint parts of GA.
+    struct GraphLayoutTask {
+        GraphLayoutTask(AssemblyGraph &graph, unsigned seed)
+                : graph(graph), edgeLengths(G),
+                  GA(G, ogdf::GraphAttributes::nodeGraphics | ogdf::GraphAttributes::edgeGraphics),
+                  layout(graph), seed(seed) {}
+
+        AssemblyGraph &graph;
+        ogdf::Graph G;
+        ogdf::EdgeArray<double> edgeLengths;
+        ogdf::GraphAttributes GA;
+        OGDFGraphLayout layout;
+        ogdf::Array<ogdf::List<ogdf::node>> nodesInCC;
+        // Position of every node in the list of its component
+        ogdf::NodeArray<int> indexInCC;
+        std::vector<bool> pathComponents;
+        unsigned seed;
+
+        // Incremental layout: nodes placed by the previous layout and their
+        // number in every component
+        const GraphLayout *previous = nullptr;
+        ogdf::NodeArray<bool> placed;
+        std::vector<int> placedInCC;
+
+        // Layout cache key (empty if the cache is not used) and the layout
+        // found there
+        QByteArray cacheKey;
+        std::unique_ptr<GraphLayout> cached;
+
+        // Results, they are reduced once all graphs are done
+        GraphLayout *result = nullptr;
+        qreal sumX = 0;
+        qreal maxX = 0;
+    };
+
+    struct ComponentTask {
+        GraphLayoutTask *graph;
+        int index;
+        int size;
+        int placed;
+        bool path;
+    };
+
+    // Standalone copy of the subgraph induced by some nodes of a component.
+    // The cost of the copy depends on the number of these nodes only (a
+    // GraphCopy allocates arrays for the whole graph).
+    struct ComponentCopy {
+        ComponentCopy(const ogdf::GraphAttributes &originalGA,
+                      const ogdf::EdgeArray<double> &originalEdgeLengths,
+                      const ogdf::NodeArray<int> &indexInCC, int componentSize,
+                      const std::vector<ogdf::node> &nodes)
+                : ComponentCopy(originalGA, originalEdgeLengths, nodes,
+                                localIndices(indexInCC, componentSize, nodes)) {}
+
+        // local(v) is the position of v in nodes, or -1 if v is not copied
+        template<class LocalIndex>
+        ComponentCopy(const ogdf::GraphAttributes &originalGA,
+                      const ogdf::EdgeArray<double> &originalEdgeLengths,
+                      const std::vector<ogdf::node> &nodes, const LocalIndex &local)
+                : edgeLengths(G), GA(G, originalGA.attributes()) {
+            copies.reserve(nodes.size());
+            for (size_t i = 0; i < nodes.size(); ++i) {
+                ogdf::node c = G.newNode();
+                GA.x(c) = originalGA.x(nodes[i]);
+                GA.y(c) = originalGA.y(nodes[i]);
+                GA.width(c) = originalGA.width(nodes[i]);
+                GA.height(c) = originalGA.height(nodes[i]);
+                copies.push_back(c);
+            }
+
+            for (size_t i = 0; i < nodes.size(); ++i) {
+                for (ogdf::adjEntry adj : nodes[i]->adjEntries) {
+                    // Every edge (self-loops as well) is added once, from its source
+                    if (!adj->isSource())
+                        continue;
+
+                    ogdf::edge e = adj->theEdge();
+                    int target = local(e->target());
+                    if (target < 0)
+                        continue;
+
+                    ogdf::edge ce = G.newEdge(copies[i], copies[target]);
+                    edgeLengths[ce] = originalEdgeLengths[e];
+                }
+            }
+        }
+
+        ogdf::Graph G;
+        ogdf::EdgeArray<double> edgeLengths;
+        ogdf::GraphAttributes GA;
+        // Copies of the nodes, in the same order
+        std::vector<ogdf::node> copies;
+    };
+}
+
+// Components are scheduled in batches of at least this many OGDF nodes, so
+// the scheduling overhead is amortized over many tiny components
+static constexpr int MinBatchNodes = 512;
+
+// Lays out a copy with FMMM. In the multilevel mode FMMM is run on the coarse
+// graph only.
+static void layoutCopy(GraphLayouter &layouter, bool multilevel, ComponentCopy &copy) {
+    if (multilevel) {
+        layout::CoarseGraph coarse(copy.GA, copy.edgeLengths);
+        layouter.run(coarse.attributes(), coarse.edgeLengths());
+        coarse.expand(copy.GA);
+    } else
+        layouter.run(copy.GA, copy.edgeLengths);
+}
+
+// Lays out a single component
+static void layoutComponent(GraphLayouter &layouter, bool multilevel,
+                            ogdf::GraphAttributes &GA,
+                            const ogdf::EdgeArray<double> &edgeLengths,
+                            const ogdf::NodeArray<int> &indexInCC,
+                            const ogdf::List<ogdf::node> &nodesInCC) {
+    std::vector<ogdf::node> nodes;
+    nodes.reserve(nodesInCC.size());
+    for (ogdf::node v : nodesInCC)
+        nodes.push_back(v);
+
+    ComponentCopy copy(GA, edgeLengths, indexInCC, nodesInCC.size(), nodes);
+    layoutCopy(layouter, multilevel, copy);
+
+    // Components do not share nodes, so the writes do not race
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        GA.x(nodes[i]) = copy.GA.x(copy.copies[i]);
+        GA.y(nodes[i]) = copy.GA.y(copy.copies[i]);
+    }
+}
+
+// Communities of the hierarchical layout get about 16 sqrt(n) nodes, so
+// there are about sqrt(n) / 16 of them
+static int communitySize(int componentSize) {
+    return std::max(64, int(16 * std::sqrt(double(componentSize))));
+}
+
+// Nodes up to this many edges away from the edges between communities are
+// moved when the communities are stitched together
+static constexpr int StitchDepth = 8;
+static constexpr int StitchIterations = 100;
+// Rounds of moving whole communities towards their neighbours before that
+static constexpr int DockIterations = 50;
+
+// Two-level layout of a huge component. The component is split into connected
+// communities (see layout::Communities), which are laid out independently and
+// in parallel. Their quotient graph, with the community radii added to the
+// edge lengths, is laid out to place them and the remaining overlaps are
+// pushed apart. Every community is rotated (or mirrored) so its boundary nodes
+// face the communities they are connected to and moved as a whole to bring
+// the edges between them closer to their lengths. Finally the nodes around the
+// edges between communities are relaxed: they keep the shape of their
+// community layout as far as possible while these edges get their desired
+// lengths, so the stretch is spread over StitchDepth nodes on either side.
+// Returns the community of every node, in the order of nodesInCC.
+static std::vector<int> layoutHierarchically(const std::function<std::unique_ptr<GraphLayouter>(unsigned)> &makeLayouter,
+                                             unsigned threadCount, bool multilevel, unsigned seed,
+                                             const std::atomic<bool> &cancelled,
+                                             ogdf::GraphAttributes &GA,
+                                             const ogdf::EdgeArray<double> &edgeLengths,
+                                             const ogdf::NodeArray<int> &indexInCC,
+                                             const ogdf::List<ogdf::node> &nodesInCC) {
+    std::vector<ogdf::node> nodes;
+    nodes.reserve(nodesInCC.size());
+    for (ogdf::node v : nodesInCC)
+        nodes.push_back(v);
+
+    ComponentCopy copy(GA, edgeLengths, indexInCC, nodesInCC.size(), nodes);
+    const ogdf::Graph &G = copy.G;
+    ogdf::GraphAttributes &CA = copy.GA;
+
+    layout::Communities communities(G, communitySize(G.numberOfNodes()));
+    int k = communities.count();
+    ogdf::NodeArray<int> indexInCommunity(G);
+    std::vector<ogdf::DPoint> centers(k);
+    for (int c = 0; c < k; ++c) {
+        const auto &members = communities.members(c);
+        for (size_t i = 0; i < members.size(); ++i) {
+            indexInCommunity[members[i]] = int(i);
+            centers[c] += CA.point(members[i]);
+        }
+        // Initial (e.g. linear) positions of the communities
+        centers[c] /= double(members.size());
+    }
+
+    // Community layouts, centered at the origin. Communities do not share
+    // nodes, so the writes do not race. Every community is laid out on a
+    // single thread, so there are at most threadCount of them at a time.
+    std::vector<double> radii(k);
+    layout::WorkStealingScheduler().run(size_t(k), threadCount, [&](size_t c) {
+        const auto &members = communities.members(int(c));
+        ComponentCopy part(CA, copy.edgeLengths, members, [&](ogdf::node v) {
+            return communities.community(v) == int(c) ? indexInCommunity[v] : -1;
+        });
+
+        std::unique_ptr<GraphLayouter> layouter = makeLayouter(1);
+        layouter->setSeed(deriveSeed(seed, c));
+        layouter->setRefinement(GraphLayouter::Refinement::None);
+        layouter->init();
+        layoutCopy(*layouter, multilevel, part);
+
+        ogdf::DPoint center;
+        for (ogdf::node v : part.copies)
+            center += part.GA.point(v);
+        center /= double(members.size());
+
+        // The radius of a uniformly filled disc with the same mean squared
+        // distance from the center
+        double squares = 0;
+        for (size_t i = 0; i < members.size(); ++i) {
+            ogdf::DPoint p = part.GA.point(part.copies[i]) - center;
+            CA.x(members[i]) = p.m_x;
+            CA.y(members[i]) = p.m_y;
+            squares += p.m_x * p.m_x + p.m_y * p.m_y;
+        }
+        radii[c] = std::sqrt(2 * squares / double(members.size()));
+    });
+
+    // Quotient graph: a node per community, an edge per pair of connected
+    // communities
+    std::vector<std::tuple<int, int, double>> links;
+    for (ogdf::edge e : G.edges) {
+        int a = communities.community(e->source()), b = communities.community(e->target());
+        if (a != b)
+            links.emplace_back(std::min(a, b), std::max(a, b), copy.edgeLengths[e]);
+    }
+    std::stable_sort(links.begin(), links.end(), [](const auto &x, const auto &y) {
+        return std::make_pair(std::get<0>(x), std::get<1>(x)) < std::make_pair(std::get<0>(y), std::get<1>(y));
+    });
+
+    if (k > 1) {
+        ogdf::Graph Q;
+        ogdf::GraphAttributes QA(Q, ogdf::GraphAttributes::nodeGraphics | ogdf::GraphAttributes::edgeGraphics);
+        ogdf::EdgeArray<double> quotientLengths(Q);
+        std::vector<ogdf::node> quotientNodes(k);
+        for (int c = 0; c < k; ++c) {
+            ogdf::node q = quotientNodes[c] = Q.newNode();
+            QA.x(q) = centers[c].m_x;
+            QA.y(q) = centers[c].m_y;
+            QA.width(q) = QA.height(q) = g_settings->edgeLength;
+        }
+        for (size_t i = 0; i < links.size(); ++i) {
+            auto [a, b, length] = links[i];
+            if (i > 0 && std::get<0>(links[i - 1]) == a && std::get<1>(links[i - 1]) == b)
+                continue;
+            ogdf::edge e = Q.newEdge(quotientNodes[a], quotientNodes[b]);
+            quotientLengths[e] = radii[a] + radii[b] + length;
+        }
+
+        std::unique_ptr<GraphLayouter> layouter = makeLayouter(threadCount);
+        layouter->setSeed(deriveSeed(seed, k));
+        layouter->setRefinement(GraphLayouter::Refinement::None);
+        layouter->init();
+        layouter->run(QA, quotientLengths);
+        for (int c = 0; c < k; ++c)
+            centers[c] = QA.point(quotientNodes[c]);
+
+        // There are few communities, so the overlaps are looked for among
+        // all the pairs
+        for (int iteration = 0; iteration < 50; ++iteration) {
+            bool moved = false;
+            for (int a = 0; a < k; ++a) {
+                for (int b = a + 1; b < k; ++b) {
+                    ogdf::DPoint d = centers[b] - centers[a];
+                    double distance = std::hypot(d.m_x, d.m_y);
+                    double overlap = radii[a] + radii[b] - distance;
+                    if (overlap <= 0)
+                        continue;
+
+                    ogdf::DPoint direction = distance > 0 ? d / distance : ogdf::DPoint(1, 0);
+                    centers[a] -= direction * (overlap / 2);
+                    centers[b] += direction * (overlap / 2);
+                    moved = true;
+                }
+            }
+            if (!moved)
+                break;
+        }
+    }
+
+    // Best rotation of the boundary nodes (as unit vectors) onto the
+    // directions of their neighbouring communities, as is and mirrored
+    std::vector<double> dots(k, 0), crosses(k, 0), mirroredDots(k, 0), mirroredCrosses(k, 0);
+    auto unit = [](ogdf::DPoint p) {
+        double length = std::hypot(p.m_x, p.m_y);
+        return length > 0 ? p / length : ogdf::DPoint();
+    };
+    for (ogdf::edge e : G.edges) {
+        for (ogdf::node v : { e->source(), e->target() }) {
+            int c = communities.community(v), d = communities.community(e->opposite(v));
+            if (c == d)
+                continue;
+
+            ogdf::DPoint p = unit(CA.point(v)), q = unit(centers[d] - centers[c]);
+            dots[c] += p.m_x * q.m_x + p.m_y * q.m_y;
+            crosses[c] += p.m_x * q.m_y - p.m_y * q.m_x;
+            mirroredDots[c] += -p.m_x * q.m_x + p.m_y * q.m_y;
+            mirroredCrosses[c] += -p.m_x * q.m_y - p.m_y * q.m_x;
+        }
+    }
+
+    std::vector<bool> mirrored(k);
+    std::vector<double> angles(k);
+    for (int c = 0; c < k; ++c) {
+        mirrored[c] = std::hypot(mirroredDots[c], mirroredCrosses[c]) > std::hypot(dots[c], crosses[c]);
+        angles[c] = mirrored[c] ? std::atan2(mirroredCrosses[c], mirroredDots[c]) : std::atan2(crosses[c], dots[c]);
+    }
+    for (ogdf::node v : G.nodes) {
+        int c = communities.community(v);
+        double x = mirrored[c] ? -CA.x(v) : CA.x(v), y = CA.y(v);
+        double cosAngle = std::cos(angles[c]), sinAngle = std::sin(angles[c]);
+        CA.x(v) = centers[c].m_x + cosAngle * x - sinAngle * y;
+        CA.y(v) = centers[c].m_y + sinAngle * x + cosAngle * y;
+    }
+
+    // The discs keep elongated communities further apart than the edges
+    // between them want. Every community is moved as a whole by the average
+    // excess length of its boundary edges, halved as the community on the
+    // other side moves as well.
+    std::vector<ogdf::edge> boundary;
+    for (ogdf::edge e : G.edges) {
+        if (communities.community(e->source()) != communities.community(e->target()))
+            boundary.push_back(e);
+    }
+    std::vector<ogdf::DPoint> offsets(k), shifts(k);
+    std::vector<int> counts(k);
+    for (int iteration = 0; iteration < DockIterations && !boundary.empty(); ++iteration) {
+        std::fill(shifts.begin(), shifts.end(), ogdf::DPoint());
+        std::fill(counts.begin(), counts.end(), 0);
+        for (ogdf::edge e : boundary) {
+            int a = communities.community(e->source()), b = communities.community(e->target());
+            ogdf::DPoint d = (CA.point(e->target()) + offsets[b]) - (CA.point(e->source()) + offsets[a]);
+            ogdf::DPoint excess = unit(d) * (std::hypot(d.m_x, d.m_y) - copy.edgeLengths[e]);
+            shifts[a] += excess;
+            shifts[b] -= excess;
+            ++counts[a];
+            ++counts[b];
+        }
+        for (int c = 0; c < k; ++c) {
+            if (counts[c] > 0)
+                offsets[c] += shifts[c] / (2.0 * counts[c]);
+        }
+    }
+    for (ogdf::node v : G.nodes) {
+        int c = communities.community(v);
+        CA.x(v) += offsets[c].m_x;
+        CA.y(v) += offsets[c].m_y;
+    }
+
+    // Stitching zone: nodes near the edges between communities, in BFS order
+    ogdf::NodeArray<int> depth(G, -1);
+    std::vector<ogdf::node> zone;
+    for (ogdf::edge e : G.edges) {
+        if (communities.community(e->source()) == communities.community(e->target()))
+            continue;
+        for (ogdf::node v : { e->source(), e->target() }) {
+            if (depth[v] == -1) {
+                depth[v] = 0;
+                zone.push_back(v);
+            }
+        }
+    }
+    for (size_t head = 0; head < zone.size(); ++head) {
+        ogdf::node v = zone[head];
+        if (depth[v] == StitchDepth)
+            continue;
+        for (ogdf::adjEntry adj : v->adjEntries) {
+            ogdf::node u = adj->twinNode();
+            if (depth[u] == -1) {
+                depth[u] = depth[v] + 1;
+                zone.push_back(u);
+            }
+        }
+    }
+
+    // Gauss-Seidel iterations of the Poisson equation: every zone node goes
+    // to the average of its neighbours offset by the desired edge vectors,
+    // which are the vectors of the community layouts inside the communities
+    // and the desired lengths (in the current directions) between them
+    ogdf::NodeArray<ogdf::DPoint> placed(G);
+    for (ogdf::node v : zone) {
+        placed[v] = CA.point(v);
+        for (ogdf::adjEntry adj : v->adjEntries)
+            placed[adj->twinNode()] = CA.point(adj->twinNode());
+    }
+    for (int iteration = 0; iteration < StitchIterations && !cancelled; ++iteration) {
+        for (ogdf::node v : zone) {
+            ogdf::DPoint sum;
+            int count = 0;
+            for (ogdf::adjEntry adj : v->adjEntries) {
+                ogdf::node u = adj->twinNode();
+                if (u == v)
+                    continue;
+
+                ogdf::DPoint offset = placed[v] - placed[u];
+                if (communities.community(u) != communities.community(v))
+                    offset = unit(offset) * copy.edgeLengths[adj->theEdge()];
+                sum += CA.point(u) + offset;
+                ++count;
+            }
+            if (count > 0) {
+                CA.x(v) = sum.m_x / count;
+                CA.y(v) = sum.m_y / count;
+            }
+        }
+    }
+
+    // Components do not share nodes, so the writes do not race
+    std::vector<int> membership(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        GA.x(nodes[i]) = CA.x(copy.copies[i]);
+        GA.y(nodes[i]) = CA.y(copy.copies[i]);
+        membership[i] = communities.community(copy.copies[i]);
+    }
+
+    return membership;
+}
+
+// Whether the previous layout has exactly the nodes of the OGDF graph, with
+// the same number of segments
+static bool hasSameNodes(const GraphLayoutTask &task) {
+    const GraphLayout &previous = *task.previous;
+    size_t matched = 0;
+    for (auto *node : task.graph.m_deBruijnGraphNodes) {
+        if (!task.layout.contains(node))
+            continue;
+
+        size_t n = task.layout.segments(node).size();
+        const auto *rcNode = node->getReverseComplement();
+        bool own = previous.contains(node) && previous.segments(node).size() == n;
+        bool rc = previous.contains(rcNode) && previous.segments(rcNode).size() == n;
+        if (!own && !rc)
+            return false;
+        matched += own + rc;
+    }
+
+    return matched == previous.size();
+}
+
+// Moves the segments of the nodes found in the previous layout to their old
+// positions. Both strands are laid out along the same line, but in double
+// mode their drawn lines are shifted apart, so the two are averaged.
+static void seedFromPrevious(GraphLayoutTask &task) {
+    const GraphLayout &previous = *task.previous;
+    task.placed.init(task.G, false);
+    for (auto *node : task.graph.m_deBruijnGraphNodes) {
+        if (!task.layout.contains(node))
+            continue;
+
+        const auto &segments = task.layout.segments(node);
+        size_t n = segments.size();
+        const auto *rcNode = node->getReverseComplement();
+        bool own = previous.contains(node) && previous.segments(node).size() == n;
+        bool rc = previous.contains(rcNode) && previous.segments(rcNode).size() == n;
+        if (!own && !rc)
+            continue;
+
+        for (size_t i = 0; i < n; ++i) {
+            QPointF point;
+            if (own && rc)
+                point = (previous.segments(node)[i] + previous.segments(rcNode)[n - 1 - i]) / 2;
+            else if (own)
+                point = previous.segments(node)[i];
+            else
+                point = previous.segments(rcNode)[n - 1 - i];
+
+            task.GA.x(segments[i]) = point.x();
+            task.GA.y(segments[i]) = point.y();
+            task.placed[segments[i]] = true;
+        }
+    }
+}
+
+// Places the new nodes of a component that has nodes from the previous
+// layout. New nodes grow outwards from the placed ones (in BFS order), then
+// FMMM refines the component starting from there: a short single-level pass
+// if most of the component is placed, a full one otherwise. FMMM cannot fix
+// nodes, so the result is rigidly aligned with the placed nodes, which keep
+// their old positions, and only the new nodes are taken from it.
+static void placeNewNodes(GraphLayouter &layouter,
+                          ogdf::GraphAttributes &GA,
+                          const ogdf::EdgeArray<double> &edgeLengths,
+                          const ogdf::NodeArray<int> &indexInCC,
+                          const ogdf::NodeArray<bool> &placed,
+                          const ogdf::List<ogdf::node> &nodesInCC,
+                          unsigned seed) {
+    double centerX = 0, centerY = 0;
+    std::vector<ogdf::node> queue;
+    std::vector<bool> positioned(nodesInCC.size(), false);
+    for (ogdf::node v : nodesInCC) {
+        if (!placed[v])
+            continue;
+        centerX += GA.x(v);
+        centerY += GA.y(v);
+        queue.push_back(v);
+        positioned[indexInCC[v]] = true;
+    }
+    size_t placedCount = queue.size();
+    centerX /= double(placedCount);
+    centerY /= double(placedCount);
+
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> jitter(-0.5, 0.5);
+    for (size_t head = 0; head < queue.size(); ++head) {
+        ogdf::node u = queue[head];
+        double direction = std::atan2(GA.y(u) - centerY, GA.x(u) - centerX);
+        for (ogdf::adjEntry adj : u->adjEntries) {
+            ogdf::node w = adj->twinNode();
+            if (positioned[indexInCC[w]])
+                continue;
+
+            double angle = direction + jitter(rng);
+            GA.x(w) = GA.x(u) + edgeLengths[adj->theEdge()] * std::cos(angle);
+            GA.y(w) = GA.y(u) + edgeLengths[adj->theEdge()] * std::sin(angle);
+            positioned[indexInCC[w]] = true;
+            queue.push_back(w);
+        }
+    }
+
+    // The whole component is refined: FMMM packs disconnected parts anew,
+    // which would break their alignment
+    std::vector<ogdf::node> nodes;
+    nodes.reserve(nodesInCC.size());
+    for (ogdf::node v : nodesInCC)
+        nodes.push_back(v);
+
+    bool local = 2 * placedCount >= nodes.size();
+    ComponentCopy copy(GA, edgeLengths, indexInCC, nodesInCC.size(), nodes);
+    layouter.setRefinement(local ? GraphLayouter::Refinement::Local : GraphLayouter::Refinement::Global);
+    layouter.init();
+    layouter.run(copy.GA, copy.edgeLengths);
+
+    // Least squares rigid transformation mapping the placed nodes of the
+    // refined layout onto their old positions
+    double fromX = 0, fromY = 0, toX = 0, toY = 0;
+    size_t pairs = 0;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        if (!placed[nodes[i]])
+            continue;
+        fromX += copy.GA.x(copy.copies[i]);
+        fromY += copy.GA.y(copy.copies[i]);
+        toX += GA.x(nodes[i]);
+        toY += GA.y(nodes[i]);
+        ++pairs;
+    }
+    fromX /= double(pairs); fromY /= double(pairs);
+    toX /= double(pairs); toY /= double(pairs);
+
+    double dot = 0, cross = 0;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        if (!placed[nodes[i]])
+            continue;
+        double px = copy.GA.x(copy.copies[i]) - fromX, py = copy.GA.y(copy.copies[i]) - fromY;
+        double qx = GA.x(nodes[i]) - toX, qy = GA.y(nodes[i]) - toY;
+        dot += px * qx + py * qy;
+        cross += px * qy - py * qx;
+    }
+    double angle = std::atan2(cross, dot);
+    double cosAngle = std::cos(angle), sinAngle = std::sin(angle);
+
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        if (placed[nodes[i]])
+            continue;
+        double px = copy.GA.x(copy.copies[i]) - fromX, py = copy.GA.y(copy.copies[i]) - fromY;
+        GA.x(nodes[i]) = toX + cosAngle * px - sinAngle * py;
+        GA.y(nodes[i]) = toY + sinAngle * px + cosAngle * py;
+    }
+}
+
+// Components with nodes from the previous layout stay where they are, the
+// other ones are packed as usual and put to the right of them. The drawing
+// is then moved to the origin, so repeated incremental layouts do not drift.
+static void reassembleIncremental(GraphLayoutTask &task,
+                                  double graphLayoutComponentSeparation, double aspectRatio) {
+    ogdf::GraphAttributes &GA = task.GA;
+    const double infinity = std::numeric_limits<double>::infinity();
+
+    double minX = infinity, minY = infinity, maxX = -infinity;
+    std::vector<int> fresh;
+    for (int i = 0; i < task.nodesInCC.size(); ++i) {
+        if (task.placedInCC[i] == 0) {
+            fresh.push_back(i);
+            continue;
+        }
+        for (ogdf::node v : task.nodesInCC[i]) {
+            minX = std::min(minX, GA.x(v));
+            minY = std::min(minY, GA.y(v));
+            maxX = std::max(maxX, GA.x(v));
+        }
+    }
+
+    if (!fresh.empty()) {
+        ogdf::Array<ogdf::List<ogdf::node>> freshInCC(int(fresh.size()));
+        for (size_t i = 0; i < fresh.size(); ++i)
+            freshInCC[int(i)] = task.nodesInCC[fresh[i]];
+        reassembleDrawings(GA, graphLayoutComponentSeparation, aspectRatio, freshInCC);
+
+        double freshMinX = infinity, freshMinY = infinity;
+        for (const auto &nodesInCC : freshInCC) {
+            for (ogdf::node v : nodesInCC) {
+                freshMinX = std::min(freshMinX, GA.x(v));
+                freshMinY = std::min(freshMinY, GA.y(v));
+            }
+        }
+
+        double dx = maxX + graphLayoutComponentSeparation - freshMinX, dy = minY - freshMinY;
+        for (const auto &nodesInCC : freshInCC) {
+            for (ogdf::node v : nodesInCC) {
+                GA.x(v) += dx;
+                GA.y(v) += dy;
+            }
+        }
+    }
+
+    for (ogdf::node v : task.G.nodes) {
+        GA.x(v) -= minX;
+        GA.y(v) -= minY;
+    }
+}
+
+void GraphLayoutWorker::setPreviousLayout(GraphLayout layout) {
+    m_previousLayouts.emplace_back(std::move(layout));
+}
+
+std::vector<int> GraphLayoutWorker::layoutHierarchically(ogdf::GraphAttributes &GA,
+                                                         const ogdf::EdgeArray<double> &edgeLengths,
+                                                         unsigned seed) {
+    ogdf::NodeArray<int> indexInCC(GA.constGraph());
+    ogdf::List<ogdf::node> nodesInCC;
+    for (ogdf::node v : GA.constGraph().nodes) {
+        indexInCC[v] = nodesInCC.size();
+        nodesInCC.pushBack(v);
+    }
+
+    return ::layoutHierarchically([this](unsigned threads) { return makeLayouter(threads); },
+                                  m_threadCount, m_multilevel, seed, m_cancelled,
+                                  GA, edgeLengths, indexInCC, nodesInCC);
+}
+
+QByteArray GraphLayoutWorker::layoutParameters() const {
+    QByteArray parameters;
+    QDataStream out(&parameters, QIODevice::WriteOnly);
+    // Bump the version whenever the layout algorithm changes
+    out << qint32(7)
+        << qint32(m_engine) << qint32(m_graphLayoutQuality) << m_useLinearLayout << m_multilevel << quint32(m_seed)
+        << qint32(m_hierarchicalNodes)
+        << m_graphLayoutComponentSeparation
+        << getNodeLengthPerMegabase()
+        << double(g_settings->minimumNodeLength) << double(g_settings->nodeSegmentLength)
+        << double(g_settings->edgeLength)
+        << double(g_settings->hicEdgeLength) << double(g_settings->averageNodeWidth);
+    // Only the fast multipole embedder depends on the number of threads, so
+    // other layouts can be shared between machines
+    if (m_engine == FAST_MULTIPOLE_LAYOUT)
+        out << quint32(m_threadCount);
+
+    return parameters;
+}
+
+QByteArray GraphLayoutWorker::cacheParameters() const {
+    QByteArray parameters = layoutParameters();
+    QDataStream out(&parameters, QIODevice::Append);
+    out << m_aspectRatio;
+
+    return parameters;
+}
+
 QList<GraphLayout*> GraphLayoutWorker::layoutGraph(QSharedPointer<AssemblyGraphList> graphList) {
-    time_t start, end;
-    time(&start);
     QList<GraphLayout*> resList;
 
-    double boardWidth = 1000;
+    QThreadPool pool;
+    pool.setMaxThreadCount(int(m_threadCount));
+
+    // Build OGDF graphs and split them into components. Graphs are visited in
+    // the order of their ids, so are the components.
+    std::vector<std::unique_ptr<GraphLayoutTask>> graphs;
+    for (auto it = graphList->m_graphMap.begin(); it != graphList->m_graphMap.end(); ++it) {
+        graphs.emplace_back(std::make_unique<GraphLayoutTask>(*it.value(), deriveSeed(m_seed, unsigned(it.key()))));
+        for (const auto &previous : m_previousLayouts) {
+            if (&previous.graph() == it.value())
+                graphs.back()->previous = &previous;
+        }
+    }
+
+    QByteArray parameters;
+    if (m_cache.enabled())
+        parameters = cacheParameters();
+
+    QtConcurrent::blockingMap(&pool, graphs, [&](std::unique_ptr<GraphLayoutTask> &task) {
+        // Cached graphs are not laid out at all: they have no components
+        if (m_cache.enabled() && !task->previous) {
+            task->cacheKey = layout::LayoutCache::key(task->graph, parameters);
+            auto cached = std::make_unique<GraphLayout>(task->graph);
+            if (m_cache.load(task->cacheKey, *cached)) {
+                task->cached = std::move(cached);
+                return;
+            }
+        }
+
+        buildGraph(task->G, task->GA, task->edgeLengths, task->layout, m_useLinearLayout);
+
+        ogdf::NodeArray<int> componentNumber(task->G);
+        int numberOfComponents = connectedComponents(task->G, componentNumber);
+        task->nodesInCC.init(numberOfComponents);
+        task->indexInCC.init(task->G);
+        for (auto v : task->G.nodes) {
+            auto &nodesInCC = task->nodesInCC[componentNumber[v]];
+            task->indexInCC[v] = nodesInCC.size();
+            nodesInCC.pushBack(v);
+        }
+
+        task->pathComponents.resize(numberOfComponents);
+        for (int i = 0; i < numberOfComponents; ++i)
+            task->pathComponents[i] = layout::isPath(task->nodesInCC[i]);
+
+        task->placedInCC.assign(numberOfComponents, 0);
+        if (task->previous && hasSameNodes(*task))
+            task->previous = nullptr;
+        if (task->previous) {
+            seedFromPrevious(*task);
+            for (auto v : task->G.nodes)
+                task->placedInCC[componentNumber[v]] += task->placed[v];
+        }
+    });
+
+    // Components are processed largest first (longest processing time
+    // scheduling). Paths are cheap to place, so they go last. Components
+    // placed completely by the previous layout are kept as they are.
+    std::vector<ComponentTask> components;
+    for (auto &task : graphs) {
+        for (int i = 0; i < task->nodesInCC.size(); ++i) {
+            int size = task->nodesInCC[i].size(), placed = task->placedInCC[i];
+            if (placed == size)
+                continue;
+            components.push_back({ task.get(), i, size, placed, placed == 0 && task->pathComponents[i] });
+        }
+    }
+    std::stable_sort(components.begin(), components.end(),
+                     [](const ComponentTask &a, const ComponentTask &b) {
+        return (a.path ? 0 : a.size - a.placed) > (b.path ? 0 : b.size - b.placed);
+    });
+
+    // The thread budget is split between the components and the layouts:
+    // components laid out on several threads themselves (the large ones with
+    // the fast multipole embedder and the hierarchical ones) get all the
+    // threads, one at a time, the rest are laid out by the workers on a
+    // thread each. The largest ones come first anyway.
+    auto hierarchical = [this](const ComponentTask &component) {
+        return component.placed == 0 && m_hierarchicalNodes > 0 && component.size >= m_hierarchicalNodes;
+    };
+    auto parallel = [&](const ComponentTask &component) {
+        return !component.path &&
+               (hierarchical(component) ||
+                (m_engine == FAST_MULTIPOLE_LAYOUT && component.size >= FMEGraphLayout::MinParallelNodes));
+    };
+    size_t parallelCount =
+            std::stable_partition(components.begin(), components.end(), parallel) - components.begin();
+
+    // Large components form batches of their own, small ones are grouped
+    std::vector<size_t> batchStarts;
+    int batchNodes = MinBatchNodes;
+    for (size_t i = parallelCount; i < components.size(); ++i) {
+        if (batchNodes >= MinBatchNodes) {
+            batchStarts.push_back(i);
+            batchNodes = 0;
+        }
+        batchNodes += components[i].size - components[i].placed;
+    }
+    batchStarts.push_back(components.size());
+
+    // Progress is reported in nodes, every whole percent
+    qint64 totalNodes = 0;
+    for (const ComponentTask &component : components)
+        totalNodes += component.size - component.placed;
+    std::atomic<qint64> doneNodes{0};
+    emit layoutProgress(0, int(totalNodes));
+
+    // Every component gets a seed of its own, so the result does not
+    // depend on the batch or the worker it is processed by. Components are
+    // still placed after the layout is cancelled: the layouters stop right
+    // after the initial placement then.
+    auto layoutComponents = [&](size_t begin, size_t end, unsigned threadCount) {
+        std::unique_ptr<GraphLayouter> layouter = makeLayouter(threadCount);
+        for (size_t i = begin; i < end; ++i) {
+            const ComponentTask &component = components[i];
+            GraphLayoutTask &task = *component.graph;
+            const ogdf::List<ogdf::node> &nodesInCC = task.nodesInCC[component.index];
+            unsigned seed = deriveSeed(task.seed, unsigned(component.index));
+            if (component.path) {
+                layout::placePath(task.GA, task.edgeLengths, nodesInCC);
+            } else if (component.placed > 0) {
+                layouter->setSeed(seed);
+                placeNewNodes(*layouter, task.GA, task.edgeLengths, task.indexInCC, task.placed, nodesInCC, seed);
+            } else if (hierarchical(component)) {
+                layoutHierarchically([this](unsigned threads) { return makeLayouter(threads); },
+                                     threadCount, m_multilevel, seed, m_cancelled,
+                                     task.GA, task.edgeLengths, task.indexInCC, nodesInCC);
+            } else {
+                layouter->setSeed(seed);
+                layouter->setRefinement(GraphLayouter::Refinement::None);
+                layouter->init();
+                layoutComponent(*layouter, m_multilevel, task.GA, task.edgeLengths, task.indexInCC, nodesInCC);
+            }
+
+            qint64 nodes = component.size - component.placed;
+            qint64 done = doneNodes.fetch_add(nodes) + nodes;
+            if ((done - nodes) * 100 / totalNodes != done * 100 / totalNodes)
+                emit layoutProgress(int(done), int(totalNodes));
+        }
+    };
+    for (size_t i = 0; i < parallelCount; ++i)
+        layoutComponents(i, i + 1, m_threadCount);
+    m_scheduler.run(batchStarts.size() - 1, m_threadCount, [&](size_t batch) {
+        layoutComponents(batchStarts[batch], batchStarts[batch + 1], 1);
+    });
+
+    QtConcurrent::blockingMap(&pool, graphs, [&](std::unique_ptr<GraphLayoutTask> &task) {
+        const AssemblyGraph &graph = task->graph;
+        GraphLayout *res;
+        if (task->cached) {
+            res = task->cached.release();
+        } else {
+            res = new GraphLayout(graph);
+            bool anchored = std::any_of(task->placedInCC.begin(), task->placedInCC.end(),
+                                        [](int placed) { return placed > 0; });
+            if (anchored)
+                reassembleIncremental(*task, m_graphLayoutComponentSeparation, m_aspectRatio);
+            else if (task->nodesInCC.size() > 0)
+                reassembleDrawings(task->GA,
+                                   m_graphLayoutComponentSeparation, m_aspectRatio,
+                                   task->nodesInCC);
+
+            for (auto *node : graph.m_deBruijnGraphNodes) {
+                if (!task->layout.contains(node))
+                    continue;
+                for (ogdf::node segment : task->layout.segments(node))
+                    res->add(node, { task->GA.x(segment), task->GA.y(segment) });
+            }
+            // In double mode add layout for the reverse-complement nodes (in opposite direction)
+            for (auto *node : graph.m_deBruijnGraphNodes) {
+                if (!task->layout.contains(node))
+                    continue;
+                auto *rcNode = node->getReverseComplement();
+                if (!rcNode->isDrawn())
+                    continue;
+                const auto &segments = task->layout.segments(node);
+                for (auto rIt = segments.rbegin(); rIt != segments.rend(); ++rIt)
+                    res->add(rcNode, { task->GA.x(*rIt), task->GA.y(*rIt) });
+            }
+
+            // Incomplete layouts are not cached
+            if (!task->cacheKey.isEmpty() && !m_cancelled)
+                m_cache.store(task->cacheKey, *res);
+        }
+
+        // Nodes are visited in the trie order, so the sums are the same
+        // in every run, whether the layout is cached or not
+        for (auto *node : graph.m_deBruijnGraphNodes) {
+            if (!res->contains(node))
+                continue;
+            for (const QPointF &point : res->segments(node)) {
+                task->sumX += point.x();
+                task->maxX = std::max(task->maxX, point.x());
+            }
+        }
+
+        task->result = res;
+    });
+
     qreal sumX = 0;
     qreal oneMaxX = 0;
-    int numGraph = 0;
-    for(AssemblyGraph* graph : graphList->m_graphMap.values()) {
-        QFutureSynchronizer<void> * synch = new QFutureSynchronizer<void>();
-        m_taskSynchronizers.push_back(std::move(synch));
-        m_taskSynchronizerMultiGraph.addFuture(
-                    QtConcurrent::run([&](AssemblyGraph* graph, QFutureSynchronizer<void> * taskSynchronizer) {
-                        const AssemblyGraph& refGraph = std::cref(*graph);
-                        ogdf::Graph G;
-                        ogdf::EdgeArray<double> edgeLengths(G);
-                        ogdf::GraphAttributes GA(G,
-                                                 ogdf::GraphAttributes::nodeGraphics | ogdf::GraphAttributes::edgeGraphics);
-                        OGDFGraphLayout layout(refGraph);
-                        std::vector<std::unique_ptr<GraphLayouter>> m_state;
-                        buildGraph(G, GA, edgeLengths, layout, m_useLinearLayout);
-
-                        //first we split the graph into its components
-                        ogdf::NodeArray<int> componentNumber(G);
-                        int numberOfComponents = connectedComponents(G, componentNumber);
-                        if (numberOfComponents == 0) {
-                            GraphLayout res(refGraph);
-                            graph->setLayout(&res);
-                            return;
-                        }
-
-                        ogdf::Array<ogdf::List<ogdf::node> > nodesInCC(numberOfComponents);
-                        for (auto v : G.nodes)
-                            nodesInCC[componentNumber[v]].pushBack(v);
-
-                        for (size_t i= 0; i < numberOfComponents; ++i) {
-                            m_state.emplace_back(new FMMGraphLayout(m_graphLayoutQuality,
-                                                                   m_useLinearLayout,
-                                                                   m_graphLayoutComponentSeparation,
-                                                                   m_aspectRatio));
-                            m_state.back()->init();
-                        }
-
-                        for (int i = 0; i < numberOfComponents; i++) {
-                            taskSynchronizer->addFuture(
-                                    QtConcurrent::run([&](GraphLayouter *layout,
-                                            const ogdf::List<ogdf::node> &nodesInCC) {
-
-                                        ogdf::GraphCopy GC;
-                                        ogdf::EdgeArray<double> cedgeLengths(GC);
-                                        ogdf::EdgeArray<ogdf::edge> auxCopy(G);
-
-                                        GC.createEmpty(G);
-
-                                        GC.initByNodes(nodesInCC, auxCopy);
-                                        ogdf::GraphAttributes cGA(GC, GA.attributes());
-                                        for (ogdf::node v : GC.nodes) {
-                                            cGA.x(v) = GA.x(GC.original(v));
-                                            cGA.y(v) = GA.y(GC.original(v));
-                                            cGA.width(v) = GA.width(GC.original(v));
-                                            cGA.height(v) = GA.height(GC.original(v));
-                                        }
-
-                                        for (ogdf::edge e : GC.edges)
-                                            cedgeLengths(e) = edgeLengths(GC.original(e));
-
-                                        layout->run(cGA, cedgeLengths);
-
-                                        for (ogdf::node v : GC.nodes) {
-                                            ogdf::node w = GC.original(v);
-                                            if (w == nullptr)
-                                                continue;
-
-                                            GA.x(w) = cGA.x(v);
-                                            GA.y(w) = cGA.y(v);
-                                        }
-
-                                    }, m_state[i].get(), nodesInCC[i]));
-                        }
-                        taskSynchronizer->waitForFinished();
-
-                        reassembleDrawings(GA,
-                                           m_graphLayoutComponentSeparation, m_aspectRatio,
-                                           nodesInCC);
-
-                        GraphLayout* res = new GraphLayout(refGraph);
-                        for (const auto & entry : layout) {
-                            for (ogdf::node node : entry.second) {
-                                double curX = GA.x(node);
-                                double curY = GA.y(node);
-                                res->add(entry.first, { curX, curY });
-                                sumX += curX;
-                                oneMaxX = std::max(oneMaxX, curX);
-                            }
-                        }
-                        // In double mode add layout for the reverse-complement nodes (in opposite direction)
-                        for (const auto & entry : layout) {
-                            auto *rcNode = entry.first->getReverseComplement();
-                            if (!rcNode->isDrawn())
-                                continue;
-                            for (auto rIt = entry.second.rbegin(); rIt != entry.second.rend(); ++rIt)
-                                res->add(rcNode, { GA.x(*rIt), GA.y(*rIt) });
-                        }
-
-                        graph->setLayout(res);
-        }, graph, (m_taskSynchronizers[numGraph])));
-        numGraph+=1;
-    }
-    m_taskSynchronizerMultiGraph.waitForFinished();
+    for (const auto &task : graphs) {
+        task->graph.setLayout(task->result);
+        sumX += task->sumX;
+        oneMaxX = std::max(oneMaxX, task->maxX);
+    }
+
+    double boardWidth = 1000;
     qreal boundX = std::max(oneMaxX, std::round(std::sqrt(sumX))) + 1.0;
 
     qreal prevX = 0.0;
     qreal prevY = 0.0;
-    qreal curMaxX = 0.0;
-    qreal curMaxY = -boardWidth;
     qreal maxX = 0.0;
     qreal maxY = -boardWidth;
     double textWidth = 0.0;
 
     QList<int> idGraphs = graphList->m_graphMap.keys();
 
-    std::sort(idGraphs.begin(), idGraphs.end(), [&](int a, int b)->bool{
+    std::stable_sort(idGraphs.begin(), idGraphs.end(), [&](int a, int b)->bool{
         return (layout::getMaxX(*(graphList->m_graphMap[a])->m_layout) + layout::getMaxY(*(graphList->m_graphMap[a])->m_layout)) >
                 (layout::getMaxX(*(graphList->m_graphMap[b])->m_layout) + layout::getMaxY(*(graphList->m_graphMap[b])->m_layout));
     });
@@ -748,15 +1684,9 @@ QList<GraphLayout*> GraphLayoutWorker::layoutGraph(QSharedPointer<AssemblyGraphL
 
     }
 
-    time(&end);
-    double second = difftime(end, start);
     return resList;
 }
 
 [[maybe_unused]] void GraphLayoutWorker::cancelLayout() {
-    for (auto taskSynchronizer : m_taskSynchronizers) {
-        for (auto & future : taskSynchronizer->futures()) {
-            future.cancel();
-        }
-    }
+    m_cancelled = true;
 }
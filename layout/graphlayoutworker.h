@@ -18,13 +18,21 @@
 #pragma once
 
 #include "graphlayout.h"
+#include "layoutcache.h"
+#include "workstealing.h"
 #include "graph/assemblygraph.h"
 #include "graph/assemblygraphlist.h"
+#include "program/settings.h"
 
 #include <QObject>
-#include <QFutureSynchronizer>
 #include <QSharedPointer>
 
+#include <atomic>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
 namespace ogdf {
     class Graph;
     class GraphAttributes;
@@ -39,20 +47,50 @@ public:
                   double aspectRatio = 1.333333);
     virtual ~GraphLayouter() {}
     virtual void init() = 0;
-    virtual void cancel() = 0;
     virtual void run(ogdf::GraphAttributes &GA, const ogdf::EdgeArray<double> &edges) = 0;
 
+    // Once the flag is set, run() stops iterating and leaves the positions
+    // reached so far. Must be set before init().
+    void setCancellationFlag(const std::atomic<bool> *cancelled) { m_cancelled = cancelled; }
+
+    // Must be called before init(), layouts are reproducible for the same seed
+    void setSeed(unsigned seed) { m_seed = seed; }
+
+    // How the current positions are used, must be set before init()
+    enum class Refinement {
+        None,   // Random (or linear) initial positions
+        Global, // Full layout starting from the current positions
+        Local   // A few single-level iterations from the current positions
+    };
+    void setRefinement(Refinement refinement) { m_refinement = refinement; }
+
 protected:
     int m_graphLayoutQuality;
     bool m_useLinearLayout;
     double m_graphLayoutComponentSeparation;
     double m_aspectRatio;
+    unsigned m_seed = 0;
+    Refinement m_refinement = Refinement::None;
+    const std::atomic<bool> *m_cancelled = nullptr;
 };
 
 class GraphLayoutWorker : public QObject {
     Q_OBJECT
 
 public:
+    // The layout is fully determined by the settings, g_settings->layoutSeed
+    // and g_settings->multilevelLayout (with g_settings->graphLayoutEngine
+    // set to the fast multipole embedder it depends on the number of threads):
+    // every graph and every connected component gets its own seed derived from
+    // it, so the result does not depend on the number of threads
+    // (g_settings->threadCount()) or on the order the components are finished.
+    // The threads are shared: components laid out on several threads get
+    // all of them one at a time, the others a thread each.
+    // Layouts are looked up in (and added to) the layout cache in
+    // g_settings->layoutCacheDir, graphs with a previous layout bypass it.
+    // Components of at least g_settings->hierarchicalLayoutNodes nodes are
+    // laid out hierarchically: communities of nodes are laid out in
+    // parallel, placed by the layout of their quotient graph and stitched.
     GraphLayoutWorker(int graphLayoutQuality,
                       bool useLinearLayout,
                       double graphLayoutComponentSeparation,
@@ -60,16 +98,70 @@ public:
     ~GraphLayoutWorker() override = default;
 
     QList<GraphLayout*> layoutGraph(QSharedPointer<AssemblyGraphList> graphList);
-    //void layoutGraph(QSharedPointer<AssemblyGraphList> graphList);
+
+    // Seeds the layout of layout.graph() with its previous layout. Nodes
+    // found there (with the same number of segments) keep their positions
+    // and the components containing them are not moved: only the new nodes
+    // are placed, followed by a short refinement pass. The remaining
+    // components are laid out as usual and placed next to them. A previous
+    // layout of exactly the drawn nodes is ignored, so that redrawing the
+    // same nodes lays them out afresh.
+    void setPreviousLayout(GraphLayout layout);
+
+    // Everything but the graph and the aspect ratio the layout depends on.
+    // Previous layouts should only be passed on while these stay the same.
+    QByteArray layoutParameters() const;
+
+    // Lays out the connected graph of GA the way components of at least
+    // g_settings->hierarchicalLayoutNodes nodes are. Returns the community of
+    // every node, in the node order of the graph.
+    std::vector<int> layoutHierarchically(ogdf::GraphAttributes &GA,
+                                          const ogdf::EdgeArray<double> &edgeLengths,
+                                          unsigned seed);
+
+    bool isCancelled() const { return m_cancelled; }
+
+signals:
+    // Reported as the components are laid out, in nodes
+    void layoutProgress(int done, int total);
 
 private:
-    std::vector<QFutureSynchronizer<void>*> m_taskSynchronizers;
-    QFutureSynchronizer<void> m_taskSynchronizerMultiGraph;
+    // Everything but the graph the layout depends on
+    QByteArray cacheParameters() const;
+    // Fast multipole layouters lay out large components on threadCount
+    // threads, the others ignore it
+    std::unique_ptr<GraphLayouter> makeLayouter(unsigned threadCount) const;
+
+    std::vector<GraphLayout> m_previousLayouts;
+    layout::WorkStealingScheduler m_scheduler;
+    std::atomic<bool> m_cancelled{false};
     int m_graphLayoutQuality;
     bool m_useLinearLayout;
     double m_graphLayoutComponentSeparation;
     double m_aspectRatio;
+    layout::LayoutCache m_cache;
+    unsigned m_seed;
+    bool m_multilevel;
+    int m_hierarchicalNodes;
+    GraphLayoutEngine m_engine;
+    // All the layout threads together, see layoutGraph()
+    unsigned m_threadCount;
 
 public slots:
+    // Stops the layout as soon as possible: the components being laid out
+    // keep their current positions, the remaining ones get only their
+    // initial placement. May be called from any thread (and a signal
+    // handler), the layout is not cached.
     [[maybe_unused]] void cancelLayout();
 };
+
+namespace layout {
+    // Natural sort key of a node name: runs of digits compare by their numeric
+    // value and go before any text, text compares ASCII case-insensitively.
+    // Keys compare bytewise, so every name is parsed only once.
+    std::string naturalSortKey(std::string_view name);
+
+    // Initial positions of the drawn nodes in the linear layout, before the
+    // layout algorithm is run on them
+    GraphLayout linearPositions(const AssemblyGraph &graph);
+}
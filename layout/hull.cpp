@@ -0,0 +1,66 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "hull.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace layout {
+    std::vector<ogdf::DPoint> convexHull(std::vector<ogdf::DPoint> points) {
+        std::sort(points.begin(), points.end(), [](const ogdf::DPoint &a, const ogdf::DPoint &b) {
+            return a.m_x < b.m_x || (a.m_x == b.m_x && a.m_y < b.m_y);
+        });
+        points.erase(std::unique(points.begin(), points.end()), points.end());
+        if (points.size() < 3)
+            return points;
+
+        auto cross = [](const ogdf::DPoint &o, const ogdf::DPoint &a, const ogdf::DPoint &b) {
+            return (a.m_x - o.m_x) * (b.m_y - o.m_y) - (a.m_y - o.m_y) * (b.m_x - o.m_x);
+        };
+
+        std::vector<ogdf::DPoint> hull(2 * points.size());
+        size_t k = 0;
+        for (size_t i = 0; i < points.size(); ++i) {
+            while (k >= 2 && cross(hull[k - 2], hull[k - 1], points[i]) <= 0)
+                --k;
+            hull[k++] = points[i];
+        }
+        for (size_t i = points.size() - 1, lower = k + 1; i > 0; --i) {
+            while (k >= lower && cross(hull[k - 2], hull[k - 1], points[i - 1]) <= 0)
+                --k;
+            hull[k++] = points[i - 1];
+        }
+        hull.resize(k - 1);
+
+        return hull;
+    }
+
+    void rotatedExtents(const std::vector<ogdf::DPoint> &points, double angle,
+                        double &x_min, double &x_max, double &y_min, double &y_max) {
+        double sin_a = sin(angle), cos_a = cos(angle);
+        x_min = y_min = std::numeric_limits<double>::max();
+        x_max = y_max = std::numeric_limits<double>::lowest();
+        for (const ogdf::DPoint &p : points) {
+            double x = cos_a * p.m_x - sin_a * p.m_y, y = sin_a * p.m_x + cos_a * p.m_y;
+            x_min = std::min(x_min, x);
+            x_max = std::max(x_max, x);
+            y_min = std::min(y_min, y);
+            y_max = std::max(y_max, y);
+        }
+    }
+}
@@ -0,0 +1,87 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "ogdf/basic/geometry.h"
+#include "ogdf/basic/Math.h"
+
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace layout {
+    // Convex hull of the points (Andrew's monotone chain), counter-clockwise.
+    // Fewer than three distinct points are returned as they are, sorted.
+    std::vector<ogdf::DPoint> convexHull(std::vector<ogdf::DPoint> points);
+
+    // Extents of the points rotated by the angle (the way the
+    // components are rotated when they are packed: counter-clockwise)
+    void rotatedExtents(const std::vector<ogdf::DPoint> &points, double angle,
+                        double &x_min, double &x_max, double &y_min, double &y_max);
+
+    // Rotation angles (in [0, PI/2), a rotation by PI/2 only swaps the sides)
+    // aligning the hull edges with the x axis and the bounding rectangle sides
+    // for these angles. The minimum area rectangle has a side on a hull edge, so
+    // these are the candidates. The extreme points are advanced around the hull
+    // together with the edge (rotating calipers), which is O(h) in total.
+    template<class Visitor>
+    void visitHullEdgeRectangles(const std::vector<ogdf::DPoint> &hull, Visitor visitor) {
+        size_t h = hull.size();
+        if (h < 2)
+            return;
+
+        auto dot = [](const ogdf::DPoint &p, double x, double y) { return p.m_x * x + p.m_y * y; };
+        size_t right = 0, top = 0, left = 0;
+        for (size_t i = 0; i < h; ++i) {
+            const ogdf::DPoint &from = hull[i], &to = hull[(i + 1) % h];
+            double length = std::hypot(to.m_x - from.m_x, to.m_y - from.m_y);
+            if (length == 0)
+                continue;
+            // Edge direction and the inward normal (the hull is counter-clockwise)
+            double ux = (to.m_x - from.m_x) / length, uy = (to.m_y - from.m_y) / length;
+            double nx = -uy, ny = ux;
+
+            if (i == 0) {
+                for (size_t j = 1; j < h; ++j) {
+                    if (dot(hull[j], ux, uy) > dot(hull[right], ux, uy)) right = j;
+                    if (dot(hull[j], nx, ny) > dot(hull[top], nx, ny)) top = j;
+                    if (dot(hull[j], ux, uy) < dot(hull[left], ux, uy)) left = j;
+                }
+            } else {
+                for (size_t steps = 0; steps < h && dot(hull[(right + 1) % h], ux, uy) >= dot(hull[right], ux, uy); ++steps)
+                    right = (right + 1) % h;
+                for (size_t steps = 0; steps < h && dot(hull[(top + 1) % h], nx, ny) >= dot(hull[top], nx, ny); ++steps)
+                    top = (top + 1) % h;
+                for (size_t steps = 0; steps < h && dot(hull[(left + 1) % h], ux, uy) <= dot(hull[left], ux, uy); ++steps)
+                    left = (left + 1) % h;
+            }
+
+            double width = dot(hull[right], ux, uy) - dot(hull[left], ux, uy);
+            double height = dot(hull[top], nx, ny) - dot(from, nx, ny);
+            // Rotating by -atan2(uy, ux) maps the edge onto the x axis, every
+            // quarter turn taken off swaps the sides
+            double angle = -std::atan2(uy, ux);
+            double quarters = std::floor(angle / ogdf::Math::pi_2);
+            angle -= quarters * ogdf::Math::pi_2;
+            if (int64_t(quarters) % 2 != 0)
+                std::swap(width, height);
+            visitor(angle, width, height);
+        }
+    }
+}
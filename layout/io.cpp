@@ -19,6 +19,7 @@
 
 #include "graph/assemblygraph.h"
 #include "graph/debruijnnode.h"
+#include "graph/snapshot.h"
 #include "graphlayout.h"
 
 #include "program/settings.h"
@@ -109,6 +110,10 @@ namespace layout::io {
 
     bool load(const QString &filename,
               GraphLayout &layout) {
+        // Layouts could also be taken from graph snapshots
+        if (snapshot::isSnapshot(filename))
+            return snapshot::loadLayout(filename, layout);
+
         QFile loadFile(filename);
         // FIXME: Switch to Error return object stuff!
         if (!loadFile.open(QIODevice::ReadOnly | QIODevice::Text))
@@ -0,0 +1,135 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "layoutcache.h"
+#include "io.h"
+
+#include "graph/assemblygraph.h"
+#include "graph/debruijnnode.h"
+#include "graph/debruijnedge.h"
+#include "hic/hicedge.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#include <stdexcept>
+
+namespace layout {
+    LayoutCache::LayoutCache(QString directory, qint64 maxSize)
+            : m_directory(std::move(directory)), m_maxSize(maxSize) {}
+
+    QByteArray LayoutCache::key(const AssemblyGraph &graph, const QByteArray &parameters) {
+        QByteArray content;
+        QDataStream out(&content, QIODevice::WriteOnly);
+        out << parameters;
+
+        // Nodes are visited in the trie order, so are their edges: the key
+        // does not depend on the pointers
+        for (const auto *node : graph.m_deBruijnGraphNodes) {
+            if (!node->isDrawn())
+                continue;
+            out << node->getName() << quint64(node->getLength());
+        }
+
+        for (const auto *node : graph.m_deBruijnGraphNodes) {
+            for (const auto *edge : node->edges()) {
+                if (edge->getStartingNode() != node || !edge->isDrawn())
+                    continue;
+                out << edge->getStartingNode()->getName() << edge->getEndingNode()->getName()
+                    << qint32(edge->getOverlapType());
+            }
+            for (const auto *edge : node->hicEdges()) {
+                if (edge->getStartingNode() != node || !edge->isDrawn())
+                    continue;
+                out << QStringLiteral("hic") << edge->getStartingNode()->getName() << edge->getEndingNode()->getName();
+            }
+        }
+
+        return QCryptographicHash::hash(content, QCryptographicHash::Sha256).toHex();
+    }
+
+    QString LayoutCache::fileName(const QByteArray &key) const {
+        return QDir(m_directory).filePath(QString::fromLatin1(key) + ".layout");
+    }
+
+    bool LayoutCache::load(const QByteArray &key, GraphLayout &layout) const {
+        if (!enabled())
+            return false;
+
+        QString name = fileName(key);
+        QFile file(name);
+        if (!file.exists())
+            return false;
+
+        // Broken (e.g. partially written by an old version) entries are
+        // dropped
+        bool loaded = false;
+        try {
+            loaded = layout::io::load(name, layout);
+        } catch (const std::runtime_error &) {
+        }
+        if (!loaded) {
+            file.remove();
+            layout.clear();
+            return false;
+        }
+
+        // Eviction is by the modification time, so hits keep layouts alive
+        if (file.open(QIODevice::Append))
+            file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+
+        return true;
+    }
+
+    bool LayoutCache::store(const QByteArray &key, const GraphLayout &layout) const {
+        if (!enabled() || !QDir().mkpath(m_directory))
+            return false;
+
+        // Written aside and renamed, so concurrent readers never see a
+        // partial layout
+        QString name = fileName(key);
+        QString temporary = name + QString(".%1.tmp").arg(QCoreApplication::applicationPid());
+        if (!layout::io::save(temporary, layout))
+            return false;
+
+        QFile::remove(name);
+        if (!QFile::rename(temporary, name)) {
+            QFile::remove(temporary);
+            return false;
+        }
+
+        evict();
+        return true;
+    }
+
+    void LayoutCache::evict() const {
+        QFileInfoList entries = QDir(m_directory).entryInfoList({ "*.layout" }, QDir::Files, QDir::Time);
+
+        // Newest first
+        qint64 size = 0;
+        for (const QFileInfo &entry : entries) {
+            size += entry.size();
+            if (size > m_maxSize)
+                QFile::remove(entry.filePath());
+        }
+    }
+}
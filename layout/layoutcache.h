@@ -0,0 +1,54 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "graphlayout.h"
+
+#include <QByteArray>
+#include <QString>
+
+class AssemblyGraph;
+
+namespace layout {
+    // On-disk cache of graph layouts. Every layout is stored (in the usual
+    // layout::io format) in a file named after its key: a hash of the drawn
+    // part of the graph (nodes, their lengths and drawn edges, so the graph
+    // scope is covered as well) and of the layout parameters. The least
+    // recently used layouts are removed once the cache grows over its size.
+    class LayoutCache {
+    public:
+        // An empty directory disables the cache
+        LayoutCache(QString directory, qint64 maxSize);
+
+        bool enabled() const { return !m_directory.isEmpty(); }
+
+        // The parameters must contain everything else the layout depends on
+        static QByteArray key(const AssemblyGraph &graph, const QByteArray &parameters);
+
+        // Returns false if there is no (valid) layout for the key
+        bool load(const QByteArray &key, GraphLayout &layout) const;
+        bool store(const QByteArray &key, const GraphLayout &layout) const;
+
+    private:
+        QString fileName(const QByteArray &key) const;
+        void evict() const;
+
+        QString m_directory;
+        qint64 m_maxSize;
+    };
+}
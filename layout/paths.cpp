@@ -0,0 +1,60 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "paths.h"
+
+namespace layout {
+    bool isPath(const ogdf::List<ogdf::node> &nodesInCC) {
+        int degrees = 0;
+        for (ogdf::node v : nodesInCC) {
+            if (v->degree() > 2)
+                return false;
+            degrees += v->degree();
+        }
+
+        // A connected graph with n - 1 edges is a tree
+        return degrees == 2 * (nodesInCC.size() - 1);
+    }
+
+    void placePath(ogdf::GraphAttributes &GA,
+                   const ogdf::EdgeArray<double> &edgeLengths,
+                   const ogdf::List<ogdf::node> &nodesInCC) {
+        ogdf::node start = nullptr;
+        for (ogdf::node v : nodesInCC) {
+            if (v->degree() <= 1 && (start == nullptr || GA.x(v) < GA.x(start)))
+                start = v;
+        }
+
+        ogdf::edge prev = nullptr;
+        double x = 0;
+        for (ogdf::node v = start; v != nullptr;) {
+            GA.x(v) = x;
+            GA.y(v) = 0;
+
+            ogdf::node next = nullptr;
+            for (ogdf::adjEntry adj : v->adjEntries) {
+                if (adj->theEdge() == prev)
+                    continue;
+                prev = adj->theEdge();
+                x += edgeLengths[prev];
+                next = adj->twinNode();
+                break;
+            }
+            v = next;
+        }
+    }
+}
@@ -0,0 +1,35 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "ogdf/basic/GraphAttributes.h"
+#include "ogdf/basic/List.h"
+
+namespace layout {
+    // Whether the connected component is a simple path: a single node or a
+    // chain of them
+    bool isPath(const ogdf::List<ogdf::node> &nodesInCC);
+
+    // Places a path component as a straight horizontal line with the desired
+    // edge lengths, which is what FMMM converges to, without running it. The
+    // line starts at x = 0 from the end that was leftmost before, so the
+    // linear layout keeps its direction.
+    void placePath(ogdf::GraphAttributes &GA,
+                   const ogdf::EdgeArray<double> &edgeLengths,
+                   const ogdf::List<ogdf::node> &nodesInCC);
+}
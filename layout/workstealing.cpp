@@ -0,0 +1,81 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "workstealing.h"
+
+#include <QThreadPool>
+
+#include <algorithm>
+
+namespace layout {
+    void WorkStealingScheduler::run(size_t count, unsigned threadCount,
+                                    const std::function<void(size_t)> &task) {
+        if (m_cancelled || count == 0)
+            return;
+
+        size_t workerCount = std::clamp<size_t>(threadCount, 1, count);
+        m_workers.clear();
+        for (size_t i = 0; i < workerCount; ++i)
+            m_workers.push_back(std::make_unique<Worker>());
+        for (size_t i = 0; i < count; ++i)
+            m_workers[i % workerCount]->tasks.push_back(i);
+
+        auto work = [&](size_t worker) {
+            size_t current;
+            while (!m_cancelled && (pop(worker, current) || steal(worker, current)))
+                task(current);
+        };
+
+        // The calling thread is the first worker
+        QThreadPool pool;
+        pool.setMaxThreadCount(int(workerCount));
+        for (size_t i = 1; i < workerCount; ++i)
+            pool.start([&work, i]() { work(i); });
+        work(0);
+        pool.waitForDone();
+
+        m_workers.clear();
+    }
+
+    bool WorkStealingScheduler::pop(size_t worker, size_t &task) {
+        Worker &own = *m_workers[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (own.tasks.empty())
+            return false;
+
+        task = own.tasks.front();
+        own.tasks.pop_front();
+        return true;
+    }
+
+    bool WorkStealingScheduler::steal(size_t worker, size_t &task) {
+        // Nothing is added to the queues once the workers are started, so
+        // a single round over the victims is enough
+        for (size_t i = 1; i < m_workers.size(); ++i) {
+            Worker &victim = *m_workers[(worker + i) % m_workers.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (victim.tasks.empty())
+                continue;
+
+            task = victim.tasks.back();
+            victim.tasks.pop_back();
+            return true;
+        }
+
+        return false;
+    }
+}
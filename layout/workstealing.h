@@ -0,0 +1,62 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace layout {
+    // Runs a fixed set of tasks on a number of workers. Every worker owns a
+    // queue of task indices: it takes tasks from the front of its own queue
+    // and, once the queue is empty, steals from the back of the others.
+    // Tasks are dealt round-robin in index order, so if the indices are
+    // sorted by decreasing cost every worker starts with the most expensive
+    // tasks and the cheap ones are left for balancing.
+    class WorkStealingScheduler {
+    public:
+        WorkStealingScheduler() = default;
+
+        // Runs task(i) for every i in [0, count) on the given number of
+        // threads and blocks until all of them are finished. Does nothing if
+        // the scheduler was cancelled.
+        void run(size_t count, unsigned threadCount,
+                 const std::function<void(size_t)> &task);
+
+        // Tasks that were not started yet are dropped, may be called from
+        // any thread
+        void cancel() { m_cancelled = true; }
+        bool isCancelled() const { return m_cancelled; }
+
+    private:
+        struct Worker {
+            std::mutex mutex;
+            std::deque<size_t> tasks;
+        };
+
+        bool pop(size_t worker, size_t &task);
+        bool steal(size_t worker, size_t &task);
+
+        std::vector<std::unique_ptr<Worker>> m_workers;
+        std::atomic<bool> m_cancelled{false};
+    };
+}
@@ -158,6 +158,31 @@ void CommonGraphicsItemNode::remakePath()
     }
 
     m_path = path;
+    m_outlineWidth = std::numeric_limits<double>::quiet_NaN();
+}
+
+const QPainterPath &CommonGraphicsItemNode::outline() const {
+    // The width and the arrow are public, so they are compared rather than
+    // tracked. NaN does not compare equal, so the outline is remade after
+    // remakePath().
+    if (!(m_outlineWidth == m_width) || m_outlineHasArrow != m_hasArrow) {
+        m_outline = makeOutline();
+        m_outlineWidth = m_width;
+        m_outlineHasArrow = m_hasArrow;
+        m_simplifiedOutlineValid = false;
+    }
+
+    return m_outline;
+}
+
+const QPainterPath &CommonGraphicsItemNode::simplifiedOutline() const {
+    const QPainterPath &path = outline();
+    if (!m_simplifiedOutlineValid) {
+        m_simplifiedOutline = path.simplified();
+        m_simplifiedOutlineValid = true;
+    }
+
+    return m_simplifiedOutline;
 }
 
 double CommonGraphicsItemNode::getNodePathLength()
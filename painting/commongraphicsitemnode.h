@@ -14,6 +14,7 @@
 #include <QStringList>
 #include <algorithm>
 #include <iostream>
+#include <limits>
 #include "../ui/bandagegraphicsview.h"
 #include "graph/assemblygraphlist.h"
 
@@ -35,6 +36,12 @@ public:
     static double distance(QPointF p1, QPointF p2);
     void shiftPoints(QPointF difference);
     virtual void remakePath();
+
+    // Outline of the node (see makeOutline()) and its simplified version for
+    // stroking. Both are made on first use and kept until the path is remade
+    // (i.e. the line points change) or the width or the arrow change.
+    const QPainterPath &outline() const;
+    const QPainterPath &simplifiedOutline() const;
     void setWidth(double width) { m_width = width; }
     void updateGrabIndex(QGraphicsSceneMouseEvent* event);
     QPointF getFirst() const { return m_linePoints.front(); }
@@ -151,8 +158,19 @@ public:
         return {};
     }
 
+protected:
+    // Outline for the current path, width and arrow
+    virtual QPainterPath makeOutline() const { return m_path; }
+
 private:
     void shiftPointSideways(bool left);
+
+    mutable QPainterPath m_outline;
+    mutable QPainterPath m_simplifiedOutline;
+    // Width and arrow the outline was made for, NaN width if there is none
+    mutable double m_outlineWidth = std::numeric_limits<double>::quiet_NaN();
+    mutable bool m_outlineHasArrow = false;
+    mutable bool m_simplifiedOutlineValid = false;
 };
 
 #endif //COMMONGRAPHICSITEMNODE_H
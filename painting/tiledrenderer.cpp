@@ -0,0 +1,305 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "tiledrenderer.h"
+
+#include "graph/graphicsitembatch.h"
+#include "graph/graphicsitemnode.h"
+#include "program/settings.h"
+
+#include <QDir>
+#include <QFile>
+#include <QGraphicsItem>
+#include <QGraphicsScene>
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+namespace {
+    // Just enough of a PNG encoder to write 8 bit RGB images a row at a
+    // time, without holding the image in memory
+    class PngWriter {
+    public:
+        ~PngWriter() {
+            if (m_deflating)
+                deflateEnd(&m_stream);
+        }
+
+        bool open(const QString &filename, int width, int height) {
+            m_file.setFileName(filename);
+            if (!m_file.open(QIODevice::WriteOnly) || deflateInit(&m_stream, Z_DEFAULT_COMPRESSION) != Z_OK)
+                return false;
+            m_deflating = true;
+            m_width = width;
+            m_row.resize(1 + 3 * size_t(width));
+            m_buffer.resize(1 << 16);
+            m_stream.next_out = m_buffer.data();
+            m_stream.avail_out = uInt(m_buffer.size());
+
+            static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+            write(signature, sizeof(signature));
+
+            uint8_t header[13] = {};
+            putBigEndian(header, uint32_t(width));
+            putBigEndian(header + 4, uint32_t(height));
+            header[8] = 8; // bits per channel
+            header[9] = 2; // RGB
+            writeChunk("IHDR", header, sizeof(header));
+            return m_ok;
+        }
+
+        // Rows are stored with the Sub filter, which turns the long runs of
+        // background into zeroes
+        void writeRow(const QRgb *pixels) {
+            uint8_t *row = m_row.data();
+            row[0] = 1;
+            uint8_t previous[3] = {};
+            for (int x = 0; x < m_width; ++x) {
+                uint8_t rgb[3] = { uint8_t(qRed(pixels[x])), uint8_t(qGreen(pixels[x])), uint8_t(qBlue(pixels[x])) };
+                for (int c = 0; c < 3; ++c) {
+                    row[1 + 3 * x + c] = uint8_t(rgb[c] - previous[c]);
+                    previous[c] = rgb[c];
+                }
+            }
+            compress(m_row.data(), m_row.size(), Z_NO_FLUSH);
+        }
+
+        bool close() {
+            compress(nullptr, 0, Z_FINISH);
+            writeChunk("IEND", nullptr, 0);
+            m_file.close();
+            return m_ok && m_file.error() == QFileDevice::NoError;
+        }
+
+    private:
+        static void putBigEndian(uint8_t *out, uint32_t value) {
+            out[0] = uint8_t(value >> 24);
+            out[1] = uint8_t(value >> 16);
+            out[2] = uint8_t(value >> 8);
+            out[3] = uint8_t(value);
+        }
+
+        void write(const uint8_t *data, size_t size) {
+            m_ok = m_ok && m_file.write(reinterpret_cast<const char *>(data), qint64(size)) == qint64(size);
+        }
+
+        void writeChunk(const char *type, const uint8_t *data, size_t size) {
+            uint8_t length[4], checksum[4];
+            putBigEndian(length, uint32_t(size));
+            uLong crc = crc32(0, reinterpret_cast<const Bytef *>(type), 4);
+            if (size > 0)
+                crc = crc32(crc, data, uInt(size));
+            putBigEndian(checksum, uint32_t(crc));
+
+            write(length, 4);
+            write(reinterpret_cast<const uint8_t *>(type), 4);
+            if (size > 0)
+                write(data, size);
+            write(checksum, 4);
+        }
+
+        // Deflates into m_buffer, which goes out as an IDAT chunk whenever
+        // it is full, and once more at the end
+        void compress(const uint8_t *data, size_t size, int flush) {
+            m_stream.next_in = const_cast<Bytef *>(data);
+            m_stream.avail_in = uInt(size);
+            while (true) {
+                int result = deflate(&m_stream, flush);
+                if (result == Z_STREAM_ERROR) {
+                    m_ok = false;
+                    return;
+                }
+                if (m_stream.avail_out == 0) {
+                    writeChunk("IDAT", m_buffer.data(), m_buffer.size());
+                    m_stream.next_out = m_buffer.data();
+                    m_stream.avail_out = uInt(m_buffer.size());
+                    continue;
+                }
+                if (flush != Z_FINISH || result == Z_STREAM_END)
+                    break;
+            }
+
+            if (flush == Z_FINISH && m_stream.avail_out < m_buffer.size())
+                writeChunk("IDAT", m_buffer.data(), m_buffer.size() - m_stream.avail_out);
+        }
+
+        QFile m_file;
+        z_stream m_stream{};
+        bool m_deflating = false;
+        bool m_ok = true;
+        int m_width = 0;
+        std::vector<uint8_t> m_row;
+        std::vector<uint8_t> m_buffer;
+    };
+}
+
+TiledRenderer::TiledRenderer(QGraphicsScene &scene, QSize imageSize)
+        : m_sceneRect(scene.sceneRect()), m_imageSize(imageSize) {
+    // Centred and scaled to fit, as in QGraphicsScene::render()
+    double scale = 1.0;
+    if (m_sceneRect.width() > 0.0 && m_sceneRect.height() > 0.0)
+        scale = std::min(imageSize.width() / m_sceneRect.width(), imageSize.height() / m_sceneRect.height());
+    m_sceneToImage = QTransform::fromTranslate(-m_sceneRect.left(), -m_sceneRect.top()) *
+                     QTransform::fromScale(scale, scale) *
+                     QTransform::fromTranslate((imageSize.width() - m_sceneRect.width() * scale) / 2.0,
+                                               (imageSize.height() - m_sceneRect.height() * scale) / 2.0);
+
+    // Scene transforms are cached on first use as well, so everything the
+    // tiles need is taken from the items here
+    std::vector<QRectF> bounds;
+    for (QGraphicsItem *item : scene.items(Qt::AscendingOrder)) {
+        if (!item->isVisible() || (item->flags() & QGraphicsItem::ItemHasNoContents) ||
+            item->effectiveOpacity() <= 0.0)
+            continue;
+
+        m_items.push_back({ item, item->sceneTransform(), item->boundingRect(), item->effectiveOpacity() });
+        bounds.push_back(item->sceneBoundingRect());
+    }
+    m_index = RTree(bounds);
+
+    prepareOutlines(m_sceneToImage);
+}
+
+void TiledRenderer::prepareOutlines(const QTransform &sceneToImage) const {
+    for (const Item &item : m_items) {
+        double lod = QStyleOptionGraphicsItem::levelOfDetailFromTransform(item.sceneTransform * sceneToImage);
+        if (auto *node = dynamic_cast<GraphicsItemNode *>(item.item))
+            node->prepareOutlines(lod);
+        else if (auto *batch = dynamic_cast<GraphicsItemBatch *>(item.item))
+            batch->prepareOutlines(lod);
+    }
+}
+
+QImage TiledRenderer::render(const QRect &target) const {
+    return render(m_sceneToImage, target);
+}
+
+QImage TiledRenderer::render(const QTransform &sceneToImage, const QRect &target) const {
+    QImage image(target.size(), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::white);
+
+    QTransform sceneToTile = sceneToImage * QTransform::fromTranslate(-target.left(), -target.top());
+    QRectF area = sceneToTile.inverted().mapRect(QRectF(image.rect()));
+    std::vector<uint32_t> visible;
+    m_index.query(area, [&visible](uint32_t id) { visible.push_back(id); });
+    std::sort(visible.begin(), visible.end());
+
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setRenderHint(QPainter::TextAntialiasing);
+    for (uint32_t id : visible) {
+        const Item &item = m_items[id];
+        QStyleOptionGraphicsItem option;
+        option.state = item.item->isSelected() ? QStyle::State_Selected : QStyle::State_None;
+        option.rect = item.bounds.toAlignedRect();
+        option.exposedRect = item.sceneTransform.inverted().mapRect(area);
+
+        painter.save();
+        painter.setTransform(item.sceneTransform * sceneToTile);
+        painter.setOpacity(item.opacity);
+        item.item->paint(&painter, &option, nullptr);
+        painter.restore();
+    }
+
+    return image;
+}
+
+bool TiledRenderer::savePng(const QString &filename) const {
+    PngWriter png;
+    if (!png.open(filename, m_imageSize.width(), m_imageSize.height()))
+        return false;
+
+    struct Tile {
+        QRect rect;
+        QImage image;
+    };
+    // The whole band is held until its rows are written
+    size_t rowBytes = size_t(m_imageSize.width()) * sizeof(QRgb);
+    int bandHeight = int(std::clamp(BandBytes / rowBytes, size_t(1), size_t(TileSize)));
+    QThreadPool pool;
+    pool.setMaxThreadCount(int(g_settings->threadCount()));
+    std::vector<Tile> band;
+    std::vector<QRgb> row(m_imageSize.width());
+    for (int top = 0; top < m_imageSize.height(); top += bandHeight) {
+        int height = std::min(bandHeight, m_imageSize.height() - top);
+        band.clear();
+        for (int left = 0; left < m_imageSize.width(); left += TileSize)
+            band.push_back({ QRect(left, top, std::min(TileSize, m_imageSize.width() - left), height), QImage() });
+        QtConcurrent::blockingMap(&pool, band, [this](Tile &tile) { tile.image = render(tile.rect); });
+
+        for (int y = 0; y < height; ++y) {
+            for (const Tile &tile : band)
+                std::memcpy(row.data() + tile.rect.left(), tile.image.constScanLine(y),
+                            size_t(tile.rect.width()) * sizeof(QRgb));
+            png.writeRow(row.data());
+        }
+    }
+
+    return png.close();
+}
+
+bool TiledRenderer::saveTilePyramid(const QString &directory) const {
+    double side = std::max({ m_sceneRect.width(), m_sceneRect.height(), 1e-9 });
+    int maxZoom = 0;
+    while ((TileSize << maxZoom) < std::max(m_imageSize.width(), m_imageSize.height()) && maxZoom < 20)
+        ++maxZoom;
+
+    auto sceneToImage = [&](int zoom) {
+        double scale = double(TileSize << zoom) / side;
+        return QTransform::fromTranslate(-m_sceneRect.left(), -m_sceneRect.top()) * QTransform::fromScale(scale, scale);
+    };
+    // Deeper levels show more detail, so their outlines cover the others
+    prepareOutlines(sceneToImage(maxZoom));
+
+    QDir dir(directory);
+    QThreadPool pool;
+    pool.setMaxThreadCount(int(g_settings->threadCount()));
+    std::vector<QPoint> tiles;
+    for (int zoom = 0; zoom <= maxZoom; ++zoom) {
+        QTransform transform = sceneToImage(zoom);
+        QRectF extent = transform.mapRect(m_sceneRect);
+        int columns = std::max(1, int(std::ceil(extent.width() / TileSize)));
+        int rows = std::max(1, int(std::ceil(extent.height() / TileSize)));
+
+        tiles.clear();
+        for (int x = 0; x < columns; ++x) {
+            if (!dir.mkpath(QString("%1/%2").arg(zoom).arg(x)))
+                return false;
+            for (int y = 0; y < rows; ++y)
+                tiles.emplace_back(x, y);
+        }
+
+        std::atomic<bool> success = true;
+        QtConcurrent::blockingMap(&pool, tiles, [&](const QPoint &tile) {
+            QImage image = render(transform, QRect(tile * TileSize, QSize(TileSize, TileSize)));
+            if (!image.save(dir.filePath(QString("%1/%2/%3.png").arg(zoom).arg(tile.x()).arg(tile.y()))))
+                success = false;
+        });
+        if (!success)
+            return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,81 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "graph/rtree.h"
+
+#include <QImage>
+#include <QRectF>
+#include <QSize>
+#include <QString>
+#include <QTransform>
+
+#include <vector>
+
+class QGraphicsItem;
+class QGraphicsScene;
+
+// Renders a scene into images of any size, one tile at a time on
+// g_settings->threadCount() threads, so that neither the image nor a single
+// QPainter has to cover it all. The scene rectangle is fitted into the image
+// like QGraphicsScene::render() does.
+//
+// The items are collected and indexed in an R-tree up front, and the scene
+// must not change while the renderer is alive: tiles paint the items
+// directly, bypassing the scene, which is not safe to use from several
+// threads.
+class TiledRenderer {
+public:
+    static constexpr int TileSize = 256;
+    // Memory for a row of tiles in savePng(): very wide images get flatter
+    // tiles, 64 pixels high at the 2^20 pixel width limit of the command line
+    static constexpr size_t BandBytes = size_t(256) << 20;
+
+    TiledRenderer(QGraphicsScene &scene, QSize imageSize);
+
+    [[nodiscard]] QSize imageSize() const { return m_imageSize; }
+
+    // The target rectangle of the image. Can be called from several threads
+    [[nodiscard]] QImage render(const QRect &target) const;
+
+    // Streams the image to a PNG file a row of tiles at a time, see BandBytes
+    bool savePng(const QString &filename) const;
+    // Writes TileSize PNG tiles as directory/z/x/y.png. The scene fits into
+    // the single tile of zoom level 0, and each level doubles the resolution
+    // up to the first one as large as the image.
+    bool saveTilePyramid(const QString &directory) const;
+
+private:
+    struct Item {
+        QGraphicsItem *item;
+        QTransform sceneTransform;
+        QRectF bounds;
+        double opacity;
+    };
+
+    QImage render(const QTransform &sceneToImage, const QRect &target) const;
+    // See GraphicsItemNode::prepareOutlines()
+    void prepareOutlines(const QTransform &sceneToImage) const;
+
+    QRectF m_sceneRect;
+    QSize m_imageSize;
+    QTransform m_sceneToImage;
+    // In stacking order, bottom first
+    std::vector<Item> m_items;
+    RTree m_index;
+};
@@ -36,11 +36,14 @@
 #include "command_line/image.h"
 #include "command_line/querypaths.h"
 #include "command_line/reduce.h"
+#include "command_line/convert.h"
+#include "command_line/compact.h"
 #include "command_line/settings.h"
 #include "command_line/commoncommandlinefunctions.h"
 #include <CLI/CLI.hpp>
 
 #include <QApplication>
+#include <QStandardPaths>
 #include <QString>
 #include <QTextStream>
 #include <variant>
@@ -58,6 +61,8 @@ using SubCmd = std::variant<std::monostate,
                             ImageCmd,
                             InfoCmd,
                             ReduceCmd,
+                            ConvertCmd,
+                            CompactCmd,
                             QueryPathsCmd,
                             LayoutCmd>;
 
@@ -89,6 +94,14 @@ static SubCmd parseCmdLine(CLI::App &app, int argc, char *argv[]) {
     ReduceCmd reduceCmd;
     auto *reduce = addReduceSubcommand(app, reduceCmd);
 
+    // "BandageNG convert"
+    ConvertCmd convertCmd;
+    auto *convert = addConvertSubcommand(app, convertCmd);
+
+    // "BandageNG compact"
+    CompactCmd compactCmd;
+    auto *compact = addCompactSubcommand(app, compactCmd);
+
     // "BandageNG querypaths"
     QueryPathsCmd qpCmd;
     auto *qp = addQueryPathsSubcommand(app, qpCmd);
@@ -113,6 +126,10 @@ static SubCmd parseCmdLine(CLI::App &app, int argc, char *argv[]) {
     } else if (app.got_subcommand(reduce)) {
         g_memory->commandLineCommand = BANDAGE_REDUCE; // FIXME: not needed
         subcmd = reduceCmd;
+    } else if (app.got_subcommand(convert)) {
+        subcmd = convertCmd;
+    } else if (app.got_subcommand(compact)) {
+        subcmd = compactCmd;
     } else if (app.got_subcommand(qp)) {
         g_memory->commandLineCommand = BANDAGE_QUERY_PATHS; // FIXME: not needed
         subcmd = qpCmd;
@@ -180,6 +197,12 @@ int main(int argc, char *argv[]) {
     app->setApplicationName("Bandage-NG");
     app->setApplicationVersion(APP_VERSION);
 
+    // The GUI caches layouts by default, the command line only if asked to
+    if (g_settings->layoutCacheDir.isEmpty() &&
+        (std::holds_alternative<std::monostate>(cmd) || std::holds_alternative<LoadCmd>(cmd)))
+        g_settings->layoutCacheDir =
+                QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/layouts";
+
     return std::visit([&](const auto &command) {
         using T = std::decay_t<decltype(command)>;
         if constexpr (std::is_same_v<T, LoadCmd>) {
@@ -190,6 +213,10 @@ int main(int argc, char *argv[]) {
             return handleInfoCmd(app.get(), cli, command);
         } else  if constexpr (std::is_same_v<T, ReduceCmd>) {
             return handleReduceCmd(app.get(), cli, command);
+        } else  if constexpr (std::is_same_v<T, ConvertCmd>) {
+            return handleConvertCmd(app.get(), cli, command);
+        } else  if constexpr (std::is_same_v<T, CompactCmd>) {
+            return handleCompactCmd(app.get(), cli, command);
         } else  if constexpr (std::is_same_v<T, QueryPathsCmd>) {
             return handleQueryPathsCmd(app.get(), cli, command);
         } else  if constexpr (std::is_same_v<T, LayoutCmd>) {
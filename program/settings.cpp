@@ -19,6 +19,10 @@
 #include "settings.h"
 #include "graph/nodecolorer.h"
 #include <QDir>
+#include <QThread>
+
+#include <algorithm>
+#include <limits>
 
 Settings::Settings()
 {
@@ -31,11 +35,21 @@ Settings::Settings()
     minTotalGraphLength = 500.0;
     graphLayoutQuality = IntSetting(2, 0, 4);
     linearLayout = false;
+    multilevelLayout = false;
+    incrementalLayout = false;
+    graphLayoutEngine = FMMM_LAYOUT;
     minimumNodeLength = FloatSetting(5.0, 1.0, 100.0);
     edgeLength = FloatSetting(5.0, 0.1, 100.0);
     doubleModeNodeSeparation = FloatSetting(2.0, 0.0, 100.0);
     nodeSegmentLength = FloatSetting(20.0, 1.0, 1000.0);
     componentSeparation = FloatSetting(50.0, 0, 1000.0);
+    layoutSeed = IntSetting(0, 0, std::numeric_limits<int>::max());
+    layoutCacheSize = IntSetting(1024, 1, 1 << 20);
+    hierarchicalLayoutNodes = IntSetting(1000000, 0, std::numeric_limits<int>::max());
+
+    threads = IntSetting(0, 0, 256);
+    lazySequences = false;
+    sequenceCacheSize = IntSetting(256, 1, 1 << 20);
 
     averageNodeWidth = FloatSetting(10.0, 0.5, 1000.0);
     depthEffectOnWidth = FloatSetting(0.5, 0.0, 1.0);
@@ -43,6 +57,9 @@ Settings::Settings()
 
     edgeWidth = FloatSetting(1.5, 0.1, 100);
     outlineThickness = FloatSetting(0.0, 0.0, 100.0);
+    nodeDetailPixels = FloatSetting(2.0, 0.0, 100.0);
+    edgeDetailPixels = FloatSetting(4.0, 0.0, 100.0);
+    batchedSceneNodes = IntSetting(500000, 0, std::numeric_limits<int>::max());
     selectionThickness = 1.0;
     arrowheadsInSingleMode = false;
     textOutlineThickness = FloatSetting(1.5, 0.0, 10.0);
@@ -165,3 +182,9 @@ void Settings::initializeColorer(FeatureNodeColorScheme scheme) {
     featureNodeColorer = IFeatureNodeColorer::create(scheme);
 }
 
+unsigned Settings::threadCount() const {
+    if (threads > 0)
+        return unsigned(threads.val);
+
+    return unsigned(std::max(QThread::idealThreadCount(), 1));
+}
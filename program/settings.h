@@ -86,6 +86,7 @@ using AnnotationSettings = std::unordered_map<AnnotationGroupId, AnnotationSetti
 
 enum NodeLengthMode {AUTO_NODE_LENGTH, MANUAL_NODE_LENGTH};
 enum NodeDragging {ONE_PIECE, NEARBY_PIECES, ALL_PIECES, NO_DRAGGING};
+enum GraphLayoutEngine {FMMM_LAYOUT, FAST_MULTIPOLE_LAYOUT};
 
 class Settings
 {
@@ -101,11 +102,35 @@ public:
     double minTotalGraphLength;
     IntSetting graphLayoutQuality;
     bool linearLayout;
+    // Lay out collapsed non-branching paths first, then expand them
+    bool multilevelLayout;
+    // Keep the positions of already drawn nodes when a redraw adds or removes
+    // nodes and the layout settings are unchanged
+    bool incrementalLayout;
+    GraphLayoutEngine graphLayoutEngine;
     FloatSetting minimumNodeLength;
     FloatSetting edgeLength;
     FloatSetting doubleModeNodeSeparation;
     FloatSetting nodeSegmentLength;
     FloatSetting componentSeparation;
+    // Seed of the graph layout, the same seed gives the same layout
+    IntSetting layoutSeed;
+    // Directory of the on-disk layout cache (empty means no cache) and its
+    // size in megabytes
+    QString layoutCacheDir;
+    IntSetting layoutCacheSize;
+    // Components with at least this many layout nodes (node segments) are
+    // laid out in two levels: communities first, then the nodes inside them
+    // (0 disables it)
+    IntSetting hierarchicalLayoutNodes;
+
+    // Number of worker threads used by parallel stages (0 means all cores)
+    IntSetting threads;
+    [[nodiscard]] unsigned threadCount() const;
+    // Do not keep sequences in memory, read them from the input on demand
+    bool lazySequences;
+    // Memory budget for lazily loaded sequences, in megabytes
+    IntSetting sequenceCacheSize;
 
     FloatSetting averageNodeWidth;
     FloatSetting depthEffectOnWidth;
@@ -113,6 +138,14 @@ public:
 
     FloatSetting edgeWidth;
     FloatSetting outlineThickness;
+    // Level of detail: nodes narrower than this many pixels are drawn as plain
+    // lines without outlines, arrowheads or annotation detail, edges spanning
+    // less than edgeDetailPixels as polylines. 0 always draws full detail
+    FloatSetting nodeDetailPixels;
+    FloatSetting edgeDetailPixels;
+    // Graphs with at least this many drawn nodes are drawn by a single batch
+    // item instead of an item per node and edge (0 disables)
+    IntSetting batchedSceneNodes;
     double selectionThickness;
     bool arrowheadsInSingleMode;
     FloatSetting textOutlineThickness;
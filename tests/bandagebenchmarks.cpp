@@ -0,0 +1,654 @@
+// Copyright 2023 Anton Korobeynikov
+
+// This file is part of Bandage-NG
+
+// Bandage-NG is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// Bandage-NG is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with Bandage.  If not, see <http://www.gnu.org/licenses/>.
+
+// Throughput benchmarks. These are not part of the regular test suite, run
+// BandageBenchmarks explicitly. The size of the synthetic inputs could be
+// controlled via BANDAGE_BENCH_SEGMENTS environment variable.
+
+#include "io/linereader.h"
+#include "io/gfa.h"
+
+#include "graph/assemblygraph.h"
+#include "graph/assemblygraphlist.h"
+#include "graph/debruijnnode.h"
+#include "graph/debruijnedge.h"
+#include "graph/nodestore.h"
+#include "graph/adjacency.h"
+#include "graph/graphscope.h"
+#include "graph/annotationsmanager.h"
+
+#include "layout/graphlayout.h"
+#include "layout/graphlayoutworker.h"
+
+#include "ui/bandagegraphicsscene.h"
+
+#include "program/globals.h"
+#include "program/memory.h"
+#include "program/settings.h"
+
+#include <QtTest/QtTest>
+#include <QTemporaryDir>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QLineF>
+#include <QPainter>
+
+#include <algorithm>
+#include <random>
+#include <memory>
+#include <deque>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+
+#include <zlib.h>
+
+// Per-character line reader that was used by the GFA loader before
+// io::LineReader. Kept here as a baseline.
+static ssize_t gzgetdelim(char **buf, size_t *bufsiz, int delimiter, gzFile fp) {
+    char *ptr, *eptr;
+
+    if (*buf == NULL || *bufsiz == 0) {
+        *bufsiz = BUFSIZ;
+        if ((*buf = (char*)malloc(*bufsiz)) == NULL)
+            return -1;
+    }
+
+    for (ptr = *buf, eptr = *buf + *bufsiz;;) {
+        char c = gzgetc(fp);
+        if (c == -1) {
+            if (gzeof(fp)) {
+                ssize_t diff = (ssize_t) (ptr - *buf);
+                if (diff != 0) {
+                    *ptr = '\0';
+                    return diff;
+                }
+            }
+            return -1;
+        }
+        *ptr++ = c;
+        if (c == delimiter) {
+            *ptr = '\0';
+            return ptr - *buf;
+        }
+        if (ptr + 2 >= eptr) {
+            char *nbuf;
+            size_t nbufsiz = *bufsiz * 2;
+            ssize_t d = ptr - *buf;
+            if ((nbuf = (char*)realloc(*buf, nbufsiz)) == NULL)
+                return -1;
+
+            *buf = nbuf;
+            *bufsiz = nbufsiz;
+            eptr = nbuf + nbufsiz;
+            ptr = nbuf + d;
+        }
+    }
+}
+
+class BandageBenchmarks : public QObject
+{
+    Q_OBJECT
+
+    QTemporaryDir m_tmpDir;
+    QString m_plainGfa, m_gzipGfa, m_fragmentedGfa, m_giantGfa, m_chainsGfa;
+    qint64 m_gfaSize = 0;
+    std::unique_ptr<AssemblyGraph> m_graph;
+
+    static size_t segmentCount() {
+        if (const char *env = std::getenv("BANDAGE_BENCH_SEGMENTS"))
+            return std::strtoull(env, nullptr, 10);
+        return 200000;
+    }
+
+    // Generates a GFA file of a shape typical for assemblers output: S-lines
+    // with sequence and depth tags, followed by L-lines
+    void writeSyntheticGfa(const QString &fileName, const char *mode) const {
+        std::unique_ptr<std::remove_pointer<gzFile>::type, decltype(&gzclose)>
+                fp(gzopen(fileName.toStdString().c_str(), mode), gzclose);
+        QVERIFY(fp);
+
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<int> nucl(0, 3), len(100, 2000);
+        std::string seq;
+        size_t segments = segmentCount();
+        for (size_t i = 0; i < segments; ++i) {
+            seq.resize(len(rng));
+            for (auto &c : seq)
+                c = "ACGT"[nucl(rng)];
+            gzprintf(fp.get(), "S\t%zu\t%s\tLN:i:%zu\tdp:f:%.3f\n", i, seq.c_str(), seq.size(), 10.0 + i % 7);
+        }
+        std::uniform_int_distribution<size_t> node(0, segments - 1);
+        for (size_t i = 0; i < 2 * segments; ++i)
+            gzprintf(fp.get(), "L\t%zu\t%c\t%zu\t%c\t55M\n",
+                     node(rng), "+-"[i & 1], node(rng), "+-"[(i >> 1) & 1]);
+    }
+
+    // Generates a GFA file of a fragmented assembly: lots of components of
+    // 1-3 nodes (mostly single nodes and simple chains) and a few small
+    // tangles, as short-read assemblers produce
+    void writeFragmentedGfa(const QString &fileName) const {
+        std::unique_ptr<std::remove_pointer<gzFile>::type, decltype(&gzclose)>
+                fp(gzopen(fileName.toStdString().c_str(), "wT"), gzclose);
+        QVERIFY(fp);
+
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<int> nucl(0, 3), len(100, 2000), kind(0, 9);
+        std::string seq;
+        size_t segment = 0;
+        auto addSegment = [&]() {
+            seq.resize(len(rng));
+            for (auto &c : seq)
+                c = "ACGT"[nucl(rng)];
+            gzprintf(fp.get(), "S\t%zu\t%s\tdp:f:%.3f\n", segment, seq.c_str(), 10.0 + segment % 7);
+            return segment++;
+        };
+
+        size_t components = segmentCount() / 10;
+        for (size_t i = 0; i < components; ++i) {
+            int k = kind(rng);
+            if (k < 6) {
+                addSegment();
+            } else if (k < 9) {
+                size_t prev = addSegment();
+                for (int j = 6; j <= k && j < 8; ++j) {
+                    size_t next = addSegment();
+                    gzprintf(fp.get(), "L\t%zu\t+\t%zu\t+\t55M\n", prev, next);
+                    prev = next;
+                }
+            } else {
+                size_t first = segment;
+                for (int j = 0; j < 6; ++j)
+                    addSegment();
+                std::uniform_int_distribution<size_t> node(first, segment - 1);
+                for (int j = 0; j < 9; ++j)
+                    gzprintf(fp.get(), "L\t%zu\t%c\t%zu\t%c\t55M\n",
+                             node(rng), "+-"[j & 1], node(rng), "+-"[(j >> 1) & 1]);
+            }
+        }
+    }
+
+    // Generates a GFA file of a single giant component: long chains of
+    // segments tangled by a few random links, as metagenome assemblies are
+    void writeGiantComponentGfa(const QString &fileName) const {
+        std::unique_ptr<std::remove_pointer<gzFile>::type, decltype(&gzclose)>
+                fp(gzopen(fileName.toStdString().c_str(), "wT"), gzclose);
+        QVERIFY(fp);
+
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<int> nucl(0, 3), len(100, 5000);
+        std::string seq;
+        size_t segments = segmentCount() / 40;
+        for (size_t i = 0; i < segments; ++i) {
+            seq.resize(len(rng));
+            for (auto &c : seq)
+                c = "ACGT"[nucl(rng)];
+            gzprintf(fp.get(), "S\t%zu\t%s\tdp:f:%.3f\n", i, seq.c_str(), 10.0 + i % 7);
+        }
+        for (size_t i = 1; i < segments; ++i)
+            gzprintf(fp.get(), "L\t%zu\t+\t%zu\t+\t55M\n", i - 1, i);
+        std::uniform_int_distribution<size_t> node(0, segments - 1);
+        for (size_t i = 0; i < segments / 10; ++i)
+            gzprintf(fp.get(), "L\t%zu\t%c\t%zu\t%c\t55M\n",
+                     node(rng), "+-"[i & 1], node(rng), "+-"[(i >> 1) & 1]);
+    }
+
+    // Generates a GFA file of short chains of 10 segments each, to be drawn
+    // on a grid without a layout
+    void writeChainsGfa(const QString &fileName) const {
+        std::unique_ptr<std::remove_pointer<gzFile>::type, decltype(&gzclose)>
+                fp(gzopen(fileName.toStdString().c_str(), "wT"), gzclose);
+        QVERIFY(fp);
+
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<int> nucl(0, 3), len(100, 2000);
+        std::string seq;
+        size_t segments = segmentCount();
+        for (size_t i = 0; i < segments; ++i) {
+            seq.resize(len(rng));
+            for (auto &c : seq)
+                c = "ACGT"[nucl(rng)];
+            gzprintf(fp.get(), "S\t%zu\t%s\tdp:f:%.3f\n", i, seq.c_str(), 10.0 + i % 7);
+        }
+        for (size_t i = 1; i < segments; ++i) {
+            if (i % 10 != 0)
+                gzprintf(fp.get(), "L\t%zu\t+\t%zu\t+\t55M\n", i - 1, i);
+        }
+    }
+
+    // Mean squared relative error of the drawn edge and node segment lengths
+    static double layoutStress(const AssemblyGraph &graph, const GraphLayout &layout) {
+        double lengthPerMegabase = g_settings->nodeLengthMode == AUTO_NODE_LENGTH ?
+                                   g_settings->autoNodeLengthPerMegabase :
+                                   double(g_settings->manualNodeLengthPerMegabase);
+        double stress = 0;
+        size_t count = 0;
+        auto add = [&](QPointF from, QPointF to, double desired) {
+            double error = (QLineF(from, to).length() - desired) / desired;
+            stress += error * error;
+            ++count;
+        };
+
+        for (const auto &entry : layout) {
+            const auto &segments = entry.second;
+            double nodeLength = std::max(lengthPerMegabase * entry.first->getLength() / 1000000.0,
+                                         double(g_settings->minimumNodeLength));
+            for (size_t i = 1; i < segments.size(); ++i)
+                add(segments[i - 1], segments[i], nodeLength / double(segments.size() - 1));
+        }
+
+        for (const auto *node : graph.m_deBruijnGraphNodes) {
+            for (const auto *edge : node->edges()) {
+                const auto *from = edge->getStartingNode(), *to = edge->getEndingNode();
+                if (from != node || from == to || !layout.contains(from) || !layout.contains(to))
+                    continue;
+                add(layout.segments(from).back(), layout.segments(to).front(), g_settings->edgeLength);
+            }
+        }
+
+        return count > 0 ? stress / double(count) : 0;
+    }
+
+    // Synthetic graph, loaded on first use
+    AssemblyGraph &syntheticGraph() {
+        if (!m_graph) {
+            m_graph = std::make_unique<AssemblyGraph>();
+            if (!m_graph->loadGraphFromFile(m_plainGfa))
+                qFatal("Cannot load synthetic graph");
+        }
+        return *m_graph;
+    }
+
+private slots:
+    void initTestCase() {
+        g_settings.reset(new Settings());
+        g_memory.reset(new Memory());
+        g_annotationsManager = std::make_shared<AnnotationsManager>();
+
+        m_plainGfa = m_tmpDir.filePath("bench.gfa");
+        m_gzipGfa = m_tmpDir.filePath("bench.gfa.gz");
+        writeSyntheticGfa(m_plainGfa, "wT");
+        writeSyntheticGfa(m_gzipGfa, "w6");
+        m_fragmentedGfa = m_tmpDir.filePath("fragmented.gfa");
+        writeFragmentedGfa(m_fragmentedGfa);
+        m_giantGfa = m_tmpDir.filePath("giant.gfa");
+        writeGiantComponentGfa(m_giantGfa);
+        m_chainsGfa = m_tmpDir.filePath("chains.gfa");
+        writeChainsGfa(m_chainsGfa);
+        m_gfaSize = QFileInfo(m_plainGfa).size();
+        qInfo("Synthetic GFA: %lld bytes uncompressed", m_gfaSize);
+    }
+
+    void gzgetlineThroughput_data() {
+        QTest::addColumn<QString>("fileName");
+        QTest::newRow("plain") << m_plainGfa;
+        QTest::newRow("gzip") << m_gzipGfa;
+    }
+
+    void gzgetlineThroughput() {
+        QFETCH(QString, fileName);
+        size_t lines = 0;
+        QBENCHMARK {
+            std::unique_ptr<std::remove_pointer<gzFile>::type, decltype(&gzclose)>
+                    fp(gzopen(fileName.toStdString().c_str(), "r"), gzclose);
+            char *line = nullptr;
+            size_t len = 0;
+            lines = 0;
+            while (gzgetdelim(&line, &len, '\n', fp.get()) != -1)
+                lines += 1;
+            free(line);
+        }
+        QCOMPARE(lines, 3 * segmentCount());
+    }
+
+    void lineReaderThroughput_data() {
+        gzgetlineThroughput_data();
+    }
+
+    void lineReaderThroughput() {
+        QFETCH(QString, fileName);
+        size_t lines = 0;
+        QBENCHMARK {
+            io::LineReader reader(fileName.toStdString());
+            std::string_view line;
+            lines = 0;
+            while (reader.readLine(line))
+                lines += 1;
+        }
+        QCOMPARE(lines, 3 * segmentCount());
+    }
+
+    void gfaParse_data() {
+        QTest::addColumn<QString>("fileName");
+        QTest::addColumn<bool>("generic");
+        const std::pair<const char*, QString> inputs[] = {
+            { "test.gfa", QFINDTESTDATA("inputs/test.gfa") },
+            { "test_gfa12.gfa.gz", QFINDTESTDATA("inputs/test_gfa12.gfa.gz") },
+            { "test_plasmids.gfa", QFINDTESTDATA("inputs/test_plasmids.gfa") },
+            { "synthetic", m_plainGfa }
+        };
+        for (const auto &[name, fileName] : inputs) {
+            QTest::addRow("%s/fast", name) << fileName << false;
+            QTest::addRow("%s/generic", name) << fileName << true;
+        }
+    }
+
+    // Records parsing throughput. The input is parsed from memory, so only
+    // the parser is measured.
+    void gfaParse() {
+        QFETCH(QString, fileName);
+        QFETCH(bool, generic);
+
+        std::vector<std::string> lines;
+        io::LineReader reader(fileName.toStdString());
+        QVERIFY(reader.isOpen());
+        std::string_view line;
+        while (reader.readLine(line))
+            lines.emplace_back(line);
+
+        auto parse = generic ? gfa::parseRecordGeneric : gfa::parseRecord;
+        size_t records = 0, iterations = 0;
+        qint64 elapsed = 0;
+        QElapsedTimer timer;
+        QBENCHMARK {
+            timer.start();
+            records = 0;
+            for (const auto &l : lines)
+                records += parse(l.data(), l.size()).has_value();
+            elapsed += timer.nsecsElapsed();
+            iterations += 1;
+        }
+        qInfo("%zu records, %.0f records/sec",
+              records, double(records) * double(iterations) * 1e9 / double(std::max<qint64>(elapsed, 1)));
+    }
+
+    // Memory per node the node store index adds on top of the node objects
+    // (the latter is a lower bound: allocator overhead and the name trie are
+    // not accounted for), and the time to build it
+    void nodeStoreOverhead() {
+        AssemblyGraph &graph = syntheticGraph();
+
+        size_t objects = 0;
+        for (const auto *node : graph.m_deBruijnGraphNodes)
+            objects += sizeof(DeBruijnNode) + size_t(node->getName().capacity()) * sizeof(QChar);
+
+        std::unique_ptr<graph::NodeStore> store;
+        QBENCHMARK {
+            store = std::make_unique<graph::NodeStore>(graph);
+        }
+
+        double nodes = double(graph.m_deBruijnGraphNodes.size());
+        qInfo("%.0f nodes: >= %.1f bytes/node in DeBruijnNode objects, plus %.1f bytes/node for the node store",
+              nodes, double(objects) / nodes, double(store->memoryUsage()) / nodes);
+    }
+
+    void nodeScan_data() {
+        QTest::addColumn<bool>("store");
+        QTest::newRow("nodes") << false;
+        QTest::newRow("store") << true;
+    }
+
+    // Whole-graph attribute scan: trie of node objects vs contiguous arrays
+    void nodeScan() {
+        QFETCH(bool, store);
+        AssemblyGraph &graph = syntheticGraph();
+        auto snapshot = graph.nodeStore();
+        const graph::NodeStore &nodes = *snapshot;
+
+        double weighted = 0;
+        QBENCHMARK {
+            weighted = 0;
+            if (store) {
+                for (graph::NodeStore::Id id = 0; id < nodes.size(); ++id)
+                    weighted += double(nodes.length(id)) * nodes.depth(id);
+            } else {
+                for (const auto *node : graph.m_deBruijnGraphNodes)
+                    weighted += double(node->getLength()) * node->getDepth();
+            }
+        }
+        QVERIFY(weighted > 0);
+    }
+
+    // Breadth-first traversal of the whole graph over the node objects. This
+    // is the baseline for the id-based traversals.
+    void bfsThroughput() {
+        AssemblyGraph &graph = syntheticGraph();
+
+        size_t visitedNodes = 0, iterations = 0;
+        qint64 elapsed = 0;
+        QElapsedTimer timer;
+        QBENCHMARK {
+            timer.start();
+            phmap::flat_hash_set<const DeBruijnNode *> visited;
+            std::deque<const DeBruijnNode *> queue;
+            for (const auto *start : graph.m_deBruijnGraphNodes) {
+                if (!visited.insert(start).second)
+                    continue;
+                queue.push_back(start);
+                while (!queue.empty()) {
+                    const auto *node = queue.front();
+                    queue.pop_front();
+                    for (const auto *edge : node->edges()) {
+                        const auto *next = edge->getStartingNode() == node ? edge->getEndingNode() : edge->getStartingNode();
+                        if (visited.insert(next).second)
+                            queue.push_back(next);
+                    }
+                }
+            }
+            visitedNodes = visited.size();
+            elapsed += timer.nsecsElapsed();
+            iterations += 1;
+        }
+        QCOMPARE(visitedNodes, graph.m_deBruijnGraphNodes.size());
+        qInfo("%.0f nodes/sec", double(visitedNodes) * double(iterations) * 1e9 / double(std::max<qint64>(elapsed, 1)));
+    }
+
+    // The same traversal over the CSR snapshot: dense visited array and
+    // contiguous neighbour slices
+    void bfsThroughputCsr() {
+        AssemblyGraph &graph = syntheticGraph();
+        auto snapshot = graph.adjacency();
+        const graph::Adjacency &adjacency = *snapshot;
+        const graph::NodeStore &nodes = adjacency.nodes();
+
+        size_t visitedNodes = 0, iterations = 0;
+        qint64 elapsed = 0;
+        QElapsedTimer timer;
+        std::vector<bool> visited;
+        std::vector<graph::NodeStore::Id> queue;
+        QBENCHMARK {
+            timer.start();
+            visited.assign(nodes.size(), false);
+            queue.clear();
+            queue.reserve(nodes.size());
+            for (graph::NodeStore::Id start = 0; start < nodes.size(); ++start) {
+                if (visited[start] || !nodes.exists(start))
+                    continue;
+                visited[start] = true;
+                size_t head = queue.size();
+                queue.push_back(start);
+                for (; head < queue.size(); ++head) {
+                    graph::NodeStore::Id node = queue[head];
+                    for (auto neighbours : { adjacency.outNodes(node), adjacency.inNodes(node) }) {
+                        for (graph::NodeStore::Id next : neighbours) {
+                            if (!visited[next]) {
+                                visited[next] = true;
+                                queue.push_back(next);
+                            }
+                        }
+                    }
+                }
+            }
+            visitedNodes = queue.size();
+            elapsed += timer.nsecsElapsed();
+            iterations += 1;
+        }
+        QCOMPARE(visitedNodes, graph.m_deBruijnGraphNodes.size());
+        qInfo("%.0f nodes/sec", double(visitedNodes) * double(iterations) * 1e9 / double(std::max<qint64>(elapsed, 1)));
+    }
+
+    void layoutFragmented_data() {
+        QTest::addColumn<int>("threads");
+        QTest::addColumn<bool>("linear");
+        QTest::newRow("1 thread") << 1 << false;
+        QTest::newRow("all threads") << 0 << false;
+        QTest::newRow("all threads, linear") << 0 << true;
+    }
+
+    // Wall-clock time of the whole layout of a fragmented graph, dominated
+    // by the per-component overhead rather than by FMMM itself (and by the
+    // seeding of the initial positions in linear mode)
+    void layoutFragmented() {
+        QFETCH(int, threads);
+        QFETCH(bool, linear);
+        auto graphList = QSharedPointer<AssemblyGraphList>::create();
+        AssemblyGraph &graph = *graphList->first();
+        QVERIFY(graph.loadGraphFromFile(m_fragmentedGfa));
+
+        g_settings->doubleMode = false;
+        g_settings->threads = threads;
+        QString errorTitle, errorMessage;
+        auto scope = graph::Scope::wholeGraph();
+        auto startingNodes = graph::getStartingNodes(&errorTitle, &errorMessage, graph, scope);
+        graph.markNodesToDraw(scope, startingNodes);
+
+        QList<GraphLayout*> layouts;
+        QBENCHMARK {
+            layouts = GraphLayoutWorker(g_settings->graphLayoutQuality,
+                                        linear,
+                                        g_settings->componentSeparation).layoutGraph(graphList);
+        }
+        QCOMPARE(layouts.size(), 1);
+        QCOMPARE(layouts.first()->size(), graph.getDrawnNodeCount());
+        qInfo("%d nodes, %u threads", graph.getDrawnNodeCount(), g_settings->threadCount());
+        g_settings->threads = 0;
+    }
+
+    void layoutEngine_data() {
+        QTest::addColumn<int>("engine");
+        QTest::addColumn<bool>("hierarchical");
+        QTest::newRow("FMMM") << int(FMMM_LAYOUT) << false;
+        QTest::newRow("FME") << int(FAST_MULTIPOLE_LAYOUT) << false;
+        QTest::newRow("FMMM, hierarchical") << int(FMMM_LAYOUT) << true;
+        QTest::newRow("FME, hierarchical") << int(FAST_MULTIPOLE_LAYOUT) << true;
+    }
+
+    // Wall-clock time and edge length stress of the layout of a graph that is
+    // a single giant component, FMMM uses one thread for it (unless the
+    // component is laid out hierarchically)
+    void layoutEngine() {
+        QFETCH(int, engine);
+        QFETCH(bool, hierarchical);
+        auto graphList = QSharedPointer<AssemblyGraphList>::create();
+        AssemblyGraph &graph = *graphList->first();
+        QVERIFY(graph.loadGraphFromFile(m_giantGfa));
+
+        g_settings->doubleMode = false;
+        g_settings->graphLayoutEngine = GraphLayoutEngine(engine);
+        g_settings->hierarchicalLayoutNodes = hierarchical ? 1 : 0;
+        QString errorTitle, errorMessage;
+        auto scope = graph::Scope::wholeGraph();
+        auto startingNodes = graph::getStartingNodes(&errorTitle, &errorMessage, graph, scope);
+        graph.markNodesToDraw(scope, startingNodes);
+
+        QList<GraphLayout*> layouts;
+        QBENCHMARK {
+            layouts = GraphLayoutWorker(g_settings->graphLayoutQuality,
+                                        g_settings->linearLayout,
+                                        g_settings->componentSeparation).layoutGraph(graphList);
+        }
+        QCOMPARE(layouts.size(), 1);
+        qInfo("%d nodes, %u threads, stress %.3f",
+              graph.getDrawnNodeCount(), g_settings->threadCount(), layoutStress(graph, *layouts.first()));
+        g_settings->graphLayoutEngine = FMMM_LAYOUT;
+        g_settings->hierarchicalLayoutNodes = 1000000;
+    }
+
+    void sceneRender_data() {
+        QTest::addColumn<double>("viewFraction");
+        QTest::newRow("zoomed in") << 0.02;
+        QTest::newRow("zoomed out") << 0.2;
+    }
+
+    // Frame time of panning over a scene of segmentCount() nodes: a 1280x720
+    // view of the given fraction of the scene width moves diagonally across
+    // it. Nodes are put on a grid in the order of their names, so the edges
+    // of the chains are short.
+    void sceneRender() {
+        QFETCH(double, viewFraction);
+        auto graphList = QSharedPointer<AssemblyGraphList>::create();
+        AssemblyGraph &graph = *graphList->first();
+        QVERIFY(graph.loadGraphFromFile(m_chainsGfa));
+
+        g_settings->doubleMode = false;
+        QString errorTitle, errorMessage;
+        auto scope = graph::Scope::wholeGraph();
+        auto startingNodes = graph::getStartingNodes(&errorTitle, &errorMessage, graph, scope);
+        graph.markNodesToDraw(scope, startingNodes);
+
+        std::vector<DeBruijnNode *> nodes;
+        for (auto *node : graph.m_deBruijnGraphNodes) {
+            if (node->isDrawn() && node->isPositiveNode())
+                nodes.push_back(node);
+        }
+        std::sort(nodes.begin(), nodes.end(), [](const DeBruijnNode *a, const DeBruijnNode *b) {
+            return a->getName().toULongLong() < b->getName().toULongLong();
+        });
+
+        auto columns = size_t(std::ceil(std::sqrt(double(nodes.size()))));
+        GraphLayout layout(graph);
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            double x = double(i % columns) * 60.0, y = double(i / columns) * 30.0;
+            for (int j = 0; j < 3; ++j)
+                layout.add(nodes[i], QPointF(x + j * 20.0, y));
+        }
+
+        BandageGraphicsScene scene;
+        scene.addGraphicsItemsToScene(graph, layout);
+        scene.setSceneRectangle();
+
+        QImage image(1280, 720, QImage::Format_ARGB32_Premultiplied);
+        QRectF sceneRect = scene.sceneRect();
+        QSizeF view(sceneRect.width() * viewFraction, sceneRect.width() * viewFraction * 720.0 / 1280.0);
+        const int frames = 50;
+
+        QElapsedTimer timer;
+        qint64 elapsed = 0, rendered = 0;
+        QBENCHMARK {
+            timer.start();
+            for (int frame = 0; frame < frames; ++frame) {
+                double t = double(frame) / double(frames - 1);
+                QRectF source(sceneRect.left() + t * (sceneRect.width() - view.width()),
+                              sceneRect.top() + t * (sceneRect.height() - view.height()),
+                              view.width(), view.height());
+                image.fill(Qt::white);
+                QPainter painter(&image);
+                painter.setRenderHint(QPainter::Antialiasing);
+                scene.render(&painter, QRectF(image.rect()), source);
+            }
+            elapsed += timer.nsecsElapsed();
+            rendered += frames;
+        }
+        qInfo("%zu nodes, %.3f ms per frame", nodes.size(), double(elapsed) / double(rendered) / 1e6);
+
+        scene.clear();
+        graph.resetNodes();
+    }
+};
+
+QTEST_MAIN(BandageBenchmarks)
+#include "bandagebenchmarks.moc"
@@ -21,14 +21,34 @@
 #include "graph/debruijnnode.h"
 #include "graph/debruijnedge.h"
 #include "graph/graphicsitemedgecommon.h"
+#include "graph/graphicsitembatch.h"
 #include "graph/graphicsitemnode.h"
+#include "graph/rtree.h"
 #include "graph/annotationsmanager.h"
 #include "graph/gfawriter.h"
 #include "graph/io.h"
+#include "graph/snapshot.h"
+#include "graph/sequencestore.h"
+#include "graph/nodestore.h"
+#include "graph/adjacency.h"
+#include "graph/graphstats.h"
+#include "graph/compaction.h"
 
 #include "layout/graphlayoutworker.h"
+#include "layout/coarsening.h"
+#include "layout/communities.h"
+#include "layout/layoutcache.h"
+#include "layout/hull.h"
+#include "layout/paths.h"
+#include "layout/workstealing.h"
 #include "layout/io.h"
 
+#include "painting/tiledrenderer.h"
+
+#include "io/linereader.h"
+#include "io/randomaccessreader.h"
+#include "io/gfa.h"
+
 #include "program/settings.h"
 #include "program/memory.h"
 #include "program/globals.h"
@@ -37,13 +57,22 @@
 
 #include "graphsearch/blast/blastsearch.h"
 
+#include "ui/bandagegraphicsscene.h"
+
 #include <CLI/CLI.hpp>
 
 #include <QtTest/QtTest>
 #include <QDebug>
 #include <QTemporaryDir>
+#include <QImage>
+#include <QPainter>
 
+#include <csignal>
 #include <iostream>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <sstream>
 
 class BandageTests : public QObject
 {
@@ -104,10 +133,22 @@ private slots:
     void loadGFAWithPlaceholders();
     void loadGFA12();
     void loadGFA();
+    void loadGFAThreads_data();
+    void loadGFAThreads();
+    void loadGFAMissingSequences();
+    void loadGFALazy_data();
+    void loadGFALazy();
+    void loadGFALazyFastaIndex();
+    void snapshotRoundTrip_data();
+    void snapshotRoundTrip();
+    void snapshotLayout();
     void loadGAF();
     void loadSPAdesPaths();
     void loadTrinity();
+    void randomAccessReader();
+    void gfaFastPath();
     void pathFunctionsOnGFA();
+    void lineReader();
     void pathFunctionsOnFastg();
     void pathFunctionsOnGfaSequencesInGraph();
     void pathFunctionsOnGfaSequencesInFasta();
@@ -118,19 +159,39 @@ private slots:
     void blastSearchFilters();
     void graphScope();
     void graphLayout();
+    void naturalSortKey();
+    void linearPlacement();
+    void graphLayoutDeterminism();
+    void layoutCoarsening();
+    void workStealing();
+    void pathPlacement();
+    void hullRectangles();
+    void hierarchicalLayout();
+    void incrementalLayout();
+    void layoutCache();
+    void layoutCancellation();
+    void batchedScene();
+    void rtree();
+    void tiledRenderer();
     void commandLineSettings();
     void sciNotComparisons();
     void graphEdits();
+    void nodeStore();
+    void adjacency();
     void fastgToGfa();
     void mergeNodesOnGfa();
+    void compactGraph();
     void changeNodeNames();
     void changeNodeDepths();
     void blastQueryPaths();
     void bandageInfo();
+    void graphStatistics();
     void sequenceInit();
     void sequenceInitN();
+    void sequenceAllNs();
     void sequenceAccess();
     void sequenceSubstring();
+    void sequenceConcat();
     void sequenceDoubleReverseComplement();
 
 
@@ -209,6 +270,315 @@ void BandageTests::loadGFA()
     QCOMPARE(node14->getLength(), 120);
 }
 
+void BandageTests::loadGFAThreads_data()
+{
+    QTest::addColumn<QString>("fileName");
+    QTest::newRow("placeholders") << testFile("test_not_defined.gfa");
+    QTest::newRow("gfa12") << testFile("test_gfa12.gfa.gz");
+    QTest::newRow("gfa") << testFile("test.gfa");
+    QTest::newRow("rgfa") << testFile("test_rgfa.gfa");
+
+    // Links before segments, duplicated links (including the reverse
+    // complementary ones), self-complementary links and gap links
+    QFile gfa(tempFile("threads.gfa"));
+    QVERIFY(gfa.open(QIODevice::WriteOnly));
+    gfa.write("H\tVN:Z:1.2\n"
+              "L\t1\t+\t2\t-\t3M\tCB:Z:blue\n"
+              "L\t2\t+\t1\t-\t3M\n"
+              "L\t1\t+\t2\t-\t4M\n"
+              "L\t3\t+\t3\t-\t2M\tWD:i:3\n"
+              "J\t3\t-\t5\t+\t100\n"
+              "S\t1\tACGTACGT\tdp:f:2.5\n"
+              "S\t2\t*\tLN:i:42\tKC:i:84\tLB:Z:two\n"
+              "S\t3\tGGGCCC\tzz:Z:custom\n"
+              "L\t3\t-\t1\t+\t1M1I1M\n"
+              "P\tp1\t1+,2-,3+\t*\n"
+              "S\t5\tTTTT\n");
+    gfa.close();
+    QTest::newRow("synthetic") << tempFile("threads.gfa");
+}
+
+// Textual description of everything the graph loaders produce, used to check
+// that different ways of loading give the same graph
+static QStringList describeGraph(const AssemblyGraph &graph) {
+    auto describeTags = [](const std::vector<gfa::tag> &tags) {
+        std::ostringstream res;
+        for (const auto &tag : tags)
+            res << " " << tag;
+        return QString::fromStdString(res.str());
+    };
+
+    QStringList res;
+    for (const auto *node : graph.m_deBruijnGraphNodes) {
+        QString descr = node->getName() + " " + QString::number(node->getLength()) + " " +
+                        QString::number(node->getDepth()) + " " +
+                        QString::fromStdString(node->getSequence().str()) + " " +
+                        node->getReverseComplement()->getName() + " " +
+                        graph.getCustomLabel(node) + " " +
+                        node->m_customColor.name(QColor::HexArgb);
+        for (const auto *edge : node->edges())
+            descr += " " + edge->getStartingNode()->getName() + ">" + edge->getEndingNode()->getName() + ":" +
+                     QString::number(edge->getOverlap()) + ":" + QString::number(edge->getOverlapType()) + ":" +
+                     graph.getCustomColour(edge).name() + ":" +
+                     QString::number(graph.getCustomStyle(edge).width) + ":" +
+                     QString::number(graph.getCustomStyle(edge).lineStyle) + ":" +
+                     (edge->getReverseComplement() ? edge->getReverseComplement()->getStartingNode()->getName() : "-");
+        if (auto tags = graph.m_nodeTags.find(node); tags != graph.m_nodeTags.end())
+            descr += " tags:" + describeTags(tags->second);
+        res.push_back(descr);
+    }
+    QStringList edgeTags;
+    for (const auto &[edge, tags] : graph.m_edgeTags)
+        edgeTags.push_back(edge->getStartingNode()->getName() + ">" + edge->getEndingNode()->getName() +
+                           describeTags(tags));
+    edgeTags.sort();
+    res += edgeTags;
+    for (auto it = graph.m_deBruijnGraphPaths.begin(); it != graph.m_deBruijnGraphPaths.end(); ++it)
+        res.push_back(QString::fromStdString(it.key()) + " " + (*it)->getString(true) + " " +
+                      QString::number((*it)->isCircular()));
+    res.push_back(QString::number(graph.m_deBruijnGraphEdges.size()) + " " + graph.m_depthTag + " " +
+                  QString::number(graph.m_sequencesLoadedFromFasta));
+    return res;
+}
+
+// Loading with several threads must give exactly the same graph as the
+// sequential loader
+void BandageTests::loadGFAThreads()
+{
+    QFETCH(QString, fileName);
+
+    g_settings->threads = 1;
+    AssemblyGraph sequential;
+    QVERIFY(sequential.loadGraphFromFile(fileName));
+
+    g_settings->threads = 4;
+    AssemblyGraph parallel;
+    QVERIFY(parallel.loadGraphFromFile(fileName));
+
+    QCOMPARE(describeGraph(parallel), describeGraph(sequential));
+}
+
+void BandageTests::snapshotRoundTrip_data()
+{
+    loadGFAThreads_data();
+    QTest::newRow("fastg") << testFile("test.fastg");
+    QTest::newRow("trinity") << testFile("test.Trinity.fasta");
+}
+
+// Graph loaded from a snapshot must be the same as the original one
+void BandageTests::snapshotRoundTrip()
+{
+    QFETCH(QString, fileName);
+
+    AssemblyGraph original;
+    QVERIFY(original.loadGraphFromFile(fileName));
+    QVERIFY(!snapshot::isSnapshot(fileName));
+
+    // Make sure custom attributes are stored as well
+    auto *node = *original.m_deBruijnGraphNodes.begin();
+    original.setCustomLabel(node, "label");
+    original.setCustomColour(node, QColor(10, 20, 30, 40));
+    if (!original.m_deBruijnGraphEdges.empty()) {
+        auto *edge = original.m_deBruijnGraphEdges.begin()->second;
+        original.setCustomColour(edge, Qt::green);
+        original.setCustomStyle(edge, Qt::DotLine);
+    }
+
+    QString snapshotName = tempFile("roundtrip.bandage");
+    QVERIFY(snapshot::save(snapshotName, original));
+    QVERIFY(snapshot::isSnapshot(snapshotName));
+
+    AssemblyGraph loaded;
+    QVERIFY(loaded.loadGraphFromFile(snapshotName));
+    QCOMPARE(loaded.m_filename, snapshotName);
+    QCOMPARE(describeGraph(loaded), describeGraph(original));
+
+    // Reverse complementary sequences still share the storage
+    for (auto it = original.m_deBruijnGraphNodes.begin(); it != original.m_deBruijnGraphNodes.end(); ++it) {
+        const auto *rc = (*it)->getReverseComplement();
+        if ((*it)->getSequence().empty() || !(*it)->getSequence().IsReverseComplementView(rc->getSequence()))
+            continue;
+        const auto *loadedNode = loaded.m_deBruijnGraphNodes.at(it.key());
+        QVERIFY(loadedNode->getSequence().IsReverseComplementView(loadedNode->getReverseComplement()->getSequence()));
+    }
+
+    // Snapshot of a snapshot is the same
+    QString secondName = tempFile("roundtrip2.bandage");
+    QVERIFY(snapshot::save(secondName, loaded));
+    AssemblyGraph reloaded;
+    QVERIFY(reloaded.loadGraphFromFile(secondName));
+    QCOMPARE(describeGraph(reloaded), describeGraph(original));
+
+    // Truncated snapshots are rejected
+    QFile truncated(tempFile("truncated.bandage"));
+    QVERIFY(truncated.open(QIODevice::WriteOnly));
+    QFile full(snapshotName);
+    QVERIFY(full.open(QIODevice::ReadOnly));
+    truncated.write(full.read(full.size() / 2));
+    truncated.close();
+    AssemblyGraph broken;
+    QVERIFY(!broken.loadGraphFromFile(truncated.fileName()));
+}
+
+void BandageTests::snapshotLayout()
+{
+    AssemblyGraph graph;
+    QVERIFY(graph.loadGraphFromFile(testFile("test.fastg")));
+
+    GraphLayout layout(graph);
+    layout::io::load(testFile("test.layout"), layout);
+    QCOMPARE(layout.size(), 42);
+
+    QString snapshotName = tempFile("layout.bandage");
+    QVERIFY(snapshot::save(snapshotName, graph, &layout));
+
+    AssemblyGraph loaded;
+    QVERIFY(loaded.loadGraphFromFile(snapshotName));
+    GraphLayout loadedLayout(loaded);
+    QVERIFY(layout::io::load(snapshotName, loadedLayout));
+    QCOMPARE(loadedLayout.size(), layout.size());
+    for (const auto &[node, segments] : layout) {
+        auto *loadedNode = loaded.m_deBruijnGraphNodes.at(node->getName().toStdString());
+        QVERIFY(loadedLayout.contains(loadedNode));
+        const auto &loadedSegments = loadedLayout.segments(loadedNode);
+        QCOMPARE(loadedSegments.size(), segments.size());
+        for (size_t i = 0; i < segments.size(); ++i)
+            QCOMPARE(loadedSegments[i], segments[i]);
+    }
+
+    // The layout could also be applied to the original graph
+    GraphLayout originalLayout(graph);
+    QVERIFY(layout::io::load(snapshotName, originalLayout));
+    QCOMPARE(originalLayout.size(), layout.size());
+
+    // Snapshot without layout
+    QString noLayoutName = tempFile("nolayout.bandage");
+    QVERIFY(snapshot::save(noLayoutName, graph));
+    GraphLayout emptyLayout(graph);
+    bool thrown = false;
+    try {
+        layout::io::load(noLayoutName, emptyLayout);
+    } catch (std::runtime_error &) {
+        thrown = true;
+    }
+    QVERIFY(thrown);
+}
+
+// Segments without sequences must not allocate memory for them, but the
+// sequences could still be loaded from FASTA later on
+void BandageTests::loadGFAMissingSequences()
+{
+    QFile gfa(tempFile("missing.gfa"));
+    QVERIFY(gfa.open(QIODevice::WriteOnly));
+    gfa.write("S\t1\t*\tLN:i:1000000000\n"
+              "S\t2\t*\tLN:i:1000000000\n"
+              "S\t3\t*\tLN:i:8\n"
+              "L\t1\t+\t2\t-\t0M\n");
+    gfa.close();
+
+    QFile fasta(tempFile("missing.fasta"));
+    QVERIFY(fasta.open(QIODevice::WriteOnly));
+    fasta.write(">3\nACGTTTTT\n");
+    fasta.close();
+
+    AssemblyGraph graph;
+    QVERIFY(graph.loadGraphFromFile(gfa.fileName()));
+    for (const char *name : { "1+", "1-", "2+", "2-" }) {
+        const DeBruijnNode *node = graph.m_deBruijnGraphNodes.at(name);
+        QCOMPARE(node->getLength(), 1000000000u);
+        QVERIFY(node->sequenceIsMissing());
+        QCOMPARE(node->getSequence().capacity(), size_t(0));
+        QCOMPARE(node->getBaseAt(999999999), 'N');
+    }
+
+    QVERIFY(!graph.m_deBruijnGraphNodes.at("3+")->sequenceIsMissing());
+    QCOMPARE(QString::fromStdString(graph.m_deBruijnGraphNodes.at("3+")->getSequence().str()), "ACGTTTTT");
+    QCOMPARE(QString::fromStdString(graph.m_deBruijnGraphNodes.at("3-")->getSequence().str()), "AAAAACGT");
+}
+
+void BandageTests::loadGFALazy_data()
+{
+    loadGFAThreads_data();
+}
+
+// Lazily loaded sequences must be the same as the ones loaded right away
+void BandageTests::loadGFALazy()
+{
+    QFETCH(QString, fileName);
+
+    AssemblyGraph eager;
+    QVERIFY(eager.loadGraphFromFile(fileName));
+    QVERIFY(!eager.m_sequenceStore);
+
+    g_settings->lazySequences = true;
+    g_settings->sequenceCacheSize = 1;
+    for (int threads : { 1, 4 }) {
+        g_settings->threads = threads;
+        AssemblyGraph lazy;
+        QVERIFY(lazy.loadGraphFromFile(fileName));
+        QVERIFY(lazy.m_sequenceStore);
+
+        QCOMPARE(describeGraph(lazy), describeGraph(eager));
+        QVERIFY(lazy.m_sequenceStore->cached() <= lazy.m_sequenceStore->budget());
+    }
+
+    // Cache must stay within the budget
+    AssemblyGraph lazy;
+    QVERIFY(lazy.loadGraphFromFile(fileName));
+    lazy.m_sequenceStore->setBudget(0);
+    QCOMPARE(describeGraph(lazy), describeGraph(eager));
+    QCOMPARE(lazy.m_sequenceStore->cached(), size_t(0));
+}
+
+// Sequences from indexed FASTA are loaded on demand
+void BandageTests::loadGFALazyFastaIndex()
+{
+    QFile gfa(tempFile("indexed.gfa"));
+    QVERIFY(gfa.open(QIODevice::WriteOnly));
+    gfa.write("S\t1\t*\tLN:i:12\n"
+              "S\t2\t*\tLN:i:6\n"
+              "S\t3\t*\tLN:i:8\n"
+              "L\t1\t+\t2\t-\t0M\n");
+    gfa.close();
+
+    QFile fasta(tempFile("indexed.fasta"));
+    QVERIFY(fasta.open(QIODevice::WriteOnly));
+    fasta.write(">1 first\nACGTA\nCCGGT\nAA\n>2\nTTTTT\nG\n");
+    fasta.close();
+
+    // The index deliberately does not list the last sequence
+    QFile fai(tempFile("indexed.fasta.fai"));
+    QVERIFY(fai.open(QIODevice::WriteOnly));
+    fai.write("1\t12\t9\t5\t6\n"
+              "2\t6\t27\t5\t6\n");
+    fai.close();
+
+    g_settings->lazySequences = true;
+    AssemblyGraph graph;
+    QVERIFY(graph.loadGraphFromFile(gfa.fileName()));
+    QCOMPARE(graph.m_sequenceStore->size(), size_t(2));
+
+    const DeBruijnNode *node1 = graph.m_deBruijnGraphNodes.at("1+");
+    QVERIFY(node1->hasLazySequence());
+    QVERIFY(!node1->sequenceIsMissing());
+
+    // Single bases are read on their own, across line breaks and on both
+    // strands, without caching the whole sequence
+    size_t cached = graph.m_sequenceStore->cached();
+    QCOMPARE(node1->getBaseAt(5), 'C');
+    QCOMPARE(node1->getBaseAt(11), 'A');
+    QCOMPARE(node1->getBaseAt(12), '\0');
+    QCOMPARE(node1->getReverseComplement()->getBaseAt(0), 'T');
+    QCOMPARE(node1->getReverseComplement()->getBaseAt(6), 'G');
+    QCOMPARE(graph.m_sequenceStore->cached(), cached);
+
+    QCOMPARE(QString::fromStdString(node1->getSequence().str()), "ACGTACCGGTAA");
+    QCOMPARE(QString::fromStdString(node1->getReverseComplement()->getSequence().str()), "TTACCGGTACGT");
+    QCOMPARE(QString::fromStdString(graph.m_deBruijnGraphNodes.at("2-")->getSequence().str()), "CAAAAA");
+    QCOMPARE(node1->getBaseAt(11), 'A');
+    QVERIFY(graph.m_deBruijnGraphNodes.at("3+")->sequenceIsMissing());
+}
+
 void BandageTests::loadGAF()
 {
     // Check that the graph loaded properly.
@@ -274,6 +644,102 @@ void BandageTests::loadTrinity()
 }
 
 
+void BandageTests::randomAccessReader()
+{
+    // test.fastg.gz is two gzip members, several spans long, so reads start
+    // from access points within and at the start of members
+    for (const char *name : { "test_gfa12.gfa.gz", "test.fastg.gz", "test.gfa", "test_plasmids.gfa" }) {
+        std::string fileName = testFile(name).toStdString();
+
+        std::string contents;
+        io::LineReader lineReader(fileName);
+        std::vector<char> chunk;
+        while (lineReader.readChunk(chunk, 1 << 20))
+            contents.append(chunk.data(), chunk.size());
+
+        // Small span to get a few access points even for small inputs
+        io::RandomAccessReader reader(fileName, 1);
+        QVERIFY(reader.isOpen());
+        QCOMPARE(reader.isCompressed(), QString(name).endsWith(".gz"));
+
+        std::string out;
+        for (size_t offset = 0; offset < contents.size(); offset += contents.size() / 17 + 1) {
+            for (size_t size : { size_t(0), size_t(1), size_t(100), size_t(40000) }) {
+                QCOMPARE(reader.read(offset, size, out), std::min(size, contents.size() - offset));
+                QVERIFY(out == contents.substr(offset, size));
+            }
+        }
+        QCOMPARE(reader.read(contents.size() + 1, 10, out), size_t(0));
+        if (QString(name) == "test.fastg.gz")
+            QVERIFY(reader.accessPoints() > 4);
+    }
+}
+
+static std::string describeRecord(const std::optional<gfa::record> &record) {
+    if (!record)
+        return "none";
+
+    std::ostringstream res;
+    auto describeTags = [&](const std::vector<gfa::tag> &tags) {
+        for (const auto &tag : tags)
+            res << ' ' << tag << ':' << tag.type << ':' << tag.val.index();
+    };
+    std::visit([&](const auto &record) {
+        using T = std::decay_t<decltype(record)>;
+        if constexpr (std::is_same_v<T, gfa::segment>) {
+            res << "S " << record.name << ' ' << record.seq;
+        } else if constexpr (std::is_same_v<T, gfa::link>) {
+            res << "L " << record.lhs << record.lhs_revcomp << ' ' << record.rhs << record.rhs_revcomp;
+            for (const auto &op : record.overlap)
+                res << ' ' << op.count << int(op.op);
+        } else
+            res << "other " << record.tags.size();
+        describeTags(record.tags);
+    }, *record);
+
+    return res.str();
+}
+
+// The fast path for common segment / link shapes must give the same results
+// as the generic parser
+void BandageTests::gfaFastPath()
+{
+    const char *lines[] = {
+        "S\t1\tACGTACGTACGTAAAAcgtNn\tLN:i:21\tdp:f:1.5e-3\tCL:Z:red blue\tXA:A:x",
+        "S\t1\t*\tLN:i:-0\tKC:i:9223372036854775807",
+        "S\t1\t*",
+        "S\tutg000001l\t*\tLN:i:100\tRC:i:2000\tlc:f:20\t",
+        "S\t1\t*\t",
+        "S\t1\tAC-GT",
+        "S\t*1\tA",
+        "S\tx,y\tA",
+        "S\t1\tA\tLN:i:01",
+        "S\t1\tA\tdp:f:1e5",
+        "S\t1\tA\tdp:f:-0.25\t",
+        "S\t1\tA\tdp:f:.5",
+        "S\t1\tA\tdp:f:00.5",
+        "S\t1\tA\tLN:B:i,1,2",
+        "S\t1\tA\tLN:i:1\t\t",
+        "S\t1\tAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA[",
+        "L\t1\t+\t2\t-\t55M",
+        "L\t1\t+\t2\t-\t*\tCB:Z:x\tWD:f:2.5",
+        "L\t1\t+\t2\t-\t1M2I.3D",
+        "L\t1\t+\t2\t-\t007M",
+        "L\t1\t+\t2\t-\t4294967296M",
+        "L\t1\t+\t2\t-\tM",
+        "L\t1\t*\t2\t-\t5M",
+        "L\t1\t+\t2\t-",
+        "H\tVN:Z:1.0",
+        "S",
+    };
+
+    for (const char *line : lines) {
+        auto fast = gfa::parseRecord(line, strlen(line));
+        auto generic = gfa::parseRecordGeneric(line, strlen(line));
+        QCOMPARE(QString::fromStdString(describeRecord(fast)), QString::fromStdString(describeRecord(generic)));
+    }
+}
+
 //LastGraph files have no overlap in the edges, so these tests look at paths
 //where the connections are simple.
 void BandageTests::pathFunctionsOnGFA()
@@ -332,6 +798,46 @@ void BandageTests::pathFunctionsOnGFA()
     QCOMPARE(nodeRange.size(), 3);
 }
 
+void BandageTests::lineReader()
+{
+    // Small block size to force lines spanning across several blocks
+    io::LineReader reader(testFile("test_gfa12.gfa.gz").toStdString(), 7);
+    QVERIFY(reader.isOpen());
+
+    size_t lines = 0;
+    std::string_view line;
+    while (reader.readLine(line)) {
+        QVERIFY(line.empty() || line.back() != '\n');
+        lines += 1;
+    }
+    QCOMPARE(lines, size_t(19));
+
+    QFile crlf(tempFile("crlf.txt"));
+    QVERIFY(crlf.open(QIODevice::WriteOnly));
+    crlf.write("H\tVN:Z:1.0\r\n\r\nS\t1\t*");
+    crlf.close();
+
+    io::LineReader crlfReader(tempFile("crlf.txt").toStdString());
+    QVERIFY(crlfReader.readLine(line));
+    QCOMPARE(QByteArray(line.data(), line.size()), QByteArray("H\tVN:Z:1.0"));
+    QVERIFY(crlfReader.readLine(line));
+    QVERIFY(line.empty());
+    QVERIFY(crlfReader.readLine(line));
+    QCOMPARE(QByteArray(line.data(), line.size()), QByteArray("S\t1\t*"));
+    QCOMPARE(crlfReader.lineOffset(), uint64_t(14));
+    QVERIFY(!crlfReader.readLine(line));
+
+    // Chunks must consist of whole lines and cover the whole input
+    io::LineReader chunkReader(testFile("test_gfa12.gfa.gz").toStdString(), 7);
+    std::vector<char> chunk;
+    uint64_t chunkBytes = 0;
+    while (chunkReader.readChunk(chunk, 10)) {
+        QVERIFY(chunk.size() >= 10 || chunkReader.offset() == reader.offset());
+        QVERIFY(chunk.back() == '\n' || chunkReader.offset() == reader.offset());
+        chunkBytes += chunk.size();
+    }
+    QCOMPARE(chunkBytes, reader.offset());
+}
 
 
 //FASTG files have overlaps in the edges, so these tests look at paths where
@@ -889,6 +1395,1031 @@ void BandageTests::graphLayout() {
 
         QCOMPARE(layout.first()->size(), 88);
     }
+
+    // Linear layout seeds every drawn node (the reverse complements follow
+    // their nodes)
+    {
+        auto layout = GraphLayoutWorker(g_settings->graphLayoutQuality,
+                                        true,
+                                        g_settings->componentSeparation).layoutGraph(g_assemblyGraph);
+
+        QCOMPARE(layout.first()->size(), 88);
+        for (const auto &entry : *layout.first()) {
+            for (const QPointF &point : entry.second)
+                QVERIFY(std::isfinite(point.x()) && std::isfinite(point.y()));
+        }
+    }
+}
+
+void BandageTests::naturalSortKey() {
+    auto before = [](std::string_view a, std::string_view b) {
+        return layout::naturalSortKey(a) < layout::naturalSortKey(b);
+    };
+    auto same = [](std::string_view a, std::string_view b) {
+        return layout::naturalSortKey(a) == layout::naturalSortKey(b);
+    };
+
+    // Numbers compare by their value
+    QVERIFY(before("contig_2", "contig_10"));
+    QVERIFY(!before("contig_10", "contig_2"));
+    QVERIFY(before("9", "10"));
+    QVERIFY(before("contig_2_5", "contig_2_10"));
+
+    // Leading zeros do not count
+    QVERIFY(same("contig_007", "contig_7"));
+    QVERIFY(before("contig_007", "contig_10"));
+    QVERIFY(before("0", "1"));
+    QVERIFY(same("000", "0"));
+
+    // Text compares case-insensitively
+    QVERIFY(same("Contig_2", "contig_2"));
+    QVERIFY(before("abc", "ABD"));
+    QVERIFY(before("ABC", "abd"));
+
+    // Digits go before any text
+    QVERIFY(before("1", "a"));
+    QVERIFY(before("contig_9", "contig_a"));
+    QVERIFY(before("edge_99", "edge_-"));
+}
+
+// Linear layout places every node right after the rightmost end of its
+// upstream nodes placed so far, otherwise after the previous node
+void BandageTests::linearPlacement() {
+    QFile gfa(tempFile("linear.gfa"));
+    QVERIFY(gfa.open(QIODevice::WriteOnly));
+    gfa.write("S\tn1\t*\tLN:i:1000\n"
+              "S\tn2\t*\tLN:i:100000\n"
+              "S\tn3\t*\tLN:i:1000\n"
+              "S\tn10\t*\tLN:i:1000\n"
+              "S\tn11\t*\tLN:i:1000\n"
+              "L\tn1\t+\tn2\t+\t0M\n"
+              "L\tn1\t+\tn3\t+\t0M\n"
+              "L\tn2\t+\tn10\t+\t0M\n"
+              "L\tn3\t+\tn10\t+\t0M\n");
+    gfa.close();
+
+    AssemblyGraph graph;
+    QVERIFY(graph.loadGraphFromFile(gfa.fileName()));
+    g_settings->doubleMode = false;
+    QString errorTitle, errorMessage;
+    auto scope = graph::Scope::wholeGraph();
+    auto startingNodes = graph::getStartingNodes(&errorTitle, &errorMessage, graph, scope);
+    graph.resetNodes();
+    graph.markNodesToDraw(scope, startingNodes);
+
+    GraphLayout positions = layout::linearPositions(graph);
+    QCOMPARE(positions.size(), size_t(5));
+    auto start = [&](const char *name) { return positions.segments(graph.m_deBruijnGraphNodes.at(name)).front(); };
+    auto end = [&](const char *name) { return positions.segments(graph.m_deBruijnGraphNodes.at(name)).back().x(); };
+    double gap = g_settings->edgeLength;
+
+    // n10 goes after n3 in the natural order, not before n2
+    QCOMPARE(start("n1+").x(), gap);
+    QCOMPARE(start("n2+").x(), end("n1+") + gap);
+    // Upstream n1 counts, not the previous n2: n3 is stacked under n2
+    QCOMPARE(start("n3+").x(), end("n1+") + gap);
+    QCOMPARE(start("n2+").y(), 0.0);
+    QCOMPARE(start("n3+").y(), gap);
+    // The rightmost upstream end is that of the longer n2, not of n3
+    QVERIFY(end("n2+") > end("n3+"));
+    QCOMPARE(start("n10+").x(), end("n2+") + gap);
+    QCOMPARE(start("n10+").y(), 0.0);
+    // Without upstream nodes placed, nodes follow the previous one
+    QCOMPARE(start("n11+").x(), end("n10+") + gap);
+}
+
+void BandageTests::graphLayoutDeterminism() {
+    auto layoutWithThreads = [](int threads) {
+        g_settings->threads = threads;
+        QList<GraphLayout*> layouts = GraphLayoutWorker(g_settings->graphLayoutQuality,
+                                                        g_settings->linearLayout,
+                                                        g_settings->componentSeparation).layoutGraph(g_assemblyGraph);
+        return GraphLayout(*layouts.first());
+    };
+
+    for (const char *fileName : { "test.fastg", "test.gfa", "test_plasmids.gfa" }) {
+        for (bool doubleMode : { false, true }) {
+            for (bool multilevel : { false, true }) {
+                QVERIFY(g_assemblyGraph->first()->loadGraphFromFile(testFile(fileName)));
+                g_settings->doubleMode = doubleMode;
+                g_settings->multilevelLayout = multilevel;
+
+                QString errorTitle, errorMessage;
+                auto scope = graph::Scope::wholeGraph();
+                auto startingNodes =
+                        graph::getStartingNodes(&errorTitle, &errorMessage,
+                                                *g_assemblyGraph->first(), scope);
+                g_assemblyGraph->first()->resetNodes();
+                g_assemblyGraph->first()->markNodesToDraw(scope, startingNodes);
+
+                GraphLayout sequential = layoutWithThreads(1);
+                GraphLayout parallel = layoutWithThreads(4);
+
+                // Positions must be bit-identical, not just close
+                QCOMPARE(parallel.size(), sequential.size());
+                for (const auto &entry : sequential) {
+                    QVERIFY(parallel.contains(entry.first));
+                    const auto &segments = parallel.segments(entry.first);
+                    QCOMPARE(segments.size(), entry.second.size());
+                    for (size_t i = 0; i < segments.size(); ++i) {
+                        QVERIFY(segments[i].x() == entry.second[i].x());
+                        QVERIFY(segments[i].y() == entry.second[i].y());
+                    }
+                }
+            }
+        }
+    }
+
+    g_settings->threads = 0;
+    g_settings->multilevelLayout = false;
+}
+
+void BandageTests::layoutCoarsening() {
+    ogdf::Graph G;
+    ogdf::GraphAttributes GA(G, ogdf::GraphAttributes::nodeGraphics | ogdf::GraphAttributes::edgeGraphics);
+    ogdf::EdgeArray<double> edgeLengths(G);
+
+    // Three straight arms of 400 unit edges around a branching node, a
+    // cycle of 50 nodes and an isolated node
+    ogdf::node center = G.newNode();
+    std::vector<std::vector<ogdf::node>> arms(3);
+    for (int arm = 0; arm < 3; ++arm) {
+        double angle = 2.0 * ogdf::Math::pi * arm / 3.0;
+        ogdf::node prev = center;
+        for (int i = 1; i <= 400; ++i) {
+            ogdf::node v = G.newNode();
+            GA.x(v) = i * std::cos(angle);
+            GA.y(v) = i * std::sin(angle);
+            edgeLengths[G.newEdge(prev, v)] = 1.0;
+            arms[arm].push_back(v);
+            prev = v;
+        }
+    }
+    ogdf::node first = G.newNode(), prev = first;
+    for (int i = 1; i < 50; ++i) {
+        ogdf::node v = G.newNode();
+        edgeLengths[G.newEdge(prev, v)] = 1.0;
+        prev = v;
+    }
+    edgeLengths[G.newEdge(prev, first)] = 1.0;
+    G.newNode();
+
+    layout::CoarseGraph coarse(GA, edgeLengths);
+
+    // Arms become paths of sqrt(400) = 20 edges, the cycle one of
+    // ceil(sqrt(50)) = 8 edges
+    QCOMPARE(G.numberOfNodes(), 1252);
+    QCOMPARE(coarse.numberOfNodes(), 1 + 3 * 20 + 8 + 1);
+    double length = 0;
+    for (ogdf::edge e : coarse.attributes().constGraph().edges)
+        length += coarse.edgeLengths()[e];
+    QCOMPARE(length, 1250.0);
+
+    // Straight evenly spaced paths are restored exactly
+    for (ogdf::node v : G.nodes)
+        GA.x(v) = GA.y(v) = std::numeric_limits<double>::quiet_NaN();
+    coarse.expand(GA);
+    for (int arm = 0; arm < 3; ++arm) {
+        double angle = 2.0 * ogdf::Math::pi * arm / 3.0;
+        for (int i = 1; i <= 400; ++i) {
+            QVERIFY(std::abs(GA.x(arms[arm][i - 1]) - i * std::cos(angle)) < 1e-6);
+            QVERIFY(std::abs(GA.y(arms[arm][i - 1]) - i * std::sin(angle)) < 1e-6);
+        }
+    }
+    for (ogdf::node v : G.nodes)
+        QVERIFY(std::isfinite(GA.x(v)) && std::isfinite(GA.y(v)));
+}
+
+// Every task must run exactly once, whatever the number of workers
+void BandageTests::workStealing() {
+    for (unsigned threads : { 1u, 4u }) {
+        for (size_t count : { size_t(1), size_t(3), size_t(1000) }) {
+            std::vector<std::atomic<int>> runs(count);
+            std::vector<size_t> order;
+            std::mutex orderMutex;
+            layout::WorkStealingScheduler scheduler;
+            scheduler.run(count, threads, [&](size_t i) {
+                // Uneven costs, so that the workers have to steal
+                if (i % 7 == 0)
+                    QThread::usleep(50);
+                ++runs[i];
+                std::lock_guard<std::mutex> lock(orderMutex);
+                order.push_back(i);
+            });
+
+            for (const auto &run : runs)
+                QCOMPARE(run.load(), 1);
+            // A single worker is the calling thread, it takes the tasks in order
+            if (threads == 1) {
+                for (size_t i = 0; i < count; ++i)
+                    QCOMPARE(order[i], i);
+            }
+        }
+    }
+
+    // Once cancelled, every worker finishes at most the task it has started
+    layout::WorkStealingScheduler scheduler;
+    std::atomic<size_t> started = 0;
+    scheduler.run(1000, 4, [&](size_t) {
+        if (++started == 10)
+            scheduler.cancel();
+    });
+    QVERIFY(scheduler.isCancelled());
+    QVERIFY(started.load() <= 10 + 3);
+    scheduler.run(10, 4, [&](size_t) { ++started; });
+    QVERIFY(started.load() <= 10 + 3);
+}
+
+// Paths are recognized and laid out on a line with the desired edge lengths
+void BandageTests::pathPlacement() {
+    ogdf::Graph G;
+    ogdf::GraphAttributes GA(G, ogdf::GraphAttributes::nodeGraphics | ogdf::GraphAttributes::edgeGraphics);
+    ogdf::EdgeArray<double> edgeLengths(G);
+
+    // A path of 5 nodes created out of order, with edges in both directions.
+    // The end at index 4 starts on the left.
+    std::vector<ogdf::node> path;
+    for (int i = 0; i < 5; ++i)
+        path.push_back(G.newNode());
+    std::swap(path[1], path[3]);
+    for (int i = 0; i < 5; ++i) {
+        GA.x(path[i]) = 10.0 - i;
+        GA.y(path[i]) = i * i;
+    }
+    const double lengths[] = { 1.0, 2.5, 4.0, 0.5 };
+    for (int i = 0; i < 4; ++i)
+        edgeLengths[i % 2 ? G.newEdge(path[i], path[i + 1]) : G.newEdge(path[i + 1], path[i])] = lengths[i];
+
+    ogdf::List<ogdf::node> pathNodes;
+    for (ogdf::node v : path)
+        pathNodes.pushBack(v);
+    QVERIFY(layout::isPath(pathNodes));
+
+    layout::placePath(GA, edgeLengths, pathNodes);
+    double x = 0;
+    for (int i = 4; i >= 0; --i) {
+        QCOMPARE(GA.x(path[i]), x);
+        QCOMPARE(GA.y(path[i]), 0.0);
+        if (i > 0)
+            x += lengths[i - 1];
+    }
+
+    // Single nodes are paths, cycles and branching components are not
+    ogdf::List<ogdf::node> single;
+    single.pushBack(G.newNode());
+    QVERIFY(layout::isPath(single));
+    layout::placePath(GA, edgeLengths, single);
+    QCOMPARE(GA.x(single.front()), 0.0);
+
+    ogdf::List<ogdf::node> cycle;
+    for (int i = 0; i < 4; ++i)
+        cycle.pushBack(G.newNode());
+    for (int i = 0; i < 4; ++i)
+        G.newEdge(*cycle.get(i), *cycle.get((i + 1) % 4));
+    QVERIFY(!layout::isPath(cycle));
+
+    ogdf::List<ogdf::node> star;
+    star.pushBack(G.newNode());
+    for (int i = 0; i < 3; ++i) {
+        star.pushBack(G.newNode());
+        G.newEdge(star.front(), star.back());
+    }
+    QVERIFY(!layout::isPath(star));
+}
+
+void BandageTests::hullRectangles() {
+    // The smallest bounding rectangle area among the hull edge rotations
+    // must be the one found by a fine sweep of the angles
+    auto edgeMinimum = [](const std::vector<ogdf::DPoint> &points, size_t &visited) {
+        std::vector<ogdf::DPoint> hull = layout::convexHull(points);
+        double best = std::numeric_limits<double>::max();
+        visited = 0;
+        layout::visitHullEdgeRectangles(hull, [&](double angle, double width, double height) {
+            // The sides are those of all the points rotated by the angle
+            double x_min, x_max, y_min, y_max;
+            layout::rotatedExtents(points, angle, x_min, x_max, y_min, y_max);
+            QVERIFY(angle >= 0 && angle < ogdf::Math::pi_2);
+            QVERIFY(std::abs(x_max - x_min - width) < 1e-9);
+            QVERIFY(std::abs(y_max - y_min - height) < 1e-9);
+            best = std::min(best, width * height);
+            ++visited;
+        });
+        return best;
+    };
+    auto sweepMinimum = [](const std::vector<ogdf::DPoint> &points) {
+        const int steps = 100000;
+        double best = std::numeric_limits<double>::max();
+        for (int i = 0; i < steps; ++i) {
+            double x_min, x_max, y_min, y_max;
+            layout::rotatedExtents(points, ogdf::Math::pi_2 * i / steps, x_min, x_max, y_min, y_max);
+            best = std::min(best, (x_max - x_min) * (y_max - y_min));
+        }
+        return best;
+    };
+    // The sweep misses the best angle by up to half a step, which costs up
+    // to about the squared diameter times the step
+    auto compare = [&](const std::vector<ogdf::DPoint> &points, double diameter, double &edge) {
+        size_t visited;
+        edge = edgeMinimum(points, visited);
+        double sweep = sweepMinimum(points);
+        QVERIFY(visited > 0);
+        QVERIFY(edge <= sweep + 1e-9);
+        QVERIFY(sweep - edge < diameter * diameter * 1e-4);
+    };
+
+    // A 4 x 1 rectangle rotated by 0.3 with points inside
+    std::vector<ogdf::DPoint> rectangle;
+    double sin_a = std::sin(0.3), cos_a = std::cos(0.3);
+    for (auto [x, y] : { std::pair(0.0, 0.0), { 4.0, 0.0 }, { 4.0, 1.0 }, { 0.0, 1.0 },
+                         { 1.0, 0.5 }, { 2.0, 0.25 }, { 3.5, 0.75 }, { 2.0, 0.0 } })
+        rectangle.emplace_back(5 + cos_a * x - sin_a * y, -2 + sin_a * x + cos_a * y);
+    QCOMPARE(layout::convexHull(rectangle).size(), size_t(4));
+    double area;
+    compare(rectangle, std::sqrt(17.0), area);
+    QVERIFY(std::abs(area - 4.0) < 1e-9);
+
+    // Collinear points have a two point hull and no area at all
+    std::vector<ogdf::DPoint> line;
+    for (int i : { 0, 3, 1, 2 })
+        line.emplace_back(1 + 3 * i, 4 * i);
+    QCOMPARE(layout::convexHull(line).size(), size_t(2));
+    compare(line, 15.0, area);
+    QVERIFY(std::abs(area) < 1e-9);
+
+    // Random points in a disc
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> coordinate(-1.0, 1.0);
+    std::vector<ogdf::DPoint> disc;
+    while (disc.size() < 200) {
+        double x = coordinate(rng), y = coordinate(rng);
+        if (x * x + y * y <= 1)
+            disc.emplace_back(10 * x, 10 * y);
+    }
+    compare(disc, 20.0, area);
+
+    // A single point has no edges and no extent
+    std::vector<ogdf::DPoint> single = { ogdf::DPoint(3, 7) };
+    QCOMPARE(layout::convexHull(single).size(), size_t(1));
+    size_t visited;
+    edgeMinimum(single, visited);
+    QCOMPARE(visited, size_t(0));
+    double x_min, x_max, y_min, y_max;
+    layout::rotatedExtents(single, 0.7, x_min, x_max, y_min, y_max);
+    QCOMPARE(x_max - x_min, 0.0);
+    QCOMPARE(y_max - y_min, 0.0);
+}
+
+void BandageTests::hierarchicalLayout() {
+    // Communities of a 60 x 60 grid are connected and of bounded size
+    {
+        ogdf::Graph G;
+        std::vector<ogdf::node> grid;
+        for (int i = 0; i < 60 * 60; ++i)
+            grid.push_back(G.newNode());
+        for (int i = 0; i < 60; ++i) {
+            for (int j = 0; j < 60; ++j) {
+                if (i + 1 < 60) G.newEdge(grid[i * 60 + j], grid[(i + 1) * 60 + j]);
+                if (j + 1 < 60) G.newEdge(grid[i * 60 + j], grid[i * 60 + j + 1]);
+            }
+        }
+
+        layout::Communities communities(G, 200);
+        QVERIFY(communities.count() >= 3600 / 250);
+        int total = 0;
+        for (int c = 0; c < communities.count(); ++c) {
+            const auto &members = communities.members(c);
+            QVERIFY(!members.empty() && members.size() <= 250);
+            total += int(members.size());
+
+            ogdf::NodeArray<bool> seen(G, false);
+            std::vector<ogdf::node> queue = { members.front() };
+            seen[members.front()] = true;
+            for (size_t head = 0; head < queue.size(); ++head) {
+                QCOMPARE(communities.community(queue[head]), c);
+                for (ogdf::adjEntry adj : queue[head]->adjEntries) {
+                    ogdf::node u = adj->twinNode();
+                    if (!seen[u] && communities.community(u) == c) {
+                        seen[u] = true;
+                        queue.push_back(u);
+                    }
+                }
+            }
+            QCOMPARE(queue.size(), members.size());
+        }
+        QCOMPARE(total, 3600);
+    }
+
+    // The grid is laid out as several communities, the edges between them
+    // get close to their lengths without stretching the ones inside
+    {
+        ogdf::Graph G;
+        ogdf::GraphAttributes GA(G, ogdf::GraphAttributes::nodeGraphics | ogdf::GraphAttributes::edgeGraphics);
+        ogdf::EdgeArray<double> edgeLengths(G);
+        std::vector<ogdf::node> grid;
+        for (int i = 0; i < 60 * 60; ++i) {
+            grid.push_back(G.newNode());
+            GA.width(grid.back()) = GA.height(grid.back()) = g_settings->edgeLength;
+        }
+        for (int i = 0; i < 60; ++i) {
+            for (int j = 0; j < 60; ++j) {
+                if (i + 1 < 60) edgeLengths[G.newEdge(grid[i * 60 + j], grid[(i + 1) * 60 + j])] = 20;
+                if (j + 1 < 60) edgeLengths[G.newEdge(grid[i * 60 + j], grid[i * 60 + j + 1])] = 20;
+            }
+        }
+
+        std::vector<int> membership =
+                GraphLayoutWorker(2, false, g_settings->componentSeparation).layoutHierarchically(GA, edgeLengths, 1);
+        QCOMPARE(membership.size(), size_t(3600));
+        QVERIFY(*std::max_element(membership.begin(), membership.end()) > 0);
+
+        // Mean ratios of the edge lengths to the desired ones
+        double boundary = 0, inner = 0;
+        int boundaryEdges = 0, innerEdges = 0;
+        for (ogdf::edge e : G.edges) {
+            QVERIFY(std::isfinite(GA.x(e->source())) && std::isfinite(GA.y(e->source())));
+            double ratio = std::hypot(GA.x(e->source()) - GA.x(e->target()),
+                                      GA.y(e->source()) - GA.y(e->target())) / edgeLengths[e];
+            if (membership[e->source()->index()] != membership[e->target()->index()]) {
+                boundary += ratio;
+                ++boundaryEdges;
+            } else {
+                inner += ratio;
+                ++innerEdges;
+            }
+        }
+        QVERIFY(boundaryEdges > 0);
+        QVERIFY(boundary / boundaryEdges < 4);
+        QVERIFY(inner / innerEdges < 2);
+    }
+
+    // Every component is laid out hierarchically, still reproducibly
+    QVERIFY(g_assemblyGraph->first()->loadGraphFromFile(testFile("test.fastg")));
+    g_settings->doubleMode = true;
+    g_settings->hierarchicalLayoutNodes = 1;
+
+    QString errorTitle, errorMessage;
+    auto scope = graph::Scope::wholeGraph();
+    auto startingNodes =
+            graph::getStartingNodes(&errorTitle, &errorMessage,
+                                    *g_assemblyGraph->first(), scope);
+    g_assemblyGraph->first()->resetNodes();
+    g_assemblyGraph->first()->markNodesToDraw(scope, startingNodes);
+
+    auto layoutWithThreads = [](int threads) {
+        g_settings->threads = threads;
+        QList<GraphLayout*> layouts = GraphLayoutWorker(g_settings->graphLayoutQuality,
+                                                        g_settings->linearLayout,
+                                                        g_settings->componentSeparation).layoutGraph(g_assemblyGraph);
+        return GraphLayout(*layouts.first());
+    };
+
+    GraphLayout sequential = layoutWithThreads(1);
+    GraphLayout parallel = layoutWithThreads(4);
+    QCOMPARE(sequential.size(), 88);
+    QCOMPARE(parallel.size(), sequential.size());
+    for (const auto &entry : sequential) {
+        const auto &segments = parallel.segments(entry.first);
+        QCOMPARE(segments.size(), entry.second.size());
+        for (size_t i = 0; i < segments.size(); ++i) {
+            QVERIFY(std::isfinite(entry.second[i].x()) && std::isfinite(entry.second[i].y()));
+            QVERIFY(segments[i].x() == entry.second[i].x());
+            QVERIFY(segments[i].y() == entry.second[i].y());
+        }
+    }
+
+    g_settings->threads = 0;
+    g_settings->hierarchicalLayoutNodes = 1000000;
+}
+
+void BandageTests::incrementalLayout() {
+    QVERIFY(g_assemblyGraph->first()->loadGraphFromFile(testFile("test.fastg")));
+    g_settings->doubleMode = false;
+
+    auto layoutAround = [](unsigned distance, const GraphLayout *previous) {
+        QString errorTitle, errorMessage;
+        auto scope = graph::Scope::aroundNodes("1", distance);
+        auto startingNodes =
+                graph::getStartingNodes(&errorTitle, &errorMessage,
+                                        *g_assemblyGraph->first(), scope);
+        g_assemblyGraph->first()->resetNodes();
+        g_assemblyGraph->first()->markNodesToDraw(scope, startingNodes);
+
+        GraphLayoutWorker worker(g_settings->graphLayoutQuality,
+                                 g_settings->linearLayout,
+                                 g_settings->componentSeparation);
+        if (previous)
+            worker.setPreviousLayout(*previous);
+        return GraphLayout(*worker.layoutGraph(g_assemblyGraph).first());
+    };
+
+    GraphLayout before = layoutAround(1, nullptr);
+    GraphLayout after = layoutAround(3, &before);
+    QVERIFY(after.size() > before.size());
+
+    // Nodes drawn before keep their relative positions, the drawing as a
+    // whole may be moved
+    bool first = true;
+    QPointF shift;
+    for (const auto &entry : before) {
+        QVERIFY(after.contains(entry.first));
+        const auto &segments = after.segments(entry.first);
+        QCOMPARE(segments.size(), entry.second.size());
+        for (size_t i = 0; i < segments.size(); ++i) {
+            if (first) {
+                shift = segments[i] - entry.second[i];
+                first = false;
+            }
+            QPointF delta = segments[i] - entry.second[i] - shift;
+            QVERIFY(std::abs(delta.x()) < 1e-6 && std::abs(delta.y()) < 1e-6);
+        }
+    }
+
+    for (const auto &entry : after) {
+        for (const QPointF &point : entry.second)
+            QVERIFY(std::isfinite(point.x()) && std::isfinite(point.y()));
+    }
+
+    // Redrawing the same nodes ignores the previous layout
+    GraphLayout fresh = layoutAround(3, nullptr);
+    GraphLayout again = layoutAround(3, &after);
+    QCOMPARE(again.size(), fresh.size());
+    for (const auto &entry : fresh) {
+        QVERIFY(again.contains(entry.first));
+        QVERIFY(again.segments(entry.first) == entry.second);
+    }
+
+    // Previous layouts are only passed on while the parameters are the same
+    // (see MainWindow::layoutGraph())
+    auto parameters = [](int quality, bool linear) {
+        return GraphLayoutWorker(quality, linear, g_settings->componentSeparation).layoutParameters();
+    };
+    QCOMPARE(parameters(1, false), parameters(1, false));
+    QVERIFY(parameters(1, false) != parameters(2, false));
+    QVERIFY(parameters(1, false) != parameters(1, true));
+    // So are the Hi-C edge lengths
+    QByteArray defaults = parameters(1, false);
+    double hicEdgeLength = g_settings->hicEdgeLength;
+    g_settings->hicEdgeLength = hicEdgeLength + 10.0;
+    QVERIFY(defaults != parameters(1, false));
+    g_settings->hicEdgeLength = hicEdgeLength;
+    double averageNodeWidth = g_settings->averageNodeWidth;
+    g_settings->averageNodeWidth = averageNodeWidth + 1.0;
+    QVERIFY(defaults != parameters(1, false));
+    g_settings->averageNodeWidth = averageNodeWidth;
+    // Fast multipole layouts of large components depend on the threads,
+    // the others do not
+    GraphLayoutEngine engine = g_settings->graphLayoutEngine;
+    g_settings->graphLayoutEngine = FMMM_LAYOUT;
+    g_settings->threads = 1;
+    QByteArray single = parameters(1, false);
+    g_settings->threads = 2;
+    QCOMPARE(parameters(1, false), single);
+    g_settings->graphLayoutEngine = FAST_MULTIPOLE_LAYOUT;
+    QByteArray fmeMultiple = parameters(1, false);
+    g_settings->threads = 1;
+    QVERIFY(parameters(1, false) != fmeMultiple);
+    g_settings->graphLayoutEngine = engine;
+    g_settings->threads = 0;
+    QVERIFY(!Settings().incrementalLayout);
+}
+
+void BandageTests::layoutCache() {
+    QTemporaryDir cacheDir;
+    g_settings->layoutCacheDir = cacheDir.path();
+    auto cacheEntries = [&]() {
+        return QDir(cacheDir.path()).entryInfoList({ "*.layout" }, QDir::Files);
+    };
+
+    QVERIFY(g_assemblyGraph->first()->loadGraphFromFile(testFile("test.fastg")));
+    g_settings->doubleMode = false;
+    QString errorTitle, errorMessage;
+    auto scope = graph::Scope::wholeGraph();
+    auto startingNodes =
+            graph::getStartingNodes(&errorTitle, &errorMessage,
+                                    *g_assemblyGraph->first(), scope);
+    g_assemblyGraph->first()->resetNodes();
+    g_assemblyGraph->first()->markNodesToDraw(scope, startingNodes);
+
+    auto layout = []() {
+        QList<GraphLayout*> layouts = GraphLayoutWorker(g_settings->graphLayoutQuality,
+                                                        g_settings->linearLayout,
+                                                        g_settings->componentSeparation).layoutGraph(g_assemblyGraph);
+        return GraphLayout(*layouts.first());
+    };
+
+    // The first layout is stored, the second one is loaded
+    GraphLayout computed = layout();
+    QCOMPARE(cacheEntries().size(), 1);
+    GraphLayout cached = layout();
+    QCOMPARE(cacheEntries().size(), 1);
+    QCOMPARE(cached.size(), computed.size());
+    for (const auto &entry : computed) {
+        QVERIFY(cached.contains(entry.first));
+        const auto &segments = cached.segments(entry.first);
+        QCOMPARE(segments.size(), entry.second.size());
+        for (size_t i = 0; i < segments.size(); ++i)
+            QVERIFY(segments[i] == entry.second[i]);
+    }
+
+    // Layouts really come from the cache: move the stored one and get it back
+    QString entryName = cacheEntries().front().filePath();
+    GraphLayout stored(*g_assemblyGraph->first());
+    QVERIFY(layout::io::load(entryName, stored));
+    for (auto &entry : stored) {
+        for (QPointF &point : entry.second)
+            point += QPointF(100, 0);
+    }
+    QVERIFY(layout::io::save(entryName, stored));
+    GraphLayout moved = layout();
+    for (const auto &entry : computed) {
+        const auto &segments = moved.segments(entry.first);
+        for (size_t i = 0; i < segments.size(); ++i)
+            QVERIFY(std::abs(segments[i].x() - entry.second[i].x() - 100) < 1e-6);
+    }
+
+    // Any layout setting changes the key
+    int quality = g_settings->graphLayoutQuality;
+    g_settings->graphLayoutQuality = quality == 0 ? 1 : 0;
+    layout();
+    QCOMPARE(cacheEntries().size(), 2);
+    g_settings->graphLayoutQuality = quality;
+
+    // Broken entries are dropped
+    layout::LayoutCache cache(cacheDir.path(), std::numeric_limits<qint64>::max());
+    QByteArray key = layout::LayoutCache::key(*g_assemblyGraph->first(), "test");
+    QFile broken(QDir(cacheDir.path()).filePath(QString::fromLatin1(key) + ".layout"));
+    QVERIFY(broken.open(QIODevice::WriteOnly));
+    broken.write("not a layout");
+    broken.close();
+    GraphLayout missing(*g_assemblyGraph->first());
+    QVERIFY(!cache.load(key, missing));
+    QVERIFY(!broken.exists());
+
+    // The least recently used entries are evicted: with room for two, the
+    // one that was not loaded goes first. Modification times are set
+    // explicitly, so the order does not depend on the file time resolution.
+    QTemporaryDir lruDir;
+    QVERIFY(cache.store(key, computed));
+    qint64 entrySize = QFileInfo(broken).size();
+    QVERIFY(entrySize > 0);
+    layout::LayoutCache lru(lruDir.path(), 2 * entrySize + entrySize / 2);
+    QByteArray first = layout::LayoutCache::key(*g_assemblyGraph->first(), "first"),
+              second = layout::LayoutCache::key(*g_assemblyGraph->first(), "second"),
+              third = layout::LayoutCache::key(*g_assemblyGraph->first(), "third");
+    auto lruEntry = [&](const QByteArray &entryKey) {
+        return QDir(lruDir.path()).filePath(QString::fromLatin1(entryKey) + ".layout");
+    };
+    auto age = [&](const QByteArray &entryKey, int seconds) {
+        QFile file(lruEntry(entryKey));
+        QVERIFY(file.open(QIODevice::Append));
+        QVERIFY(file.setFileTime(QDateTime::currentDateTime().addSecs(-seconds),
+                                 QFileDevice::FileModificationTime));
+    };
+
+    QVERIFY(lru.store(first, computed));
+    age(first, 20);
+    QVERIFY(lru.store(second, computed));
+    age(second, 10);
+    QVERIFY(QFile::exists(lruEntry(first)) && QFile::exists(lruEntry(second)));
+
+    GraphLayout touched(*g_assemblyGraph->first());
+    QVERIFY(lru.load(first, touched));
+    QVERIFY(lru.store(third, computed));
+    QVERIFY(QFile::exists(lruEntry(first)));
+    QVERIFY(!QFile::exists(lruEntry(second)));
+    QVERIFY(QFile::exists(lruEntry(third)));
+
+    g_settings->layoutCacheDir.clear();
+}
+
+void BandageTests::layoutCancellation() {
+    QTemporaryDir cacheDir;
+    g_settings->layoutCacheDir = cacheDir.path();
+
+    QVERIFY(g_assemblyGraph->first()->loadGraphFromFile(testFile("test.fastg")));
+    g_settings->doubleMode = false;
+    QString errorTitle, errorMessage;
+    auto scope = graph::Scope::wholeGraph();
+    auto startingNodes =
+            graph::getStartingNodes(&errorTitle, &errorMessage,
+                                    *g_assemblyGraph->first(), scope);
+    g_assemblyGraph->first()->resetNodes();
+    g_assemblyGraph->first()->markNodesToDraw(scope, startingNodes);
+    int drawnNodes = g_assemblyGraph->first()->getDrawnNodeCount();
+
+    auto checkLayout = [&](const GraphLayout &layout) {
+        QCOMPARE(int(layout.size()), drawnNodes);
+        for (const auto &entry : layout) {
+            for (const QPointF &point : entry.second)
+                QVERIFY(std::isfinite(point.x()) && std::isfinite(point.y()));
+        }
+    };
+
+    // Progress goes up to the total number of nodes laid out
+    {
+        GraphLayoutWorker worker(g_settings->graphLayoutQuality,
+                                 g_settings->linearLayout,
+                                 g_settings->componentSeparation);
+        QSignalSpy progress(&worker, &GraphLayoutWorker::layoutProgress);
+        checkLayout(*worker.layoutGraph(g_assemblyGraph).first());
+        QVERIFY(progress.size() >= 2);
+        QCOMPARE(progress.first().at(0).toInt(), 0);
+        QCOMPARE(progress.last().at(0).toInt(), progress.last().at(1).toInt());
+        QVERIFY(!worker.isCancelled());
+    }
+    QDir(cacheDir.path()).removeRecursively();
+
+    // Cancelled layouts still place every node, they are not cached
+    {
+        GraphLayoutWorker worker(g_settings->graphLayoutQuality,
+                                 g_settings->linearLayout,
+                                 g_settings->componentSeparation);
+        worker.cancelLayout();
+        checkLayout(*worker.layoutGraph(g_assemblyGraph).first());
+        QVERIFY(QDir(cacheDir.path()).entryInfoList({ "*.layout" }, QDir::Files).isEmpty());
+    }
+
+    // SIGINT cancels the command line layout (raised from the layout itself)
+    {
+        GraphLayoutWorker worker(g_settings->graphLayoutQuality,
+                                 g_settings->linearLayout,
+                                 g_settings->componentSeparation);
+        bool raised = false;
+        connect(&worker, &GraphLayoutWorker::layoutProgress, &worker, [&]() {
+            if (!raised) {
+                raised = true;
+                std::raise(SIGINT);
+            }
+        }, Qt::DirectConnection);
+        QString warnings;
+        QTextStream err(&warnings);
+        layoutGraphInterruptibly(worker, g_assemblyGraph, &err);
+        QVERIFY(raised);
+        QVERIFY(worker.isCancelled());
+        QVERIFY(warnings.contains("interrupted"));
+        checkLayout(*g_assemblyGraph->first()->m_layout);
+    }
+
+    g_settings->layoutCacheDir.clear();
+}
+
+void BandageTests::batchedScene() {
+    QVERIFY(g_assemblyGraph->first()->loadGraphFromFile(testFile("test.fastg")));
+    AssemblyGraph &graph = *g_assemblyGraph->first();
+    g_settings->doubleMode = false;
+    QString errorTitle, errorMessage;
+    auto scope = graph::Scope::wholeGraph();
+    auto startingNodes = graph::getStartingNodes(&errorTitle, &errorMessage, graph, scope);
+    graph.resetNodes();
+    graph.markNodesToDraw(scope, startingNodes);
+    QList<GraphLayout*> layouts = GraphLayoutWorker(g_settings->graphLayoutQuality,
+                                                    g_settings->linearLayout,
+                                                    g_settings->componentSeparation).layoutGraph(g_assemblyGraph);
+
+    g_settings->batchedSceneNodes = 1;
+    BandageGraphicsScene scene;
+    scene.addGraphicsItemsToScene(graph, *layouts.first());
+    scene.setSceneRectangle();
+
+    // No node or edge is in the scene, but all of them are drawn
+    std::vector<DeBruijnNode *> drawnNodes;
+    for (auto *node : graph.m_deBruijnGraphNodes) {
+        if (node->hasGraphicsItem())
+            drawnNodes.push_back(node);
+    }
+    QCOMPARE(int(drawnNodes.size()), 44);
+    for (auto *item : scene.items()) {
+        QVERIFY(!dynamic_cast<GraphicsItemNode *>(item));
+        QVERIFY(!dynamic_cast<GraphicsItemEdge *>(item));
+    }
+
+    // Pixels that are painted, and pixels of the selection colour
+    auto countPixels = [&scene](int &painted, int &selectionColoured) {
+        QImage image(400, 400, QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::white);
+        {
+            QPainter painter(&image);
+            scene.render(&painter);
+        }
+        painted = selectionColoured = 0;
+        for (int y = 0; y < image.height(); ++y) {
+            for (int x = 0; x < image.width(); ++x) {
+                painted += image.pixel(x, y) != qRgb(255, 255, 255);
+                selectionColoured += image.pixel(x, y) == g_settings->selectionColour.rgb();
+            }
+        }
+    };
+    // A few pixels wide
+    double selectionThickness = g_settings->selectionThickness;
+    g_settings->selectionThickness = scene.sceneRect().width() / 100.0;
+    int painted, unselectedColoured;
+    countPixels(painted, unselectedColoured);
+    QVERIFY(painted > 0);
+
+    // Selecting a batched node keeps it out of the scene, the batch keeps
+    // track of it
+    auto withEdges = std::find_if(drawnNodes.begin(), drawnNodes.end(),
+                                  [](DeBruijnNode *node) { return node->edgeBegin() != node->edgeEnd(); });
+    QVERIFY(withEdges != drawnNodes.end());
+    DeBruijnNode *selected = *withEdges;
+    GraphicsItemNode *selectedItem = selected->getGraphicsItemNode();
+    selectedItem->setSelected(true);
+    QVERIFY(selectedItem->isSelected());
+    QVERIFY(!selectedItem->scene());
+    QCOMPARE(scene.getSelectedNodes().size(), size_t(1));
+    QCOMPARE(scene.getSelectedNodes().front(), selected);
+    QCOMPARE(scene.getSelectedGraphicsItemNodes().size(), size_t(1));
+
+    // Clicking or dragging it promotes it, its edges come along and it stays
+    // selected
+    selectedItem->m_batch->promote(selectedItem);
+    QCOMPARE(selectedItem->scene(), &scene);
+    QVERIFY(selectedItem->isSelected());
+    QCOMPARE(scene.getSelectedNodes().size(), size_t(1));
+    QCOMPARE(scene.getSelectedNodes().front(), selected);
+    for (auto *edge : selected->edges()) {
+        GraphicsItemEdge *graphicsItemEdge = edge->getGraphicsItemEdge();
+        if (!graphicsItemEdge)
+            graphicsItemEdge = edge->getReverseComplement()->getGraphicsItemEdge();
+        QVERIFY(graphicsItemEdge);
+        QCOMPARE(graphicsItemEdge->scene(), &scene);
+    }
+
+    // Area selection finds batched nodes by their line points
+    DeBruijnNode *other = selected == drawnNodes.front() ? drawnNodes.back() : drawnNodes.front();
+    QPointF point = other->getGraphicsItemNode()->getFirst();
+    scene.selectBatchedNodes(QPolygonF(QRectF(point - QPointF(0.5, 0.5), QSizeF(1.0, 1.0))));
+    QVERIFY(other->getGraphicsItemNode()->isSelected());
+    QVERIFY(!other->getGraphicsItemNode()->scene());
+    QCOMPARE(scene.getSelectedNodes().size(), size_t(2));
+
+    // Selecting everything leaves the batched nodes in the batch, which draws
+    // them with the selection pen
+    scene.selectBatchedNodes(QPolygonF(scene.sceneRect()));
+    QCOMPARE(scene.getSelectedNodes().size(), drawnNodes.size());
+    int nodesInScene = 0;
+    for (auto *item : scene.items())
+        nodesInScene += dynamic_cast<GraphicsItemNode *>(item) != nullptr;
+    QCOMPARE(nodesInScene, 1);
+    int selectedColoured;
+    countPixels(painted, selectedColoured);
+    QVERIFY(selectedColoured > unselectedColoured);
+    g_settings->selectionThickness = selectionThickness;
+
+    // Clearing the selection deselects the batched nodes too
+    scene.clearSelection();
+    QVERIFY(scene.getSelectedNodes().empty());
+    QVERIFY(!other->getGraphicsItemNode()->isSelected());
+
+    // Batched nodes can be removed, the rest go with the scene
+    DeBruijnNode *removed = nullptr;
+    for (auto *node : drawnNodes) {
+        if (node != selected && node != other && !node->getGraphicsItemNode()->scene())
+            removed = node;
+    }
+    QVERIFY(removed);
+    BandageGraphicsScene::removeGraphicsItemNodes({ removed }, true);
+    QVERIFY(!removed->hasGraphicsItem());
+
+    scene.clear();
+    graph.resetNodes();
+    g_settings->batchedSceneNodes = 500000;
+}
+
+void BandageTests::tiledRenderer() {
+    QVERIFY(g_assemblyGraph->first()->loadGraphFromFile(testFile("test.fastg")));
+    AssemblyGraph &graph = *g_assemblyGraph->first();
+    QString errorTitle, errorMessage;
+    auto scope = graph::Scope::wholeGraph();
+    auto startingNodes = graph::getStartingNodes(&errorTitle, &errorMessage, graph, scope);
+    graph.resetNodes();
+    graph.markNodesToDraw(scope, startingNodes);
+    QList<GraphLayout*> layouts = GraphLayoutWorker(g_settings->graphLayoutQuality,
+                                                    g_settings->linearLayout,
+                                                    g_settings->componentSeparation).layoutGraph(g_assemblyGraph);
+
+    // A scene of items and a batched one
+    for (int batchedSceneNodes : { 500000, 1 }) {
+        g_settings->batchedSceneNodes = batchedSceneNodes;
+        graph.resetEdges();
+        graph.resetNodes();
+        graph.markNodesToDraw(scope, startingNodes);
+        BandageGraphicsScene scene;
+        scene.addGraphicsItemsToScene(graph, *layouts.first());
+        scene.setSceneRectangle();
+        QString name = batchedSceneNodes == 1 ? "batched" : "items";
+
+        // Several tiles across and two rows of them, the last ones partial
+        QSize size(600, 300);
+        TiledRenderer renderer(scene, size);
+        QVERIFY(renderer.savePng(tempFile(name + ".png")));
+        QImage png(tempFile(name + ".png"));
+        QCOMPARE(png.size(), size);
+
+        // Same as the image in one piece, give or take antialiasing at the seams
+        QImage whole = renderer.render(QRect(QPoint(0, 0), size));
+        int painted = 0, different = 0;
+        for (int y = 0; y < size.height(); ++y) {
+            for (int x = 0; x < size.width(); ++x) {
+                QRgb a = png.pixel(x, y), b = whole.pixel(x, y);
+                painted += a != qRgb(255, 255, 255);
+                different += std::abs(qRed(a) - qRed(b)) > 16 || std::abs(qGreen(a) - qGreen(b)) > 16 ||
+                             std::abs(qBlue(a) - qBlue(b)) > 16;
+            }
+        }
+        QVERIFY(painted > 0);
+        QVERIFY(different < size.width() * size.height() / 100);
+
+        // 600 pixels need zoom levels 0 to 2
+        QVERIFY(renderer.saveTilePyramid(tempFile(name + "_tiles")));
+        QDir tiles(tempFile(name + "_tiles"));
+        QCOMPARE(QImage(tiles.filePath("0/0/0.png")).size(), QSize(TiledRenderer::TileSize, TiledRenderer::TileSize));
+        QVERIFY(tiles.exists("2/0/0.png"));
+        QVERIFY(!tiles.exists("3"));
+
+        scene.clear();
+    }
+
+    g_settings->batchedSceneNodes = 500000;
+    graph.resetNodes();
+}
+
+void BandageTests::rtree() {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> position(0.0, 1000.0), extent(0.0, 20.0);
+    auto randomRect = [&]() {
+        // Points and zero width rectangles too
+        switch (rng() % 4) {
+            case 0: return QRectF(position(rng), position(rng), 0.0, 0.0);
+            case 1: return QRectF(position(rng), position(rng), 0.0, extent(rng));
+            default: return QRectF(position(rng), position(rng), extent(rng), extent(rng));
+        }
+    };
+
+    std::vector<QRectF> rects(2000);
+    for (auto &rect : rects)
+        rect = randomRect();
+    std::vector<bool> present(rects.size(), true);
+    RTree tree(rects);
+    QCOMPARE(tree.size(), rects.size());
+
+    auto check = [&]() {
+        for (int i = 0; i < 50; ++i) {
+            QRectF area = i == 0 ? QRectF(rects.front().topLeft(), QSizeF(0.0, 0.0))
+                                 : QRectF(position(rng), position(rng), 5.0 * extent(rng), 5.0 * extent(rng));
+            std::vector<uint32_t> expected, found;
+            for (uint32_t id = 0; id < rects.size(); ++id) {
+                const QRectF &rect = rects[id];
+                if (present[id] &&
+                    rect.left() <= area.right() && area.left() <= rect.right() &&
+                    rect.top() <= area.bottom() && area.top() <= rect.bottom())
+                    expected.push_back(id);
+            }
+            tree.query(area, [&](uint32_t id) { found.push_back(id); });
+            std::sort(found.begin(), found.end());
+            QVERIFY(found == expected);
+        }
+    };
+    check();
+
+    // Moved, new and removed rectangles, enough of them to trigger repacking
+    for (uint32_t i = 0; i < 1000; ++i) {
+        uint32_t id = rng() % rects.size();
+        switch (i % 3) {
+            case 0:
+                rects[id] = randomRect();
+                tree.update(id, rects[id]);
+                present[id] = true;
+                break;
+            case 1:
+                rects.push_back(randomRect());
+                present.push_back(true);
+                tree.insert(uint32_t(rects.size() - 1), rects.back());
+                break;
+            case 2:
+                tree.remove(id);
+                present[id] = false;
+                break;
+        }
+        if (i % 100 == 0)
+            check();
+    }
+    check();
+    QCOMPARE(tree.size(), size_t(std::count(present.begin(), present.end(), true)));
+    for (uint32_t id = 0; id < rects.size(); ++id)
+        QCOMPARE(tree.contains(id), bool(present[id]));
+
+    // QRectF::united() would skip the points
+    double left = 1000.0, top = 1000.0, right = 0.0, bottom = 0.0;
+    for (uint32_t id = 0; id < rects.size(); ++id) {
+        if (!present[id])
+            continue;
+        left = std::min(left, rects[id].left());
+        top = std::min(top, rects[id].top());
+        right = std::max(right, rects[id].right());
+        bottom = std::max(bottom, rects[id].bottom());
+    }
+    QCOMPARE(tree.bounds(), QRectF(QPointF(left, top), QPointF(right, bottom)));
 }
 
 static void parseSettings(const QStringList &commandLineSettings) {
@@ -1021,6 +2552,11 @@ void BandageTests::commandLineSettings() {
     parseSettings(commandLineSettings);
     QCOMPARE(g_settings->outlineThickness.val, 0.123);
 
+    commandLineSettings = QString("--noddetail 0 --edgdetail 1.5").split(" ");
+    parseSettings(commandLineSettings);
+    QCOMPARE(g_settings->nodeDetailPixels.val, 0.0);
+    QCOMPARE(g_settings->edgeDetailPixels.val, 1.5);
+
     commandLineSettings = QString("--selcol tomato").split(" ");
     parseSettings(commandLineSettings);
     QCOMPARE(g_settings->selectionColour.name(), QString("#ff6347"));
@@ -1316,6 +2852,93 @@ void BandageTests::graphEdits()
 
 
 
+// Node store must mirror the graph and follow the edits
+void BandageTests::nodeStore()
+{
+    AssemblyGraph graph;
+    QVERIFY(graph.loadGraphFromFile(testFile("test.gfa")));
+
+    auto store = graph.nodeStore();
+    QVERIFY(store == graph.nodeStore());
+    QCOMPARE(store->size(), graph.m_deBruijnGraphNodes.size());
+    for (auto *node : graph.m_deBruijnGraphNodes) {
+        auto id = store->id(node);
+        QVERIFY(id != graph::NodeStore::InvalidId);
+        QCOMPARE(store->node(id), node);
+        QCOMPARE(store->node(graph::NodeStore::reverseComplement(id)), node->getReverseComplement());
+        QCOMPARE(QString::fromStdString(store->name(id)), node->getName());
+        QCOMPARE(store->find(node->getName().toStdString()), id);
+        QCOMPARE(store->length(id), node->getLength());
+        QCOMPARE(store->depth(id), float(node->getDepth()));
+        QCOMPARE(store->isNegative(id), node->isNegativeNode());
+        QCOMPARE(store->sequenceIsMissing(id), node->sequenceIsMissing());
+    }
+    QCOMPARE(store->find("no_such_node+"), graph::NodeStore::InvalidId);
+    QCOMPARE(store->find("1"), graph::NodeStore::InvalidId);
+
+    // The name of the node pair is interned once
+    auto id = store->find("1+");
+    QVERIFY(store->baseName(id).data() == store->baseName(graph::NodeStore::reverseComplement(id)).data());
+
+    // Snapshots taken before an edit stay valid and unchanged
+    auto before = store;
+    graph.changeNodeName("1", "renamed");
+    store = graph.nodeStore();
+    QVERIFY(store != before);
+    QVERIFY(before->find("1+") != graph::NodeStore::InvalidId);
+    QCOMPARE(store->find("1+"), graph::NodeStore::InvalidId);
+    QVERIFY(store->find("renamed-") != graph::NodeStore::InvalidId);
+
+    size_t nodeCount = store->size();
+    graph.deleteNodes({ graph.m_deBruijnGraphNodes.at("renamed+") });
+    QCOMPARE(graph.nodeStore()->size(), nodeCount - 2);
+}
+
+// CSR snapshot must mirror the node edges and follow the edits
+void BandageTests::adjacency()
+{
+    AssemblyGraph graph;
+    QVERIFY(graph.loadGraphFromFile(testFile("test.gfa")));
+
+    auto adjacency = graph.adjacency();
+    const graph::NodeStore &store = adjacency->nodes();
+    QVERIFY(&store == graph.nodeStore().get());
+    QCOMPARE(adjacency->nodeCount(), store.size());
+    QCOMPARE(adjacency->edgeCount(), graph.m_deBruijnGraphEdges.size());
+    for (auto *node : graph.m_deBruijnGraphNodes) {
+        auto id = store.id(node);
+
+        std::vector<DeBruijnEdge *> leaving, entering;
+        for (auto edge : adjacency->outEdges(id)) {
+            QCOMPARE(adjacency->source(edge), id);
+            QCOMPARE(adjacency->id(adjacency->edge(edge)), edge);
+            leaving.push_back(adjacency->edge(edge));
+        }
+        for (auto edge : adjacency->inEdges(id))
+            entering.push_back(adjacency->edge(edge));
+        QVERIFY(leaving == node->getLeavingEdges());
+        QVERIFY(entering == node->getEnteringEdges());
+
+        std::vector<DeBruijnNode *> downstream, upstream;
+        for (auto next : adjacency->outNodes(id))
+            downstream.push_back(store.node(next));
+        for (auto prev : adjacency->inNodes(id))
+            upstream.push_back(store.node(prev));
+        QVERIFY(downstream == node->getDownstreamNodes());
+        QVERIFY(upstream == node->getUpstreamNodes());
+    }
+
+    size_t edgeCount = adjacency->edgeCount();
+    auto before = adjacency;
+    graph.createDeBruijnEdge("1+", "2+");
+    adjacency = graph.adjacency();
+    QCOMPARE(before->edgeCount(), edgeCount);
+    QCOMPARE(adjacency->edgeCount(), edgeCount + 2);
+    auto from = adjacency->nodes().find("1+"), to = adjacency->nodes().find("2+");
+    auto outNodes = adjacency->outNodes(from);
+    QVERIFY(std::find(outNodes.begin(), outNodes.end(), to) != outNodes.end());
+}
+
 void BandageTests::fastgToGfa()
 {
     //First load the graph as a FASTG and pull out some information and a
@@ -1427,6 +3050,71 @@ void BandageTests::mergeNodesOnGfa()
 
 
 
+void BandageTests::compactGraph()
+{
+    AssemblyGraph graph;
+    QVERIFY(graph.loadGraphFromFile(testFile("test.fastg")));
+
+    // The graph has no non-branching paths, removing some nodes makes them
+    QVERIFY(graph::findChains(graph).empty());
+    graph.deleteNodes({ graph.m_deBruijnGraphNodes["8+"],
+                        graph.m_deBruijnGraphNodes["13+"],
+                        graph.m_deBruijnGraphNodes["24+"] });
+    QCOMPARE(graph.m_deBruijnGraphNodes.size(), 82);
+    QCOMPARE(graph.m_deBruijnGraphEdges.size(), 106);
+
+    // Merged sequences must be the path sequences of the chains
+    std::vector<graph::Chain> chains = graph::findChains(graph);
+    QCOMPARE(chains.size(), 5);
+    std::vector<QByteArray> pathSequences;
+    size_t chainNodes = 0;
+    for (const auto &chain : chains) {
+        std::vector<DeBruijnNode *> nodes;
+        for (graph::NodeStore::Id id : chain)
+            nodes.push_back(graph.nodeStore()->node(id));
+        Path path = Path::makeFromOrderedNodes(nodes, false);
+        QVERIFY(!path.isEmpty());
+        pathSequences.push_back(path.getPathSequence());
+        chainNodes += chain.size();
+    }
+
+    for (int threads : { 1, 4 }) {
+        g_settings->threads = threads;
+        std::vector<graph::Unitig> unitigs = graph::buildUnitigs(graph, chains);
+        QCOMPARE(unitigs.size(), chains.size());
+        for (size_t i = 0; i < unitigs.size(); ++i) {
+            QCOMPARE(unitigs[i].sequence, Sequence(pathSequences[i]));
+            QCOMPARE(unitigs[i].depth, AssemblyGraph::getMeanDepth(unitigs[i].nodes));
+        }
+    }
+
+    // Cancelled builds return nothing, progress counts the built chains
+    std::atomic<bool> cancelled = true;
+    std::atomic<size_t> built = 0;
+    QVERIFY(graph::buildUnitigs(graph, chains, &cancelled, &built).empty());
+    QCOMPARE(built.load(), size_t(0));
+    cancelled = false;
+    QCOMPARE(graph::buildUnitigs(graph, chains, &cancelled, &built).size(), chains.size());
+    QCOMPARE(built.load(), chains.size());
+
+    // Only the edges inside the chains go away
+    size_t nodeCount = graph.m_deBruijnGraphNodes.size(), edgeCount = graph.m_deBruijnGraphEdges.size();
+    QCOMPARE(graph.mergeAllPossible(), int(chains.size()));
+    QCOMPARE(graph.m_deBruijnGraphNodes.size(), nodeCount - 2 * (chainNodes - chains.size()));
+    QCOMPARE(graph.m_deBruijnGraphEdges.size(), edgeCount - 2 * (chainNodes - chains.size()));
+    QCOMPARE(graph.m_deBruijnGraphNodes.size(), 70);
+    QCOMPARE(graph.m_deBruijnGraphEdges.size(), 94);
+
+    // Nothing is left to merge and the edges are consistent
+    QVERIFY(graph::findChains(graph).empty());
+    for (const auto &entry : graph.m_deBruijnGraphEdges) {
+        const DeBruijnEdge *edge = entry.second;
+        QVERIFY(graph.m_deBruijnGraphNodes.count(edge->getStartingNode()->getName().toStdString()));
+        QVERIFY(graph.m_deBruijnGraphNodes.count(edge->getEndingNode()->getName().toStdString()));
+        QCOMPARE(edge->getReverseComplement()->getReverseComplement(), edge);
+    }
+}
+
 void BandageTests::changeNodeNames()
 {
     QVERIFY(g_assemblyGraph->first()->loadGraphFromFile(testFile("test.fastg")));
@@ -1671,6 +3359,45 @@ void BandageTests::bandageInfo()
     QCOMPARE(30959, largestComponentLength);
 }
 
+// Statistics engine must agree with the individual graph getters
+void BandageTests::graphStatistics()
+{
+    for (const char *fileName : { "test.fastg", "test.Trinity.fasta", "test.gfa", "test_plasmids.gfa" }) {
+        AssemblyGraph graph;
+        QVERIFY(graph.loadGraphFromFile(testFile(fileName)));
+
+        int n50 = 0, shortestNode = 0, firstQuartile = 0, median = 0, thirdQuartile = 0, longestNode = 0;
+        int componentCount = 0, largestComponentLength = 0;
+        graph.getNodeStats(&n50, &shortestNode, &firstQuartile, &median, &thirdQuartile, &longestNode);
+        graph.getGraphComponentCountAndLargestComponentSize(&componentCount, &largestComponentLength);
+        QPair<int, int> overlapRange = graph.getOverlapRange();
+        double medianDepthByBase = graph.getMedianDepthByBase();
+
+        for (int threads : { 1, 4 }) {
+            g_settings->threads = threads;
+            graph::Statistics stats = graph::computeStatistics(graph);
+            QCOMPARE(stats.nodeCount, graph.m_nodeCount);
+            QCOMPARE(stats.edgeCount, graph.m_edgeCount);
+            QCOMPARE(stats.smallestOverlap, overlapRange.first);
+            QCOMPARE(stats.largestOverlap, overlapRange.second);
+            QCOMPARE(stats.totalLength, graph.m_totalLength);
+            QCOMPARE(stats.totalLengthNoOverlaps, graph.getTotalLengthMinusEdgeOverlaps());
+            QCOMPARE(stats.deadEnds, graph.getDeadEndCount());
+            QCOMPARE(stats.componentCount, componentCount);
+            QCOMPARE(stats.largestComponentLength, (long long)largestComponentLength);
+            QCOMPARE(stats.totalLengthOrphanedNodes, graph.getTotalLengthOrphanedNodes());
+            QCOMPARE(stats.n50, n50);
+            QCOMPARE(stats.shortestNode, shortestNode);
+            QCOMPARE(stats.firstQuartile, firstQuartile);
+            QCOMPARE(stats.median, median);
+            QCOMPARE(stats.thirdQuartile, thirdQuartile);
+            QCOMPARE(stats.longestNode, longestNode);
+            QCOMPARE(stats.medianDepthByBase, medianDepthByBase);
+            QCOMPARE(stats.estimatedSequenceLength, graph.getEstimatedSequenceLength(medianDepthByBase));
+        }
+    }
+}
+
 void BandageTests::sequenceInit() {
     Sequence sequenceFromString{"ATGC"};
     Sequence sequenceFromQByteArray{QByteArray{"ATGC"}};
@@ -1695,6 +3422,33 @@ void BandageTests::sequenceInitN() {
     QCOMPARE(sequenceFromStringLower, sequenceFromQByteArray);
 }
 
+// Sequences of unknown nucleotides must not allocate any storage
+void BandageTests::sequenceAllNs() {
+    Sequence sequence(size_t(3) << 30, /* allNs */ true);
+    QCOMPARE(sequence.size(), size_t(3) << 30);
+    QCOMPARE(sequence.capacity(), size_t(0));
+    QVERIFY(sequence.missing());
+    QCOMPARE(sequence[0], 'N');
+    QCOMPARE(sequence[sequence.size() - 1], 'N');
+
+    Sequence rc = sequence.GetReverseComplement();
+    QVERIFY(rc.missing());
+    QCOMPARE(rc[12345], 'N');
+
+    Sequence subseq = sequence.Subseq(100, 110);
+    QCOMPARE(QString::fromStdString(subseq.str()), QString(10, 'N'));
+    QCOMPARE(QString::fromStdString(subseq.GetReverseComplement().str()), QString(10, 'N'));
+    QCOMPARE(rc.Subseq(5, 10), Sequence("NNNNN"));
+
+    std::vector<uint64_t> words;
+    std::vector<uint32_t> nRuns;
+    sequence.Pack(words, nRuns);
+    QVERIFY(words.empty());
+    Sequence unpacked(sequence.size(), words.data(), nRuns.data(), nRuns.size() / 2);
+    QCOMPARE(unpacked.capacity(), size_t(0));
+    QVERIFY(unpacked.missing());
+}
+
 void BandageTests::sequenceAccess() {
     Sequence sequence{"ATGCN"};
 
@@ -1740,6 +3494,18 @@ void BandageTests::sequenceSubstring() {
     QCOMPARE(rcSubstr[4], 'G');
 }
 
+void BandageTests::sequenceConcat() {
+    Sequence sequence{"ATGCNATGCN"};
+    std::vector<Sequence> parts = { sequence.Subseq(2, 7), Sequence(size_t(3), true), Sequence(),
+                                    sequence.GetReverseComplement().Subseq(1), Sequence("ACGTACGTACGTACGTACGTACGTACGTACGTA") };
+
+    Sequence concat = Sequence::Concat(parts);
+    QCOMPARE(concat.str(), std::string("GCNAT" "NNN" "GCATNGCAT" "ACGTACGTACGTACGTACGTACGTACGTACGTA"));
+    QCOMPARE(concat, Sequence("GCNATNNNGCATNGCATACGTACGTACGTACGTACGTACGTACGTACGTA"));
+    QCOMPARE(parts[0] + parts[3], Sequence("GCNATGCATNGCAT"));
+    QVERIFY(Sequence::Concat(std::vector<Sequence>{ Sequence(size_t(2), true), Sequence(size_t(3), true) }).missing());
+}
+
 void BandageTests::sequenceDoubleReverseComplement() {
     Sequence sequence{"ATGCNATGCN"};
 
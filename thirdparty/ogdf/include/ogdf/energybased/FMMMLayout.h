@@ -38,6 +38,8 @@
 #include <ogdf/energybased/fmmm/NewMultipoleMethod.h>
 #include <ogdf/energybased/fmmm/maar_packing/Rectangle.h>
 
+#include <atomic>
+
 namespace ogdf {
 
 /**
@@ -703,6 +705,11 @@ public:
 	//! Sets the precision for the multipole expansions to \p p.
 	void nmPrecision(int p) { m_NMPrecision = ((p >= 1) ? p : 1); }
 
+	//! Bandage: the force calculation stops once \p flag is set (it may be
+	//! set from any thread), the drawing is finished from the positions
+	//! reached so far.
+	void interruptFlag(const std::atomic<bool>* flag) { m_interruptFlag = flag; }
+
 	//! @}
 
 private:
@@ -772,6 +779,8 @@ private:
 	int m_NMParticlesInLeaves; //!< The maximal number of particles in a leaf.
 	int m_NMPrecision; //!< The precision for multipole expansions.
 
+	const std::atomic<bool>* m_interruptFlag = nullptr; //!< Bandage: stops the force calculation.
+
 	//other variables
 	double max_integer_position; //!< The maximum value for an integer position.
 	double cool_factor; //!< Needed for scaling the forces if coolTemperature is true.
@@ -799,6 +808,11 @@ private:
 	//! Returns true iff stopCriterion() is not met
 	bool running(int iter, int max_mult_iter, double actforcevectorlength);
 
+	//! Bandage: returns true iff the interrupt flag is set
+	bool interrupted() const {
+		return m_interruptFlag && m_interruptFlag->load(std::memory_order_relaxed);
+	}
+
 	//! Calls the force calculation step for \p G, \p A, \p E.
 	/**
 	 * If act_level is 0 and resizeDrawing is true the drawing is resized.
@@ -90,6 +90,10 @@ public:
 #endif
 	}
 
+	//! Bandage: the iterations stop once \p flag is set (it may be set from
+	//! any thread)
+	void setInterruptFlag(const std::atomic<bool>* flag) { m_interruptFlag = flag; }
+
 #if 0
 	void setEnablePostProcessing(bool b) { m_doPostProcessing = b; }
 #endif
@@ -129,6 +133,8 @@ private:
 	uint32_t m_numberOfThreads;
 
 	uint32_t m_maxNumberOfThreads;
+
+	const std::atomic<bool>* m_interruptFlag = nullptr;
 };
 
 //! The fast multipole multilevel embedder approach for force-directed multilevel layout.
@@ -152,6 +158,9 @@ public:
 
 	void maxNumThreads(int numThreads) { m_iMaxNumThreads = numThreads; }
 
+	//! Bandage: the iterations of every level stop once \p flag is set
+	void interruptFlag(const std::atomic<bool>* flag) { m_interruptFlag = flag; }
+
 private:
 	//! internal function to compute a good edgelength
 	void computeAutoEdgeLength(const GraphAttributes& GA, EdgeArray<float>& edgeLength,
@@ -209,6 +218,8 @@ private:
 
 	NodeArray<float>* m_pLastNodeXPos = nullptr;
 	NodeArray<float>* m_pLastNodeYPos = nullptr;
+
+	const std::atomic<bool>* m_interruptFlag = nullptr;
 };
 
 }
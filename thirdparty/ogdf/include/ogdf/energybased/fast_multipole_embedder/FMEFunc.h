@@ -38,6 +38,7 @@
 #include <ogdf/energybased/fast_multipole_embedder/LinearQuadtreeExpansion.h>
 #include <ogdf/energybased/fast_multipole_embedder/WSPD.h>
 
+#include <atomic>
 #include <list>
 
 namespace ogdf {
@@ -84,6 +85,8 @@ struct FMEGlobalOptions {
 	double stopCritConstSq; //!< stopping criteria
 
 	uint32_t multipolePrecision;
+
+	const std::atomic<bool>* interruptFlag; //!< Bandage: stops the iterations once set
 };
 
 
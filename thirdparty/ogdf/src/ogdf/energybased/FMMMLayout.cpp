@@ -161,6 +161,9 @@ void FMMMLayout::call_MULTILEVEL_step_for_subGraph(Graph& G, NodeArray<NodeAttri
 
 bool FMMMLayout::running(int iter, int max_mult_iter, double actforcevectorlength) {
 	const int ITERBOUND = 10000;
+	if (interrupted()) {
+		return false;
+	}
 	switch (stopCriterion()) {
 	case FMMMOptions::StopCriterion::FixedIterations:
 		return iter <= max_mult_iter;
@@ -207,7 +210,7 @@ void FMMMLayout::call_FORCE_CALCULATION_step(Graph& G, NodeArray<NodeAttributes>
 void FMMMLayout::call_POSTPROCESSING_step(Graph& G, NodeArray<NodeAttributes>& A,
 		EdgeArray<EdgeAttributes>& E, NodeArray<DPoint>& F, NodeArray<DPoint>& F_attr,
 		NodeArray<DPoint>& F_rep, NodeArray<DPoint>& last_node_movement) {
-	for (int i = 1; i <= 10; i++) {
+	for (int i = 1; i <= 10 && !interrupted(); i++) {
 		calculate_forces(G, A, E, F, F_attr, F_rep, last_node_movement, i, 1);
 	}
 
@@ -216,7 +219,7 @@ void FMMMLayout::call_POSTPROCESSING_step(Graph& G, NodeArray<NodeAttributes>& A
 		update_boxlength_and_cornercoordinate(G, A);
 	}
 
-	for (int i = 1; i <= fineTuningIterations(); i++) {
+	for (int i = 1; i <= fineTuningIterations() && !interrupted(); i++) {
 		calculate_forces(G, A, E, F, F_attr, F_rep, last_node_movement, i, 2);
 	}
 
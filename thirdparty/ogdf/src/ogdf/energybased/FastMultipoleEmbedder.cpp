@@ -140,6 +140,7 @@ void FastMultipoleEmbedder::run(uint32_t numIterations) {
 	}
 
 	m_pOptions->maxNumIterations = numIterations;
+	m_pOptions->interruptFlag = m_interruptFlag;
 	m_pOptions->stopCritForce =
 			(((float)m_pGraph->numNodes()) * ((float)m_pGraph->numNodes()) * m_pGraph->avgNodeSize())
 			/ m_pOptions->stopCritConstSq;
@@ -211,6 +212,7 @@ void FastMultipoleMultilevelEmbedder::call(GraphAttributes& GA) {
 		fme.setNumberOfThreads(this->m_iMaxNumThreads);
 		fme.setRandomize(true);
 		fme.setNumIterations(500);
+		fme.setInterruptFlag(m_interruptFlag);
 		fme.call(GA);
 		return;
 	}
@@ -373,6 +375,7 @@ void FastMultipoleMultilevelEmbedder::layoutCurrentLevel() {
 	fme.setNumberOfThreads(this->m_iMaxNumThreads);
 	fme.setRandomize(m_iCurrentLevelNr == (m_iNumLevels - 1));
 	fme.setNumIterations(numberOfIterationsByLevelNr(m_iCurrentLevelNr));
+	fme.setInterruptFlag(m_interruptFlag);
 	fme.call((*m_pCurrentGraph), (*m_pCurrentNodeXPos), (*m_pCurrentNodeYPos),
 			(*m_pCurrentEdgeLength), (*m_pCurrentNodeSize));
 }
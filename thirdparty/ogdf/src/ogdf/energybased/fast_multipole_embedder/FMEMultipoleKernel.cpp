@@ -531,6 +531,11 @@ void FMEMultipoleKernel::operator()(FMEGlobalContext* globalContext) {
 					&& (maxForceSq < globalContext->pOptions->stopCritForce)) {
 				globalContext->earlyExit = true;
 			}
+			// Bandage: interrupted layouts keep the positions reached so far
+			const std::atomic<bool>* interruptFlag = globalContext->pOptions->interruptFlag;
+			if (interruptFlag && interruptFlag->load(std::memory_order_relaxed)) {
+				globalContext->earlyExit = true;
+			}
 		}
 		// this is required to wait for the earlyExit result
 		sync();
@@ -15,6 +15,7 @@
 #include <llvm/ADT/SparseBitVector.h>
 #include <llvm/Support/TrailingObjects.h>
 
+#include <algorithm>
 #include <vector>
 #include <string>
 #include <memory>
@@ -41,7 +42,7 @@ class Sequence {
 
         ManagedNuclBuffer() {}
 
-        ManagedNuclBuffer(size_t nucls, ST *buf) {
+        ManagedNuclBuffer(size_t nucls, const ST *buf) {
             std::uninitialized_copy(buf, buf + Sequence::DataSize(nucls), data());
         }
 
@@ -53,7 +54,7 @@ class Sequence {
             return new (mem) ManagedNuclBuffer();
         }
 
-        static ManagedNuclBuffer *create(size_t nucls, ST *data) {
+        static ManagedNuclBuffer *create(size_t nucls, const ST *data) {
             void *mem = ::operator new(totalSizeToAlloc<ST>(Sequence::DataSize(nucls)));
             return new (mem) ManagedNuclBuffer(nucls, data);
         }
@@ -62,6 +63,8 @@ class Sequence {
         ST *data() { return getTrailingObjects<ST>(); }
 
         std::unique_ptr<llvm::SparseBitVector<>> empty_nucls_ = nullptr;
+        // Sequence of unknown nucleotides, no storage is allocated
+        bool all_ns_ = false;
     };
 
     size_t size_ : 32;
@@ -149,7 +152,7 @@ class Sequence {
 
     bool isEmptySymbol(size_t idx) const {
         if (LLVM_LIKELY(data_->empty_nucls_ == nullptr)) {
-            return false;
+            return LLVM_UNLIKELY(data_->all_ns_);
         }
         return data_->empty_nucls_->test(idx);
     }
@@ -160,6 +163,8 @@ class Sequence {
     }
 
     bool emptyNuclsEqual(const Sequence &that) const {
+        if (data_->all_ns_ != that.data_->all_ns_)
+            return false;
         return data_->empty_nucls_ == that.data_->empty_nucls_
             || (data_->empty_nucls_ != nullptr
                 && that.data_->empty_nucls_ != nullptr
@@ -171,13 +176,13 @@ class Sequence {
             : size_(size), from_(from), rtl_(rtl), data_(seq.data_) {}
 
 public:
+    /**
+     * Sequence of given size. Sequence of Ns (unknown nucleotides) does not
+     * allocate any storage.
+     */
     explicit Sequence(size_t size, bool allNs = false)
-            : size_(size), from_(0), rtl_(false), data_(ManagedNuclBuffer::create(size_)) {
-        if (allNs) {
-            data_->empty_nucls_ = std::make_unique<llvm::SparseBitVector<>>();
-            for (size_t i = from_; i < size_; ++i)
-                data_->empty_nucls_->set(i);
-        }
+            : size_(size), from_(0), rtl_(false), data_(ManagedNuclBuffer::create(allNs ? 0 : size_)) {
+        data_->all_ns_ = allNs;
     }
 
     /**
@@ -213,6 +218,28 @@ public:
 
     Sequence(Sequence &&) = default;
 
+    /**
+     * Sequence initialization from already packed data (as produced by Pack)
+     *
+     * @param words 2-bit packed nucleotides, DataSize(size) words
+     * @param nRuns (start, length) pairs of N runs
+     */
+    Sequence(size_t size, const uint64_t *words,
+             const uint32_t *nRuns = nullptr, size_t nRunCount = 0)
+            : Sequence(size, PackedSize(size, nRuns, nRunCount) == 0 && size > 0) {
+        if (data_->all_ns_ || !size)
+            return;
+
+        std::uninitialized_copy(words, words + DataSize(size), data_->data());
+        if (!nRunCount)
+            return;
+
+        data_->empty_nucls_ = std::make_unique<llvm::SparseBitVector<>>();
+        for (size_t i = 0; i < nRunCount; ++i)
+            for (size_t j = nRuns[2 * i], e = j + nRuns[2 * i + 1]; j < e; ++j)
+                data_->empty_nucls_->set(j);
+    }
+
     Sequence &operator=(const Sequence &rhs) {
         if (&rhs == this)
             return *this;
@@ -280,6 +307,25 @@ public:
         return {*this, from_, size_, !rtl_};
     }
 
+    /**
+     * Appends the sequence in packed form: 2-bit nucleotides (DataSize(size())
+     * words, unused bits are zero) and (start, length) pairs of N runs.
+     * Sequences of Ns only are packed as a single run without any words.
+     */
+    inline void Pack(std::vector<uint64_t> &words, std::vector<uint32_t> &nRuns) const;
+
+    // Number of words of packed sequence with given N runs
+    static size_t PackedSize(size_t size, const uint32_t *nRuns, size_t nRunCount) {
+        if (nRunCount == 1 && nRuns[0] == 0 && nRuns[1] == size)
+            return 0;
+        return DataSize(size);
+    }
+
+    // Whether the sequence is the reverse complement of that one sharing the same storage
+    bool IsReverseComplementView(const Sequence &that) const {
+        return data_ == that.data_ && from_ == that.from_ && size_ == that.size_ && rtl_ != that.rtl_;
+    }
+
     inline Sequence operator<<(char c) const;
 
     /**
@@ -292,6 +338,13 @@ public:
 
     inline Sequence operator+(const Sequence &s) const;
 
+    /**
+     * Concatenation of any number of sequences, packed directly without
+     * going through a string
+     */
+    template<class Range>
+    static Sequence Concat(const Range &parts);
+
     inline Sequence First(size_t count) const;
 
     inline Sequence Last(size_t count) const;
@@ -313,7 +366,7 @@ public:
     }
 
     size_t capacity() const {
-        return DataSize(size_) * sizeof(ST);
+        return data_->all_ns_ ? 0 : DataSize(size_) * sizeof(ST);
     }
 
     bool empty() const {
@@ -321,6 +374,9 @@ public:
     }
 
     bool missing() const {
+        if (data_->all_ns_)
+            return true;
+
         // No N's - nothing is missed
         if (!data_->empty_nucls_)
             return false;
@@ -392,21 +448,94 @@ size_t Sequence::find(const Sequence &t, size_t from) const {
     return -1ULL;
 }
 
-/**
- * @todo optimize
- */
 Sequence Sequence::operator+(const Sequence &s) const {
-    return Sequence(str() + s.str());
-    // TODO might be opposite to correct
-    //    int total = size_ + s.size_;
-    //    std::vector<Seq<4> > bytes((total + 3) >> 2);
-    //    for (size_t i = 0; i < size_; ++i) {
-    //        bytes[i / 4] = (bytes[i / 4] << operator [](i)); // TODO :-) use <<=
-    //    }
-    //    for (size_t i = 0, j = size_; i < s.size_; ++i, ++j) {
-    //        bytes[j / 4] = (bytes[j / 4]) << s[i];
-    //    }
-    //    return Sequence(new Data(bytes), 0, total, false);
+    const Sequence parts[] = {*this, s};
+    return Concat(parts);
+}
+
+template<class Range>
+Sequence Sequence::Concat(const Range &parts) {
+    size_t size = 0;
+    bool allNs = true;
+    for (const Sequence &part : parts) {
+        size += part.size_;
+        allNs = allNs && (part.size_ == 0 || part.data_->all_ns_);
+    }
+    if (allNs && size > 0)
+        return Sequence(size, true);
+
+    Sequence res(size);
+    ST *bytes = res.data_->data();
+    std::fill(bytes, bytes + DataSize(size), ST(0));
+
+    size_t pos = 0;
+    for (const Sequence &part : parts) {
+        for (size_t i = 0; i < part.size_; ++i, ++pos) {
+            size_t idx = part.rtl_ ? part.from_ + part.size_ - 1 - i : part.from_ + i;
+            if (LLVM_UNLIKELY(part.isEmptySymbol(idx))) {
+                if (res.data_->empty_nucls_ == nullptr)
+                    res.data_->empty_nucls_ = std::make_unique<llvm::SparseBitVector<>>();
+                res.data_->empty_nucls_->set(unsigned(pos));
+                continue;
+            }
+
+            char c = part.getNuclFromBuffer(idx);
+            if (part.rtl_)
+                c = complement(c);
+            bytes[pos >> STNBits] |= ST(c) << ((pos & (STN - 1)) << 1);
+        }
+    }
+
+    return res;
+}
+
+void Sequence::Pack(std::vector<uint64_t> &words, std::vector<uint32_t> &nRuns) const {
+    size_t runsStart = nRuns.size();
+    if (data_->all_ns_) {
+        if (size_) {
+            nRuns.push_back(0);
+            nRuns.push_back(uint32_t(size_));
+        }
+    } else if (LLVM_UNLIKELY(data_->empty_nucls_ != nullptr)) {
+        std::vector<uint32_t> ns;
+        for (unsigned idx : *data_->empty_nucls_) {
+            if (idx < from_ || idx >= from_ + size_)
+                continue;
+            ns.push_back(rtl_ ? uint32_t(from_ + size_ - 1 - idx) : uint32_t(idx - from_));
+        }
+        if (rtl_)
+            std::reverse(ns.begin(), ns.end());
+
+        for (size_t i = 0; i < ns.size();) {
+            size_t j = i + 1;
+            while (j < ns.size() && ns[j] == ns[j - 1] + 1)
+                ++j;
+            nRuns.push_back(ns[i]);
+            nRuns.push_back(uint32_t(j - i));
+            i = j;
+        }
+    }
+
+    size_t count = PackedSize(size_, nRuns.data() + runsStart, (nRuns.size() - runsStart) / 2);
+    if (!count)
+        return;
+
+    size_t start = words.size();
+    words.resize(start + count);
+    ST *out = words.data() + start;
+
+    if (!rtl_ && (from_ & (STN - 1)) == 0) {
+        // Aligned forward view: the storage words could be taken as-is
+        memcpy(out, data_->data() + (from_ >> STNBits), count * sizeof(ST));
+        if (size_t tail = size_ & (STN - 1))
+            out[count - 1] &= (ST(1) << (tail << 1)) - 1;
+    } else {
+        std::fill(out, out + count, ST(0));
+        for (size_t i = 0; i < size_; ++i) {
+            char c = rtl_ ? complement(getNuclFromBuffer(from_ + size_ - 1 - i)) : getNuclFromBuffer(from_ + i);
+            out[i >> STNBits] |= ST(c) << ((i & (STN - 1)) << 1);
+        }
+    }
 }
 
 std::string Sequence::str() const {
@@ -22,6 +22,7 @@
 #include "graph/debruijnedge.h"
 #include "graph/graphicsitemnode.h"
 #include "graph/graphicsitemedgecommon.h"
+#include "graph/graphicsitembatch.h"
 #include "layout/graphlayout.h"
 #include "program/settings.h"
 #include "features_forest/assemblyfeaturesforest.h"
@@ -32,6 +33,11 @@
 #include "hic/hicmanager.h"
 #include "painting/textgraphicsitemnode.h"
 
+#include <QGraphicsSceneMouseEvent>
+#include <QGraphicsView>
+#include <QStyleOptionGraphicsItem>
+
+#include <algorithm>
 #include <unordered_set>
 
 BandageGraphicsScene::BandageGraphicsScene(QObject *parent) :
@@ -66,6 +72,9 @@ std::vector<DeBruijnNode *> BandageGraphicsScene::getSelectedNodes() {
     for (auto *selectedItem : selectedItems())
         if (auto *selectedNodeItem = dynamic_cast<GraphicsItemNode *>(selectedItem))
             returnVector.push_back(selectedNodeItem->m_deBruijnNode);
+    for (auto *batch : m_batches)
+        for (auto *selectedNodeItem : batch->selectedNodes())
+            returnVector.push_back(selectedNodeItem->m_deBruijnNode);
 
     std::sort(returnVector.begin(), returnVector.end(), compareNodePointers);
 
@@ -94,6 +103,10 @@ std::vector<GraphicsItemNode *> BandageGraphicsScene::getSelectedGraphicsItemNod
     for (auto *selectedItem : selectedItems())
         if (auto * selectedNodeItem = dynamic_cast<GraphicsItemNode *>(selectedItem))
             returnVector.push_back(selectedNodeItem);
+    for (auto *batch : m_batches) {
+        std::vector<GraphicsItemNode *> batchedNodes = batch->selectedNodes();
+        returnVector.insert(returnVector.end(), batchedNodes.begin(), batchedNodes.end());
+    }
 
     return returnVector;
 }
@@ -229,6 +242,20 @@ void BandageGraphicsScene::addGraphicsItemsToScene(AssemblyGraph &graph,
 
     double meanDrawnDepth = graph.getMeanDepth(true);
 
+    // Very large graphs are drawn by a single batch item instead of adding
+    // each node and edge to the scene
+    bool batched = g_settings->batchedSceneNodes > 0 &&
+                   graph.getDrawnNodeCount() >= g_settings->batchedSceneNodes;
+    std::vector<GraphicsItemNode *> batchedNodes;
+    std::vector<GraphicsItemEdge *> batchedEdges;
+
+    // The batch keeps its own R-tree, and the items promoted out of it are
+    // few enough to be scanned, so the scene does without its BSP index
+    if (batched)
+        setItemIndexMethod(QGraphicsScene::NoIndex);
+    else if (m_batches.empty())
+        setItemIndexMethod(QGraphicsScene::BspTreeIndex);
+
     // First make the GraphicsItemNode objects
     for (auto &entry : layout) {
         DeBruijnNode *node = entry.first;
@@ -274,7 +301,10 @@ void BandageGraphicsScene::addGraphicsItemsToScene(AssemblyGraph &graph,
         auto * graphicsItemEdge = new GraphicsItemEdge(edge);
         edge->setGraphicsItemEdge(graphicsItemEdge);
         graphicsItemEdge->setFlag(QGraphicsItem::ItemIsSelectable);
-        addItem(graphicsItemEdge);
+        if (batched)
+            batchedEdges.push_back(graphicsItemEdge);
+        else
+            addItem(graphicsItemEdge);
     }
 
     // Then make the GraphicsItemHiCEdge objects and add them to the scene first,
@@ -296,7 +326,15 @@ void BandageGraphicsScene::addGraphicsItemsToScene(AssemblyGraph &graph,
         if (!node->hasGraphicsItem())
             continue;
         GraphicsItemNode * graphicsItemNode = node->getGraphicsItemNode();
-        addItem(graphicsItemNode);
+        if (batched)
+            batchedNodes.push_back(graphicsItemNode);
+        else
+            addItem(graphicsItemNode);
+    }
+    if (batched) {
+        auto *batch = new GraphicsItemBatch(batchedNodes, batchedEdges);
+        m_batches.push_back(batch);
+        addItem(batch);
     }
     //Add graph name to the scene if need
     if (!graph.m_graphName.isEmpty()) {
@@ -336,6 +374,21 @@ void BandageGraphicsScene::removeGraphicsItemEdges(const std::vector<DeBruijnEdg
         }
     }
 
+    // Batched edges are not in the scene, their batch just forgets them
+    for (auto it = graphicsItemEdgesToDelete.begin(); it != graphicsItemEdgesToDelete.end();) {
+        GraphicsItemEdge *graphicsItemEdge = *it;
+        if (graphicsItemEdge->m_batch && !graphicsItemEdge->scene()) {
+            graphicsItemEdge->m_batch->remove(graphicsItemEdge);
+            delete graphicsItemEdge;
+            it = graphicsItemEdgesToDelete.erase(it);
+        } else {
+            // Promoted ones leave the batch tree as well
+            if (graphicsItemEdge->m_batch)
+                graphicsItemEdge->m_batch->remove(graphicsItemEdge);
+            ++it;
+        }
+    }
+
     // Nothing to do
     if (graphicsItemEdgesToDelete.empty())
         return;
@@ -380,6 +433,21 @@ void BandageGraphicsScene::removeGraphicsItemNodes(const std::vector<DeBruijnNod
         }
     }
 
+    // Batched nodes are not in the scene, their batch just forgets them
+    for (auto it = graphicsItemNodesToDelete.begin(); it != graphicsItemNodesToDelete.end();) {
+        GraphicsItemNode *graphicsItemNode = *it;
+        if (graphicsItemNode->m_batch && !graphicsItemNode->scene()) {
+            graphicsItemNode->m_batch->remove(graphicsItemNode);
+            delete graphicsItemNode;
+            it = graphicsItemNodesToDelete.erase(it);
+        } else {
+            // Promoted ones leave the batch tree as well
+            if (graphicsItemNode->m_batch)
+                graphicsItemNode->m_batch->remove(graphicsItemNode);
+            ++it;
+        }
+    }
+
     // Nothing to do
     if (graphicsItemNodesToDelete.empty())
         return;
@@ -408,6 +476,10 @@ void BandageGraphicsScene::duplicateGraphicsNode(DeBruijnNode * originalNode, De
     if (originalGraphicsItemNode == nullptr)
         return;
 
+    // The original is moved aside below, so it cannot stay batched
+    if (originalGraphicsItemNode->m_batch)
+        originalGraphicsItemNode->m_batch->promote(originalGraphicsItemNode);
+
     auto *newGraphicsItemNode = new GraphicsItemNode(newNode, originalGraphicsItemNode);
 
     newNode->setGraphicsItemNode(newGraphicsItemNode);
@@ -416,6 +488,8 @@ void BandageGraphicsScene::duplicateGraphicsNode(DeBruijnNode * originalNode, De
 
     originalGraphicsItemNode->shiftPointsLeft();
     newGraphicsItemNode->shiftPointsRight();
+    if (originalGraphicsItemNode->m_batch)
+        originalGraphicsItemNode->m_batch->moved(originalGraphicsItemNode);
     originalGraphicsItemNode->fixEdgePaths();
 
     addItem(newGraphicsItemNode);
@@ -429,6 +503,83 @@ void BandageGraphicsScene::duplicateGraphicsNode(DeBruijnNode * originalNode, De
     }
 }
 
+void BandageGraphicsScene::selectBatchedNodes(const QPolygonF &area) {
+    bool changed = false;
+    for (auto *batch : m_batches)
+        changed |= batch->select(area);
+    if (changed)
+        emit selectionChanged();
+}
+
+void BandageGraphicsScene::clearSelection() {
+    if (clearBatchedSelection())
+        emit selectionChanged();
+    QGraphicsScene::clearSelection();
+}
+
+void BandageGraphicsScene::invertBatchedSelection() {
+    bool changed = false;
+    for (auto *batch : m_batches)
+        changed |= batch->invertSelection();
+    if (changed)
+        emit selectionChanged();
+}
+
+bool BandageGraphicsScene::clearBatchedSelection() {
+    bool changed = false;
+    for (auto *batch : m_batches)
+        changed |= batch->clearSelection();
+    return changed;
+}
+
+void BandageGraphicsScene::forgetBatch(GraphicsItemBatch *batch) {
+    m_batches.erase(std::remove(m_batches.begin(), m_batches.end(), batch), m_batches.end());
+}
+
+// A batched node or edge under the cursor is promoted to a scene item first,
+// so the scene can select and drag it as usual. The scene only clears the
+// selection of its own items, so the batched nodes are deselected here when
+// the click does the same: outside the selection and without Ctrl.
+void BandageGraphicsScene::mousePressEvent(QGraphicsSceneMouseEvent *event) {
+    if (!m_batches.empty()) {
+        // A couple of pixels of tolerance
+        double tolerance = 2.0;
+        QTransform viewTransform;
+        if (auto *view = event->widget() ? qobject_cast<QGraphicsView *>(event->widget()->parentWidget()) : nullptr) {
+            viewTransform = view->transform();
+            double lod = QStyleOptionGraphicsItem::levelOfDetailFromTransform(viewTransform);
+            if (lod > 0.0)
+                tolerance /= lod;
+        }
+
+        for (auto it = m_batches.rbegin(); it != m_batches.rend(); ++it) {
+            if (QGraphicsItem *item = (*it)->itemAt(event->scenePos(), tolerance)) {
+                (*it)->promote(item);
+                break;
+            }
+        }
+
+        QGraphicsItem *clickedItem = itemAt(event->scenePos(), viewTransform);
+        if (event->button() == Qt::LeftButton && !(event->modifiers() & Qt::ControlModifier) &&
+            !(clickedItem && clickedItem->isSelected()) && clearBatchedSelection())
+            emit selectionChanged();
+    }
+
+    QGraphicsScene::mousePressEvent(event);
+}
+
+// Dragging the selection drags the selected batched nodes too, so they join
+// the scene first.
+void BandageGraphicsScene::mouseMoveEvent(QGraphicsSceneMouseEvent *event) {
+    QGraphicsItem *grabber = mouseGrabberItem();
+    if ((event->buttons() & Qt::LeftButton) && grabber && grabber->isSelected()) {
+        for (auto *batch : m_batches)
+            batch->promoteSelected();
+    }
+
+    QGraphicsScene::mouseMoveEvent(event);
+}
+
 //This function returns all of the selected nodes, sorted by their node number.
 std::vector<FeatureTreeNode *> BandageGraphicsScene::getSelectedFeatureNodes()
 {
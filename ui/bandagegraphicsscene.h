@@ -21,6 +21,7 @@
 #include "layout/featureslayout.h"
 
 #include <QGraphicsScene>
+#include <QPolygonF>
 #include <vector>
 #include <unordered_set>
 
@@ -28,6 +29,7 @@ class DeBruijnNode;
 class DeBruijnEdge;
 class GraphicsItemNode;
 class GraphicsItemEdge;
+class GraphicsItemBatch;
 class AssemblyGraph;
 class AssemblyFeaturesForest;
 class GraphicsItemFeatureNode;
@@ -70,7 +72,26 @@ public:
     std::vector<FeatureTreeNode *> getSelectedFeatureNodes();
     void possiblyExpandSceneRectangle(TextGraphicsItemNode * movedText);
 
+    // Select the batched nodes (see GraphicsItemBatch) with a line point in
+    // the area. They stay batched until they are clicked or dragged, nodes
+    // that are in the scene are selected as usual
+    void selectBatchedNodes(const QPolygonF &area);
+    void invertBatchedSelection();
+    void forgetBatch(GraphicsItemBatch *batch);
+
+    // Hides QGraphicsScene::clearSelection() to deselect the batched nodes too
+    void clearSelection();
+
+protected:
+    void mousePressEvent(QGraphicsSceneMouseEvent *event) override;
+    void mouseMoveEvent(QGraphicsSceneMouseEvent *event) override;
+
 private:
+    std::vector<GraphicsItemBatch *> m_batches;
+
+    // Returns whether any batched node was selected
+    bool clearBatchedSelection();
+
     void removeGraphicsItemNodes(const std::unordered_set<GraphicsItemNode*> &nodes);
     void removeGraphicsItemEdges(const std::unordered_set<GraphicsItemEdge*> &edges);
 };
@@ -17,6 +17,7 @@
 
 
 #include "bandagegraphicsview.h"
+#include "bandagegraphicsscene.h"
 #include "graph/graphicsitemnode.h"
 #include "program/globals.h"
 #include "program/settings.h"
@@ -55,7 +56,15 @@ void BandageGraphicsView::mousePressEvent(QMouseEvent * event)
 
 void BandageGraphicsView::mouseReleaseEvent(QMouseEvent * event)
 {
+    //The rubber band only selects the items in the scene, the batched nodes
+    //inside it are selected separately.
+    QRect rubberBand = rubberBandRect();
     QGraphicsView::mouseReleaseEvent(event);
+    if (!rubberBand.isNull())
+    {
+        if (auto *bandageScene = dynamic_cast<BandageGraphicsScene *>(scene()))
+            bandageScene->selectBatchedNodes(mapToScene(rubberBand));
+    }
     setDragMode(QGraphicsView::RubberBandDrag);
     g_settings->nodeDragging = NEARBY_PIECES;
 }
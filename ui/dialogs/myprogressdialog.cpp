@@ -73,3 +73,26 @@ void MyProgressDialog::setValue(int value)
 {
     ui->progressBar->setValue(value);
 }
+
+void MyProgressDialog::setProgress(int value, int max)
+{
+    if (!m_progressTimer.isValid())
+        m_progressTimer.start();
+
+    ui->progressBar->setMaximum(max);
+    ui->progressBar->setValue(value);
+    if (value <= 0 || value >= max)
+        return;
+
+    qint64 remaining = qint64(double(m_progressTimer.elapsed()) * (max - value) / value / 1000.0);
+    QString remainingText;
+    if (remaining < 60)
+        remainingText = QString("%1 s").arg(remaining);
+    else if (remaining < 3600)
+        remainingText = QString("%1 min").arg((remaining + 59) / 60);
+    else
+        remainingText = QString("%1 h %2 min").arg(remaining / 3600).arg((remaining % 3600 + 59) / 60);
+
+    ui->progressBar->setFormat("%p% (about " + remainingText + " left)");
+    ui->progressBar->setTextVisible(true);
+}
@@ -20,6 +20,7 @@
 #define MYPROGRESSDIALOG_H
 
 #include <QDialog>
+#include <QElapsedTimer>
 #include <QString>
 
 namespace Ui {
@@ -42,11 +43,15 @@ public:
 public slots:
     void setMaxValue(int max);
     void setValue(int value);
+    // Also shows the remaining time, estimated from the rate since the first
+    // call
+    void setProgress(int value, int max);
 
 private:
     Ui::MyProgressDialog *ui;
     QString m_cancelMessage;
     bool m_cancelled;
+    QElapsedTimer m_progressTimer;
 
 private slots:
     void cancel();
@@ -176,6 +176,7 @@ void SettingsDialog::loadOrSaveSettingsToOrFromWidgets(bool setWidgets, Settings
     doubleFunctionPointer(&settings->doubleModeNodeSeparation, ui->doubleModeNodeSeparationSpinBox, false);
     doubleFunctionPointer(&settings->nodeSegmentLength, ui->nodeSegmentLengthSpinBox, false);
     doubleFunctionPointer(&settings->componentSeparation, ui->componentSeparationSpinBox, false);
+    intFunctionPointer(&settings->threads, ui->threadsSpinBox);
     doubleFunctionPointer(&settings->depthEffectOnWidth, ui->depthEffectOnWidthSpinBox, true);
     doubleFunctionPointer(&settings->depthPower, ui->depthPowerSpinBox, false);
     doubleFunctionPointer(&settings->edgeWidth, ui->edgeWidthSpinBox, false);
@@ -230,6 +231,12 @@ void SettingsDialog::loadOrSaveSettingsToOrFromWidgets(bool setWidgets, Settings
         ui->graphLayoutQualitySlider->setValue(settings->graphLayoutQuality);
         ui->linearLayoutOffRadioButton->setChecked(!settings->linearLayout);
         ui->linearLayoutOnRadioButton->setChecked(settings->linearLayout);
+        ui->multilevelLayoutOffRadioButton->setChecked(!settings->multilevelLayout);
+        ui->multilevelLayoutOnRadioButton->setChecked(settings->multilevelLayout);
+        ui->incrementalLayoutOffRadioButton->setChecked(!settings->incrementalLayout);
+        ui->incrementalLayoutOnRadioButton->setChecked(settings->incrementalLayout);
+        ui->graphLayoutEngineFmmmRadioButton->setChecked(settings->graphLayoutEngine == FMMM_LAYOUT);
+        ui->graphLayoutEngineFmeRadioButton->setChecked(settings->graphLayoutEngine == FAST_MULTIPOLE_LAYOUT);
         ui->antialiasingOffRadioButton->setChecked(!settings->antialiasing);
         ui->antialiasingOnRadioButton->setChecked(settings->antialiasing);
         ui->antialiasingOffRadioButton->setChecked(!settings->antialiasing);
@@ -251,6 +258,10 @@ void SettingsDialog::loadOrSaveSettingsToOrFromWidgets(bool setWidgets, Settings
     {
         settings->graphLayoutQuality = ui->graphLayoutQualitySlider->value();
         settings->linearLayout = ui->linearLayoutOnRadioButton->isChecked();
+        settings->multilevelLayout = ui->multilevelLayoutOnRadioButton->isChecked();
+        settings->incrementalLayout = ui->incrementalLayoutOnRadioButton->isChecked();
+        settings->graphLayoutEngine = ui->graphLayoutEngineFmeRadioButton->isChecked() ?
+                                      FAST_MULTIPOLE_LAYOUT : FMMM_LAYOUT;
         settings->antialiasing = ui->antialiasingOnRadioButton->isChecked();
         settings->arrowheadsInSingleMode = ui->singleNodeArrowHeadsOnRadioButton->isChecked();
         settings->autoDepthValue = ui->depthValueAutoRadioButton->isChecked();
@@ -435,7 +435,8 @@ AssemblyGraph* MainWindow::loadGraph(QString fullFileName, QString graphName, bo
                                              "GFA (*.gfa);;"
                                              "Trinity.fasta (*.fasta);;"
                                              "ASQG (*.asqg);;"
-                                             "Plain FASTA (*.fasta)",
+                                             "Plain FASTA (*.fasta);;"
+                                             "Bandage snapshot (*.bandage)",
                                              &selectedFilter);
 
     if (fullFileName.isEmpty()) //User did hit cancel
@@ -543,7 +544,7 @@ AssemblyGraph* MainWindow::loadGraph(QString fullFileName, QString graphName, bo
 void MainWindow::loadGraphLayout(QString fullFileName) {
     if (fullFileName.isEmpty())
         fullFileName = QFileDialog::getOpenFileName(this, "Load Bandage layout", "",
-                                                    "Bandage layout (*.layout)");
+                                                    "Bandage layout (*.layout *.bandage)");
 
     if (fullFileName.isEmpty())
         return; // user clicked on cancel
@@ -1065,6 +1066,14 @@ void MainWindow::drawGraph() {
     g_hicManager->setMinLength(ui->hicSeqLenSpinBox->value());
 
     if (m_uiState == GRAPH_LOADED || m_uiState == GRAPH_DRAWN) {
+        // Positions of the drawn nodes are kept for the incremental layout,
+        // they have to be taken before the scene is gone
+        std::vector<GraphLayout> previousLayouts;
+        if (m_uiState == GRAPH_DRAWN && g_settings->incrementalLayout) {
+            for (auto *assemblyGraph : g_assemblyGraph->m_graphMap.values())
+                previousLayouts.emplace_back(layout::fromGraph(*assemblyGraph));
+        }
+
         resetScene();
         for(auto& assemblyGraph : g_assemblyGraph->m_graphMap.values()) {
             auto scope =
@@ -1088,7 +1097,7 @@ void MainWindow::drawGraph() {
             assemblyGraph->resetNodes();
             assemblyGraph->markNodesToDraw(scope, startingNodes);
         }
-        layoutGraph();
+        layoutGraph(std::move(previousLayouts));
     }
 }
 
@@ -1147,7 +1156,7 @@ std::vector<DeBruijnNode *> MainWindow::getNodesFromLineEdit(QLineEdit * lineEdi
     return res;
 }
 
-void MainWindow::layoutGraph()
+void MainWindow::layoutGraph(std::vector<GraphLayout> previousLayouts)
 {
     //The actual layout is done in a different thread so the UI will stay responsive.
         auto *progress = new MyProgressDialog(this, "Laying out graph...", true, "Cancel layout", "Cancelling layout...",
@@ -1168,8 +1177,16 @@ void MainWindow::layoutGraph()
         auto *graphLayoutWorker = new GraphLayoutWorker(g_settings->graphLayoutQuality,
                                                         g_settings->linearLayout,
                                                         g_settings->componentSeparation, aspectRatio);
+        // Positions laid out with other settings are not kept, so changing
+        // a layout setting always gives a fresh layout
+        if (graphLayoutWorker->layoutParameters() == m_layoutParameters) {
+            for (auto &previousLayout : previousLayouts)
+                graphLayoutWorker->setPreviousLayout(std::move(previousLayout));
+        }
+        m_layoutParameters = graphLayoutWorker->layoutParameters();
 
         connect(progress, SIGNAL(halt()), graphLayoutWorker, SLOT(cancelLayout()));
+        connect(graphLayoutWorker, SIGNAL(layoutProgress(int,int)), progress, SLOT(setProgress(int,int)));
 
         auto *watcher = new QFutureWatcher<QList<GraphLayout*>>;
 
@@ -2309,6 +2326,7 @@ void MainWindow::selectAll() {
     m_scene->blockSignals(true);
     for (auto *item : m_scene->items())
         item->setSelected(true);
+    m_scene->selectBatchedNodes(QPolygonF(m_scene->sceneRect()));
     m_scene->blockSignals(false);
     g_graphicsView->viewport()->update();
     selectionChanged();
@@ -2317,8 +2335,7 @@ void MainWindow::selectAll() {
 
 void MainWindow::selectNone() {
     m_scene->blockSignals(true);
-    for (auto *item : m_scene->items())
-        item->setSelected(false);
+    m_scene->clearSelection();
     m_scene->blockSignals(false);
     g_graphicsView->viewport()->update();
     selectionChanged();
@@ -2328,6 +2345,7 @@ void MainWindow::invertSelection() {
     m_scene->blockSignals(true);
     for (auto item : m_scene->items())
         item->setSelected(!item->isSelected());
+    m_scene->invertBatchedSelection();
     m_scene->blockSignals(false);
     g_graphicsView->viewport()->update();
     selectionChanged();
@@ -2338,6 +2356,9 @@ void MainWindow::invertSelection() {
 void MainWindow::zoomToSelection()
 {
     QList<QGraphicsItem *> selection = m_scene->selectedItems();
+    for (auto *selectedNode : m_scene->getSelectedGraphicsItemNodes())
+        if (!selectedNode->scene())
+            selection.push_back(selectedNode);
     if (selection.empty()) {
         QMessageBox::information(this, "No nodes selected", "You must first select nodes in the graph before using "
                                                             "the 'Zoom to fit selection' function.");
@@ -2763,8 +2784,8 @@ void MainWindow::mergeAllPossible()
     int merges;
     {
         MyProgressDialog progress(this, "Merging nodes", true, "Cancel merge", "Cancelling merge...",
-                                  "Clicking this button will stop the merging process. Merges that have already completed will remain "
-                                  "merged but no further merging will take place.");
+                                  "Clicking this button will stop the merging process. All merges are applied at once "
+                                  "at the end, so a cancelled merge leaves the graph unchanged.");
 
         progress.setWindowModality(Qt::WindowModal);
         progress.setMaxValue(100);
@@ -34,6 +34,7 @@
 
 #include <QMainWindow>
 #include <QGraphicsScene>
+#include <QByteArray>
 #include <QMap>
 #include <QString>
 #include <vector>
@@ -86,6 +87,8 @@ private:
     GraphSearchDialog * m_blastSearchDialog;
 
     bool m_alreadyShown;
+    // Parameters of the last graph layout, see GraphLayoutWorker::layoutParameters()
+    QByteArray m_layoutParameters;
     FeaturesForestWidget* m_featuresForestWidget;
     BlastFeaturesNodesMatcher* m_blastFeaturesNodesMatcher;
 
@@ -95,7 +98,7 @@ private:
     void resetScene();
     void resetAllNodeColours();
     void resetAllNodeColoursInGraph(AssemblyGraph* assemblyGraph);
-    void layoutGraph();
+    void layoutGraph(std::vector<GraphLayout> previousLayouts = {});
     void zoomToFitRect(QRectF rect, BandageGraphicsView* graphicsView);
     void setZoomSpinBoxStep();
     void getSelectedNodeInfo(int & selectedNodeCount, QString & selectedNodeCountText,